@@ -1,52 +1,129 @@
 #! /usr/bin/python
 import re
+import struct
 import sys
+import zlib
+
+# the struct module's format characters for the data types used by VTK
+vtkTypes = { "Int8" : "b", "UInt8" : "B",
+             "Int16" : "h", "UInt16" : "H",
+             "Int32" : "i", "UInt32" : "I",
+             "Int64" : "q", "UInt64" : "Q",
+             "Float32" : "f", "Float64" : "d" }
+
+# returns the value of an XML attribute or None if the attribute does not exist
+def getAttribute(tag, name):
+    m = re.search(r'\b%s="([^"]*)"'%name, tag)
+    if m:
+        return m.group(1)
+    return None
+
+# decode the binary blob of a data array which is stored in the appended section of a
+# VTK file. the blob starts with a header that contains its size and, for compressed
+# data, the sizes of the individual blocks
+def decodeAppended(data, offset, valueType, headerType, byteOrder, compressed):
+    headerFmt = byteOrder + vtkTypes[headerType]
+    headerSize = struct.calcsize(headerFmt)
+
+    def readHeader(pos):
+        return struct.unpack(headerFmt, data[pos:pos + headerSize])[0]
+
+    if not compressed:
+        numBytes = readHeader(offset)
+        begin = offset + headerSize
+        raw = data[begin:begin + numBytes]
+    else:
+        numBlocks = readHeader(offset)
+        compressedSizes = [ readHeader(offset + (3 + i)*headerSize) for i in range(0, numBlocks) ]
+        pos = offset + (3 + numBlocks)*headerSize
+        raw = b""
+        for blockSize in compressedSizes:
+            raw += zlib.decompress(data[pos:pos + blockSize])
+            pos += blockSize
+
+    valueFmt = vtkTypes[valueType]
+    numValues = len(raw)//struct.calcsize(valueFmt)
+    return list(struct.unpack("%s%i%s"%(byteOrder, numValues, valueFmt), raw))
+
+# read all data arrays of a VTK file. the result is a list of (name, values) tuples
+# which are in the same order as in the file. the values of inline arrays must be
+# written as ASCII, the ones of appended arrays in raw (optionally zlib compressed)
+# form.
+def readDataArrays(fileName):
+    data = open(fileName, "rb").read()
+
+    # split the file into the XML part and the binary data of the appended section
+    appendedPos = data.find(b"<AppendedData")
+    appendedData = None
+    if appendedPos >= 0:
+        xmlText = data[0:appendedPos].decode("latin-1")
+        appendedTag = data[appendedPos:data.find(b">", appendedPos) + 1].decode("latin-1")
+        if getAttribute(appendedTag, "encoding") != "raw":
+            print("Only raw encoding of appended data is supported by %s"%sys.argv[0])
+            exit(1)
+        appendedData = data[data.find(b"_", appendedPos) + 1:]
+    else:
+        xmlText = data.decode("latin-1")
+
+    fileTag = re.search(r'<VTKFile[^>]*>', xmlText).group(0)
+    byteOrder = "<"
+    if getAttribute(fileTag, "byte_order") == "BigEndian":
+        byteOrder = ">"
+    headerType = getAttribute(fileTag, "header_type") or "UInt32"
+    compressed = getAttribute(fileTag, "compressor") is not None
+
+    arrays = []
+    for m in re.finditer(r'<DataArray([^>]*?)(/>|>(.*?)</DataArray>)', xmlText, re.DOTALL):
+        tag = m.group(1)
+        name = getAttribute(tag, "Name")
+        arrayFormat = getAttribute(tag, "format")
+        if arrayFormat == "ascii":
+            values = list(map(float, m.group(3).split()))
+        elif arrayFormat == "appended":
+            values = decodeAppended(appendedData,
+                                    int(getAttribute(tag, "offset")),
+                                    getAttribute(tag, "type"),
+                                    headerType,
+                                    byteOrder,
+                                    compressed)
+        else:
+            print("Data array '%s' uses the unsupported format '%s'"%(name, arrayFormat))
+            exit(1)
+        arrays.append((name, values))
+
+    return arrays
 
 # fuzzy compare two VTK files
-def isFuzzyEqual(vtkFile1, vtkFile2, absTol, relTol):
-    inField = False
-    curFieldName = ""
-    for curLine1 in vtkFile1.xreadlines():
-        curLine2 = vtkFile2.readline()
-
-        if curLine1.find("</DataArray>") >= 0:
-            inField = False
-            continue
-
-        m = re.search(r'Name="([a-zA-Z0-9 _\-]*)"', curLine1)
-        if m:
-            curFieldName = m.group(1)
-            inField = True
-            continue
-
-        if not inField:
-            continue
-
-        curVals1 = map(float, curLine1.split())
-        curVals2 = map(float, curLine2.split())
-        
+def isFuzzyEqual(vtkFileName1, vtkFileName2, absTol, relTol):
+    arrays2 = dict(readDataArrays(vtkFileName2))
+    for curFieldName, curVals1 in readDataArrays(vtkFileName1):
+        if curFieldName not in arrays2:
+            print("Field '%s' does not exist in both files"%curFieldName)
+            return False
+        curVals2 = arrays2[curFieldName]
+
         if len(curVals1) != len(curVals2):
-            print "Length of field '%s' is different"%curFieldName
+            print("Length of field '%s' is different"%curFieldName)
             return False
-        
+
         for i in range(0, len(curVals1)):
             number1 = curVals1[i]
             number2 = curVals2[i]
             if curFieldName.find("saturation") >= 0:
                 if abs(number1 - number2) > 0.1:
-                    print 'Difference between %f and %f too large in data field "%s": %s'%(number1,number2,curFieldName,abs(number1 - number2))
+                    print('Difference between %f and %f too large in data field "%s": %s'%(number1,number2,curFieldName,abs(number1 - number2)))
                     return False
             if curFieldName.find("mole") >= 0 or curFieldName.find("mass") >= 0:
                 if abs(number1 - number2) > 0.1:
-                    print 'Difference between %f and %f too large in data field "%s": %s'%(number1,number2,curFieldName,abs(number1 - number2))
+                    print('Difference between %f and %f too large in data field "%s": %s'%(number1,number2,curFieldName,abs(number1 - number2)))
                     return False
             elif curFieldName.find("velocity") >= 0:
                 if abs(number1 - number2) > 0.02:
-                    print 'Difference between %f and %f too large in data field "%s": %s'%(number1,number2,curFieldName,abs(number1 - number2))
+                    print('Difference between %f and %f too large in data field "%s": %s'%(number1,number2,curFieldName,abs(number1 - number2)))
                     return False
             elif curFieldName.find("pressure") >= 0:
                 if abs(number1 - number2) > 0.1*abs(number1 + number2):
-                    print 'Difference between %f and %f too large in data field "%s": %s'%(number1,number2,curFieldName,abs(number1 - number2))
+                    print('Difference between %f and %f too large in data field "%s": %s'%(number1,number2,curFieldName,abs(number1 - number2)))
                     return False
             else:
                 # don't compare any other fields
@@ -54,10 +131,10 @@ def isFuzzyEqual(vtkFile1, vtkFile2, absTol, relTol):
     return True
 
 if len(sys.argv) != 3:
-    print sys.argv[0], "CURRENT_RESULT REFERENCE_RESULT"
+    print("%s CURRENT_RESULT REFERENCE_RESULT"%sys.argv[0])
     exit(1);
 
-if isFuzzyEqual(open(sys.argv[1]), open(sys.argv[2]), absTol=1e-6, relTol=1e-2):
+if isFuzzyEqual(sys.argv[1], sys.argv[2], absTol=1e-6, relTol=1e-2):
     exit(0)
 else:
     exit(1)
@@ -12,7 +12,7 @@ usage() {
     echo "Usage:"
     echo
     echo "runTest.sh TEST_TYPE TEST_BINARY [TEST_ARGS]"
-    echo "where TEST_TYPE can either be --plain, --simulation or --parallel-simulation=\$NUM_CORES (is '$TEST_TYPE')."
+    echo "where TEST_TYPE can either be --plain, --parallel-plain=\$NUM_CORES, --simulation or --parallel-simulation=\$NUM_CORES (is '$TEST_TYPE')."
 };
 
 validateResults() {
@@ -228,6 +228,17 @@ EOF
             exit 1
         fi
 
+        exit 0
+        ;;
+
+    "--parallel-plain="*)
+        NUM_PROCS="${TEST_TYPE/--parallel-plain=/}"
+
+        echo "executing \"mpirun -np \"$NUM_PROCS\" $TEST_BINARY $TEST_ARGS\""
+        if ! mpirun -np "$NUM_PROCS" "$TEST_BINARY" $TEST_ARGS; then
+            exit 1
+        fi
+
         exit 0
         ;;
 esac
@@ -39,7 +39,13 @@
 
 #include <dune/grid/common/mcmgmapper.hh>
 
+#if HAVE_MPI
+#include <mpi.h>
+#endif
+
+#include <list>
 #include <stdexcept>
+#include <vector>
 
 namespace Ewoms
 {
@@ -180,6 +186,9 @@ namespace Ewoms
               isIORank_( gridManager.grid().comm().rank() == ioRank ),
               isParallel_( gridManager.grid().comm().size() > 1 )
         {
+#if HAVE_MPI
+            mpiComm_ = gridManager.grid().comm();
+#endif
             if ( !isParallel_ )
             {
                 // no need to collect anything.
@@ -228,13 +237,14 @@ namespace Ewoms
                     send.insert( ioRank );
                 }
 
+                // the local indices of all interior elements in the order in which
+                // their data is sent to the I/O rank
                 localIndexMap_.clear();
                 const size_t gridSize = gridManager.grid().size( 0 );
-                localIndexMap_.resize( gridSize, -1 );
+                localIndexMap_.reserve( gridSize );
 
                 // store the local Cartesian index
                 IndexMapType distributedCartesianIndex;
-                int interiorElementIdx = 0;
                 distributedCartesianIndex.resize(gridSize, -1);
 
                 auto localView = gridManager.grid().leafGridView();
@@ -247,12 +257,12 @@ namespace Ewoms
 #else
                     int elemIdx = elemMapper.map( element );
 #endif
-                    distributedCartesianIndex.push_back( gridManager.cartesianIndex( elemIdx ) );
+                    distributedCartesianIndex[ elemIdx ] = gridManager.cartesianIndex( elemIdx );
 
                     // only store interior element for collection
                     if( element.partitionType() == Dune :: InteriorEntity )
                     {
-                        localIndexMap_[elemIdx] = interiorElementIdx++;
+                        localIndexMap_.push_back( elemIdx );
                     }
                 }
 
@@ -272,141 +282,146 @@ namespace Ewoms
             }
         }
 
-        template <class BufferList>
-        class PackUnPackOutputBuffers : public P2PCommunicatorType::DataHandleInterface
+        /*!
+         * \brief Start gathering a single field to the I/O rank without blocking.
+         *
+         * The fields of an output step must be passed in the same order on all
+         * ranks; fieldIdx is used to tell the messages for the individual fields
+         * apart. On the compute ranks the data is copied into a send buffer, so the
+         * passed buffer may be modified as soon as this method returns. The I/O
+         * rank posts the receives for the field's data of all other ranks and
+         * copies its own contribution to the global buffer.
+         */
+        template <class Buffer>
+        void beginCollectField( const unsigned fieldIdx, const Buffer& buffer )
         {
-            BufferList& bufferList_;
-
-            const IndexMapType& localIndexMap_;
-            const IndexMapStorageType& indexMaps_;
-
-        public:
-            PackUnPackOutputBuffers( BufferList& bufferList,
-                                     const IndexMapType& localIndexMap,
-                                     const IndexMapStorageType& indexMaps,
-                                     const size_t globalSize,
-                                     const bool isIORank )
-            : bufferList_( bufferList ),
-              localIndexMap_( localIndexMap ),
-              indexMaps_( indexMaps )
+            if ( !isParallel_ )
             {
-                if( isIORank )
-                {
-                    MessageBufferType buffer;
-                    pack( 0, buffer );
-                    // resize all buffers
-                    for (auto it = bufferList_.begin(), end = bufferList_.end(); it != end; ++it )
-                    {
-                      it->second->resize( globalSize );
-                    }
-                    // the last index map is the local one
-                    doUnpack( indexMaps.back(), buffer );
+                // no need to collect anything.
+                return;
+            }
 
-                }
+            // the send buffers of the previous output step may be released only
+            // after the I/O rank has received them.
+            if( fieldIdx == 0 )
+            {
+                waitForPendingSends_();
             }
 
-            // pack all data associated with link
-            void pack( const int link, MessageBufferType& buffer )
+#if HAVE_MPI
+            const int tag = fieldTagOffset + static_cast<int>( fieldIdx );
+            if( isIORank() )
             {
-                // we should only get one link
-                if( link != 0 ) {
-                    OPM_THROW(std::logic_error,"link in method pack is not 0 as execpted");
+                if( pendingFields_.size() <= fieldIdx )
+                {
+                    pendingFields_.resize( fieldIdx + 1 );
                 }
+                PendingField& field = pendingFields_[ fieldIdx ];
+                field.globalBuffer.assign( numCells(), 0.0 );
 
-                size_t buffers = bufferList_.size();
-                buffer.write( buffers );
-                for (auto it = bufferList_.begin(), end = bufferList_.end(); it != end; ++it )
+                // the last index map is the one of the I/O rank itself
+                const IndexMapType& localMap = indexMaps_.back();
+                for( size_t i = 0; i < localMap.size(); ++i )
                 {
-                    write( buffer, localIndexMap_, *(it->second) );
+                    field.globalBuffer[ localMap[ i ] ] = buffer[ localIndexMap_[ i ] ];
                 }
-            }
 
-            void doUnpack( const IndexMapType& indexMap, MessageBufferType& buffer )
-            {
-                size_t buffers = 0;
-                buffer.read( buffers );
-                assert( buffers == bufferList_.size() );
-                for( auto it = bufferList_.begin(), end = bufferList_.end(); it != end; ++it )
+                const int commSize = static_cast<int>( indexMaps_.size() );
+                field.recvBuffers.resize( commSize );
+                field.requests.clear();
+                for( int rank = 0; rank < commSize; ++rank )
                 {
-                    read( buffer, indexMap, *(it->second) );
-                }
-            }
+                    if( rank == ioRank )
+                    {
+                        continue;
+                    }
 
-            // unpack all data associated with link
-            void unpack( const int link, MessageBufferType& buffer )
-            {
-                doUnpack( indexMaps_[ link ], buffer );
-            }
+                    std::vector<double>& recvBuffer = field.recvBuffers[ rank ];
+                    recvBuffer.resize( indexMapOfRank_( rank ).size() );
 
-        protected:
-            template <class Vector>
-            void write( MessageBufferType& buffer, const IndexMapType& localIndexMap, const Vector& data ) const
+                    MPI_Request request;
+                    MPI_Irecv( recvBuffer.data(), static_cast<int>( recvBuffer.size() ),
+                               MPI_DOUBLE, rank, tag, mpiComm_, &request );
+                    field.requests.push_back( request );
+                }
+            }
+            else
             {
-                const size_t size = localIndexMap.size();
-                assert( size <= data.size() );
-                buffer.write( size );
-                for( size_t i=0; i<size; ++i )
+                sendBuffers_.push_back( std::vector<double>( localIndexMap_.size() ) );
+                std::vector<double>& sendBuffer = sendBuffers_.back();
+                for( size_t i = 0; i < localIndexMap_.size(); ++i )
                 {
-                    buffer.write( data[ localIndexMap[ i ] ] );
+                    sendBuffer[ i ] = buffer[ localIndexMap_[ i ] ];
                 }
+
+                MPI_Request request;
+                MPI_Isend( sendBuffer.data(), static_cast<int>( sendBuffer.size() ),
+                           MPI_DOUBLE, ioRank, tag, mpiComm_, &request );
+                sendRequests_.push_back( request );
             }
+#else
+            OPM_THROW(std::logic_error, "Parallel data collection requires MPI");
+#endif
+        }
 
-            template <class Vector>
-            void read( MessageBufferType& buffer, const IndexMapType& indexMap, Vector& data ) const
+        /*!
+         * \brief Complete gathering the fields to the I/O rank.
+         *
+         * On the I/O rank, writeField(fieldIdx, globalBuffer) is called for each
+         * field as soon as the data of all ranks for this field has arrived, i.e.,
+         * while a field is written, the messages of the later ones are received in
+         * the background. On all other ranks, this method returns immediately.
+         *
+         * In the sequential case, the buffers of the list are passed to writeField
+         * unmodified.
+         */
+        template <class BufferList, class WriteFieldFunctor>
+        void finishCollect( const BufferList& bufferList, WriteFieldFunctor writeField )
+        {
+            if ( !isParallel_ )
             {
-                size_t size = indexMap.size();
-                assert( size <= data.size() );
-                buffer.read( size );
-                assert( size == indexMap.size() );
-                for( size_t i=0; i<size; ++i )
+                unsigned fieldIdx = 0;
+                for( auto it = bufferList.begin(), end = bufferList.end(); it != end; ++it, ++fieldIdx )
                 {
-                    buffer.read( data[ indexMap[ i ] ] );
+                    writeField( fieldIdx, *(it->second) );
                 }
+                return;
             }
 
-            void writeString( MessageBufferType& buffer, const std::string& s) const
+            if( !isIORank() )
             {
-                const int size = s.size();
-                buffer.write( size );
-                for( int i=0; i<size; ++i )
-                {
-                    buffer.write( s[ i ] );
-                }
+                return;
             }
 
-            void readString( MessageBufferType& buffer, std::string& s) const
+#if HAVE_MPI
+            const size_t numFields = bufferList.size();
+            assert( numFields <= pendingFields_.size() );
+            for( unsigned fieldIdx = 0; fieldIdx < numFields; ++fieldIdx )
             {
-                int size = -1;
-                buffer.read( size );
-                s.resize( size );
-                for( int i=0; i<size; ++i )
+                PendingField& field = pendingFields_[ fieldIdx ];
+                MPI_Waitall( static_cast<int>( field.requests.size() ),
+                             field.requests.data(),
+                             MPI_STATUSES_IGNORE );
+                field.requests.clear();
+
+                // bring the received data into the order of the global grid
+                for( size_t rank = 0; rank < field.recvBuffers.size(); ++rank )
                 {
-                    buffer.read( s[ i ] );
+                    if( static_cast<int>( rank ) == ioRank )
+                    {
+                        continue;
+                    }
+
+                    const IndexMapType& indexMap = indexMapOfRank_( static_cast<int>( rank ) );
+                    const std::vector<double>& recvBuffer = field.recvBuffers[ rank ];
+                    for( size_t i = 0; i < indexMap.size(); ++i )
+                    {
+                        field.globalBuffer[ indexMap[ i ] ] = recvBuffer[ i ];
+                    }
                 }
-            }
-        };
 
-        // gather solution to rank 0 for EclipseWriter
-        template <class BufferList>
-        void collect( BufferList& bufferList ) const
-        {
-            if ( !isParallel_ )
-            {
-                // no need to collect anything.
-                return;
+                writeField( fieldIdx, field.globalBuffer );
             }
-            PackUnPackOutputBuffers< BufferList >
-                packUnpack( bufferList,
-                            localIndexMap_,
-                            indexMaps_,
-                            numCells(),
-                            isIORank() );
-
-            //toIORankComm_.exchangeCached( packUnpack );
-            toIORankComm_.exchange( packUnpack );
-#ifndef NDEBUG
-            // mkae sure every process is on the same page
-            toIORankComm_.barrier();
 #endif
         }
 
@@ -422,11 +437,58 @@ namespace Ewoms
 
         size_t numCells () const { return globalCartesianIndex_.size(); }
 
+        ~CollectDataToIORank()
+        {
+            waitForPendingSends_();
+        }
+
     protected:
+        // the data of a field which is currently received by the I/O rank
+        struct PendingField
+        {
+            std::vector<double> globalBuffer;
+            std::vector< std::vector<double> > recvBuffers;
+#if HAVE_MPI
+            std::vector<MPI_Request> requests;
+#endif
+        };
+
+        // the tags of the messages for the fields start at this value
+        enum { fieldTagOffset = 1000 };
+
+        // the index maps are stored per communication link. since the I/O rank
+        // receives from all other ranks, link i corresponds to rank i + 1.
+        const IndexMapType& indexMapOfRank_( const int rank ) const
+        {
+            assert( rank != ioRank );
+            return indexMaps_[ rank - 1 ];
+        }
+
+        void waitForPendingSends_()
+        {
+#if HAVE_MPI
+            if( !sendRequests_.empty() )
+            {
+                MPI_Waitall( static_cast<int>( sendRequests_.size() ),
+                             sendRequests_.data(),
+                             MPI_STATUSES_IGNORE );
+            }
+            sendRequests_.clear();
+#endif
+            sendBuffers_.clear();
+        }
+
+
         P2PCommunicatorType             toIORankComm_;
         IndexMapType                    globalCartesianIndex_;
         IndexMapType                    localIndexMap_;
         IndexMapStorageType             indexMaps_;
+        std::vector< PendingField >     pendingFields_;
+        std::list< std::vector<double> > sendBuffers_;
+#if HAVE_MPI
+        std::vector< MPI_Request >      sendRequests_;
+        MPI_Comm                        mpiComm_;
+#endif
         // true if we are on I/O rank
         bool                            isIORank_;
         /// \brief True if there is more than one MPI process
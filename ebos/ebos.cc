@@ -32,13 +32,173 @@
 
 #include "eclproblem.hh"
 
+#include <fstream>
+#include <sstream>
+#include <string>
+
 namespace Ewoms {
 namespace Properties {
 NEW_TYPE_TAG(EclProblem, INHERITS_FROM(BlackOilModel, EclBaseProblem));
+
+// instantiations of the black-oil model which only consider two phases
+NEW_TYPE_TAG(EclOilWaterProblem, INHERITS_FROM(EclProblem));
+NEW_TYPE_TAG(EclOilGasProblem, INHERITS_FROM(EclProblem));
+
+SET_PROP(EclOilWaterProblem, Indices)
+{
+private:
+    typedef typename GET_PROP_TYPE(TypeTag, FluidSystem) FluidSystem;
+
+public:
+    typedef Ewoms::BlackOilTwoPhaseIndices<FluidSystem, FluidSystem::gasCompIdx> type;
+};
+
+SET_PROP(EclOilGasProblem, Indices)
+{
+private:
+    typedef typename GET_PROP_TYPE(TypeTag, FluidSystem) FluidSystem;
+
+public:
+    typedef Ewoms::BlackOilTwoPhaseIndices<FluidSystem, FluidSystem::waterCompIdx> type;
+};
 }}
 
+/*!
+ * \brief Scans a file of a deck for the keywords which enable the water, gas and oil
+ *        phases.
+ *
+ * The files which are included by INCLUDE keywords are scanned recursively. Their
+ * paths are relative to the directory of the deck's main file.
+ *
+ * \return false if the file or one of the files it includes cannot be read.
+ */
+static bool scanDeckFilePhases_(const std::string& fileName,
+                                const std::string& deckDir,
+                                unsigned includeDepth,
+                                bool& waterEnabled,
+                                bool& gasEnabled,
+                                bool& oilEnabled,
+                                bool& runspecDone)
+{
+    // guard against include cycles
+    if (includeDepth > 32)
+        return false;
+
+    std::ifstream deckFile(fileName);
+    if (!deckFile.good())
+        return false;
+
+    bool expectIncludePath = false;
+    std::string line;
+    while (!runspecDone && std::getline(deckFile, line)) {
+        // strip comments
+        std::string::size_type commentPos = line.find("--");
+        if (commentPos != std::string::npos)
+            line.erase(commentPos);
+
+        std::istringstream iss(line);
+        std::string keyword;
+        if (!(iss >> keyword))
+            continue;
+
+        if (expectIncludePath) {
+            expectIncludePath = false;
+
+            // the path is either quoted or ends at the first whitespace or slash
+            std::string includePath;
+            std::string::size_type quotePos = line.find('\'');
+            if (quotePos != std::string::npos) {
+                std::string::size_type endQuotePos = line.find('\'', quotePos + 1);
+                if (endQuotePos == std::string::npos)
+                    return false;
+                includePath = line.substr(quotePos + 1, endQuotePos - quotePos - 1);
+            }
+            else
+                includePath = keyword.substr(0, keyword.find('/'));
+
+            // aliases defined by the PATHS keyword are not resolved
+            if (includePath.empty() || includePath.find('$') != std::string::npos)
+                return false;
+
+            if (includePath[0] != '/')
+                includePath = deckDir + includePath;
+
+            if (!scanDeckFilePhases_(includePath, deckDir, includeDepth + 1,
+                                     waterEnabled, gasEnabled, oilEnabled, runspecDone))
+                return false;
+        }
+        else if (keyword == "WATER")
+            waterEnabled = true;
+        else if (keyword == "GAS")
+            gasEnabled = true;
+        else if (keyword == "OIL")
+            oilEnabled = true;
+        else if (keyword == "INCLUDE")
+            expectIncludePath = true;
+        else if (keyword == "GRID")
+            // the phase keywords must be specified in the RUNSPEC section
+            runspecDone = true;
+    }
+
+    return true;
+}
+
+/*!
+ * \brief Determines which of the water, gas and oil phases are enabled by the RUNSPEC
+ *        section of a deck.
+ *
+ * This only does a textual scan because the deck must be known before the type tag of
+ * the simulator can be chosen. If the deck cannot be read, all phases are assumed to be
+ * enabled.
+ */
+static void peekDeckPhases_(const std::string& deckFileName,
+                            bool& waterEnabled,
+                            bool& gasEnabled,
+                            bool& oilEnabled)
+{
+    waterEnabled = false;
+    gasEnabled = false;
+    oilEnabled = false;
+
+    std::string deckDir;
+    std::string::size_type dirSepPos = deckFileName.rfind('/');
+    if (dirSepPos != std::string::npos)
+        deckDir = deckFileName.substr(0, dirSepPos + 1);
+
+    bool runspecDone = false;
+    if (!scanDeckFilePhases_(deckFileName, deckDir, /*includeDepth=*/0,
+                             waterEnabled, gasEnabled, oilEnabled, runspecDone))
+    {
+        waterEnabled = true;
+        gasEnabled = true;
+        oilEnabled = true;
+    }
+}
+
 int main(int argc, char **argv)
 {
     typedef TTAG(EclProblem) ProblemTypeTag;
+    typedef TTAG(EclOilWaterProblem) OilWaterProblemTypeTag;
+    typedef TTAG(EclOilGasProblem) OilGasProblemTypeTag;
+
+    // select the instantiation of the black-oil model based on the phases of the
+    // deck. This avoids paying for a third equation if a phase is not present.
+    const std::string deckParam("--ecl-deck-file-name=");
+    std::string deckFileName(GET_PROP_VALUE(ProblemTypeTag, EclDeckFileName));
+    for (int i = 1; i < argc; ++i) {
+        std::string arg(argv[i]);
+        if (arg.compare(0, deckParam.size(), deckParam) == 0)
+            deckFileName = arg.substr(deckParam.size());
+    }
+
+    // the phases are decided once before the simulator is started. if the deck which
+    // is parsed by the simulator disagrees with this choice, EclProblem aborts the run.
+    bool waterEnabled, gasEnabled, oilEnabled;
+    peekDeckPhases_(deckFileName, waterEnabled, gasEnabled, oilEnabled);
+    if (oilEnabled && waterEnabled && !gasEnabled)
+        return Ewoms::start<OilWaterProblemTypeTag>(argc, argv);
+    else if (oilEnabled && gasEnabled && !waterEnabled)
+        return Ewoms::start<OilGasProblemTypeTag>(argc, argv);
+
     return Ewoms::start<ProblemTypeTag>(argc, argv);
 }
@@ -143,6 +143,11 @@ public:
         grid().communicate(*dataHandle,
                            Dune::InteriorBorder_All_Interface,
                            Dune::ForwardCommunication );
+
+        // the initial condition is computed by the I/O rank and the output is collected
+        // there as well, so only that process needs the global EQUIL grid
+        if (!this->isIORank())
+            releaseEquilGrid();
     }
 
     /*!
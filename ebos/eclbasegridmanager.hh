@@ -30,6 +30,7 @@
 #include <ewoms/io/basegridmanager.hh>
 #include <ewoms/common/propertysystem.hh>
 #include <ewoms/common/parametersystem.hh>
+#include <ewoms/common/memoryusage.hh>
 
 #include <opm/parser/eclipse/Parser/Parser.hpp>
 #include <opm/parser/eclipse/Parser/ParseContext.hpp>
@@ -39,13 +40,21 @@
 #include <opm/parser/eclipse/EclipseState/Grid/EclipseGrid.hpp>
 #include <opm/parser/eclipse/EclipseState/Schedule/Schedule.hpp>
 
+#include <opm/common/ErrorMacros.hpp>
+#include <opm/common/Exceptions.hpp>
+
 #if HAVE_MPI
 #include <mpi.h>
+#include <dune/common/parallel/mpitraits.hh>
 #endif // HAVE_MPI
 
+#include <algorithm>
+#include <exception>
 #include <vector>
 #include <unordered_set>
+#include <set>
 #include <array>
+#include <string>
 
 namespace Ewoms {
 template <class TypeTag>
@@ -101,6 +110,7 @@ public:
      */
     EclBaseGridManager(Simulator& simulator)
         : ParentType(simulator)
+        , deckReleased_(false)
     {
         int myRank = 0;
 #if HAVE_MPI
@@ -140,24 +150,117 @@ public:
         ParseModePairs tmp;
         tmp.push_back(ParseModePair(Opm::ParseContext::PARSE_RANDOM_SLASH, Opm::InputError::IGNORE));
         tmp.push_back(ParseModePair(Opm::ParseContext::PARSE_MISSING_DIMS_KEYWORD, Opm::InputError::WARN));
-        Opm::ParseContext parseContext(tmp);
 
-        deck_ = parser.parseFile(fileName , parseContext);
-        eclState_.reset(new Opm::EclipseState(deck_, parseContext));
+        // the parser and the grids do not expose how much memory they use, so the
+        // growth of the resident set is taken as an estimate
+        double rss = MemoryReport::residentSetSize();
+
+        // the I/O rank parses the complete deck first. it then tells the other processes
+        // which of the keywords that are only accessed by the I/O rank are present in
+        // the deck and which of them they can skip while parsing. if the I/O rank fails
+        // to read the deck, the other processes must not wait for it forever.
+        std::vector<int> ioRankOnlyKeywordState(ioRankOnlyKeywords_().size() + 1, notInDeck);
+        int& ioRankFailed = ioRankOnlyKeywordState.back();
+        std::exception_ptr ioRankException;
+        if (myRank == 0) {
+            try {
+                Opm::ParseContext parseContext(tmp);
+                deck_ = parser.parseFile(fileName , parseContext);
+                deckBytes_ = residentSetGrowth_(rss);
+
+                eclState_.reset(new Opm::EclipseState(deck_, parseContext));
+                eclStateBytes_ = residentSetGrowth_(rss);
+
+                determineIoRankOnlyKeywords_(ioRankOnlyKeywordState);
+            }
+            catch (...) {
+                ioRankException = std::current_exception();
+                ioRankFailed = 1;
+            }
+        }
+#if HAVE_MPI
+        MPI_Bcast(ioRankOnlyKeywordState.data(),
+                  static_cast<int>(ioRankOnlyKeywordState.size()),
+                  MPI_INT,
+                  /*root=*/0,
+                  MPI_COMM_WORLD);
+#endif
+        if (ioRankException)
+            std::rethrow_exception(ioRankException);
+        else if (ioRankFailed)
+            OPM_THROW(std::runtime_error,
+                      "The I/O rank could not read the deck file '" << fileName << "'");
+
+        for (unsigned kwIdx = 0; kwIdx < ioRankOnlyKeywords_().size(); ++kwIdx)
+            if (ioRankOnlyKeywordState[kwIdx] != notInDeck)
+                ioRankOnlyKeywordsInDeck_.insert(ioRankOnlyKeywords_()[kwIdx]);
+
+        if (myRank != 0) {
+            // the keywords which are skipped are unknown to the parser, so they must be
+            // ignored. the I/O rank has already reported any real problems of the deck.
+            for (unsigned kwIdx = 0; kwIdx < ioRankOnlyKeywords_().size(); ++kwIdx)
+                if (ioRankOnlyKeywordState[kwIdx] == skippedByOtherRanks)
+                    parser.dropParserKeyword(ioRankOnlyKeywords_()[kwIdx]);
+            tmp.push_back(ParseModePair(Opm::ParseContext::PARSE_UNKNOWN_KEYWORD, Opm::InputError::IGNORE));
+
+            Opm::ParseContext parseContext(tmp);
+            deck_ = parser.parseFile(fileName , parseContext);
+            deckBytes_ = residentSetGrowth_(rss);
+
+            eclState_.reset(new Opm::EclipseState(deck_, parseContext));
+            eclStateBytes_ = residentSetGrowth_(rss);
+        }
 
         asImp_().createGrids_();
+        gridBytes_ = residentSetGrowth_(rss);
 
         asImp_().finalizeInit_();
     }
 
     /*!
      * \brief Return a pointer to the parsed ECL deck
+     *
+     * This may only be called before releaseDeck().
      */
     const Opm::Deck& deck() const
-    { return deck_; }
+    {
+        if (deckReleased_)
+            OPM_THROW(std::logic_error, "The deck has already been released");
+        return deck_;
+    }
 
     Opm::Deck& deck()
-    { return deck_; }
+    {
+        if (deckReleased_)
+            OPM_THROW(std::logic_error, "The deck has already been released");
+        return deck_;
+    }
+
+    /*!
+     * \brief Indicates that the simulator has been initialized and the memory used by
+     *        the raw keywords of the deck can be released.
+     *
+     * Everything which is needed after this point must be taken from the EclipseState
+     * object. Subsequent calls to deck() throw an exception.
+     */
+    void releaseDeck()
+    {
+        deck_ = Opm::Deck();
+        deckReleased_ = true;
+    }
+
+    /*!
+     * \brief Add the memory used by the grid manager to a report.
+     *
+     * For the deck, the EclipseState object and the grids, the growth of the resident
+     * set of the process during their creation is used as an estimate.
+     */
+    void reportMemoryUsage(MemoryReport& report) const
+    {
+        report.add("ECL deck", deckReleased_ ? 0 : deckBytes_);
+        report.add("ECL state", eclStateBytes_);
+        report.add("grids (at creation)", gridBytes_);
+    }
 
     /*!
      * \brief Return a pointer to the internalized ECL deck
@@ -250,16 +353,234 @@ public:
     std::unordered_set<std::string> defunctWellNames() const
     { return std::unordered_set<std::string>(); }
 
+    /*!
+     * \brief Returns true if the local process is the one which distributes the global
+     *        grid properties to the other processes.
+     */
+    bool isIORank() const
+    {
+        int myRank = 0;
+#if HAVE_MPI
+        MPI_Comm_rank(MPI_COMM_WORLD, &myRank);
+#endif
+        return myRank == 0;
+    }
+
+    /*!
+     * \brief Distribute an array which is defined on the logically Cartesian grid to
+     *        the elements of the local process.
+     *
+     * The global array is only accessed on the I/O rank, the other processes may pass an
+     * empty vector. The I/O rank sends each process the values for the elements it
+     * sees, so no process except for the I/O rank needs to hold the global data. The
+     * result is indexed by the element index of the simulation grid. This is a
+     * collective operation, i.e., it must be called by all processes.
+     */
+    template <class T>
+    std::vector<T> scatterCartesianData(const std::vector<T>& globalData) const
+    {
+        unsigned numElems = this->gridView().size(/*codim=*/0);
+        std::vector<T> localData(numElems);
+
+        int mpiSize = 1;
+#if HAVE_MPI
+        MPI_Comm_size(MPI_COMM_WORLD, &mpiSize);
+#endif
+
+        if (mpiSize == 1) {
+            for (unsigned elemIdx = 0; elemIdx < numElems; ++elemIdx)
+                localData[elemIdx] = globalData[cartesianIndex(elemIdx)];
+            return localData;
+        }
+
+#if HAVE_MPI
+        int mpiRank = 0;
+        MPI_Comm_rank(MPI_COMM_WORLD, &mpiRank);
+
+        // tell the I/O rank which Cartesian cells are seen by the local process
+        std::vector<int> localCartIdx(numElems);
+        for (unsigned elemIdx = 0; elemIdx < numElems; ++elemIdx)
+            localCartIdx[elemIdx] = static_cast<int>(cartesianIndex(elemIdx));
+
+        int numLocal = static_cast<int>(numElems);
+        std::vector<int> counts;
+        std::vector<int> displs;
+        std::vector<int> allCartIdx;
+        if (mpiRank == 0)
+            counts.resize(mpiSize);
+        MPI_Gather(&numLocal, 1, MPI_INT, counts.data(), 1, MPI_INT, /*root=*/0, MPI_COMM_WORLD);
+
+        if (mpiRank == 0) {
+            displs.resize(mpiSize, 0);
+            for (int rankIdx = 1; rankIdx < mpiSize; ++rankIdx)
+                displs[rankIdx] = displs[rankIdx - 1] + counts[rankIdx - 1];
+            allCartIdx.resize(displs.back() + counts.back());
+        }
+        MPI_Gatherv(localCartIdx.data(), numLocal, MPI_INT,
+                    allCartIdx.data(), counts.data(), displs.data(), MPI_INT,
+                    /*root=*/0, MPI_COMM_WORLD);
+
+        // pick the values requested by each process from the global array and send
+        // them over
+        std::vector<T> sendBuffer;
+        if (mpiRank == 0) {
+            sendBuffer.resize(allCartIdx.size());
+            for (size_t i = 0; i < allCartIdx.size(); ++i)
+                sendBuffer[i] = globalData[allCartIdx[i]];
+        }
+
+        MPI_Datatype dataType = Dune::MPITraits<T>::getType();
+        MPI_Scatterv(sendBuffer.data(), counts.data(), displs.data(), dataType,
+                     localData.data(), numLocal, dataType,
+                     /*root=*/0, MPI_COMM_WORLD);
+#endif
+
+        return localData;
+    }
+
+    /*!
+     * \brief Returns true if a keyword is specified by the ECL deck.
+     *
+     * Some keywords which specify one value per cell (PERMX, PERMY, PERMZ, SWATINIT,
+     * PRESSURE, SWAT, SGAS, RS and RV) are only accessed via scatterCartesianData(), so
+     * the processes other than the I/O rank usually skip them when parsing the deck.
+     * For these, the result of this method is the same on all processes and it also
+     * considers grid properties which are set by operations like EQUALS. For all other
+     * keywords, this is equivalent to deck().hasKeyword().
+     */
+    bool deckHasKeyword(const std::string& name) const
+    {
+        const auto& kws = ioRankOnlyKeywords_();
+        if (std::find(kws.begin(), kws.end(), name) != kws.end())
+            return ioRankOnlyKeywordsInDeck_.count(name) > 0;
+
+        return deck().hasKeyword(name);
+    }
+
+    /*!
+     * \brief Returns the values of a floating point grid property of the ECL deck for
+     *        the elements of the local process.
+     *
+     * Only the I/O rank accesses the global array of the property, see
+     * scatterCartesianData(). This is a collective operation.
+     */
+    std::vector<double> localDoubleGridProperty(const std::string& name) const
+    {
+        const std::vector<double> noData;
+        const auto& props = eclState().get3DProperties();
+        return scatterCartesianData(isIORank() ? props.getDoubleGridProperty(name).getData() : noData);
+    }
+
+    /*!
+     * \brief Returns the values of an integer grid property of the ECL deck for the
+     *        elements of the local process.
+     *
+     * Only the I/O rank accesses the global array of the property, see
+     * scatterCartesianData(). This is a collective operation.
+     */
+    std::vector<int> localIntGridProperty(const std::string& name) const
+    {
+        const std::vector<int> noData;
+        const auto& props = eclState().get3DProperties();
+        return scatterCartesianData(isIORank() ? props.getIntGridProperty(name).getData() : noData);
+    }
+
+    /*!
+     * \brief Returns the values of a keyword of the ECL deck which specifies one value
+     *        per cell of the logically Cartesian grid for the elements of the local
+     *        process.
+     *
+     * The values are converted to SI units. Only the I/O rank accesses the keyword, see
+     * scatterCartesianData(). This is a collective operation.
+     */
+    std::vector<double> localDoubleKeywordData(const std::string& name) const
+    {
+        const std::vector<double> noData;
+        return scatterCartesianData(isIORank() ? deck().getKeyword(name).getSIDoubleData() : noData);
+    }
+
 private:
+    enum IoRankOnlyKeywordState {
+        notInDeck = 0,
+        parsedByAllRanks = 1,
+        skippedByOtherRanks = 2
+    };
+
+    static const std::vector<std::string>& ioRankOnlyKeywords_()
+    {
+        // the first four are grid properties, the others are SOLUTION keywords which are
+        // used for explicit initial conditions
+        static const std::vector<std::string> keywords = {
+            "PERMX", "PERMY", "PERMZ", "SWATINIT",
+            "PRESSURE", "SWAT", "SGAS", "RS", "RV"
+        };
+        return keywords;
+    }
+
+    // determine which of the I/O rank-only keywords are present in the deck and which of
+    // them can be skipped by the other processes. this is called on the I/O rank after
+    // the deck and the EclipseState have been created.
+    void determineIoRankOnlyKeywords_(std::vector<int>& state) const
+    {
+        static const unsigned numGridProperties = 4;
+
+        // grid properties can also be created or modified by operations on other
+        // properties. since the values of the other properties might depend on them,
+        // all processes parse the grid properties if any of these operations is used.
+        // The same applies to the J-function scaling of the capillary pressure which
+        // uses the permeabilities.
+        static const char *operationKeywords[] = {
+            "EQUALS", "COPY", "ADD", "MULTIPLY", "MINVALUE", "MAXVALUE",
+            "EQUALREG", "ADDREG", "MULTIREG", "COPYREG", "OPERATE", "OPERATER",
+            "JFUNC"
+        };
+        bool gridPropertiesModified = false;
+        for (const char *kw : operationKeywords)
+            gridPropertiesModified = gridPropertiesModified || deck_.hasKeyword(kw);
+
+        const auto& props = eclState_->get3DProperties();
+        const auto& kws = ioRankOnlyKeywords_();
+        for (unsigned kwIdx = 0; kwIdx < kws.size(); ++kwIdx) {
+            bool isGridProperty = kwIdx < numGridProperties;
+            bool inDeck =
+                isGridProperty
+                ? props.hasDeckDoubleGridProperty(kws[kwIdx])
+                : deck_.hasKeyword(kws[kwIdx]);
+
+            if (!inDeck)
+                state[kwIdx] = notInDeck;
+            else if (isGridProperty && gridPropertiesModified)
+                state[kwIdx] = parsedByAllRanks;
+            else
+                state[kwIdx] = skippedByOtherRanks;
+        }
+    }
+
     Implementation& asImp_()
     { return *static_cast<Implementation*>(this); }
 
     const Implementation& asImp_() const
     { return *static_cast<const Implementation*>(this); }
 
+    // returns the growth of the resident set since the last call and updates the
+    // reference value
+    static size_t residentSetGrowth_(double& rss)
+    {
+        double oldRss = rss;
+        rss = MemoryReport::residentSetSize();
+        return static_cast<size_t>(std::max(0.0, rss - oldRss));
+    }
+
     std::string caseName_;
     Opm::Deck deck_;
+    bool deckReleased_;
+    size_t deckBytes_;
+    size_t eclStateBytes_;
+    size_t gridBytes_;
     std::unique_ptr<Opm::EclipseState> eclState_;
+
+    // the I/O rank-only keywords which are present in the complete deck
+    std::set<std::string> ioRankOnlyKeywordsInDeck_;
 };
 
 } // namespace Ewoms
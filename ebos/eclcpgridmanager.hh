@@ -120,11 +120,15 @@ public:
      *
      * Depending on the implementation, subsequent accesses to the EQUIL grid lead to
      * crashes.
+     *
+     * For CpGrid, this frees very little memory: the EQUIL grid is a shallow copy of
+     * the simulation grid, which keeps its global view after it has been distributed.
      */
     void releaseEquilGrid()
     {
         delete equilGrid_;
         equilGrid_ = 0;
+        equilGridBytes_ = 0;
 
         delete equilCartesianIndexMapper_;
         equilCartesianIndexMapper_ = 0;
@@ -196,6 +200,13 @@ public:
                 delete globalTrans_;
                 globalTrans_ = nullptr;
             }
+
+            // the initial condition is computed by the I/O rank and the output is
+            // collected there as well, so only that process needs the EQUIL grid. note
+            // that this does not save much memory: the EQUIL grid only shares the global
+            // view of grid_, and grid_ keeps this view after the load balancing
+            if (!this->isIORank())
+                releaseEquilGrid();
         }
 #endif
 
@@ -227,12 +238,27 @@ public:
         globalTrans_ = nullptr;
     }
 
+    /*!
+     * \brief Add the memory used by the grid manager to a report.
+     *
+     * Like for the simulation grid, the memory of the EQUIL grid is estimated by the
+     * growth of the resident set during its creation.
+     */
+    void reportMemoryUsage(MemoryReport& report) const
+    {
+        ParentType::reportMemoryUsage(report);
+
+        report.add("EQUIL grid", equilGridBytes_);
+        report.add("global transmissibilities", globalTrans_ ? globalTrans_->memoryUsage() : 0);
+    }
+
 protected:
     void createGrids_()
     {
         const auto& gridProps = this->eclState().get3DProperties();
         const std::vector<double>& porv = gridProps.getDoubleGridProperty("PORV").getData();
 
+        globalTrans_ = nullptr;
         grid_ = new Dune::CpGrid();
         grid_->processEclipseFormat(this->eclState().getInputGrid(),
                                     /*isPeriodic=*/false,
@@ -246,14 +272,17 @@ protected:
         // the initial condition is calculated.
         // After loadbalance grid_ will contain a global and distribute view.
         // equilGrid_being a shallow copy only the global view.
+        double rss = MemoryReport::residentSetSize();
         equilGrid_ = new Dune::CpGrid(*grid_);
         equilCartesianIndexMapper_ = new CartesianIndexMapper(*equilGrid_);
+        equilGridBytes_ = static_cast<size_t>(std::max(0.0, MemoryReport::residentSetSize() - rss));
     }
 
     Grid* grid_;
     EquilGrid* equilGrid_;
     CartesianIndexMapper* cartesianIndexMapper_;
     CartesianIndexMapper* equilCartesianIndexMapper_;
+    size_t equilGridBytes_;
 
     EclTransmissibility<TypeTag>* globalTrans_;
     std::unordered_set<std::string> defunctWellNames_;
@@ -30,6 +30,8 @@
 
 #include <ewoms/common/propertysystem.hh>
 
+#include <dune/common/fvector.hh>
+
 #include <opm/material/fluidstates/CompositionalFluidState.hpp>
 #include <opm/material/fluidmatrixinteractions/EclMaterialLawManager.hpp>
 
@@ -40,6 +42,7 @@
 #include <opm/core/simulator/initStateEquil.hpp>
 #include <opm/core/simulator/BlackoilState.hpp>
 
+#include <memory>
 #include <vector>
 
 namespace Ewoms {
@@ -61,6 +64,11 @@ NEW_PROP_TAG(EnableSwatinit);
  * very much glued into the opm-core data structures, it should be reimplemented in the
  * medium to long term for some significant memory savings and less significant
  * performance improvements.
+ *
+ * Because the opm-core code requires the global grid, the equilibration is only done
+ * by the I/O rank. The resulting pressures, saturations and dissolution factors are
+ * then distributed to the processes which own the respective elements, so each process
+ * only stores the initial fluid states of its local elements.
  */
 template <class TypeTag>
 class EclEquilInitializer
@@ -85,6 +93,17 @@ class EclEquilInitializer
 
     enum { dimWorld = GridView::dimensionworld };
 
+    // the quantities which are computed by the equilibration for each cell
+    enum { oilPressureIdx = 0 };
+    enum { saturationIdx = oilPressureIdx + 1 };
+    enum { temperatureIdx = saturationIdx + numPhases };
+    enum { rsIdx = temperatureIdx + 1 };
+    enum { rvIdx = rsIdx + 1 };
+    enum { maxPcnwIdx = rvIdx + 1 };
+    enum { numEquilValues = maxPcnwIdx + 1 };
+
+    typedef Dune::FieldVector<double, numEquilValues> EquilValues;
+
 public:
     template <class EclMaterialLawManager>
     EclEquilInitializer(const Simulator& simulator,
@@ -93,112 +112,37 @@ public:
         : simulator_(simulator)
     {
         const auto& gridManager = simulator.gridManager();
-        const auto& deck = gridManager.deck();
-        const auto& eclState = gridManager.eclState();
-        const auto& equilGrid = gridManager.equilGrid();
-
-        unsigned numElems = gridManager.grid().size(0);
-        unsigned numEquilElems = gridManager.equilGrid().size(0);
-        unsigned numCartesianElems = gridManager.cartesianSize();
-        typedef typename GET_PROP_TYPE(TypeTag, FluidSystem) FluidSystem;
-        typedef Opm::ThreePhaseMaterialTraits<double,
-                                              /*wettingPhaseIdx=*/FluidSystem::waterPhaseIdx,
-                                              /*nonWettingPhaseIdx=*/FluidSystem::oilPhaseIdx,
-                                              /*gasPhaseIdx=*/FluidSystem::gasPhaseIdx> EquilTraits;
-
-        // create a separate instance of the material law manager just because opm-core
-        // only supports double as the type for scalars (but ebos may use float or quad)
-        std::vector<int> compressedToCartesianEquilElemIdx(numEquilElems);
-        std::vector<int> equilCartesianToCompressed( gridManager.equilCartesianSize(), -1 );
-
-        for (unsigned equilElemIdx = 0; equilElemIdx < numEquilElems; ++equilElemIdx)
-        {
-            unsigned int equilCartesianIdx = gridManager.equilCartesianIndex(equilElemIdx);
-            compressedToCartesianEquilElemIdx[equilElemIdx] = equilCartesianIdx;
-            equilCartesianToCompressed[ equilCartesianIdx ] = equilElemIdx;
-        }
-
-        auto equilMaterialLawManager =
-            std::make_shared<Opm::EclMaterialLawManager<EquilTraits> >();
-        equilMaterialLawManager->initFromDeck(deck, eclState, compressedToCartesianEquilElemIdx);
-
-        // create the data structures which are used by initStateEquil()
-        Opm::parameter::ParameterGroup tmpParam;
-        Opm::BlackoilPropertiesFromDeck opmBlackoilProps(
-            gridManager.deck(),
-            gridManager.eclState(),
-            equilMaterialLawManager,
-            Opm::UgGridHelpers::numCells(equilGrid),
-            Opm::UgGridHelpers::globalCell(equilGrid),
-            Opm::UgGridHelpers::cartDims(equilGrid),
-            tmpParam);
-
-        // initialize the boiler plate of opm-core the state structure.
-        const auto opmPhaseUsage = opmBlackoilProps.phaseUsage();
-        Opm::BlackoilState opmBlackoilState(numEquilElems,
-                                            /*numFaces=*/0, // we don't care here
-                                            opmPhaseUsage.num_phases);
 
-        // do the actual computation.
-        Opm::initStateEquil(equilGrid,
-                            opmBlackoilProps,
-                            gridManager.deck(),
-                            gridManager.eclState(),
-                            simulator.problem().gravity()[dimWorld - 1],
-                            opmBlackoilState,
-                            enableSwatinit);
+        // the equilibration is only done by the I/O rank: the result is distributed to
+        // the other processes afterwards. this means that only the I/O rank needs the
+        // EQUIL grid and the global arrays. (the other processes release the EQUIL grid
+        // after load balancing, but this only saves memory for grid managers which keep
+        // a separate EQUIL grid like the ALUGrid one. for CpGrid, the simulation grid
+        // keeps the global view which the EQUIL grid shares.)
+        std::vector<EquilValues> globalValues;
+        if (gridManager.isIORank())
+            computeEquilibrium_(globalValues, enableSwatinit);
 
-        std::vector<int> localToEquilIndex( numElems, -1 );
-        for( unsigned int elemIdx = 0; elemIdx < numElems; ++elemIdx )
-        {
-            const int cartesianIndex = gridManager.cartesianIndex( elemIdx );
-            assert( equilCartesianToCompressed[ cartesianIndex ] >= 0 );
-            localToEquilIndex[ elemIdx ] = equilCartesianToCompressed[ cartesianIndex ];
-        }
+        std::vector<EquilValues> localValues = gridManager.scatterCartesianData(globalValues);
+        globalValues.clear();
+        globalValues.shrink_to_fit();
 
         // copy the result into the array of initial fluid states
-        initialFluidStates_.resize(numCartesianElems);
+        unsigned numElems = gridManager.grid().size(0);
+        initialFluidStates_.resize(numElems);
         for (unsigned int elemIdx = 0; elemIdx < numElems; ++elemIdx) {
-            unsigned cartesianElemIdx = gridManager.cartesianIndex(elemIdx);
-            auto& fluidState = initialFluidStates_[cartesianElemIdx];
-
-            const unsigned int equilElemIdx = localToEquilIndex[ elemIdx ];
+            auto& fluidState = initialFluidStates_[elemIdx];
+            const auto& values = localValues[elemIdx];
 
             // get the PVT region index of the current element
             unsigned regionIdx = simulator_.problem().pvtRegionIndex(elemIdx);
 
             // set the phase saturations
-            for (unsigned phaseIdx = 0; phaseIdx < numPhases; ++phaseIdx) {
-                Scalar S;
-                if (!FluidSystem::phaseIsActive(phaseIdx))
-                    S = 0.0;
-                else {
-                    unsigned opmPhasePos = 10000;
-                    switch (phaseIdx) {
-                    case oilPhaseIdx:
-                        opmPhasePos = opmPhaseUsage.phase_pos[Opm::BlackoilPhases::Liquid];
-                        break;
-
-                    case gasPhaseIdx:
-                        opmPhasePos = opmPhaseUsage.phase_pos[Opm::BlackoilPhases::Vapour];
-                        break;
-
-                    case waterPhaseIdx:
-                        opmPhasePos = opmPhaseUsage.phase_pos[Opm::BlackoilPhases::Aqua];
-                        break;
-                    }
-                    S = opmBlackoilState.saturation()[equilElemIdx*opmPhaseUsage.num_phases
-                                                      + opmPhasePos];
-                }
-                fluidState.setSaturation(phaseIdx, S);
-            }
+            for (unsigned phaseIdx = 0; phaseIdx < numPhases; ++phaseIdx)
+                fluidState.setSaturation(phaseIdx, values[saturationIdx + phaseIdx]);
 
             // set the temperature
-            const auto& temperatureVector = opmBlackoilState.temperature();
-            Scalar T = FluidSystem::surfaceTemperature;
-            if (!temperatureVector.empty())
-                T = temperatureVector[equilElemIdx];
-            fluidState.setTemperature(T);
+            fluidState.setTemperature(values[temperatureIdx]);
 
             // set the phase pressures. the Opm::BlackoilState only provides the oil
             // phase pressure, so we need to calculate the other phases' pressures
@@ -206,7 +150,7 @@ public:
             Dune::FieldVector< Scalar, numPhases >  pC( 0 );
             const auto& matParams = simulator.problem().materialLawParams(elemIdx);
             MaterialLaw::capillaryPressures(pC, matParams, fluidState);
-            Scalar po = opmBlackoilState.pressure()[equilElemIdx];
+            Scalar po = values[oilPressureIdx];
             for (unsigned phaseIdx = 0; phaseIdx < numPhases; ++phaseIdx)
                 fluidState.setPressure(phaseIdx, po + (pC[phaseIdx] - pC[oilPhaseIdx]));
 
@@ -222,7 +166,7 @@ public:
             if (FluidSystem::enableDissolvedGas()) {
                 // for gas and oil we have to translate surface volumes to mole fractions
                 // before we can set the composition in the fluid state
-                Scalar Rs = opmBlackoilState.gasoilratio()[equilElemIdx];
+                Scalar Rs = values[rsIdx];
                 Scalar RsSat = FluidSystem::saturatedDissolutionFactor(fluidState, oilPhaseIdx, regionIdx);
 
                 if (Rs > RsSat)
@@ -238,7 +182,7 @@ public:
 
             // retrieve the surface volume of vaporized gas
             if (FluidSystem::enableVaporizedOil()) {
-                Scalar Rv = opmBlackoilState.rv()[equilElemIdx];
+                Scalar Rv = values[rvIdx];
                 Scalar RvSat = FluidSystem::saturatedDissolutionFactor(fluidState, gasPhaseIdx, regionIdx);
 
                 if (Rv > RvSat)
@@ -255,11 +199,9 @@ public:
             // deal with the changed pressure scaling due to SWATINIT if SWATINIT is
             // requested to be applied. this is quite hacky but hey it works!
             if (enableSwatinit) {
-                const auto& equilScalingPoints =
-                    equilMaterialLawManager->oilWaterScaledEpsPointsDrainage(equilElemIdx);
                 auto& scalingPoints =
                     materialLawManager.oilWaterScaledEpsPointsDrainage(elemIdx);
-                scalingPoints.setMaxPcnw(equilScalingPoints.maxPcnw());
+                scalingPoints.setMaxPcnw(values[maxPcnwIdx]);
             }
         }
     }
@@ -271,11 +213,105 @@ public:
      * This is supposed to correspond to hydrostatic conditions.
      */
     const ScalarFluidState& initialFluidState(unsigned elemIdx) const
+    { return initialFluidStates_[elemIdx]; }
+
+private:
+    // run the equilibration of opm-core on the EQUIL grid and store the result for each
+    // cell of the logically Cartesian grid. this is only called on the I/O rank.
+    void computeEquilibrium_(std::vector<EquilValues>& globalValues, bool enableSwatinit)
     {
         const auto& gridManager = simulator_.gridManager();
+        const auto& deck = gridManager.deck();
+        const auto& eclState = gridManager.eclState();
+        const auto& equilGrid = gridManager.equilGrid();
+
+        unsigned numEquilElems = equilGrid.size(0);
+        typedef Opm::ThreePhaseMaterialTraits<double,
+                                              /*wettingPhaseIdx=*/FluidSystem::waterPhaseIdx,
+                                              /*nonWettingPhaseIdx=*/FluidSystem::oilPhaseIdx,
+                                              /*gasPhaseIdx=*/FluidSystem::gasPhaseIdx> EquilTraits;
+
+        // create a separate instance of the material law manager just because opm-core
+        // only supports double as the type for scalars (but ebos may use float or quad)
+        std::vector<int> compressedToCartesianEquilElemIdx(numEquilElems);
+        for (unsigned equilElemIdx = 0; equilElemIdx < numEquilElems; ++equilElemIdx)
+            compressedToCartesianEquilElemIdx[equilElemIdx] =
+                gridManager.equilCartesianIndex(equilElemIdx);
 
-        unsigned cartesianElemIdx = gridManager.cartesianIndex(elemIdx);
-        return initialFluidStates_[cartesianElemIdx];
+        auto equilMaterialLawManager =
+            std::make_shared<Opm::EclMaterialLawManager<EquilTraits> >();
+        equilMaterialLawManager->initFromDeck(deck, eclState, compressedToCartesianEquilElemIdx);
+
+        // create the data structures which are used by initStateEquil()
+        Opm::parameter::ParameterGroup tmpParam;
+        Opm::BlackoilPropertiesFromDeck opmBlackoilProps(
+            deck,
+            eclState,
+            equilMaterialLawManager,
+            Opm::UgGridHelpers::numCells(equilGrid),
+            Opm::UgGridHelpers::globalCell(equilGrid),
+            Opm::UgGridHelpers::cartDims(equilGrid),
+            tmpParam);
+
+        // initialize the boiler plate of opm-core the state structure.
+        const auto opmPhaseUsage = opmBlackoilProps.phaseUsage();
+        Opm::BlackoilState opmBlackoilState(numEquilElems,
+                                            /*numFaces=*/0, // we don't care here
+                                            opmPhaseUsage.num_phases);
+
+        // do the actual computation.
+        Opm::initStateEquil(equilGrid,
+                            opmBlackoilProps,
+                            deck,
+                            eclState,
+                            simulator_.problem().gravity()[dimWorld - 1],
+                            opmBlackoilState,
+                            enableSwatinit);
+
+        // extract the quantities which are required to set up the fluid states. inactive
+        // cells are never requested by any process, so they are left at zero.
+        const auto& saturations = opmBlackoilState.saturation();
+        const auto& pressures = opmBlackoilState.pressure();
+        const auto& temperatures = opmBlackoilState.temperature();
+        globalValues.assign(gridManager.equilCartesianSize(), EquilValues(0.0));
+        for (unsigned equilElemIdx = 0; equilElemIdx < numEquilElems; ++equilElemIdx) {
+            auto& values = globalValues[compressedToCartesianEquilElemIdx[equilElemIdx]];
+
+            for (unsigned phaseIdx = 0; phaseIdx < numPhases; ++phaseIdx) {
+                if (!FluidSystem::phaseIsActive(phaseIdx))
+                    continue;
+
+                unsigned opmPhasePos = 10000;
+                switch (phaseIdx) {
+                case oilPhaseIdx:
+                    opmPhasePos = opmPhaseUsage.phase_pos[Opm::BlackoilPhases::Liquid];
+                    break;
+
+                case gasPhaseIdx:
+                    opmPhasePos = opmPhaseUsage.phase_pos[Opm::BlackoilPhases::Vapour];
+                    break;
+
+                case waterPhaseIdx:
+                    opmPhasePos = opmPhaseUsage.phase_pos[Opm::BlackoilPhases::Aqua];
+                    break;
+                }
+                values[saturationIdx + phaseIdx] =
+                    saturations[equilElemIdx*opmPhaseUsage.num_phases + opmPhasePos];
+            }
+
+            values[oilPressureIdx] = pressures[equilElemIdx];
+            values[temperatureIdx] =
+                temperatures.empty() ? FluidSystem::surfaceTemperature : temperatures[equilElemIdx];
+
+            if (FluidSystem::enableDissolvedGas())
+                values[rsIdx] = opmBlackoilState.gasoilratio()[equilElemIdx];
+            if (FluidSystem::enableVaporizedOil())
+                values[rvIdx] = opmBlackoilState.rv()[equilElemIdx];
+
+            if (enableSwatinit)
+                values[maxPcnwIdx] =
+                    equilMaterialLawManager->oilWaterScaledEpsPointsDrainage(equilElemIdx).maxPcnw();
+        }
     }
 
 protected:
@@ -31,6 +31,7 @@
 #include <ewoms/aux/baseauxiliarymodule.hh>
 #include <ewoms/common/propertysystem.hh>
 #include <ewoms/common/alignedallocator.hh>
+#include <ewoms/common/memoryusage.hh>
 
 #include <opm/material/fluidstates/CompositionalFluidState.hpp>
 #include <opm/material/densead/Evaluation.hpp>
@@ -425,8 +426,8 @@ public:
                     continue;
 
                 modelRate.setVolumetricRate(fluidState, phaseIdx, resvRates[phaseIdx]);
-                for (unsigned compIdx = 0; compIdx < numComponents; ++compIdx)
-                    q[compIdx] += modelRate[compIdx];
+                for (unsigned eqIdx = 0; eqIdx < numModelEq; ++eqIdx)
+                    q[eqIdx] += modelRate[eqIdx];
             }
 
             // then, we subtract the source rates for a undisturbed well.
@@ -436,8 +437,8 @@ public:
                     continue;
 
                 modelRate.setVolumetricRate(fluidState, phaseIdx, resvRates[phaseIdx]);
-                for (unsigned compIdx = 0; compIdx < numComponents; ++compIdx)
-                    q[compIdx] -= modelRate[compIdx];
+                for (unsigned eqIdx = 0; eqIdx < numModelEq; ++eqIdx)
+                    q[eqIdx] -= modelRate[eqIdx];
             }
 
             // and finally, we divide by the epsilon to get the derivative
@@ -446,10 +447,9 @@ public:
 
             // now we put this derivative into the right place in the Jacobian
             // matrix. This is a bit hacky because it assumes that the model uses a mass
-            // rate for each component as its first conservation equations, but we
+            // rate for each active component as its conservation equations, but we
             // require the black-oil model for now anyway, so this should not be too much
             // of a problem...
-            assert(numModelEq == numComponents);
             Opm::Valgrind::CheckDefined(q);
             auto& matrixEntry = matrix[gridDofIdx][wellGlobalDofIdx];
             matrixEntry = 0.0;
@@ -1134,6 +1134,19 @@ public:
         Opm::Valgrind::CheckDefined(q);
     }
 
+    /*!
+     * \brief Returns the number of bytes used by the well including the data of its
+     *        perforated degrees of freedom.
+     */
+    size_t memoryUsage() const
+    {
+        return
+            sizeof(*this)
+            + dynamicMemoryUsage(name_)
+            + dofVarsStore_.capacity()*sizeof(DofVariables)
+            + dynamicMemoryUsage(dofVariables_);
+    }
+
 protected:
     // compute the connection transmissibility factor based on the effective permeability
     // of a connection, the radius of the borehole and the skin factor.
@@ -239,6 +239,7 @@ class EclProblem : public GET_PROP_TYPE(TypeTag, BaseProblem)
     typedef typename GET_PROP_TYPE(TypeTag, GridView) GridView;
     typedef typename GET_PROP_TYPE(TypeTag, Stencil) Stencil;
     typedef typename GET_PROP_TYPE(TypeTag, FluidSystem) FluidSystem;
+    typedef typename GET_PROP_TYPE(TypeTag, Indices) Indices;
 
     // Grid and world dimension
     enum { dim = GridView::dimension };
@@ -632,6 +633,31 @@ public:
     const EclTransmissibility<TypeTag>& eclTransmissibilities() const
     { return transmissibilities_; }
 
+    /*!
+     * \brief Add the memory used by the problem to a report.
+     *
+     * The buffers of the output writers only exist while a report step is written and
+     * are thus not included.
+     */
+    void reportMemoryUsage(MemoryReport& report) const
+    {
+        ParentType::reportMemoryUsage(report);
+
+        report.add("transmissibilities", transmissibilities_.memoryUsage());
+        report.add("threshold pressures", thresholdPressures_.memoryUsage());
+        report.add("wells", wellManager_.memoryUsage());
+        report.add("pff dof data", pffDofData_.memoryUsage());
+
+        size_t elemBytes =
+            dynamicMemoryUsage(porosity_)
+            + dynamicMemoryUsage(elementCenterDepth_)
+            + dynamicMemoryUsage(pvtnum_)
+            + dynamicMemoryUsage(rockTableIdx_)
+            + rockParams_.capacity()*sizeof(RockParams)
+            + initialFluidStates_.capacity()*sizeof(ScalarFluidState);
+        report.add("problem element data", elemBytes);
+    }
+
     /*!
      * \copydoc BlackOilBaseProblem::thresholdPressure
      */
@@ -832,13 +858,15 @@ public:
         bool useThpres = deck.hasKeyword("THPRES") && numEquilRegions > 1;
         bool useSwatinit =
             GET_PROP_VALUE(TypeTag, EnableSwatinit) &&
-            eclState.get3DProperties().hasDeckDoubleGridProperty("SWATINIT");
+            this->simulator().gridManager().deckHasKeyword("SWATINIT");
 
         if (useThpres && useSwatinit)
             applySwatinit();
 
-        // release the memory of the EQUIL grid since it's no longer needed after this point
+        // release the memory of the EQUIL grid and of the raw deck since they are no
+        // longer needed after this point
         this->simulator().gridManager().releaseEquilGrid();
+        this->simulator().gridManager().releaseDeck();
 
         // the fluid states specifying the initial condition are also no longer required.
         initialFluidStates_.clear();
@@ -886,10 +914,8 @@ public:
     void applySwatinit()
     {
         const auto& deck = this->simulator().gridManager().deck();
-        const auto& eclState = this->simulator().gridManager().eclState();
-        const auto& deckProps = eclState.get3DProperties();
 
-        if (!deckProps.hasDeckDoubleGridProperty("SWATINIT"))
+        if (!this->simulator().gridManager().deckHasKeyword("SWATINIT"))
             return; // SWATINIT is not in the deck
         else if (!deck.hasKeyword("EQUIL"))
             // SWATINIT only applies if the initial solution is specified using the EQUIL
@@ -1027,54 +1053,65 @@ private:
     void updatePorosity_()
     {
         const auto& gridManager = this->simulator().gridManager();
-        const auto& eclState = gridManager.eclState();
-        const auto& eclGrid = eclState.getInputGrid();
-        const auto& props = eclState.get3DProperties();
 
-        size_t numDof = this->model().numGridDof();
+        // only the I/O rank accesses the global pore volumes. the other processes
+        // receive the values of their elements from it.
+        std::vector<double> cartPoreVolume;
+        if (gridManager.isIORank())
+            computeCartesianPoreVolume_(cartPoreVolume);
+        const std::vector<double> poreVolume = gridManager.scatterCartesianData(cartPoreVolume);
 
+        size_t numDof = this->model().numGridDof();
         porosity_.resize(numDof);
+        for (size_t dofIdx = 0; dofIdx < numDof; ++ dofIdx) {
+            // we define the porosity as the accumulated pore volume divided by the
+            // geometric volume of the element. Note that -- in pathetic cases -- it can
+            // be larger than 1.0!
+            Scalar dofVolume = this->simulator().model().dofTotalVolume(dofIdx);
+            assert(dofVolume > 0.0);
+            porosity_[dofIdx] = poreVolume[dofIdx]/dofVolume;
+        }
+    }
+
+    void computeCartesianPoreVolume_(std::vector<double>& cartPoreVolume) const
+    {
+        const auto& eclState = this->simulator().gridManager().eclState();
+        const auto& eclGrid = eclState.getInputGrid();
+        const auto& props = eclState.get3DProperties();
 
         const std::vector<double>& porvData =
             props.getDoubleGridProperty("PORV").getData();
+        cartPoreVolume = porvData;
+
+        // sum up the pore volume of the active cell and all inactive ones above it
+        // which were disabled due to their pore volume being too small
+        if (eclGrid.getMinpvMode() != Opm::MinpvMode::ModeEnum::OpmFIL)
+            return;
+
         const std::vector<int>& actnumData =
             props.getIntGridProperty("ACTNUM").getData();
 
         int nx = eclGrid.getNX();
         int ny = eclGrid.getNY();
-        for (size_t dofIdx = 0; dofIdx < numDof; ++ dofIdx) {
-            unsigned cartElemIdx = gridManager.cartesianIndex(dofIdx);
-            Scalar poreVolume = porvData[cartElemIdx];
-
-            // sum up the pore volume of the active cell and all inactive ones above it
-            // which were disabled due to their pore volume being too small
-            if (eclGrid.getMinpvMode() == Opm::MinpvMode::ModeEnum::OpmFIL) {
-                Scalar minPvValue = eclGrid.getMinpvValue();
-                for (int aboveElemCartIdx = static_cast<int>(cartElemIdx) - nx*ny;
-                     aboveElemCartIdx >= 0;
-                     aboveElemCartIdx -= nx*ny)
-                {
-                    if (porvData[aboveElemCartIdx] >= minPvValue)
-                        // the cartesian element above exhibits a pore volume which larger or
-                        // equal to the minimum one
-                        break;
-
-                    Scalar aboveElemVolume = eclGrid.getCellVolume(aboveElemCartIdx);
-                    if (actnumData[aboveElemCartIdx] == 0 && aboveElemVolume > 1e-3)
-                        // stop at explicitly disabled elements, but only if their volume is
-                        // greater than 10^-3 m^3
-                        break;
-
-                    poreVolume += porvData[aboveElemCartIdx];
-                }
+        Scalar minPvValue = eclGrid.getMinpvValue();
+        for (size_t cartElemIdx = 0; cartElemIdx < porvData.size(); ++ cartElemIdx) {
+            for (int aboveElemCartIdx = static_cast<int>(cartElemIdx) - nx*ny;
+                 aboveElemCartIdx >= 0;
+                 aboveElemCartIdx -= nx*ny)
+            {
+                if (porvData[aboveElemCartIdx] >= minPvValue)
+                    // the cartesian element above exhibits a pore volume which larger or
+                    // equal to the minimum one
+                    break;
+
+                Scalar aboveElemVolume = eclGrid.getCellVolume(aboveElemCartIdx);
+                if (actnumData[aboveElemCartIdx] == 0 && aboveElemVolume > 1e-3)
+                    // stop at explicitly disabled elements, but only if their volume is
+                    // greater than 10^-3 m^3
+                    break;
+
+                cartPoreVolume[cartElemIdx] += porvData[aboveElemCartIdx];
             }
-
-            // we define the porosity as the accumulated pore volume divided by the
-            // geometric volume of the element. Note that -- in pathetic cases -- it can
-            // be larger than 1.0!
-            Scalar dofVolume = this->simulator().model().dofTotalVolume(dofIdx);
-            assert(dofVolume > 0.0);
-            porosity_[dofIdx] = poreVolume/dofVolume;
         }
     }
 
@@ -1084,6 +1121,28 @@ private:
         const auto& eclState = this->simulator().gridManager().eclState();
 
         FluidSystem::initFromDeck(deck, eclState);
+
+        // the three-phase model deals with two-phase decks at run time, but if the model
+        // was instantiated for two phases, the phases of the deck must match. the
+        // instantiation is chosen by scanning the RUNSPEC section of the deck before the
+        // simulator is started, so this only fails if the scan and the parser disagree.
+        if (Indices::numPhases != 3
+            && (FluidSystem::phaseIsActive(waterPhaseIdx) != Indices::waterEnabled
+                || FluidSystem::phaseIsActive(gasPhaseIdx) != Indices::gasEnabled
+                || !FluidSystem::phaseIsActive(oilPhaseIdx)))
+        {
+            OPM_THROW(std::runtime_error,
+                      "The deck specifies the phases"
+                      << (FluidSystem::phaseIsActive(waterPhaseIdx)?" WATER":"")
+                      << (FluidSystem::phaseIsActive(oilPhaseIdx)?" OIL":"")
+                      << (FluidSystem::phaseIsActive(gasPhaseIdx)?" GAS":"")
+                      << ", but the simulator was instantiated for the phases"
+                      << (Indices::waterEnabled?" WATER":"")
+                      << " OIL"
+                      << (Indices::gasEnabled?" GAS":"")
+                      << ". The RUNSPEC section of the deck was not interpreted "
+                      << "correctly when the model was selected.");
+        }
    }
 
     void readInitialCondition_()
@@ -1105,7 +1164,7 @@ private:
         bool useThpres = deck.hasKeyword("THPRES") && numEquilRegions > 1;
         bool useSwatinit =
             GET_PROP_VALUE(TypeTag, EnableSwatinit) &&
-            eclState.get3DProperties().hasDeckDoubleGridProperty("SWATINIT");
+            this->simulator().gridManager().deckHasKeyword("SWATINIT");
 
         // initial condition corresponds to hydrostatic conditions. The SWATINIT keyword
         // can be considered here directly if threshold pressures are disabled.
@@ -1130,32 +1189,30 @@ private:
     void readExplicitInitialCondition_()
     {
         const auto& gridManager = this->simulator().gridManager();
-        const auto& deck = gridManager.deck();
-        const auto& eclState = gridManager.eclState();
 
         // since the values specified in the deck do not need to be consistent, we use an
         // initial condition that conserves the total mass specified by these values.
         useMassConservativeInitialCondition_ = true;
 
         // make sure all required quantities are enables
-        if (FluidSystem::phaseIsActive(waterPhaseIdx) && !deck.hasKeyword("SWAT"))
+        if (FluidSystem::phaseIsActive(waterPhaseIdx) && !gridManager.deckHasKeyword("SWAT"))
             OPM_THROW(std::runtime_error,
                       "The ECL input file requires the presence of the SWAT keyword if "
                       "the water phase is active");
-        if (FluidSystem::phaseIsActive(gasPhaseIdx) && !deck.hasKeyword("SGAS"))
+        if (FluidSystem::phaseIsActive(gasPhaseIdx) && !gridManager.deckHasKeyword("SGAS"))
             OPM_THROW(std::runtime_error,
                       "The ECL input file requires the presence of the SGAS keyword if "
                       "the gas phase is active");
 
-        if (!deck.hasKeyword("PRESSURE"))
+        if (!gridManager.deckHasKeyword("PRESSURE"))
              OPM_THROW(std::runtime_error,
                       "The ECL input file requires the presence of the PRESSURE "
                       "keyword if the model is initialized explicitly");
-        if (FluidSystem::enableDissolvedGas() && !deck.hasKeyword("RS"))
+        if (FluidSystem::enableDissolvedGas() && !gridManager.deckHasKeyword("RS"))
             OPM_THROW(std::runtime_error,
                       "The ECL input file requires the RS keyword to be present if"
                       " dissolved gas is enabled");
-        if (FluidSystem::enableVaporizedOil() && !deck.hasKeyword("RV"))
+        if (FluidSystem::enableVaporizedOil() && !gridManager.deckHasKeyword("RV"))
             OPM_THROW(std::runtime_error,
                       "The ECL input file requires the RV keyword to be present if"
                       " vaporized oil is enabled");
@@ -1164,57 +1221,40 @@ private:
 
         initialFluidStates_.resize(numDof);
 
-        const auto& cartSize = this->simulator().gridManager().cartesianDimensions();
-        size_t numCartesianCells = cartSize[0] * cartSize[1] * cartSize[2];
-
+        // only the I/O rank accesses the global arrays of the deck. the other processes
+        // receive the values of their elements from it.
         std::vector<double> waterSaturationData;
         if (FluidSystem::phaseIsActive(waterPhaseIdx))
-            waterSaturationData = deck.getKeyword("SWAT").getSIDoubleData();
+            waterSaturationData = gridManager.localDoubleKeywordData("SWAT");
         else
-            waterSaturationData.resize(numCartesianCells, 0.0);
+            waterSaturationData.resize(numDof, 0.0);
 
         std::vector<double> gasSaturationData;
         if (FluidSystem::phaseIsActive(gasPhaseIdx))
-            gasSaturationData = deck.getKeyword("SGAS").getSIDoubleData();
+            gasSaturationData = gridManager.localDoubleKeywordData("SGAS");
         else
-            gasSaturationData.resize(numCartesianCells, 0.0);
+            gasSaturationData.resize(numDof, 0.0);
 
-        const std::vector<double>& pressureData =
-            deck.getKeyword("PRESSURE").getSIDoubleData();
-        const std::vector<double> *rsData = 0;
+        const std::vector<double> pressureData = gridManager.localDoubleKeywordData("PRESSURE");
+        std::vector<double> rsData;
         if (FluidSystem::enableDissolvedGas())
-            rsData = &deck.getKeyword("RS").getSIDoubleData();
-        const std::vector<double> *rvData = 0;
+            rsData = gridManager.localDoubleKeywordData("RS");
+        std::vector<double> rvData;
         if (FluidSystem::enableVaporizedOil())
-            rvData = &deck.getKeyword("RV").getSIDoubleData();
+            rvData = gridManager.localDoubleKeywordData("RV");
         // initial reservoir temperature
-        const std::vector<double>& tempiData =
-            eclState.get3DProperties().getDoubleGridProperty("TEMPI").getData();
-
-        // make sure that the size of the data arrays is correct
-#ifndef NDEBUG
-        assert(waterSaturationData.size() == numCartesianCells);
-        assert(gasSaturationData.size() == numCartesianCells);
-        assert(pressureData.size() == numCartesianCells);
-        if (FluidSystem::enableDissolvedGas())
-            assert(rsData->size() == numCartesianCells);
-        if (FluidSystem::enableVaporizedOil())
-            assert(rvData->size() == numCartesianCells);
-#endif
+        const std::vector<double> tempiData = gridManager.localDoubleGridProperty("TEMPI");
 
         // calculate the initial fluid states
         for (size_t dofIdx = 0; dofIdx < numDof; ++dofIdx) {
             auto& dofFluidState = initialFluidStates_[dofIdx];
 
             int pvtRegionIdx = pvtRegionIndex(dofIdx);
-            size_t cartesianDofIdx = gridManager.cartesianIndex(dofIdx);
-            assert(0 <= cartesianDofIdx);
-            assert(cartesianDofIdx <= numCartesianCells);
 
             //////
             // set temperature
             //////
-            Scalar temperature = tempiData[cartesianDofIdx];
+            Scalar temperature = tempiData[dofIdx];
             if (!std::isfinite(temperature) || temperature <= 0)
                 temperature = FluidSystem::surfaceTemperature;
             dofFluidState.setTemperature(temperature);
@@ -1223,18 +1263,18 @@ private:
             // set saturations
             //////
             dofFluidState.setSaturation(FluidSystem::waterPhaseIdx,
-                                        waterSaturationData[cartesianDofIdx]);
+                                        waterSaturationData[dofIdx]);
             dofFluidState.setSaturation(FluidSystem::gasPhaseIdx,
-                                        gasSaturationData[cartesianDofIdx]);
+                                        gasSaturationData[dofIdx]);
             dofFluidState.setSaturation(FluidSystem::oilPhaseIdx,
                                         1.0
-                                        - waterSaturationData[cartesianDofIdx]
-                                        - gasSaturationData[cartesianDofIdx]);
+                                        - waterSaturationData[dofIdx]
+                                        - gasSaturationData[dofIdx]);
 
             //////
             // set phase pressures
             //////
-            Scalar oilPressure = pressureData[cartesianDofIdx];
+            Scalar oilPressure = pressureData[dofIdx];
 
             // this assumes that capillary pressures only depend on the phase saturations
             // and possibly on temperature. (this is always the case for ECL problems.)
@@ -1262,7 +1302,7 @@ private:
 
             if (FluidSystem::enableDissolvedGas()) {
                 Scalar RsSat = FluidSystem::saturatedDissolutionFactor(dofFluidState, oilPhaseIdx, pvtRegionIdx);
-                Scalar RsReal = (*rsData)[cartesianDofIdx];
+                Scalar RsReal = rsData[dofIdx];
 
                 if (RsReal > RsSat) {
                     std::array<int, 3> ijk;
@@ -1287,7 +1327,7 @@ private:
 
             if (FluidSystem::enableVaporizedOil()) {
                 Scalar RvSat = FluidSystem::saturatedDissolutionFactor(dofFluidState, gasPhaseIdx, pvtRegionIdx);
-                Scalar RvReal = (*rvData)[cartesianDofIdx];
+                Scalar RvReal = rvData[dofIdx];
 
                 if (RvReal > RvSat) {
                     std::array<int, 3> ijk;
@@ -1339,21 +1379,16 @@ private:
 
     void updatePvtnum_()
     {
-        const auto& eclState = this->simulator().gridManager().eclState();
-        const auto& eclProps = eclState.get3DProperties();
+        const auto& gridManager = this->simulator().gridManager();
+        const auto& eclProps = gridManager.eclState().get3DProperties();
 
         if (!eclProps.hasDeckIntGridProperty("PVTNUM"))
             return;
 
-        const auto& pvtnumData = eclProps.getIntGridProperty("PVTNUM").getData();
-        const auto& gridManager = this->simulator().gridManager();
-
-        unsigned numElems = gridManager.gridView().size(/*codim=*/0);
-        pvtnum_.resize(numElems);
-        for (unsigned elemIdx = 0; elemIdx < numElems; ++elemIdx) {
-            unsigned cartElemIdx = gridManager.cartesianIndex(elemIdx);
-            pvtnum_[elemIdx] = pvtnumData[cartElemIdx] - 1;
-        }
+        const std::vector<int> pvtnumData = gridManager.localIntGridProperty("PVTNUM");
+        pvtnum_.resize(pvtnumData.size());
+        for (unsigned elemIdx = 0; elemIdx < pvtnumData.size(); ++elemIdx)
+            pvtnum_[elemIdx] = pvtnumData[elemIdx] - 1;
     }
 
     struct PffDofData_
@@ -46,7 +46,10 @@
 
 #include <boost/algorithm/string.hpp>
 
+#include <map>
+#include <set>
 #include <string>
+#include <vector>
 
 namespace Ewoms {
 namespace Properties {
@@ -74,24 +77,24 @@ class EclSummaryWriter
     typedef Ewoms::ErtSummary<TypeTag> ErtSummary;
 
 
-    struct ErtWellInfo {
-        smspec_node_type* wbhpErtHandle;
-        smspec_node_type* wthpErtHandle;
-        smspec_node_type* wgorErtHandle;
-        smspec_node_type* wwirErtHandle;
-        smspec_node_type* wgirErtHandle;
-        smspec_node_type* woirErtHandle;
-        smspec_node_type* wwprErtHandle;
-        smspec_node_type* wgprErtHandle;
-        smspec_node_type* woprErtHandle;
-        smspec_node_type* wwitErtHandle;
-        smspec_node_type* wgitErtHandle;
-        smspec_node_type* woitErtHandle;
-        smspec_node_type* wwptErtHandle;
-        smspec_node_type* wgptErtHandle;
-        smspec_node_type* woptErtHandle;
+    // the well quantities which can be written to the summary file
+    enum WellQuantity {
+        wbhp, wthp, wgor,
+        wwir, wgir, woir,
+        wwpr, wgpr, wopr,
+        wwit, wgit, woit,
+        wwpt, wgpt, wopt,
+        numWellQuantities
     };
 
+    // the position of a well quantity in the parameter vector of the summary file
+    struct SummarySlot {
+        WellQuantity quantity;
+        int paramsIdx;
+    };
+
+    typedef std::vector<SummarySlot> WellSlots;
+
     static const unsigned waterPhaseIdx = FluidSystem::waterPhaseIdx;
     static const unsigned gasPhaseIdx = FluidSystem::gasPhaseIdx;
     static const unsigned oilPhaseIdx = FluidSystem::oilPhaseIdx;
@@ -119,6 +122,8 @@ public:
 
     /*!
      * \brief Adds an entry to the summary file.
+     *
+     * Only the record of the new time step is appended to the summary file.
      */
     void write(const WellManager& wellsManager, bool isInitial = false)
     {
@@ -134,353 +139,164 @@ public:
         typedef EclDeckUnits<TypeTag> DeckUnits;
         const DeckUnits& deckUnits = simulator_.problem().deckUnits();
 
-        // add the well quantities
-        for (unsigned wellIdx = 0; wellIdx < wellsManager.numWells(); ++wellIdx) {
-            const auto& well = wellsManager.well(wellIdx);
-            const auto& summaryInfo = ertWellInfo_.at(well->name());
-
-            if (writeWbhp_()) {
-                Scalar bhpPascal = well->bottomHolePressure();
-                ecl_sum_tstep_iset(ertSumTimeStep.ertHandle(),
-                                   smspec_node_get_params_index(summaryInfo.wbhpErtHandle),
-                                   deckUnits.siToDeck(bhpPascal, DeckUnits::pressure));
-            }
-
-            if (writeWthp_()) {
-                Scalar thpPascal = well->tubingHeadPressure();
-                ecl_sum_tstep_iset(ertSumTimeStep.ertHandle(),
-                                   smspec_node_get_params_index(summaryInfo.wthpErtHandle),
-                                   deckUnits.siToDeck(thpPascal, DeckUnits::pressure));
-            }
-
-            if (writeWgor_()) {
-                // since I'm usure what the gas-to-oil ratio exactly expresses, I just
-                // assume "volume of gas at standard conditions divided by volume of oil
-                // at standard conditions". Mass-based measures would be drastically
-                // different. (As will be if imperial units are used where the volume of
-                // gas is MCF and the volume of oil is bbl)
-                Scalar gasRate = std::abs(well->surfaceRate(gasPhaseIdx));
-                Scalar oilRate = std::abs(well->surfaceRate(oilPhaseIdx));
-
-                Scalar gasToOilRatio = 0;
-                if (std::abs(oilRate) > 1e-3)
-                    gasToOilRatio = gasRate/oilRate;
-
-                ecl_sum_tstep_iset(ertSumTimeStep.ertHandle(),
-                                   smspec_node_get_params_index(summaryInfo.wgorErtHandle),
-                                   deckUnits.siToDeck(gasToOilRatio, DeckUnits::gasOilRatio));
-            }
-
-            //////////
-            // injection surface rates
-            if (writeWwir_()) {
-                Scalar ratePerSecond = std::max<Scalar>(0.0, well->surfaceRate(waterPhaseIdx));
-                ecl_sum_tstep_iset(ertSumTimeStep.ertHandle(),
-                                   smspec_node_get_params_index(summaryInfo.wwirErtHandle),
-                                   deckUnits.siToDeck(ratePerSecond, DeckUnits::liquidRate));
-            }
-
-            if (writeWgir_()) {
-                Scalar ratePerSecond = std::max<Scalar>(0.0, well->surfaceRate(gasPhaseIdx));
-                ecl_sum_tstep_iset(ertSumTimeStep.ertHandle(),
-                                   smspec_node_get_params_index(summaryInfo.wgirErtHandle),
-                                   deckUnits.siToDeck(ratePerSecond, DeckUnits::gasRate));
-            }
-
-            if (writeWoir_()) {
-                Scalar ratePerSecond = std::max<Scalar>(0.0, well->surfaceRate(oilPhaseIdx));
-                ecl_sum_tstep_iset(ertSumTimeStep.ertHandle(),
-                                   smspec_node_get_params_index(summaryInfo.woirErtHandle),
-                                   deckUnits.siToDeck(ratePerSecond, DeckUnits::liquidRate));
-            }
-            //////////
-
-            //////////
-            // total injected surface volume
-            if (writeWwit_()) {
-                Scalar totalVolume = wellsManager.totalInjectedVolume(well->name(), waterPhaseIdx);
-                ecl_sum_tstep_iset(ertSumTimeStep.ertHandle(),
-                                   smspec_node_get_params_index(summaryInfo.wwitErtHandle),
-                                   deckUnits.siToDeck(totalVolume, DeckUnits::liquidSurfaceVolume));
-            }
-
-            if (writeWgit_()) {
-                Scalar totalVolume = wellsManager.totalInjectedVolume(well->name(), gasPhaseIdx);
-                ecl_sum_tstep_iset(ertSumTimeStep.ertHandle(),
-                                   smspec_node_get_params_index(summaryInfo.wgitErtHandle),
-                                   deckUnits.siToDeck(totalVolume, DeckUnits::gasSurfaceVolume));
-            }
-
-            if (writeWoit_()) {
-                Scalar totalVolume = wellsManager.totalInjectedVolume(well->name(), oilPhaseIdx);
-                ecl_sum_tstep_iset(ertSumTimeStep.ertHandle(),
-                                   smspec_node_get_params_index(summaryInfo.woitErtHandle),
-                                   deckUnits.siToDeck(totalVolume, DeckUnits::liquidSurfaceVolume));
-            }
-            //////////
-
-            //////////
-            // production surface rates
-            if (writeWwpr_()) {
-                Scalar ratePerSecond = std::max<Scalar>(0.0, -well->surfaceRate(waterPhaseIdx));
-                ecl_sum_tstep_iset(ertSumTimeStep.ertHandle(),
-                                   smspec_node_get_params_index(summaryInfo.wwprErtHandle),
-                                   deckUnits.siToDeck(ratePerSecond, DeckUnits::liquidRate));
-            }
-
-            if (writeWgpr_()) {
-                Scalar ratePerSecond = std::max<Scalar>(0.0, -well->surfaceRate(gasPhaseIdx));
-                ecl_sum_tstep_iset(ertSumTimeStep.ertHandle(),
-                                   smspec_node_get_params_index(summaryInfo.wgprErtHandle),
-                                   deckUnits.siToDeck(ratePerSecond, DeckUnits::gasRate));
-            }
-
-            if (writeWopr_()) {
-                Scalar ratePerSecond = std::max<Scalar>(0.0, -well->surfaceRate(oilPhaseIdx));
-                ecl_sum_tstep_iset(ertSumTimeStep.ertHandle(),
-                                   smspec_node_get_params_index(summaryInfo.woprErtHandle),
-                                   deckUnits.siToDeck(ratePerSecond, DeckUnits::liquidRate));
-            }
-            //////////
-
-            //////////
-            // total producted surface volume
-            if (writeWwpt_()) {
-                Scalar totalVolume = wellsManager.totalProducedVolume(well->name(), waterPhaseIdx);
-                ecl_sum_tstep_iset(ertSumTimeStep.ertHandle(),
-                                   smspec_node_get_params_index(summaryInfo.wwptErtHandle),
-                                   deckUnits.siToDeck(totalVolume, DeckUnits::liquidSurfaceVolume));
-            }
+        // the slot table is indexed by the well index of the well manager. since
+        // wells may be added during the simulation, it needs to be updated if the
+        // number of wells changes
+        if (wellSlotsByIdx_.size() != wellsManager.numWells())
+            updateWellSlotsByIdx_(wellsManager);
 
-            if (writeWgpt_()) {
-                Scalar totalVolume = wellsManager.totalProducedVolume(well->name(), gasPhaseIdx);
-                ecl_sum_tstep_iset(ertSumTimeStep.ertHandle(),
-                                   smspec_node_get_params_index(summaryInfo.wgptErtHandle),
-                                   deckUnits.siToDeck(totalVolume, DeckUnits::gasSurfaceVolume));
-            }
+        Scalar values[numWellQuantities];
+        for (unsigned wellIdx = 0; wellIdx < wellsManager.numWells(); ++wellIdx) {
+            const WellSlots& slots = *wellSlotsByIdx_[wellIdx];
+            if (slots.empty())
+                continue;
 
-            if (writeWopt_()) {
-                Scalar totalVolume = wellsManager.totalProducedVolume(well->name(), oilPhaseIdx);
+            computeWellQuantities_(values, wellsManager, wellIdx, deckUnits);
+            for (const auto& slot : slots)
                 ecl_sum_tstep_iset(ertSumTimeStep.ertHandle(),
-                                   smspec_node_get_params_index(summaryInfo.woptErtHandle),
-                                   deckUnits.siToDeck(totalVolume, DeckUnits::liquidSurfaceVolume));
-            }
-            //////////
+                                   slot.paramsIdx,
+                                   static_cast<float>(values[slot.quantity]));
         }
 
-        // write the _complete_ summary file!
-        ecl_sum_fwrite(ertSummary_.ertHandle());
+        // append the new time step to the summary file
+        ertSummary_.appendTimeStep(ertSumTimeStep.ertHandle(), reportIdx);
     }
 
 private:
     static bool enableEclSummaryOutput_()
     { return EWOMS_GET_PARAM(TypeTag, bool, EnableEclSummaryOutput); }
 
-    bool writeWbhp_() const
-    { return summaryKeywords_.count("WBHP") > 0; }
-
-    bool writeWthp_() const
-    { return summaryKeywords_.count("WTHP") > 0; }
-
-    // gas-oil ratio
-    bool writeWgor_() const
-    { return summaryKeywords_.count("WGOR") > 0; }
-
-    // write each well's current surface water injection rate
-    bool writeWwir_() const
-    { return summaryKeywords_.count("WWIR") > 0; }
-
-    // write each well's current surface gas injection rate
-    bool writeWgir_() const
-    { return summaryKeywords_.count("WGIR") > 0; }
-
-    // write each well's current surface oil injection rate
-    bool writeWoir_() const
-    { return summaryKeywords_.count("WOIR") > 0; }
-
-    // write each well's current surface water production rate
-    bool writeWwpr_() const
-    { return summaryKeywords_.count("WWPR") > 0; }
-
-    // write each well's current surface gas production rate
-    bool writeWgpr_() const
-    { return summaryKeywords_.count("WGPR") > 0; }
-
-    // write each well's current surface oil production rate
-    bool writeWopr_() const
-    { return summaryKeywords_.count("WOPR") > 0; }
-
-    // write each well's current surface water injection total
-    bool writeWwit_() const
-    { return summaryKeywords_.count("WWIT") > 0; }
-
-    // write each well's current surface gas injection total
-    bool writeWgit_() const
-    { return summaryKeywords_.count("WGIT") > 0; }
+    // calculate all quantities of a well which can be written to the summary file in
+    // units of the deck
+    template <class DeckUnits>
+    void computeWellQuantities_(Scalar *values,
+                                const WellManager& wellsManager,
+                                unsigned wellIdx,
+                                const DeckUnits& deckUnits) const
+    {
+        const auto& well = wellsManager.well(wellIdx);
+        const std::string& wellName = well->name();
+
+        values[wbhp] = deckUnits.siToDeck(well->bottomHolePressure(), DeckUnits::pressure);
+        values[wthp] = deckUnits.siToDeck(well->tubingHeadPressure(), DeckUnits::pressure);
+
+        // since I'm usure what the gas-to-oil ratio exactly expresses, I just
+        // assume "volume of gas at standard conditions divided by volume of oil
+        // at standard conditions". Mass-based measures would be drastically
+        // different. (As will be if imperial units are used where the volume of
+        // gas is MCF and the volume of oil is bbl)
+        Scalar gasRate = std::abs(well->surfaceRate(gasPhaseIdx));
+        Scalar oilRate = std::abs(well->surfaceRate(oilPhaseIdx));
+        Scalar gasToOilRatio = 0;
+        if (std::abs(oilRate) > 1e-3)
+            gasToOilRatio = gasRate/oilRate;
+        values[wgor] = deckUnits.siToDeck(gasToOilRatio, DeckUnits::gasOilRatio);
+
+        // injection surface rates
+        values[wwir] = deckUnits.siToDeck(std::max<Scalar>(0.0, well->surfaceRate(waterPhaseIdx)),
+                                          DeckUnits::liquidRate);
+        values[wgir] = deckUnits.siToDeck(std::max<Scalar>(0.0, well->surfaceRate(gasPhaseIdx)),
+                                          DeckUnits::gasRate);
+        values[woir] = deckUnits.siToDeck(std::max<Scalar>(0.0, well->surfaceRate(oilPhaseIdx)),
+                                          DeckUnits::liquidRate);
+
+        // production surface rates
+        values[wwpr] = deckUnits.siToDeck(std::max<Scalar>(0.0, -well->surfaceRate(waterPhaseIdx)),
+                                          DeckUnits::liquidRate);
+        values[wgpr] = deckUnits.siToDeck(std::max<Scalar>(0.0, -well->surfaceRate(gasPhaseIdx)),
+                                          DeckUnits::gasRate);
+        values[wopr] = deckUnits.siToDeck(std::max<Scalar>(0.0, -well->surfaceRate(oilPhaseIdx)),
+                                          DeckUnits::liquidRate);
+
+        // total injected surface volume
+        values[wwit] = deckUnits.siToDeck(wellsManager.totalInjectedVolume(wellName, waterPhaseIdx),
+                                          DeckUnits::liquidSurfaceVolume);
+        values[wgit] = deckUnits.siToDeck(wellsManager.totalInjectedVolume(wellName, gasPhaseIdx),
+                                          DeckUnits::gasSurfaceVolume);
+        values[woit] = deckUnits.siToDeck(wellsManager.totalInjectedVolume(wellName, oilPhaseIdx),
+                                          DeckUnits::liquidSurfaceVolume);
+
+        // total produced surface volume
+        values[wwpt] = deckUnits.siToDeck(wellsManager.totalProducedVolume(wellName, waterPhaseIdx),
+                                          DeckUnits::liquidSurfaceVolume);
+        values[wgpt] = deckUnits.siToDeck(wellsManager.totalProducedVolume(wellName, gasPhaseIdx),
+                                          DeckUnits::gasSurfaceVolume);
+        values[wopt] = deckUnits.siToDeck(wellsManager.totalProducedVolume(wellName, oilPhaseIdx),
+                                          DeckUnits::liquidSurfaceVolume);
+    }
 
-    // write each well's current surface oil injection total
-    bool writeWoit_() const
-    { return summaryKeywords_.count("WOIT") > 0; }
+    void updateWellSlotsByIdx_(const WellManager& wellsManager)
+    {
+        static const WellSlots noSlots;
 
-    // write each well's current surface water production total
-    bool writeWwpt_() const
-    { return summaryKeywords_.count("WWPT") > 0; }
+        wellSlotsByIdx_.resize(wellsManager.numWells());
+        for (unsigned wellIdx = 0; wellIdx < wellsManager.numWells(); ++wellIdx) {
+            const auto& slotIt = wellSlots_.find(wellsManager.well(wellIdx)->name());
+            if (slotIt == wellSlots_.end())
+                wellSlotsByIdx_[wellIdx] = &noSlots;
+            else
+                wellSlotsByIdx_[wellIdx] = &slotIt->second;
+        }
+    }
 
-    // write each well's current surface gas production total
-    bool writeWgpt_() const
-    { return summaryKeywords_.count("WGPT") > 0; }
+    // register a summary variable of a well with ERT and remember its slot
+    void addWellVariable_(WellSlots& slots,
+                          WellQuantity quantity,
+                          const std::string& keyword,
+                          const std::string& wellName,
+                          const char *unit)
+    {
+        if (summaryKeywords_.count(keyword) == 0)
+            return;
 
-    // write each well's current surface oil production total
-    bool writeWopt_() const
-    { return summaryKeywords_.count("WOPT") > 0; }
+        smspec_node_type* ertHandle =
+            ecl_sum_add_var(ertSummary_.ertHandle(),
+                            keyword.c_str(),
+                            wellName.c_str(),
+                            /*num=*/0,
+                            unit,
+                            /*defaultValue=*/0.0);
+
+        SummarySlot slot;
+        slot.quantity = quantity;
+        slot.paramsIdx = smspec_node_get_params_index(ertHandle);
+        slots.push_back(slot);
+    }
 
     void addVariables_(const Opm::EclipseState& eclState)
     {
         const auto& wellsVector = eclState.getSchedule().getWells();
         for (size_t wellIdx = 0; wellIdx < wellsVector.size(); ++ wellIdx) {
             const auto& eclWell = wellsVector[wellIdx];
-            auto& wellInfo = ertWellInfo_[eclWell->name()];
+            const std::string& wellName = eclWell->name();
+            auto& slots = wellSlots_[wellName];
 
             // the bottom hole and tubing head pressure
-            if (writeWbhp_())
-                wellInfo.wbhpErtHandle =
-                    ecl_sum_add_var(ertSummary_.ertHandle(),
-                                    "WBHP",
-                                    eclWell->name().c_str(),
-                                    /*num=*/0,
-                                    /*unit=*/"BARSA",
-                                    /*defaultValue=*/0.0);
-
-            if (writeWthp_())
-                wellInfo.wthpErtHandle =
-                    ecl_sum_add_var(ertSummary_.ertHandle(),
-                                    "WTHP",
-                                    eclWell->name().c_str(),
-                                    /*num=*/0,
-                                    /*unit=*/"BARSA",
-                                    /*defaultValue=*/0.0);
+            addWellVariable_(slots, wbhp, "WBHP", wellName, "BARSA");
+            addWellVariable_(slots, wthp, "WTHP", wellName, "BARSA");
 
             // the gas to oil rate
-            if (writeWgor_())
-                wellInfo.wgorErtHandle =
-                    ecl_sum_add_var(ertSummary_.ertHandle(),
-                                    "WGOR",
-                                    eclWell->name().c_str(),
-                                    /*num=*/0,
-                                    /*unit=*/"",
-                                    /*defaultValue=*/0.0);
+            addWellVariable_(slots, wgor, "WGOR", wellName, "");
 
             // add injection variables
-            if (writeWwir_())
-                wellInfo.wwirErtHandle =
-                    ecl_sum_add_var(ertSummary_.ertHandle(),
-                                    "WWIR",
-                                    eclWell->name().c_str(),
-                                    /*num=*/0,
-                                    /*unit=*/"SM3/DAY",
-                                    /*defaultValue=*/0.0);
-
-            if (writeWgir_())
-                wellInfo.wgirErtHandle =
-                    ecl_sum_add_var(ertSummary_.ertHandle(),
-                                    "WGIR",
-                                    eclWell->name().c_str(),
-                                    /*num=*/0,
-                                    /*unit=*/"SM3/DAY",
-                                    /*defaultValue=*/0.0);
-
-            if (writeWoir_())
-                wellInfo.woirErtHandle =
-                    ecl_sum_add_var(ertSummary_.ertHandle(),
-                                    "WOIR",
-                                    eclWell->name().c_str(),
-                                    /*num=*/0,
-                                    /*unit=*/"SM3/DAY",
-                                    /*defaultValue=*/0.0);
+            addWellVariable_(slots, wwir, "WWIR", wellName, "SM3/DAY");
+            addWellVariable_(slots, wgir, "WGIR", wellName, "SM3/DAY");
+            addWellVariable_(slots, woir, "WOIR", wellName, "SM3/DAY");
 
             // add production variables
-            if (writeWwpr_())
-                wellInfo.wwprErtHandle =
-                    ecl_sum_add_var(ertSummary_.ertHandle(),
-                                    "WWPR",
-                                    eclWell->name().c_str(),
-                                    /*num=*/0,
-                                    /*unit=*/"SM3/DAY",
-                                    /*defaultValue=*/0.0);
-
-            if (writeWgpr_())
-                wellInfo.wgprErtHandle =
-                    ecl_sum_add_var(ertSummary_.ertHandle(),
-                                    "WGPR",
-                                    eclWell->name().c_str(),
-                                    /*num=*/0,
-                                    /*unit=*/"SM3/DAY",
-                                    /*defaultValue=*/0.0);
-
-            if (writeWopr_())
-                wellInfo.woprErtHandle =
-                    ecl_sum_add_var(ertSummary_.ertHandle(),
-                                    "WOPR",
-                                    eclWell->name().c_str(),
-                                    /*num=*/0,
-                                    /*unit=*/"SM3/DAY",
-                                    /*defaultValue=*/0.0);
+            addWellVariable_(slots, wwpr, "WWPR", wellName, "SM3/DAY");
+            addWellVariable_(slots, wgpr, "WGPR", wellName, "SM3/DAY");
+            addWellVariable_(slots, wopr, "WOPR", wellName, "SM3/DAY");
 
             // add total injected volume variables
-            if (writeWwit_())
-                wellInfo.wwitErtHandle =
-                    ecl_sum_add_var(ertSummary_.ertHandle(),
-                                    "WWIT",
-                                    eclWell->name().c_str(),
-                                    /*num=*/0,
-                                    /*unit=*/"SM3/DAY",
-                                    /*defaultValue=*/0.0);
-
-            if (writeWgit_())
-                wellInfo.wgitErtHandle =
-                    ecl_sum_add_var(ertSummary_.ertHandle(),
-                                    "WGIT",
-                                    eclWell->name().c_str(),
-                                    /*num=*/0,
-                                    /*unit=*/"SM3/DAY",
-                                    /*defaultValue=*/0.0);
-
-            if (writeWoit_())
-                wellInfo.woitErtHandle =
-                    ecl_sum_add_var(ertSummary_.ertHandle(),
-                                    "WOIT",
-                                    eclWell->name().c_str(),
-                                    /*num=*/0,
-                                    /*unit=*/"SM3/DAY",
-                                    /*defaultValue=*/0.0);
+            addWellVariable_(slots, wwit, "WWIT", wellName, "SM3/DAY");
+            addWellVariable_(slots, wgit, "WGIT", wellName, "SM3/DAY");
+            addWellVariable_(slots, woit, "WOIT", wellName, "SM3/DAY");
 
             // add total produced volume variables
-            if (writeWwpt_())
-                wellInfo.wwptErtHandle =
-                    ecl_sum_add_var(ertSummary_.ertHandle(),
-                                    "WWPT",
-                                    eclWell->name().c_str(),
-                                    /*num=*/0,
-                                    /*unit=*/"SM3/DAY",
-                                    /*defaultValue=*/0.0);
-
-            if (writeWgpt_())
-                wellInfo.wgptErtHandle =
-                    ecl_sum_add_var(ertSummary_.ertHandle(),
-                                    "WGPT",
-                                    eclWell->name().c_str(),
-                                    /*num=*/0,
-                                    /*unit=*/"SM3/DAY",
-                                    /*defaultValue=*/0.0);
-
-            if (writeWopt_())
-                wellInfo.woptErtHandle =
-                    ecl_sum_add_var(ertSummary_.ertHandle(),
-                                    "WOPT",
-                                    eclWell->name().c_str(),
-                                    /*num=*/0,
-                                    /*unit=*/"SM3/DAY",
-                                    /*defaultValue=*/0.0);
+            addWellVariable_(slots, wwpt, "WWPT", wellName, "SM3/DAY");
+            addWellVariable_(slots, wgpt, "WGPT", wellName, "SM3/DAY");
+            addWellVariable_(slots, wopt, "WOPT", wellName, "SM3/DAY");
         }
     }
 
@@ -536,7 +352,11 @@ private:
     const Simulator& simulator_;
 
     std::set<std::string> summaryKeywords_;
-    std::map<std::string, ErtWellInfo> ertWellInfo_;
+
+    // the slots of the summary variables for each well, by well name and by the index
+    // used by the well manager
+    std::map<std::string, WellSlots> wellSlots_;
+    std::vector<const WellSlots*> wellSlotsByIdx_;
 
 #if HAVE_ERT
     ErtSummary ertSummary_;
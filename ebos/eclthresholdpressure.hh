@@ -29,6 +29,7 @@
 #define EWOMS_ECL_THRESHOLD_PRESSURE_HH
 
 #include <ewoms/common/propertysystem.hh>
+#include <ewoms/common/memoryusage.hh>
 
 #include <opm/material/densead/Evaluation.hpp>
 #include <opm/material/densead/Math.hpp>
@@ -86,6 +87,17 @@ public:
         enableThresholdPressure_ = false;
     }
 
+    /*!
+     * \brief Returns the number of bytes allocated for the threshold pressures.
+     */
+    size_t memoryUsage() const
+    {
+        return
+            dynamicMemoryUsage(thpresDefault_)
+            + dynamicMemoryUsage(thpres_)
+            + dynamicMemoryUsage(elemEquilRegion_);
+    }
+
     /*!
      * \brief Actually compute the threshold pressures over a face as a pre-compute step.
      */
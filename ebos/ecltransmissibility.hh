@@ -29,6 +29,7 @@
 #define EWOMS_ECL_TRANSMISSIBILITY_HH
 
 #include <ewoms/common/propertysystem.hh>
+#include <ewoms/common/memoryusage.hh>
 
 #include <opm/parser/eclipse/EclipseState/EclipseState.hpp>
 #include <opm/parser/eclipse/EclipseState/Grid/GridProperties.hpp>
@@ -105,8 +106,7 @@ public:
         auto& transMult = eclState.getTransMult();
         ElementMapper elemMapper(gridView);
 
-        const std::vector<double>& ntg =
-            eclState.get3DProperties().getDoubleGridProperty("NTG").getData();
+        const std::vector<double> ntg = gridManager_.localDoubleGridProperty("NTG");
 
         unsigned numElements = elemMapper.size();
 
@@ -209,8 +209,8 @@ public:
                                                   axisCentroids),
                                   permeability_[outsideElemIdx]);
 
-                applyNtg_(halfTrans1, insideFaceIdx, insideCartElemIdx, ntg);
-                applyNtg_(halfTrans2, outsideFaceIdx, outsideCartElemIdx, ntg);
+                applyNtg_(halfTrans1, insideFaceIdx, insideElemIdx, ntg);
+                applyNtg_(halfTrans2, outsideFaceIdx, outsideElemIdx, ntg);
 
                 // convert half transmissibilities to full face
                 // transmissibilities using the harmonic mean
@@ -264,34 +264,40 @@ public:
     Scalar transmissibility(unsigned elemIdx1, unsigned elemIdx2) const
     { return trans_.at(isId_(elemIdx1, elemIdx2)); }
 
+    /*!
+     * \brief Returns the number of bytes allocated for the transmissibilities and the
+     *        permeabilities.
+     */
+    size_t memoryUsage() const
+    { return dynamicMemoryUsage(trans_) + permeability_.capacity()*sizeof(DimMatrix); }
+
 private:
     void extractPermeability_()
     {
-        const auto& props = gridManager_.eclState().get3DProperties();
-
         unsigned numElem = gridManager_.gridView().size(/*codim=*/0);
         permeability_.resize(numElem);
 
         // read the intrinsic permeabilities from the eclState. Note that all arrays
         // provided by eclState are one-per-cell of "uncompressed" grid, whereas the
         // simulation grid might remove a few elements. (e.g. because it is distributed
-        // over several processes.)
-        if (props.hasDeckDoubleGridProperty("PERMX")) {
-            const std::vector<double>& permxData =
-                props.getDoubleGridProperty("PERMX").getData();
-            std::vector<double> permyData(permxData);
-            if (props.hasDeckDoubleGridProperty("PERMY"))
-                permyData = props.getDoubleGridProperty("PERMY").getData();
-            std::vector<double> permzData(permxData);
-            if (props.hasDeckDoubleGridProperty("PERMZ"))
-                permzData = props.getDoubleGridProperty("PERMZ").getData();
+        // over several processes.) To avoid that each process needs to access the
+        // global arrays, the I/O rank sends each process the values of its elements.
+        // (the other processes usually do not even have the global arrays.)
+        if (gridManager_.deckHasKeyword("PERMX")) {
+            const std::vector<double> permxData =
+                gridManager_.localDoubleGridProperty("PERMX");
+            std::vector<double> permyData;
+            if (gridManager_.deckHasKeyword("PERMY"))
+                permyData = gridManager_.localDoubleGridProperty("PERMY");
+            std::vector<double> permzData;
+            if (gridManager_.deckHasKeyword("PERMZ"))
+                permzData = gridManager_.localDoubleGridProperty("PERMZ");
 
             for (size_t dofIdx = 0; dofIdx < numElem; ++ dofIdx) {
-                unsigned cartesianElemIdx = gridManager_.cartesianIndex(dofIdx);
                 permeability_[dofIdx] = 0.0;
-                permeability_[dofIdx][0][0] = permxData[cartesianElemIdx];
-                permeability_[dofIdx][1][1] = permyData[cartesianElemIdx];
-                permeability_[dofIdx][2][2] = permzData[cartesianElemIdx];
+                permeability_[dofIdx][0][0] = permxData[dofIdx];
+                permeability_[dofIdx][1][1] = permyData.empty() ? permxData[dofIdx] : permyData[dofIdx];
+                permeability_[dofIdx][2][2] = permzData.empty() ? permxData[dofIdx] : permzData[dofIdx];
             }
 
             // for now we don't care about non-diagonal entries
@@ -373,7 +379,7 @@ private:
         }
     }
 
-    void applyNtg_(Scalar& trans, unsigned faceIdx, unsigned cartElemIdx,
+    void applyNtg_(Scalar& trans, unsigned faceIdx, unsigned elemIdx,
                    const std::vector<double>& ntg) const
     {
         // apply multiplyer for the transmissibility of the face. (the
@@ -381,17 +387,17 @@ private:
         // contains the intersection of interest.)
         switch (faceIdx) {
         case 0: // left
-            trans *= ntg[cartElemIdx];
+            trans *= ntg[elemIdx];
             break;
         case 1: // right
-            trans *= ntg[cartElemIdx];
+            trans *= ntg[elemIdx];
             break;
 
         case 2: // front
-            trans *= ntg[cartElemIdx];
+            trans *= ntg[elemIdx];
             break;
         case 3: // back
-            trans *= ntg[cartElemIdx];
+            trans *= ntg[elemIdx];
             break;
 
             // NTG does not apply to top and bottom faces
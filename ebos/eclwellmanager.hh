@@ -43,6 +43,7 @@
 #include <opm/common/Exceptions.hpp>
 
 #include <ewoms/common/propertysystem.hh>
+#include <ewoms/common/memoryusage.hh>
 #include <ewoms/parallel/threadedentityiterator.hh>
 
 #include <dune/grid/common/gridenums.hh>
@@ -584,6 +585,23 @@ public:
                                reportStepIdx);
     }
 
+    /*!
+     * \brief Returns the number of bytes used by the wells and the bookkeeping of the
+     *        well manager.
+     */
+    size_t memoryUsage() const
+    {
+        size_t result =
+            dynamicMemoryUsage(wells_)
+            + dynamicMemoryUsage(gridDofIsPenetrated_)
+            + dynamicMemoryUsage(wellNameToIndex_)
+            + dynamicMemoryUsage(wellTotalInjectedVolume_)
+            + dynamicMemoryUsage(wellTotalProducedVolume_);
+        for (const auto& well : wells_)
+            result += well->memoryUsage();
+        return result;
+    }
+
 protected:
     bool wellTopologyChanged_(const Opm::EclipseState& eclState, unsigned reportStepIdx) const
     {
@@ -43,6 +43,7 @@
 #include <boost/algorithm/string.hpp>
 
 #include <list>
+#include <vector>
 #include <utility>
 #include <string>
 #include <limits>
@@ -110,7 +111,9 @@ class EclWriterHelper
  *   soon as you try to write an ECL output file.
  * - This class requires to use the black oil model with the element
  *   centered finite volume discretization.
- * - MPI-parallel computations are not (yet?) supported.
+ * - In parallel runs, the data is gathered on the I/O rank using
+ *   non-blocking point-to-point messages (one message per field and
+ *   rank) which are posted as soon as a buffer is attached.
  */
 template <class TypeTag>
 class EclWriter : public BaseOutputWriter
@@ -216,6 +219,12 @@ public:
      */
     void attachScalarElementData(ScalarBuffer& buf, std::string name)
     {
+        // if the buffer is going to be written, start sending it to the I/O rank
+        // right away. this allows the compute ranks to continue as soon as they have
+        // posted their messages.
+        if (enableEclOutput_() && simulator_.episodeWillBeOver())
+            collectToIORank_.beginCollectField(static_cast<unsigned>(attachedBuffers_.size()), buf);
+
         attachedBuffers_.push_back(std::pair<std::string, ScalarBuffer*>(name, &buf));
     }
 
@@ -261,26 +270,26 @@ public:
                   "The ERT libraries must be available to write ECL output!");
 #else
 
-        // collect all data to I/O rank and store in attachedBuffers_
-        // this also reorders the data such that it fits the underlying eclGrid
-        collectToIORank_.collect( attachedBuffers_ );
-
-        // write output on I/O rank
+        // write output on I/O rank. the data of the individual fields has been sent
+        // to the I/O rank when the buffers were attached, so a field can be written
+        // while the later ones are still being received. the data passed to the
+        // callback is ordered such that it fits the underlying eclGrid
         if (collectToIORank_.isIORank()) {
             ErtRestartFile restartFile(simulator_, reportStepIdx_);
             restartFile.writeHeader(simulator_, reportStepIdx_);
 
             ErtSolution solution(restartFile);
-            auto bufIt = attachedBuffers_.begin();
-            const auto& bufEndIt = attachedBuffers_.end();
-            for (; bufIt != bufEndIt; ++ bufIt) {
-                const std::string& name = bufIt->first;
-                const ScalarBuffer& buffer = *bufIt->second;
+            std::vector<const std::string*> fieldNames;
+            for (const auto& attachedBuffer : attachedBuffers_)
+                fieldNames.push_back(&attachedBuffer.first);
 
+            collectToIORank_.finishCollect(attachedBuffers_,
+                                           [&](unsigned fieldIdx, const ScalarBuffer& buffer)
+            {
                 std::shared_ptr<const ErtKeyword<float>>
-                    bufKeyword(new ErtKeyword<float>(name, buffer));
+                    bufKeyword(new ErtKeyword<float>(*fieldNames[fieldIdx], buffer));
                 solution.add(bufKeyword);
-            }
+            });
         }
 
         // detach all buffers
@@ -40,6 +40,8 @@
 #include <ert/ecl/ecl_kw_magic.h>
 #include <ert/ecl/ecl_kw.h>
 #include <ert/ecl/ecl_sum.h>
+#include <ert/ecl/ecl_sum_tstep.h>
+#include <ert/ecl/ecl_smspec.h>
 #include <ert/ecl/ecl_util.h>
 #include <ert/ecl/ecl_init_file.h>
 #include <ert/ecl/ecl_file.h>
@@ -587,6 +589,18 @@ public:
                                           eclGrid.getNX(),
                                           eclGrid.getNY(),
                                           eclGrid.getNZ());
+
+        char *unsmryFileName = ecl_util_alloc_filename(/*outputDir=*/NULL,
+                                                       caseName.c_str(),
+                                                       ECL_UNIFIED_SUMMARY_FILE,
+                                                       /*formatted=*/false,
+                                                       /*reportStepIdx=*/0);
+        unsmryFileName_ = unsmryFileName;
+        std::free(unsmryFileName);
+
+        filesInitialized_ = false;
+        lastReportStepIdx_ = 0;
+        numMinisteps_ = 0;
     }
 
     ~ErtSummary()
@@ -597,11 +611,72 @@ public:
     void writeTimeStep(const WellManager& wellManager OPM_UNUSED)
     { }
 
+    /*!
+     * \brief Write the data of the most recently added time step to disk.
+     *
+     * The first time this method is called, the specification (SMSPEC) file and the
+     * unified summary file are written from scratch. After that, only the records for
+     * the new ministep are appended to the unified summary file, i.e., the cost of this
+     * method does not grow with the number of time steps which have already been
+     * written.
+     */
+    void appendTimeStep(const ecl_sum_tstep_type *tstepHandle, unsigned reportStepIdx)
+    {
+        if (!filesInitialized_) {
+            ecl_sum_fwrite(ertHandle_);
+
+            filesInitialized_ = true;
+            lastReportStepIdx_ = reportStepIdx;
+            numMinisteps_ = 1;
+            return;
+        }
+
+        fortio_type *fortio = fortio_open_append(unsmryFileName_.c_str(),
+                                                 /*formatted=*/false,
+                                                 ECL_ENDIAN_FLIP);
+        if (!fortio)
+            OPM_THROW(std::runtime_error,
+                      "Could not open summary file '" << unsmryFileName_ << "' for appending");
+
+        // each report step starts with a SEQHDR record
+        if (reportStepIdx != lastReportStepIdx_) {
+            ecl_kw_type *seqhdrKw = ecl_kw_alloc("SEQHDR", 1, ECL_INT_TYPE);
+            ecl_kw_iset_int(seqhdrKw, 0, 0);
+            ecl_kw_fwrite(seqhdrKw, fortio);
+            ecl_kw_free(seqhdrKw);
+
+            lastReportStepIdx_ = reportStepIdx;
+        }
+
+        ecl_kw_type *ministepKw = ecl_kw_alloc("MINISTEP", 1, ECL_INT_TYPE);
+        ecl_kw_iset_int(ministepKw, 0, static_cast<int>(numMinisteps_));
+        ecl_kw_fwrite(ministepKw, fortio);
+        ecl_kw_free(ministepKw);
+
+        // copy the whole parameter vector of the time step in one go
+        int numParams = ecl_smspec_get_params_size(ecl_sum_get_smspec(ertHandle_));
+        ecl_kw_type *paramsKw = ecl_kw_alloc("PARAMS", numParams, ECL_FLOAT_TYPE);
+        float *params = static_cast<float*>(ecl_kw_get_ptr(paramsKw));
+        for (int paramIdx = 0; paramIdx < numParams; ++paramIdx)
+            params[paramIdx] = ecl_sum_tstep_iget(tstepHandle, paramIdx);
+        ecl_kw_fwrite(paramsKw, fortio);
+        ecl_kw_free(paramsKw);
+
+        fortio_fclose(fortio);
+
+        ++numMinisteps_;
+    }
+
     ecl_sum_type *ertHandle() const
     { return ertHandle_; }
 
 private:
     ecl_sum_type *ertHandle_;
+
+    std::string unsmryFileName_;
+    bool filesInitialized_;
+    unsigned lastReportStepIdx_;
+    unsigned numMinisteps_;
 };
 
 /**
@@ -118,6 +118,32 @@ NEW_PROP_TAG(RestartTime);
 //! The name of the file with a number of forced time step lengths
 NEW_PROP_TAG(PredeterminedTimeStepsFile);
 
+//! Specify whether the profiling regions should be recorded
+NEW_PROP_TAG(EnableProfiling);
+
+//! The name of the file to which the Chrome trace of the profiling regions is written
+NEW_PROP_TAG(ProfilingTraceFile);
+
+//! The maximum number of profiling events which are kept for each thread
+NEW_PROP_TAG(ProfilingEventsPerThread);
+
+//! The name of the file to which the per-iteration telemetry records are written
+NEW_PROP_TAG(TelemetryFile);
+
+//! Specifies when the memory used by the subsystems of the simulator is printed
+NEW_PROP_TAG(PrintMemoryUsage);
+
+//! Specify whether the hardware performance counters are sampled for the phases of the
+//! simulation
+NEW_PROP_TAG(EnablePerfCounters);
+
+//! The comma separated list of hardware performance counter events which are sampled
+NEW_PROP_TAG(PerfCounterEvents);
+
+//! The number of time steps after which the load imbalance between the processes is
+//! reported
+NEW_PROP_TAG(LoadImbalanceReportInterval);
+
 ///////////////////////////////////
 // Values for the properties
 ///////////////////////////////////
@@ -187,6 +213,31 @@ SET_SCALAR_PROP(NumericModel, RestartTime, -1e35);
 //! By default, do not force any time steps
 SET_STRING_PROP(NumericModel, PredeterminedTimeStepsFile, "");
 
+//! By default, profiling is disabled
+SET_BOOL_PROP(NumericModel, EnableProfiling, false);
+
+//! By default, no trace is written
+SET_STRING_PROP(NumericModel, ProfilingTraceFile, "");
+
+//! Keep up to a million events per thread
+SET_INT_PROP(NumericModel, ProfilingEventsPerThread, 1000000);
+
+//! By default, no telemetry is written
+SET_STRING_PROP(NumericModel, TelemetryFile, "");
+
+//! By default, the memory usage is not printed
+SET_INT_PROP(NumericModel, PrintMemoryUsage, 0);
+
+//! By default, the hardware performance counters are not sampled
+SET_BOOL_PROP(NumericModel, EnablePerfCounters, false);
+
+//! Count the events required for the instructions per cycle and the cache miss ratio
+SET_STRING_PROP(NumericModel, PerfCounterEvents,
+                "cycles,instructions,cache-references,cache-misses");
+
+//! By default, the load imbalance is not reported
+SET_INT_PROP(NumericModel, LoadImbalanceReportInterval, 0);
+
 } // namespace Properties
 } // namespace Ewoms
 
@@ -0,0 +1,382 @@
+// -*- mode: C++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*-
+// vi: set et ts=4 sw=4 sts=4:
+/*
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+
+  Consult the COPYING file in the top-level source directory of this
+  module for the precise wording of the license and the list of
+  copyright holders.
+*/
+/*!
+ * \file
+ *
+ * \copydoc Ewoms::BenchmarkProblem
+ */
+#ifndef EWOMS_BENCHMARK_PROBLEM_HH
+#define EWOMS_BENCHMARK_PROBLEM_HH
+
+#include <ewoms/common/propertysystem.hh>
+#include <ewoms/common/parametersystem.hh>
+
+#include <opm/common/ErrorMacros.hpp>
+#include <opm/common/Exceptions.hpp>
+
+#include <dune/grid/common/gridenums.hh>
+
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+
+namespace Ewoms {
+namespace Properties {
+NEW_TYPE_TAG(BenchmarkProblem);
+
+NEW_PROP_TAG(Simulator);
+NEW_PROP_TAG(GridView);
+NEW_PROP_TAG(ThreadManager);
+
+//! The maximum number of time steps which are done by a benchmark
+NEW_PROP_TAG(BenchmarkTimeSteps);
+
+//! The name of the file to which the results of a benchmark are written
+NEW_PROP_TAG(BenchmarkOutputFile);
+
+//! The name of the file which contains the results of a previous run of a benchmark
+NEW_PROP_TAG(BenchmarkBaselineFile);
+
+//! The relative deviation from the baseline which is considered to be a regression
+NEW_PROP_TAG(BenchmarkTolerance);
+
+//! The run time in seconds below which deviations from the baseline are ignored
+NEW_PROP_TAG(BenchmarkMinTime);
+
+SET_INT_PROP(BenchmarkProblem, BenchmarkTimeSteps, 10);
+SET_STRING_PROP(BenchmarkProblem, BenchmarkOutputFile, "");
+SET_STRING_PROP(BenchmarkProblem, BenchmarkBaselineFile, "");
+SET_SCALAR_PROP(BenchmarkProblem, BenchmarkTolerance, 0.1);
+SET_SCALAR_PROP(BenchmarkProblem, BenchmarkMinTime, 0.05);
+}} // namespace Properties, Ewoms
+
+namespace Ewoms {
+/*!
+ * \ingroup Common
+ *
+ * \brief Turns a problem into a benchmark.
+ *
+ * The simulation is stopped after a fixed number of time steps (or at the end time of
+ * the problem, whichever comes first). After the simulation, the run time needed for
+ * the individual phases of the simulation, the number of Newton and linear iterations
+ * and the size of the problem are written as a JSON object. If a file containing the
+ * result of a previous run is specified, the results are compared with this baseline
+ * and an exception is thrown if the simulation got slower by more than the given
+ * tolerance.
+ *
+ * To use it, let the type tag of the simulator inherit from the BenchmarkProblem type
+ * tag and set the Problem property to
+ * \code
+ * Ewoms::BenchmarkProblem<TypeTag, ActualProblem<TypeTag> >
+ * \endcode
+ */
+template <class TypeTag, class ParentProblem>
+class BenchmarkProblem : public ParentProblem
+{
+    typedef ParentProblem ParentType;
+
+    typedef typename GET_PROP_TYPE(TypeTag, Scalar) Scalar;
+    typedef typename GET_PROP_TYPE(TypeTag, Simulator) Simulator;
+    typedef typename GET_PROP_TYPE(TypeTag, GridView) GridView;
+    typedef typename GET_PROP_TYPE(TypeTag, ThreadManager) ThreadManager;
+
+    typedef std::map<std::string, std::string> Report;
+
+public:
+    BenchmarkProblem(Simulator& simulator)
+        : ParentType(simulator)
+    {}
+
+    /*!
+     * \copydoc FvBaseProblem::registerParameters
+     */
+    static void registerParameters()
+    {
+        ParentType::registerParameters();
+
+        EWOMS_REGISTER_PARAM(TypeTag, unsigned, BenchmarkTimeSteps,
+                             "The maximum number of time steps done by the benchmark");
+        EWOMS_REGISTER_PARAM(TypeTag, std::string, BenchmarkOutputFile,
+                             "The name of the file to which the results of the benchmark "
+                             "are written. If empty, they are printed to the terminal");
+        EWOMS_REGISTER_PARAM(TypeTag, std::string, BenchmarkBaselineFile,
+                             "The name of a file containing the results of a previous run "
+                             "of the benchmark which the results are compared to");
+        EWOMS_REGISTER_PARAM(TypeTag, Scalar, BenchmarkTolerance,
+                             "The relative slow down compared to the baseline which is "
+                             "considered to be a regression");
+        EWOMS_REGISTER_PARAM(TypeTag, Scalar, BenchmarkMinTime,
+                             "The run time in seconds of a simulation phase below which "
+                             "differences to the baseline are ignored");
+    }
+
+    /*!
+     * \copydoc FvBaseProblem::endTimeStep
+     */
+    void endTimeStep()
+    {
+        ParentType::endTimeStep();
+
+        unsigned maxTimeSteps = EWOMS_GET_PARAM(TypeTag, unsigned, BenchmarkTimeSteps);
+        if (static_cast<unsigned>(this->simulator().timeStepIndex() + 1) >= maxTimeSteps)
+            this->simulator().setFinished(true);
+    }
+
+    /*!
+     * \copydoc FvBaseProblem::finalize
+     */
+    void finalize()
+    {
+        ParentType::finalize();
+
+        const Report& report = createReport_();
+        const auto& comm = this->gridView().comm();
+
+        if (comm.rank() == 0) {
+            const std::string& outputFile =
+                EWOMS_GET_PARAM(TypeTag, std::string, BenchmarkOutputFile);
+            if (outputFile.empty())
+                writeReport_(std::cout, report);
+            else {
+                std::ofstream os(outputFile);
+                if (!os)
+                    OPM_THROW(std::runtime_error,
+                              "Could not open file '" << outputFile << "' for writing");
+                writeReport_(os, report);
+            }
+        }
+
+        const std::string& baselineFile =
+            EWOMS_GET_PARAM(TypeTag, std::string, BenchmarkBaselineFile);
+        if (baselineFile.empty())
+            return;
+
+        // only the first process compares the results, but all of them need to agree
+        // on the outcome
+        int numRegressions = 0;
+        if (comm.rank() == 0) {
+            try {
+                numRegressions = compareWithBaseline_(report, baselineFile);
+            }
+            catch (const std::exception& e) {
+                std::cout << e.what() << "\n" << std::flush;
+                numRegressions = -1;
+            }
+        }
+        numRegressions = comm.min(numRegressions) < 0 ? -1 : comm.max(numRegressions);
+
+        if (numRegressions < 0)
+            OPM_THROW(std::runtime_error,
+                      "Could not compare the results with the baseline '" << baselineFile << "'");
+        if (numRegressions > 0)
+            OPM_THROW(std::runtime_error,
+                      "The benchmark exhibits " << numRegressions
+                      << " performance regression(s) compared to '" << baselineFile << "'");
+    }
+
+private:
+    // all quantities which are compared to the baseline. for all of them, smaller
+    // values are better
+    static const char* const* comparedQuantities_()
+    {
+        static const char* const names[] = {
+            "executionTime",
+            "linearizeTime",
+            "solveTime",
+            "updateTime",
+            "writeTime",
+            "numNewtonIterations",
+            "numLinearIterations",
+            0
+        };
+        return names;
+    }
+
+    // the quantities which must be identical for the baseline to be comparable
+    static const char* const* problemSizeQuantities_()
+    {
+        static const char* const names[] = {
+            "problem",
+            "numElements",
+            "numTimeSteps",
+            0
+        };
+        return names;
+    }
+
+    static bool isTimeQuantity_(const std::string& name)
+    { return name.size() > 4 && name.compare(name.size() - 4, 4, "Time") == 0; }
+
+    Report createReport_() const
+    {
+        const Simulator& simulator = this->simulator();
+        const auto& gridView = this->gridView();
+        const auto& comm = gridView.comm();
+
+        // count the interior elements so that the number of elements does not depend
+        // on the number of processes
+        unsigned long numElements = 0;
+        auto elemIt = gridView.template begin</*codim=*/0, Dune::Interior_Partition>();
+        const auto& elemEndIt = gridView.template end</*codim=*/0, Dune::Interior_Partition>();
+        for (; elemIt != elemEndIt; ++elemIt)
+            ++numElements;
+        numElements = comm.sum(numElements);
+
+        // the DOFs in the overlap are counted by each process which sees them
+        unsigned long numDof = comm.sum(static_cast<unsigned long>(this->model().numGridDof()));
+
+        Report report;
+        report["problem"] = quote_(this->name());
+        report["numProcesses"] = toString_(comm.size());
+        report["numThreads"] = toString_(ThreadManager::maxThreads());
+        report["numElements"] = toString_(numElements);
+        report["numDof"] = toString_(numDof);
+        report["numTimeSteps"] = toString_(simulator.timeStepIndex());
+        // the iteration counts are the same on all processes, the time is the one of
+        // the slowest process
+        report["numNewtonIterations"] = toString_(comm.max(simulator.numNewtonIterations()));
+        report["numLinearIterations"] = toString_(comm.max(simulator.numLinearIterations()));
+        report["setupTime"] = toString_(comm.max(simulator.setupTimer().realTimeElapsed()));
+        report["executionTime"] = toString_(comm.max(simulator.executionTimer().realTimeElapsed()));
+        report["linearizeTime"] = toString_(comm.max(simulator.linearizeTimer().realTimeElapsed()));
+        report["solveTime"] = toString_(comm.max(simulator.solveTimer().realTimeElapsed()));
+        report["updateTime"] = toString_(comm.max(simulator.updateTimer().realTimeElapsed()));
+        report["writeTime"] = toString_(comm.max(simulator.writeTimer().realTimeElapsed()));
+
+        return report;
+    }
+
+    static void writeReport_(std::ostream& os, const Report& report)
+    {
+        os << "{\n";
+        auto it = report.begin();
+        const auto& endIt = report.end();
+        for (; it != endIt; ++it) {
+            os << "    \"" << it->first << "\": " << it->second;
+            auto nextIt = it;
+            ++nextIt;
+            os << ((nextIt != endIt) ? ",\n" : "\n");
+        }
+        os << "}\n";
+    }
+
+    int compareWithBaseline_(const Report& report, const std::string& baselineFile) const
+    {
+        std::ifstream is(baselineFile);
+        if (!is)
+            OPM_THROW(std::runtime_error,
+                      "Could not open the benchmark baseline file '" << baselineFile << "'");
+        const Report& baseline = readReport_(is);
+
+        for (const char* const* name = problemSizeQuantities_(); *name; ++name) {
+            auto baseIt = baseline.find(*name);
+            if (baseIt == baseline.end() || baseIt->second != report.at(*name))
+                OPM_THROW(std::runtime_error,
+                          "The baseline '" << baselineFile << "' is not comparable: "
+                          "Value of '" << *name << "' differs");
+        }
+
+        Scalar tolerance = EWOMS_GET_PARAM(TypeTag, Scalar, BenchmarkTolerance);
+        Scalar minTime = EWOMS_GET_PARAM(TypeTag, Scalar, BenchmarkMinTime);
+
+        std::cout << "Comparison with baseline '" << baselineFile << "':\n";
+        int numRegressions = 0;
+        for (const char* const* name = comparedQuantities_(); *name; ++name) {
+            auto baseIt = baseline.find(*name);
+            if (baseIt == baseline.end())
+                continue;
+
+            Scalar baseValue = std::atof(baseIt->second.c_str());
+            Scalar curValue = std::atof(report.at(*name).c_str());
+
+            bool regression = curValue > baseValue*(1 + tolerance);
+            // ignore the noise of very short run times
+            if (isTimeQuantity_(*name) && curValue - baseValue < minTime)
+                regression = false;
+
+            std::ostringstream oss;
+            oss << "  " << std::left << std::setw(22) << *name
+                << " baseline: " << std::setw(14) << baseValue
+                << " current: " << std::setw(14) << curValue;
+            if (baseValue > 0)
+                oss << " (" << std::showpos << std::fixed << std::setprecision(1)
+                    << 100*(curValue/baseValue - 1) << "%)";
+            if (regression) {
+                oss << " REGRESSION";
+                ++numRegressions;
+            }
+            std::cout << oss.str() << "\n";
+        }
+        std::cout << std::flush;
+
+        return numRegressions;
+    }
+
+    // read a report written by writeReport_(). this is not a general JSON parser: only
+    // flat objects with string and number attributes are supported
+    static Report readReport_(std::istream& is)
+    {
+        Report report;
+        std::string line;
+        while (std::getline(is, line)) {
+            size_t keyBegin = line.find('"');
+            if (keyBegin == std::string::npos)
+                continue;
+            size_t keyEnd = line.find('"', keyBegin + 1);
+            size_t colonPos = line.find(':', keyEnd);
+            if (keyEnd == std::string::npos || colonPos == std::string::npos)
+                continue;
+
+            std::string value = line.substr(colonPos + 1);
+            size_t valueBegin = value.find_first_not_of(" \t");
+            size_t valueEnd = value.find_last_not_of(" \t,\r");
+            if (valueBegin == std::string::npos)
+                continue;
+
+            report[line.substr(keyBegin + 1, keyEnd - keyBegin - 1)] =
+                value.substr(valueBegin, valueEnd - valueBegin + 1);
+        }
+
+        return report;
+    }
+
+    template <class T>
+    static std::string toString_(const T& value)
+    {
+        std::ostringstream oss;
+        oss << std::setprecision(10) << value;
+        return oss.str();
+    }
+
+    static std::string quote_(const std::string& value)
+    { return "\"" + value + "\""; }
+};
+
+} // namespace Ewoms
+
+#endif
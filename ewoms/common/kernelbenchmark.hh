@@ -0,0 +1,219 @@
+// -*- mode: C++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*-
+// vi: set et ts=4 sw=4 sts=4:
+/*
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+
+  Consult the COPYING file in the top-level source directory of this
+  module for the precise wording of the license and the list of
+  copyright holders.
+*/
+/*!
+ * \file
+ *
+ * \copydoc Ewoms::KernelBenchmark
+ */
+#ifndef EWOMS_KERNEL_BENCHMARK_HH
+#define EWOMS_KERNEL_BENCHMARK_HH
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iomanip>
+#include <ostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace Ewoms {
+
+/*!
+ * \ingroup Common
+ *
+ * \brief Measures the run time of small computational kernels.
+ *
+ * Each kernel is first executed a few times to warm up the caches and to calibrate the
+ * number of calls per sample. The number of calls per sample is chosen such that each
+ * sample takes at least a given minimum time, so that the resolution of the clock does
+ * not matter. Then, a number of samples is taken and the minimum, median, mean and
+ * standard deviation of the time per call are determined.
+ *
+ * The results are normalized by the number of items (e.g., cells or matrix rows)
+ * processed by a single call of the kernel. If an estimate of the memory traffic per
+ * item is provided, the achieved bandwidth is printed as well.
+ */
+class KernelBenchmark
+{
+    typedef std::chrono::high_resolution_clock Clock;
+
+public:
+    /*!
+     * \brief The statistical summary of the measurements for a kernel.
+     *
+     * All times are in seconds per call of the kernel.
+     */
+    struct Result
+    {
+        std::string name;
+        unsigned numSamples;
+        unsigned callsPerSample;
+        double minTime;
+        double medianTime;
+        double meanTime;
+        double stdDevTime;
+        double itemsPerCall;
+        double bytesPerItem;
+
+        //! The median time per item in nanoseconds
+        double nsPerItem() const
+        { return medianTime/itemsPerCall*1e9; }
+
+        //! The achieved memory bandwidth in GB/s based on the median time
+        double bandwidth() const
+        { return bytesPerItem*itemsPerCall/medianTime*1e-9; }
+    };
+
+    /*!
+     * \brief Create a benchmark harness.
+     *
+     * \param numWarmupCalls The number of calls of a kernel before the measurement
+     * \param numSamples The number of samples taken for each kernel
+     * \param minSampleTime The minimum duration of a sample in seconds
+     */
+    KernelBenchmark(unsigned numWarmupCalls = 10,
+                    unsigned numSamples = 20,
+                    double minSampleTime = 1e-3)
+        : numWarmupCalls_(std::max(1u, numWarmupCalls))
+        , numSamples_(std::max(1u, numSamples))
+        , minSampleTime_(minSampleTime)
+    {}
+
+    /*!
+     * \brief Measure the run time of a kernel.
+     *
+     * \param name The name of the kernel
+     * \param itemsPerCall The number of items processed by a single call of the kernel
+     * \param bytesPerItem The estimated memory traffic per item in bytes, or 0 if unknown
+     * \param kernel The kernel. This must be callable without arguments.
+     */
+    template <class Kernel>
+    const Result& run(const std::string& name,
+                      double itemsPerCall,
+                      double bytesPerItem,
+                      Kernel kernel)
+    {
+        // warm up and calibrate the number of calls per sample
+        auto t0 = Clock::now();
+        for (unsigned i = 0; i < numWarmupCalls_; ++i)
+            kernel();
+        double warmupTime = seconds_(t0, Clock::now())/numWarmupCalls_;
+
+        unsigned callsPerSample = 1;
+        if (warmupTime > 0 && warmupTime < minSampleTime_)
+            callsPerSample = static_cast<unsigned>(std::ceil(minSampleTime_/warmupTime));
+
+        std::vector<double> samples(numSamples_);
+        for (unsigned sampleIdx = 0; sampleIdx < numSamples_; ++sampleIdx) {
+            auto t1 = Clock::now();
+            for (unsigned i = 0; i < callsPerSample; ++i)
+                kernel();
+            samples[sampleIdx] = seconds_(t1, Clock::now())/callsPerSample;
+        }
+
+        Result result;
+        result.name = name;
+        result.numSamples = numSamples_;
+        result.callsPerSample = callsPerSample;
+        result.itemsPerCall = std::max(itemsPerCall, 1e-30);
+        result.bytesPerItem = bytesPerItem;
+
+        double sum = 0.0;
+        for (double t : samples)
+            sum += t;
+        result.meanTime = sum/numSamples_;
+
+        double sumSquares = 0.0;
+        for (double t : samples)
+            sumSquares += (t - result.meanTime)*(t - result.meanTime);
+        result.stdDevTime = (numSamples_ > 1) ? std::sqrt(sumSquares/(numSamples_ - 1)) : 0.0;
+
+        std::sort(samples.begin(), samples.end());
+        result.minTime = samples.front();
+        if (numSamples_ % 2 == 1)
+            result.medianTime = samples[numSamples_/2];
+        else
+            result.medianTime = 0.5*(samples[numSamples_/2 - 1] + samples[numSamples_/2]);
+
+        results_.push_back(result);
+        return results_.back();
+    }
+
+    /*!
+     * \brief Returns the results of all kernels measured so far.
+     */
+    const std::vector<Result>& results() const
+    { return results_; }
+
+    /*!
+     * \brief Print the header of the table written by printResult().
+     */
+    static void printHeader(std::ostream& os)
+    {
+        os << std::left << std::setw(36) << "kernel"
+           << std::right
+           << std::setw(12) << "median[us]"
+           << std::setw(12) << "min[us]"
+           << std::setw(10) << "stddev%"
+           << std::setw(12) << "ns/item"
+           << std::setw(12) << "bytes/item"
+           << std::setw(10) << "GB/s"
+           << "\n";
+    }
+
+    /*!
+     * \brief Print the summary of a single kernel as a line of a table.
+     */
+    static void printResult(std::ostream& os, const Result& result)
+    {
+        std::ostringstream oss;
+        oss << std::fixed
+            << std::left << std::setw(36) << result.name
+            << std::right << std::setprecision(3)
+            << std::setw(12) << result.medianTime*1e6
+            << std::setw(12) << result.minTime*1e6
+            << std::setprecision(1)
+            << std::setw(10) << 100*result.stdDevTime/result.meanTime
+            << std::setw(12) << result.nsPerItem();
+        if (result.bytesPerItem > 0)
+            oss << std::setprecision(0) << std::setw(12) << result.bytesPerItem
+                << std::setprecision(2) << std::setw(10) << result.bandwidth();
+        else
+            oss << std::setw(12) << "-" << std::setw(10) << "-";
+        os << oss.str() << "\n";
+    }
+
+private:
+    static double seconds_(const Clock::time_point& t1, const Clock::time_point& t2)
+    { return std::chrono::duration_cast<std::chrono::duration<double> >(t2 - t1).count(); }
+
+    unsigned numWarmupCalls_;
+    unsigned numSamples_;
+    double minSampleTime_;
+    std::vector<Result> results_;
+};
+
+} // namespace Ewoms
+
+#endif
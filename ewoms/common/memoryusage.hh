@@ -0,0 +1,383 @@
+// -*- mode: C++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*-
+// vi: set et ts=4 sw=4 sts=4:
+/*
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+
+  Consult the COPYING file in the top-level source directory of this
+  module for the precise wording of the license and the list of
+  copyright holders.
+*/
+/*!
+ * \file
+ *
+ * \brief Estimates of the memory used by data structures and the report in which the
+ *        subsystems of the simulator account for the memory they use.
+ *
+ * The dynamicMemoryUsage() functions return the number of bytes allocated on the heap
+ * by an object, i.e., the result does not include sizeof() of the object itself. For
+ * the node based containers of the standard library, the overhead of the nodes is
+ * estimated based on the layout used by libstdc++.
+ */
+#ifndef EWOMS_MEMORY_USAGE_HH
+#define EWOMS_MEMORY_USAGE_HH
+
+#include <opm/common/Unused.hpp>
+
+#include <dune/istl/bvector.hh>
+#include <dune/istl/bcrsmatrix.hh>
+
+#include <algorithm>
+#include <cstddef>
+#include <fstream>
+#include <iomanip>
+#include <list>
+#include <map>
+#include <ostream>
+#include <set>
+#include <sstream>
+#include <string>
+#include <type_traits>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+#if defined(__linux__)
+#include <sys/resource.h>
+#endif
+
+namespace Ewoms {
+// the declarations are required because the overloads call each other for nested
+// containers
+template <class T>
+std::size_t dynamicMemoryUsage(const T& value);
+template <class T, class Alloc>
+std::size_t dynamicMemoryUsage(const std::vector<T, Alloc>& v);
+template <class Alloc>
+std::size_t dynamicMemoryUsage(const std::vector<bool, Alloc>& v);
+template <class T, class Alloc>
+std::size_t dynamicMemoryUsage(const std::list<T, Alloc>& l);
+template <class K, class C, class Alloc>
+std::size_t dynamicMemoryUsage(const std::set<K, C, Alloc>& s);
+template <class K, class V, class C, class Alloc>
+std::size_t dynamicMemoryUsage(const std::map<K, V, C, Alloc>& m);
+template <class K, class H, class E, class Alloc>
+std::size_t dynamicMemoryUsage(const std::unordered_set<K, H, E, Alloc>& s);
+template <class K, class V, class H, class E, class Alloc>
+std::size_t dynamicMemoryUsage(const std::unordered_map<K, V, H, E, Alloc>& m);
+template <class T1, class T2>
+std::size_t dynamicMemoryUsage(const std::pair<T1, T2>& p);
+inline std::size_t dynamicMemoryUsage(const std::string& s);
+template <class Block, class Alloc>
+std::size_t dynamicMemoryUsage(const Dune::BlockVector<Block, Alloc>& v);
+template <class Block, class Alloc>
+std::size_t dynamicMemoryUsage(const Dune::BCRSMatrix<Block, Alloc>& M);
+
+/*!
+ * \brief Objects which are not containers do not allocate any memory on the heap.
+ */
+template <class T>
+std::size_t dynamicMemoryUsage(const T& value OPM_UNUSED)
+{ return 0; }
+
+template <class T, class Alloc>
+std::size_t dynamicMemoryUsage(const std::vector<T, Alloc>& v)
+{
+    std::size_t result = v.capacity()*sizeof(T);
+    if (!std::is_pod<T>::value)
+        for (const auto& x : v)
+            result += dynamicMemoryUsage(x);
+    return result;
+}
+
+template <class Alloc>
+std::size_t dynamicMemoryUsage(const std::vector<bool, Alloc>& v)
+{ return (v.capacity() + 7)/8; }
+
+template <class T, class Alloc>
+std::size_t dynamicMemoryUsage(const std::list<T, Alloc>& l)
+{
+    // two pointers per node
+    std::size_t result = l.size()*(sizeof(T) + 2*sizeof(void*));
+    for (const auto& x : l)
+        result += dynamicMemoryUsage(x);
+    return result;
+}
+
+template <class K, class C, class Alloc>
+std::size_t dynamicMemoryUsage(const std::set<K, C, Alloc>& s)
+{
+    // three pointers and the color per node
+    std::size_t result = s.size()*(sizeof(K) + 4*sizeof(void*));
+    if (!std::is_pod<K>::value)
+        for (const auto& x : s)
+            result += dynamicMemoryUsage(x);
+    return result;
+}
+
+template <class K, class V, class C, class Alloc>
+std::size_t dynamicMemoryUsage(const std::map<K, V, C, Alloc>& m)
+{
+    typedef typename std::map<K, V, C, Alloc>::value_type ValueType;
+    std::size_t result = m.size()*(sizeof(ValueType) + 4*sizeof(void*));
+    if (!std::is_pod<K>::value || !std::is_pod<V>::value)
+        for (const auto& x : m)
+            result += dynamicMemoryUsage(x);
+    return result;
+}
+
+template <class K, class H, class E, class Alloc>
+std::size_t dynamicMemoryUsage(const std::unordered_set<K, H, E, Alloc>& s)
+{
+    // one pointer and possibly the cached hash per node plus the bucket array
+    std::size_t result =
+        s.size()*(sizeof(K) + 2*sizeof(void*))
+        + s.bucket_count()*sizeof(void*);
+    if (!std::is_pod<K>::value)
+        for (const auto& x : s)
+            result += dynamicMemoryUsage(x);
+    return result;
+}
+
+template <class K, class V, class H, class E, class Alloc>
+std::size_t dynamicMemoryUsage(const std::unordered_map<K, V, H, E, Alloc>& m)
+{
+    typedef typename std::unordered_map<K, V, H, E, Alloc>::value_type ValueType;
+    std::size_t result =
+        m.size()*(sizeof(ValueType) + 2*sizeof(void*))
+        + m.bucket_count()*sizeof(void*);
+    if (!std::is_pod<K>::value || !std::is_pod<V>::value)
+        for (const auto& x : m)
+            result += dynamicMemoryUsage(x);
+    return result;
+}
+
+template <class T1, class T2>
+std::size_t dynamicMemoryUsage(const std::pair<T1, T2>& p)
+{ return dynamicMemoryUsage(p.first) + dynamicMemoryUsage(p.second); }
+
+inline std::size_t dynamicMemoryUsage(const std::string& s)
+{ return s.capacity(); }
+
+template <class Block, class Alloc>
+std::size_t dynamicMemoryUsage(const Dune::BlockVector<Block, Alloc>& v)
+{ return v.capacity()*sizeof(Block); }
+
+/*!
+ * \brief The memory used by a BCRS matrix.
+ *
+ * This consists of the blocks and their column indices for each non-zero entry and a
+ * row object for each row.
+ */
+template <class Block, class Alloc>
+std::size_t dynamicMemoryUsage(const Dune::BCRSMatrix<Block, Alloc>& M)
+{
+    typedef Dune::BCRSMatrix<Block, Alloc> Matrix;
+    return
+        M.nonzeroes()*(sizeof(Block) + sizeof(typename Matrix::size_type))
+        + M.N()*sizeof(typename Matrix::row_type);
+}
+
+/*!
+ * \ingroup Common
+ *
+ * \brief Collects the memory used by the subsystems of the simulator and prints it.
+ *
+ * A sample is taken by calling beginSample(), then letting each subsystem add the
+ * number of bytes it currently uses using add() and finally calling endSample(). For
+ * each subsystem, the report keeps the memory used by the most recent sample and the
+ * maximum over all samples (i.e., its high-water mark). Since print() reduces the
+ * values over all processes, all processes must add the same subsystems in the same
+ * order.
+ */
+class MemoryReport
+{
+    struct Entry
+    {
+        std::string name;
+        double current; // [bytes]
+        double peak; // [bytes]
+    };
+
+public:
+    /*!
+     * \brief Start a new sample.
+     */
+    void beginSample()
+    {
+        for (auto& entry : entries_)
+            entry.current = 0.0;
+    }
+
+    /*!
+     * \brief Add memory to a subsystem for the current sample.
+     *
+     * If the same subsystem is added multiple times, the amounts are summed up.
+     */
+    void add(const std::string& subsystem, std::size_t numBytes)
+    {
+        for (auto& entry : entries_) {
+            if (entry.name == subsystem) {
+                entry.current += numBytes;
+                return;
+            }
+        }
+
+        Entry entry;
+        entry.name = subsystem;
+        entry.current = static_cast<double>(numBytes);
+        entry.peak = 0.0;
+        entries_.push_back(entry);
+    }
+
+    /*!
+     * \brief Finish the current sample and update the high-water marks.
+     */
+    void endSample()
+    {
+        for (auto& entry : entries_)
+            entry.peak = std::max(entry.peak, entry.current);
+    }
+
+    /*!
+     * \brief Print the most recent sample and the high-water marks.
+     *
+     * For each subsystem, the minimum and maximum over all processes and the sum over
+     * all processes are printed. This method is collective, but only the first process
+     * prints anything.
+     */
+    template <class CollectiveCommunication>
+    void print(std::ostream& os, const CollectiveCommunication& comm) const
+    {
+        // the values for each subsystem followed by the ones for the process
+        unsigned n = static_cast<unsigned>(entries_.size());
+        std::vector<double> current(n + 3, 0.0);
+        std::vector<double> peak(n + 3, 0.0);
+        for (unsigned i = 0; i < n; ++i) {
+            current[i] = entries_[i].current;
+            peak[i] = entries_[i].peak;
+            current[n] += entries_[i].current;
+            peak[n] = std::max(peak[n], entries_[i].peak);
+        }
+        current[n + 1] = residentSetSize();
+        peak[n + 1] = residentSetSize();
+        current[n + 2] = peakResidentSetSize();
+        peak[n + 2] = peakResidentSetSize();
+
+        std::vector<double> minCurrent(current), maxCurrent(current), sumCurrent(current);
+        std::vector<double> maxPeak(peak), sumPeak(peak);
+        comm.min(minCurrent.data(), static_cast<int>(minCurrent.size()));
+        comm.max(maxCurrent.data(), static_cast<int>(maxCurrent.size()));
+        comm.sum(sumCurrent.data(), static_cast<int>(sumCurrent.size()));
+        comm.max(maxPeak.data(), static_cast<int>(maxPeak.size()));
+        comm.sum(sumPeak.data(), static_cast<int>(sumPeak.size()));
+
+        if (comm.rank() != 0)
+            return;
+
+        std::ostringstream oss;
+        oss << "------------------------- Memory usage [MiB] --------------------------\n"
+            << std::left << std::setw(32) << "subsystem"
+            << std::right
+            << std::setw(10) << "rank min"
+            << std::setw(10) << "rank max"
+            << std::setw(10) << "total"
+            << std::setw(10) << "peak max"
+            << std::setw(10) << "peak tot"
+            << "\n";
+        for (unsigned i = 0; i < n + 3; ++i) {
+            std::string name;
+            if (i < n)
+                name = entries_[i].name;
+            else if (i == n)
+                name = "sum of the above";
+            else if (i == n + 1)
+                name = "resident set (process)";
+            else
+                name = "peak resident set (process)";
+
+            // the sum of the subsystem peaks is not meaningful because they are not
+            // reached at the same time
+            oss << std::left << std::setw(32) << name
+                << std::right << std::fixed << std::setprecision(1)
+                << std::setw(10) << minCurrent[i]/(1024*1024)
+                << std::setw(10) << maxCurrent[i]/(1024*1024)
+                << std::setw(10) << sumCurrent[i]/(1024*1024);
+            if (i == n || i == n + 1)
+                oss << std::setw(10) << "-" << std::setw(10) << "-";
+            else
+                oss << std::setw(10) << maxPeak[i]/(1024*1024)
+                    << std::setw(10) << sumPeak[i]/(1024*1024);
+            oss << "\n";
+        }
+        oss << "-----------------------------------------------------------------------\n";
+
+        os << oss.str() << std::flush;
+    }
+
+    /*!
+     * \brief Returns the current resident set size of the process in bytes.
+     *
+     * If this cannot be determined, 0 is returned.
+     */
+    static double residentSetSize()
+    { return procStatusValue_("VmRSS:"); }
+
+    /*!
+     * \brief Returns the maximum resident set size of the process in bytes since it was
+     *        started.
+     *
+     * If this cannot be determined, 0 is returned.
+     */
+    static double peakResidentSetSize()
+    {
+        double result = procStatusValue_("VmHWM:");
+#if defined(__linux__)
+        if (result == 0.0) {
+            struct rusage usage;
+            if (getrusage(RUSAGE_SELF, &usage) == 0)
+                result = static_cast<double>(usage.ru_maxrss)*1024;
+        }
+#endif
+        return result;
+    }
+
+private:
+    // returns the value of a memory related entry of /proc/self/status in bytes
+    static double procStatusValue_(const std::string& key)
+    {
+#if defined(__linux__)
+        std::ifstream is("/proc/self/status");
+        std::string line;
+        while (std::getline(is, line)) {
+            if (line.compare(0, key.size(), key) != 0)
+                continue;
+
+            std::istringstream iss(line.substr(key.size()));
+            double valueKiB = 0.0;
+            iss >> valueKiB;
+            return valueKiB*1024;
+        }
+#endif
+        return 0.0;
+    }
+
+    std::vector<Entry> entries_;
+};
+
+} // namespace Ewoms
+
+#endif
@@ -0,0 +1,703 @@
+// -*- mode: C++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*-
+// vi: set et ts=4 sw=4 sts=4:
+/*
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+
+  Consult the COPYING file in the top-level source directory of this
+  module for the precise wording of the license and the list of
+  copyright holders.
+*/
+/*!
+ * \file
+ *
+ * \copydoc Ewoms::PerfCounters
+ */
+#ifndef EWOMS_PERF_COUNTERS_HH
+#define EWOMS_PERF_COUNTERS_HH
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <ostream>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#if HAVE_MPI
+#include <mpi.h>
+#endif
+
+#if defined(__linux__)
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace Ewoms {
+/*!
+ * \ingroup Common
+ *
+ * \brief Samples the hardware performance counters of the CPU for named phases of a
+ *        simulation.
+ *
+ * The counters are accessed using the perf_event_open() system call of Linux. When
+ * init() is called, each thread of the OpenMP thread pool opens a group of counters for
+ * the configured events which only counts while that thread runs in user space. A phase
+ * is usually associated with an Ewoms::Timer object (see Timer::setPerfCounterPhase()):
+ * whenever the timer is started, the counters of all threads are read by the main thread
+ * and the difference is accumulated when the timer is stopped. This implies that the
+ * threads of the OpenMP pool must be persistent, which is the case for all common
+ * OpenMP implementations.
+ *
+ * If the counters cannot be opened, e.g., because the kernel does not permit it (see
+ * /proc/sys/kernel/perf_event_paranoid), because the simulation runs in a virtual
+ * machine without a virtualized PMU or because the operating system is not Linux, the
+ * module stays disabled and all operations are no-ops.
+ *
+ * Besides the raw counts, the following metrics are derived if the required events are
+ * part of the event set: the number of instructions per cycle ("ipc"), the ratios of
+ * cache and branch misses and an estimate of the memory bandwidth which assumes that
+ * each miss of the last level cache transfers a 64 byte cache line.
+ */
+class PerfCounters
+{
+    typedef std::chrono::steady_clock Clock;
+
+    // the maximum number of events of a group
+    static const unsigned maxEvents = 8;
+
+    // the assumed size of a cache line [byte]
+    static constexpr double cacheLineSize = 64.0;
+
+    struct EventDesc
+    {
+        std::string name;
+        std::uint32_t type;
+        std::uint64_t config;
+    };
+
+    struct Phase
+    {
+        const char *name;
+        unsigned long numCalls;
+        double time;
+        bool isActive;
+        Clock::time_point startTime;
+        std::vector<double> startCounts; // [threadIdx*numEvents + eventIdx]
+        std::vector<double> counts; // [threadIdx*numEvents + eventIdx]
+    };
+
+    struct State
+    {
+        State()
+            : enabled(false)
+        {}
+
+        ~State()
+        { closeAll_(*this); }
+
+        bool enabled;
+        std::vector<EventDesc> events;
+        std::vector<int> groupFds; // the file descriptors of the group leaders
+        std::vector<int> fds; // the file descriptors of all counters
+        std::vector<Phase> phases;
+    };
+
+public:
+    /*!
+     * \brief The counts of a phase accumulated over all threads and processes.
+     */
+    struct PhaseTotals
+    {
+        std::string name;
+        unsigned long numCalls;
+        double time; // [s], maximum over all processes
+        std::vector<double> counts; // [eventIdx], sum over all threads and processes
+        double threadImbalance; // maximum over the processes of max/mean of the first event
+    };
+
+    /*!
+     * \brief Open the counters for the given set of events.
+     *
+     * This method must be called by the main thread after the number of OpenMP threads
+     * has been set but before any phase is started. Events which are not supported by
+     * the CPU are dropped with a warning. This method is collective, i.e., the counters
+     * are only enabled if they could be opened on all processes.
+     *
+     * \param numThreads The number of threads of the OpenMP thread pool
+     * \param eventList A comma separated list of events using the names of the perf
+     *                  tool (e.g., "cycles,instructions,cache-misses"). Raw events can
+     *                  be specified as "r" followed by the hexadecimal event code.
+     * \param verbose If true, problems are reported on the standard error stream
+     *
+     * \return true if the counters are enabled
+     */
+    static bool init(unsigned numThreads, const std::string& eventList, bool verbose)
+    {
+        State& s = state_();
+        closeAll_(s);
+        s.events.clear();
+
+        bool ok = openCounters_(s, numThreads, eventList, verbose);
+
+        // all processes must count the same events for the reduction to make sense
+        unsigned numEvents = ok ? static_cast<unsigned>(s.events.size()) : 0;
+        unsigned minEvents = numEvents, maxNumEvents = numEvents;
+#if HAVE_MPI
+        int initialized;
+        MPI_Initialized(&initialized);
+        if (initialized) {
+            MPI_Allreduce(&numEvents, &minEvents, 1, MPI_UNSIGNED, MPI_MIN, MPI_COMM_WORLD);
+            MPI_Allreduce(&numEvents, &maxNumEvents, 1, MPI_UNSIGNED, MPI_MAX, MPI_COMM_WORLD);
+        }
+#endif
+        if (minEvents == 0 || minEvents != maxNumEvents) {
+            if (ok && verbose)
+                std::cerr << "Warning: The hardware performance counters are not available "
+                          << "on all processes. Disabling them.\n";
+            closeAll_(s);
+            s.events.clear();
+            return false;
+        }
+
+        s.enabled = true;
+        for (auto& phase : s.phases)
+            resetPhase_(s, phase);
+
+        return true;
+    }
+
+    /*!
+     * \brief Returns true if the hardware counters are sampled.
+     */
+    static bool isEnabled()
+    { return state_().enabled; }
+
+    /*!
+     * \brief Returns the names of the events which are counted.
+     */
+    static std::vector<std::string> eventNames()
+    {
+        std::vector<std::string> result;
+        for (const auto& ev : state_().events)
+            result.push_back(ev.name);
+        return result;
+    }
+
+    /*!
+     * \brief Returns the index of a phase of the given name.
+     *
+     * The phase is created if it does not exist yet. The name must be a string literal
+     * and all processes must create their phases in the same order.
+     */
+    static int phaseIndex(const char *name)
+    {
+        State& s = state_();
+        for (unsigned phaseIdx = 0; phaseIdx < s.phases.size(); ++phaseIdx)
+            if (std::strcmp(s.phases[phaseIdx].name, name) == 0)
+                return static_cast<int>(phaseIdx);
+
+        Phase phase;
+        phase.name = name;
+        resetPhase_(s, phase);
+        s.phases.push_back(phase);
+        return static_cast<int>(s.phases.size() - 1);
+    }
+
+    /*!
+     * \brief Start counting for a phase.
+     *
+     * \return true if the counters are sampled. Only in this case endPhase() must be
+     *         called.
+     */
+    static bool beginPhase(int phaseIdx)
+    {
+        State& s = state_();
+        if (!s.enabled)
+            return false;
+
+        Phase& phase = s.phases[static_cast<unsigned>(phaseIdx)];
+        if (phase.isActive)
+            return false;
+
+        phase.isActive = true;
+        phase.startTime = Clock::now();
+        readAll_(s, phase.startCounts);
+        return true;
+    }
+
+    /*!
+     * \brief Stop counting for a phase and accumulate the counts.
+     */
+    static void endPhase(int phaseIdx)
+    {
+        State& s = state_();
+        Phase& phase = s.phases[static_cast<unsigned>(phaseIdx)];
+        if (!s.enabled || !phase.isActive)
+            return;
+
+        static thread_local std::vector<double> stopCounts;
+        readAll_(s, stopCounts);
+        std::chrono::duration<double> dt = Clock::now() - phase.startTime;
+
+        for (unsigned i = 0; i < stopCounts.size(); ++i)
+            phase.counts[i] += std::max(0.0, stopCounts[i] - phase.startCounts[i]);
+        phase.time += dt.count();
+        ++phase.numCalls;
+        phase.isActive = false;
+    }
+
+    /*!
+     * \brief Returns the accumulated counts of all phases reduced over all processes.
+     *
+     * This method is collective. The result is empty if the counters are disabled.
+     */
+    static std::vector<PhaseTotals> globalTotals()
+    {
+        std::vector<PhaseTotals> result;
+        State& s = state_();
+        if (!s.enabled)
+            return result;
+
+        unsigned numEvents = static_cast<unsigned>(s.events.size());
+        unsigned numThreads = static_cast<unsigned>(s.groupFds.size());
+        for (const auto& phase : s.phases) {
+            PhaseTotals totals;
+            totals.name = phase.name;
+            totals.numCalls = phase.numCalls;
+            totals.time = phase.time;
+            totals.counts.assign(numEvents, 0.0);
+
+            double maxThreadCount = 0.0;
+            for (unsigned threadIdx = 0; threadIdx < numThreads; ++threadIdx) {
+                for (unsigned eventIdx = 0; eventIdx < numEvents; ++eventIdx)
+                    totals.counts[eventIdx] += phase.counts[threadIdx*numEvents + eventIdx];
+                maxThreadCount = std::max(maxThreadCount, phase.counts[threadIdx*numEvents]);
+            }
+
+            double meanThreadCount = totals.counts[0]/numThreads;
+            totals.threadImbalance =
+                (meanThreadCount > 0.0) ? maxThreadCount/meanThreadCount : 1.0;
+
+            result.push_back(totals);
+        }
+
+#if HAVE_MPI
+        int initialized;
+        MPI_Initialized(&initialized);
+        if (initialized) {
+            for (auto& totals : result) {
+                std::vector<double> localCounts(totals.counts);
+                MPI_Allreduce(localCounts.data(), totals.counts.data(),
+                              static_cast<int>(numEvents), MPI_DOUBLE, MPI_SUM,
+                              MPI_COMM_WORLD);
+
+                double localMax[2] = { totals.time, totals.threadImbalance };
+                double globalMax[2];
+                MPI_Allreduce(localMax, globalMax, 2, MPI_DOUBLE, MPI_MAX, MPI_COMM_WORLD);
+                totals.time = globalMax[0];
+                totals.threadImbalance = globalMax[1];
+            }
+        }
+#endif
+
+        return result;
+    }
+
+    /*!
+     * \brief Returns the difference between two sets of totals.
+     *
+     * This can be used to determine the counts of a time step or of a Newton iteration.
+     */
+    static PhaseTotals difference(const PhaseTotals& cur, const PhaseTotals& prev)
+    {
+        PhaseTotals result(cur);
+        result.numCalls -= prev.numCalls;
+        result.time -= prev.time;
+        for (unsigned eventIdx = 0; eventIdx < result.counts.size(); ++eventIdx)
+            result.counts[eventIdx] -= prev.counts[eventIdx];
+        return result;
+    }
+
+    /*!
+     * \brief Returns the metrics which can be derived from the counted events.
+     *
+     * The first entry of each pair is the name of the metric, the second one its value.
+     */
+    static std::vector<std::pair<std::string, double> > derivedMetrics(const PhaseTotals& totals)
+    {
+        std::vector<std::pair<std::string, double> > result;
+
+        auto ratio = [&](const char *name, const char *numerator, const char *denominator)
+        {
+            int numIdx = eventIndex_(numerator);
+            int denIdx = eventIndex_(denominator);
+            if (numIdx < 0 || denIdx < 0)
+                return;
+
+            double den = totals.counts[static_cast<unsigned>(denIdx)];
+            if (den > 0.0)
+                result.push_back(std::make_pair(std::string(name),
+                                                totals.counts[static_cast<unsigned>(numIdx)]/den));
+        };
+
+        ratio("ipc", "instructions", "cycles");
+        ratio("cache_miss_ratio", "cache-misses", "cache-references");
+        ratio("llc_miss_ratio", "LLC-load-misses", "LLC-loads");
+        ratio("l1d_miss_ratio", "L1-dcache-load-misses", "L1-dcache-loads");
+        ratio("branch_miss_ratio", "branch-misses", "branches");
+
+        // estimate the memory bandwidth from the misses of the last level cache. if
+        // these are not counted explicitly, use the generic cache misses, which refer to
+        // the last level cache on most CPUs
+        double numMisses = 0.0;
+        bool haveMisses = false;
+        for (const char *name : { "LLC-load-misses", "LLC-store-misses" }) {
+            int eventIdx = eventIndex_(name);
+            if (eventIdx >= 0) {
+                numMisses += totals.counts[static_cast<unsigned>(eventIdx)];
+                haveMisses = true;
+            }
+        }
+        if (!haveMisses) {
+            int eventIdx = eventIndex_("cache-misses");
+            if (eventIdx >= 0) {
+                numMisses = totals.counts[static_cast<unsigned>(eventIdx)];
+                haveMisses = true;
+            }
+        }
+        if (haveMisses && totals.time > 0.0)
+            result.push_back(std::make_pair(std::string("bandwidth_gbs"),
+                                            numMisses*cacheLineSize/totals.time/1e9));
+
+        return result;
+    }
+
+    /*!
+     * \brief Print the counts and the derived metrics of all phases aggregated over all
+     *        processes.
+     *
+     * This method is collective, but only the first process prints anything.
+     */
+    static void printSummary(std::ostream& os)
+    {
+        State& s = state_();
+        if (!s.enabled)
+            return;
+
+        std::vector<PhaseTotals> allTotals = globalTotals();
+
+        int rank = 0;
+#if HAVE_MPI
+        int initialized;
+        MPI_Initialized(&initialized);
+        if (initialized)
+            MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+#endif
+        if (rank != 0)
+            return;
+
+        std::ostringstream out;
+        out << "------------------ Hardware performance counters ------------------\n";
+        for (const auto& totals : allTotals) {
+            if (totals.numCalls == 0)
+                continue;
+
+            out << totals.name << ": " << totals.numCalls << " calls, "
+                << std::fixed << std::setprecision(3) << totals.time << " s";
+            for (const auto& metric : derivedMetrics(totals))
+                out << ", " << metric.first << " " << metric.second;
+            out << ", thread imbalance " << std::setprecision(2) << totals.threadImbalance
+                << "\n";
+
+            out << std::scientific << std::setprecision(3);
+            for (unsigned eventIdx = 0; eventIdx < s.events.size(); ++eventIdx)
+                out << "  " << std::left << std::setw(30) << s.events[eventIdx].name
+                    << std::right << std::setw(12) << totals.counts[eventIdx] << "\n";
+            out << std::defaultfloat;
+        }
+        out << "-------------------------------------------------------------------\n";
+
+        os << out.str() << std::flush;
+    }
+
+private:
+    static State& state_()
+    {
+        static State s;
+        return s;
+    }
+
+    static int eventIndex_(const char *name)
+    {
+        const State& s = state_();
+        for (unsigned eventIdx = 0; eventIdx < s.events.size(); ++eventIdx)
+            if (s.events[eventIdx].name == name)
+                return static_cast<int>(eventIdx);
+        return -1;
+    }
+
+    static void resetPhase_(const State& s, Phase& phase)
+    {
+        std::size_t n = s.groupFds.size()*s.events.size();
+        phase.numCalls = 0;
+        phase.time = 0.0;
+        phase.isActive = false;
+        phase.startCounts.assign(n, 0.0);
+        phase.counts.assign(n, 0.0);
+    }
+
+    static void closeAll_(State& s)
+    {
+#if defined(__linux__)
+        for (int fd : s.fds)
+            if (fd >= 0)
+                ::close(fd);
+#endif
+        s.fds.clear();
+        s.groupFds.clear();
+        s.enabled = false;
+    }
+
+#if defined(__linux__)
+    static bool lookupEvent_(const std::string& name, EventDesc& desc)
+    {
+        struct NamedEvent
+        {
+            const char *name;
+            std::uint32_t type;
+            std::uint64_t config;
+        };
+
+        auto cacheEvent = [](std::uint64_t cache, std::uint64_t op, std::uint64_t result)
+        { return cache | (op << 8) | (result << 16); };
+
+        static const NamedEvent namedEvents[] = {
+            { "cycles", PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES },
+            { "instructions", PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS },
+            { "cache-references", PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_REFERENCES },
+            { "cache-misses", PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES },
+            { "branches", PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_INSTRUCTIONS },
+            { "branch-misses", PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES },
+            { "ref-cycles", PERF_TYPE_HARDWARE, PERF_COUNT_HW_REF_CPU_CYCLES },
+            { "stalled-cycles-frontend", PERF_TYPE_HARDWARE, PERF_COUNT_HW_STALLED_CYCLES_FRONTEND },
+            { "stalled-cycles-backend", PERF_TYPE_HARDWARE, PERF_COUNT_HW_STALLED_CYCLES_BACKEND },
+            { "L1-dcache-loads", PERF_TYPE_HW_CACHE,
+              cacheEvent(PERF_COUNT_HW_CACHE_L1D, PERF_COUNT_HW_CACHE_OP_READ,
+                         PERF_COUNT_HW_CACHE_RESULT_ACCESS) },
+            { "L1-dcache-load-misses", PERF_TYPE_HW_CACHE,
+              cacheEvent(PERF_COUNT_HW_CACHE_L1D, PERF_COUNT_HW_CACHE_OP_READ,
+                         PERF_COUNT_HW_CACHE_RESULT_MISS) },
+            { "LLC-loads", PERF_TYPE_HW_CACHE,
+              cacheEvent(PERF_COUNT_HW_CACHE_LL, PERF_COUNT_HW_CACHE_OP_READ,
+                         PERF_COUNT_HW_CACHE_RESULT_ACCESS) },
+            { "LLC-load-misses", PERF_TYPE_HW_CACHE,
+              cacheEvent(PERF_COUNT_HW_CACHE_LL, PERF_COUNT_HW_CACHE_OP_READ,
+                         PERF_COUNT_HW_CACHE_RESULT_MISS) },
+            { "LLC-stores", PERF_TYPE_HW_CACHE,
+              cacheEvent(PERF_COUNT_HW_CACHE_LL, PERF_COUNT_HW_CACHE_OP_WRITE,
+                         PERF_COUNT_HW_CACHE_RESULT_ACCESS) },
+            { "LLC-store-misses", PERF_TYPE_HW_CACHE,
+              cacheEvent(PERF_COUNT_HW_CACHE_LL, PERF_COUNT_HW_CACHE_OP_WRITE,
+                         PERF_COUNT_HW_CACHE_RESULT_MISS) },
+        };
+
+        for (const auto& ev : namedEvents) {
+            if (name == ev.name) {
+                desc.name = name;
+                desc.type = ev.type;
+                desc.config = ev.config;
+                return true;
+            }
+        }
+
+        // raw events, e.g. "r01a2"
+        if (name.size() > 1 && name[0] == 'r') {
+            char *end;
+            std::uint64_t config = std::strtoull(name.c_str() + 1, &end, 16);
+            if (*end == '\0') {
+                desc.name = name;
+                desc.type = PERF_TYPE_RAW;
+                desc.config = config;
+                return true;
+            }
+        }
+
+        return false;
+    }
+
+    // opens a counter for the calling thread. returns -1 on failure
+    static int openCounter_(const EventDesc& desc, int groupFd)
+    {
+        struct perf_event_attr attr;
+        std::memset(&attr, 0, sizeof(attr));
+        attr.size = sizeof(attr);
+        attr.type = desc.type;
+        attr.config = desc.config;
+        attr.disabled = (groupFd < 0) ? 1 : 0;
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+        attr.read_format =
+            PERF_FORMAT_GROUP
+            | PERF_FORMAT_TOTAL_TIME_ENABLED
+            | PERF_FORMAT_TOTAL_TIME_RUNNING;
+
+        return static_cast<int>(::syscall(__NR_perf_event_open, &attr,
+                                          /*pid=*/0, /*cpu=*/-1, groupFd, /*flags=*/0UL));
+    }
+
+    // opens the counters of the calling thread. returns the file descriptor of the
+    // group leader or -1 on failure
+    static int openGroup_(const std::vector<EventDesc>& events, std::vector<int>& fds)
+    {
+        int groupFd = -1;
+        for (const auto& ev : events) {
+            int fd = openCounter_(ev, groupFd);
+            if (fd < 0)
+                return -1;
+            fds.push_back(fd);
+            if (groupFd < 0)
+                groupFd = fd;
+        }
+
+        ::ioctl(groupFd, PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+        ::ioctl(groupFd, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+        return groupFd;
+    }
+#endif // defined(__linux__)
+
+    static bool openCounters_(State& s, unsigned numThreads, const std::string& eventList,
+                              bool verbose)
+    {
+#if defined(__linux__)
+        // parse the list of events and drop the ones which cannot be counted on this
+        // machine
+        std::istringstream iss(eventList);
+        std::string name;
+        while (std::getline(iss, name, ',')) {
+            if (name.empty())
+                continue;
+
+            EventDesc desc;
+            if (!lookupEvent_(name, desc)) {
+                if (verbose)
+                    std::cerr << "Warning: Unknown hardware performance counter event '"
+                              << name << "'. Ignoring it.\n";
+                continue;
+            }
+
+            int fd = openCounter_(desc, /*groupFd=*/-1);
+            if (fd < 0) {
+                if (verbose)
+                    std::cerr << "Warning: The hardware performance counter event '"
+                              << name << "' is not available: " << std::strerror(errno)
+                              << ". Ignoring it.\n";
+                continue;
+            }
+            ::close(fd);
+
+            if (s.events.size() >= maxEvents) {
+                if (verbose)
+                    std::cerr << "Warning: At most " << maxEvents << " hardware performance "
+                              << "counter events are supported. Ignoring '" << name << "'.\n";
+                continue;
+            }
+            s.events.push_back(desc);
+        }
+
+        if (s.events.empty())
+            return false;
+
+        // open a group of counters for each thread of the thread pool
+        numThreads = std::max(1u, numThreads);
+        std::vector<int> groupFds(numThreads, -1);
+        std::vector<std::vector<int> > threadFds(numThreads);
+#ifdef _OPENMP
+#pragma omp parallel num_threads(static_cast<int>(numThreads))
+#endif
+        {
+#ifdef _OPENMP
+            unsigned threadIdx = static_cast<unsigned>(omp_get_thread_num());
+#else
+            unsigned threadIdx = 0;
+#endif
+            groupFds[threadIdx] = openGroup_(s.events, threadFds[threadIdx]);
+        }
+
+        bool ok = true;
+        for (unsigned threadIdx = 0; threadIdx < numThreads; ++threadIdx) {
+            s.fds.insert(s.fds.end(), threadFds[threadIdx].begin(), threadFds[threadIdx].end());
+            ok = ok && groupFds[threadIdx] >= 0;
+        }
+        s.groupFds = groupFds;
+
+        if (!ok) {
+            if (verbose)
+                std::cerr << "Warning: The hardware performance counters could not be "
+                          << "opened for all threads. Disabling them.\n";
+            closeAll_(s);
+            return false;
+        }
+
+        return true;
+#else
+        if (verbose && !eventList.empty())
+            std::cerr << "Warning: Hardware performance counters are only supported on "
+                      << "Linux. Disabling them.\n";
+        return false;
+#endif
+    }
+
+    // read the counters of all threads. if the group has been multiplexed with other
+    // counters, the counts are extrapolated to the time the group was enabled
+    static void readAll_(const State& s, std::vector<double>& counts)
+    {
+        unsigned numEvents = static_cast<unsigned>(s.events.size());
+        counts.assign(s.groupFds.size()*numEvents, 0.0);
+
+#if defined(__linux__)
+        for (unsigned threadIdx = 0; threadIdx < s.groupFds.size(); ++threadIdx) {
+            // layout: number of events, time enabled, time running, values
+            std::uint64_t buffer[3 + maxEvents];
+            ssize_t n = ::read(s.groupFds[threadIdx], buffer, sizeof(buffer));
+            if (n < static_cast<ssize_t>((3 + numEvents)*sizeof(std::uint64_t)))
+                continue;
+
+            double scale = 1.0;
+            if (buffer[2] > 0 && buffer[2] < buffer[1])
+                scale = static_cast<double>(buffer[1])/static_cast<double>(buffer[2]);
+            for (unsigned eventIdx = 0; eventIdx < numEvents; ++eventIdx)
+                counts[threadIdx*numEvents + eventIdx] =
+                    static_cast<double>(buffer[3 + eventIdx])*scale;
+        }
+#endif
+    }
+};
+
+} // namespace Ewoms
+
+#endif
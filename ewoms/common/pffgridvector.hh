@@ -117,6 +117,12 @@ public:
         return elemData_[elemIdx][localDofIdx];
     }
 
+    /*!
+     * \brief Returns the number of bytes allocated by the container.
+     */
+    size_t memoryUsage() const
+    { return data_.capacity()*sizeof(Data) + elemData_.capacity()*sizeof(Data*); }
+
 private:
     unsigned computeNumLocalDofs_() const
     {
@@ -0,0 +1,555 @@
+// -*- mode: C++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*-
+// vi: set et ts=4 sw=4 sts=4:
+/*
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+
+  Consult the COPYING file in the top-level source directory of this
+  module for the precise wording of the license and the list of
+  copyright holders.
+*/
+/*!
+ * \file
+ *
+ * \copydoc Ewoms::Profiler
+ */
+#ifndef EWOMS_PROFILER_HH
+#define EWOMS_PROFILER_HH
+
+#include <algorithm>
+#include <cassert>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <limits>
+#include <map>
+#include <memory>
+#include <ostream>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#if HAVE_MPI
+#include <mpi.h>
+#endif
+
+namespace Ewoms {
+/*!
+ * \ingroup Common
+ *
+ * \brief A low-overhead profiler for nested regions of code.
+ *
+ * Regions are opened and closed using beginRegion() and endRegion(), or more
+ * conveniently using Ewoms::ProfileRegion objects or named Ewoms::Timer objects. The
+ * regions of each thread are arranged in a tree, i.e., a region which is opened while
+ * another one is active is considered to be a part of the latter. For each node of this
+ * tree, the number of calls and the accumulated wall time are recorded. Additionally,
+ * each closed region is stored as an event in a per-thread ring buffer of fixed size,
+ * i.e., if more events are recorded, the oldest ones get overwritten.
+ *
+ * At the end of a simulation, the events can be written as a Chrome trace (to be viewed
+ * using chrome://tracing or https://ui.perfetto.dev) and an aggregated table which
+ * lists the minimum, the average and the maximum time of each region over all
+ * processes can be printed. Both operations are collective if MPI is used. The time
+ * stamps of the trace are relative to the call of init() on the respective process.
+ *
+ * The profiler is disabled by default. If it is disabled or init() has not been called,
+ * opening a region costs a single branch. Region names must be string literals (or
+ * otherwise outlive the profiler) and must not contain the '/' character.
+ */
+class Profiler
+{
+    typedef std::chrono::steady_clock Clock;
+    typedef std::int64_t TimeStamp; // [ns] since the call of init()
+
+    struct Event
+    {
+        const char *name;
+        TimeStamp begin;
+        TimeStamp duration;
+    };
+
+    struct Node
+    {
+        const char *name;
+        unsigned numCalls;
+        TimeStamp totalTime;
+        std::vector<std::pair<const char *, unsigned> > children;
+    };
+
+    struct OpenRegion
+    {
+        unsigned nodeIdx;
+        TimeStamp begin;
+    };
+
+    struct ThreadData
+    {
+        std::vector<Event> events;
+        std::size_t numEvents; // total number of events which have been recorded
+        std::vector<Node> nodes; // the root node is node 0
+        std::vector<OpenRegion> openRegions;
+    };
+
+    struct State
+    {
+        State()
+            : enabled(false)
+            , epoch(Clock::now())
+        {}
+
+        bool enabled;
+        Clock::time_point epoch;
+        std::vector<std::unique_ptr<ThreadData> > threadData;
+    };
+
+    struct RegionStats
+    {
+        RegionStats()
+            : numCalls(0), maxThreadTime(0.0), sumThreadTime(0.0), numThreads(0)
+        {}
+
+        unsigned long numCalls;
+        double maxThreadTime;
+        double sumThreadTime;
+        unsigned numThreads;
+    };
+
+public:
+    /*!
+     * \brief Allocate the data structures of the profiler.
+     *
+     * This must be called by the main thread before any region is opened.
+     *
+     * \param numThreads The maximum number of threads which open regions
+     * \param eventsPerThread The capacity of the event ring buffer of each thread
+     */
+    static void init(unsigned numThreads, unsigned eventsPerThread)
+    {
+        State& s = state_();
+        s.epoch = Clock::now();
+        s.threadData.clear();
+        for (unsigned threadIdx = 0; threadIdx < numThreads; ++threadIdx) {
+            ThreadData *td = new ThreadData;
+            td->events.resize(std::max(1u, eventsPerThread));
+            td->numEvents = 0;
+            td->nodes.resize(1);
+            td->nodes[0].name = "";
+            td->nodes[0].numCalls = 0;
+            td->nodes[0].totalTime = 0;
+            s.threadData.emplace_back(td);
+        }
+    }
+
+    /*!
+     * \brief Turn the recording of regions on or off.
+     *
+     * Regions which were opened before the profiler was disabled are still closed
+     * properly.
+     */
+    static void setEnabled(bool yesno)
+    { state_().enabled = yesno; }
+
+    /*!
+     * \brief Returns true if regions are currently recorded.
+     */
+    static bool isEnabled()
+    { return state_().enabled; }
+
+    /*!
+     * \brief Open a region on the current thread.
+     *
+     * \return true if the region is recorded. Only in this case, endRegion() must be
+     *         called to close it.
+     */
+    static bool beginRegion(const char *name)
+    {
+        State& s = state_();
+        if (!s.enabled)
+            return false;
+
+        ThreadData *td = threadData_(s);
+        if (!td)
+            return false;
+
+        unsigned parentIdx = td->openRegions.empty() ? 0 : td->openRegions.back().nodeIdx;
+        unsigned nodeIdx = childNode_(*td, parentIdx, name);
+
+        OpenRegion r;
+        r.nodeIdx = nodeIdx;
+        r.begin = now_(s);
+        td->openRegions.push_back(r);
+        return true;
+    }
+
+    /*!
+     * \brief Close the region of the current thread which was opened last.
+     */
+    static void endRegion()
+    {
+        State& s = state_();
+        ThreadData *td = threadData_(s);
+        if (!td || td->openRegions.empty())
+            return;
+
+        TimeStamp t = now_(s);
+        const OpenRegion& r = td->openRegions.back();
+        Node& node = td->nodes[r.nodeIdx];
+        ++node.numCalls;
+        node.totalTime += t - r.begin;
+
+        Event& ev = td->events[td->numEvents % td->events.size()];
+        ev.name = node.name;
+        ev.begin = r.begin;
+        ev.duration = t - r.begin;
+        ++td->numEvents;
+
+        td->openRegions.pop_back();
+    }
+
+    /*!
+     * \brief Write the recorded events of all threads and processes to a file in the
+     *        Chrome trace event format.
+     *
+     * In the trace, each process corresponds to an MPI rank. This method is collective.
+     */
+    static void writeChromeTrace(const std::string& fileName)
+    {
+        State& s = state_();
+
+        // serialize the events of the local process
+        int rank = commRank_();
+        std::ostringstream oss;
+        oss << "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":" << rank
+            << ",\"args\":{\"name\":\"rank " << rank << "\"}}";
+        for (unsigned threadIdx = 0; threadIdx < s.threadData.size(); ++threadIdx) {
+            const ThreadData& td = *s.threadData[threadIdx];
+            if (td.numEvents == 0)
+                continue;
+
+            oss << ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":" << rank
+                << ",\"tid\":" << threadIdx
+                << ",\"args\":{\"name\":\"thread " << threadIdx << "\"}}";
+
+            std::size_t capacity = td.events.size();
+            std::size_t n = std::min(td.numEvents, capacity);
+            for (std::size_t i = td.numEvents - n; i < td.numEvents; ++i) {
+                const Event& ev = td.events[i % capacity];
+                oss << ",\n{\"name\":\"" << ev.name << "\",\"ph\":\"X\""
+                    << ",\"pid\":" << rank << ",\"tid\":" << threadIdx
+                    << std::fixed << std::setprecision(3)
+                    << ",\"ts\":" << ev.begin*1e-3
+                    << ",\"dur\":" << ev.duration*1e-3 << "}";
+            }
+        }
+
+        std::vector<std::string> allEvents = gatherStrings_(oss.str());
+        if (rank != 0)
+            return;
+
+        std::ofstream os(fileName);
+        os << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+        for (unsigned procIdx = 0; procIdx < allEvents.size(); ++procIdx) {
+            if (procIdx > 0)
+                os << ",\n";
+            os << allEvents[procIdx];
+        }
+        os << "\n]}\n";
+    }
+
+    /*!
+     * \brief Print the time spent in each region aggregated over all processes.
+     *
+     * The time of a region on a given process is the maximum over its threads. For
+     * each region, the number of calls summed over all processes, the minimum, average
+     * and maximum time over the processes as well as the load imbalance between the
+     * processes and the worst load imbalance between the threads of a process is
+     * printed. This method is collective, but only the first process prints anything.
+     */
+    static void printSummary(std::ostream& os)
+    {
+        typedef std::map<std::string, RegionStats> StatsMap;
+
+        // aggregate the regions over the threads of the local process
+        State& s = state_();
+        StatsMap localStats;
+        for (unsigned threadIdx = 0; threadIdx < s.threadData.size(); ++threadIdx) {
+            const ThreadData& td = *s.threadData[threadIdx];
+            std::vector<std::pair<unsigned, std::string> > todo;
+            todo.push_back(std::make_pair(0u, std::string("")));
+            while (!todo.empty()) {
+                auto cur = todo.back();
+                todo.pop_back();
+                const Node& node = td.nodes[cur.first];
+                for (const auto& child : node.children) {
+                    std::string path = cur.second.empty()
+                        ? std::string(child.first)
+                        : cur.second + "/" + child.first;
+
+                    const Node& childNode = td.nodes[child.second];
+                    double t = childNode.totalTime*1e-9;
+                    RegionStats& stats = localStats[path];
+                    stats.numCalls += childNode.numCalls;
+                    stats.maxThreadTime = std::max(stats.maxThreadTime, t);
+                    stats.sumThreadTime += t;
+                    ++stats.numThreads;
+
+                    todo.push_back(std::make_pair(child.second, path));
+                }
+            }
+        }
+
+        std::ostringstream oss;
+        oss << std::setprecision(std::numeric_limits<double>::digits10 + 2);
+        for (const auto& entry : localStats)
+            oss << entry.first << "\t" << entry.second.numCalls << "\t"
+                << entry.second.maxThreadTime << "\t"
+                << entry.second.sumThreadTime/entry.second.numThreads << "\n";
+
+        std::vector<std::string> allStats = gatherStrings_(oss.str());
+        if (commRank_() != 0)
+            return;
+
+        // aggregate over the processes. the path is split into its components in order
+        // to get the order of a depth-first traversal when sorting
+        struct GlobalStats
+        {
+            std::vector<double> rankTimes;
+            unsigned long numCalls;
+            double maxThreadImbalance;
+        };
+        typedef std::vector<std::string> Path;
+        std::map<Path, GlobalStats> globalStats;
+        unsigned numProcs = static_cast<unsigned>(allStats.size());
+        for (unsigned procIdx = 0; procIdx < numProcs; ++procIdx) {
+            std::istringstream iss(allStats[procIdx]);
+            std::string line;
+            while (std::getline(iss, line)) {
+                std::istringstream lineStream(line);
+                std::string pathString;
+                unsigned long numCalls;
+                double maxThreadTime, avgThreadTime;
+                std::getline(lineStream, pathString, '\t');
+                lineStream >> numCalls >> maxThreadTime >> avgThreadTime;
+
+                Path path;
+                std::istringstream pathStream(pathString);
+                std::string component;
+                while (std::getline(pathStream, component, '/'))
+                    path.push_back(component);
+
+                auto it = globalStats.find(path);
+                if (it == globalStats.end()) {
+                    GlobalStats& gs = globalStats[path];
+                    gs.rankTimes.assign(numProcs, 0.0);
+                    gs.numCalls = 0;
+                    gs.maxThreadImbalance = 1.0;
+                    it = globalStats.find(path);
+                }
+
+                GlobalStats& gs = it->second;
+                gs.rankTimes[procIdx] = maxThreadTime;
+                gs.numCalls += numCalls;
+                if (avgThreadTime > 0)
+                    gs.maxThreadImbalance = std::max(gs.maxThreadImbalance,
+                                                     maxThreadTime/avgThreadTime);
+            }
+        }
+
+        std::ostringstream out;
+        out << "------------------------ Profiling summary ------------------------\n"
+            << std::left << std::setw(40) << "region"
+            << std::right
+            << std::setw(10) << "calls"
+            << std::setw(11) << "min[s]"
+            << std::setw(11) << "avg[s]"
+            << std::setw(11) << "max[s]"
+            << std::setw(10) << "rank imb"
+            << std::setw(10) << "thr imb"
+            << "\n";
+        for (const auto& entry : globalStats) {
+            const Path& path = entry.first;
+            const GlobalStats& gs = entry.second;
+
+            double minTime = *std::min_element(gs.rankTimes.begin(), gs.rankTimes.end());
+            double maxTime = *std::max_element(gs.rankTimes.begin(), gs.rankTimes.end());
+            double avgTime = 0.0;
+            for (double t : gs.rankTimes)
+                avgTime += t;
+            avgTime /= numProcs;
+
+            std::string name = std::string(2*(path.size() - 1), ' ') + path.back();
+            out << std::left << std::setw(40) << name
+                << std::right << std::fixed
+                << std::setw(10) << gs.numCalls
+                << std::setprecision(3)
+                << std::setw(11) << minTime
+                << std::setw(11) << avgTime
+                << std::setw(11) << maxTime
+                << std::setprecision(2)
+                << std::setw(10) << ((avgTime > 0) ? maxTime/avgTime : 1.0)
+                << std::setw(10) << gs.maxThreadImbalance
+                << "\n";
+        }
+
+        std::size_t numDropped = 0;
+        for (const auto& td : s.threadData)
+            if (td->numEvents > td->events.size())
+                numDropped += td->numEvents - td->events.size();
+        if (numDropped > 0)
+            out << "Note: " << numDropped << " events of the first process were dropped "
+                << "from the trace because the buffers were full\n";
+        out << "-------------------------------------------------------------------\n";
+
+        os << out.str() << std::flush;
+    }
+
+private:
+    static State& state_()
+    {
+        static State s;
+        return s;
+    }
+
+    static ThreadData *threadData_(State& s)
+    {
+#ifdef _OPENMP
+        unsigned threadIdx = static_cast<unsigned>(omp_get_thread_num());
+#else
+        unsigned threadIdx = 0;
+#endif
+        if (threadIdx >= s.threadData.size())
+            return 0;
+        return s.threadData[threadIdx].get();
+    }
+
+    static TimeStamp now_(const State& s)
+    {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now()
+                                                                    - s.epoch).count();
+    }
+
+    // returns the index of the child of a node with a given name. the node is created
+    // if it does not exist yet
+    static unsigned childNode_(ThreadData& td, unsigned parentIdx, const char *name)
+    {
+        // the '/' character separates the components of the region paths
+        assert(std::strchr(name, '/') == 0);
+
+        auto& children = td.nodes[parentIdx].children;
+        for (const auto& child : children)
+            if (child.first == name || std::strcmp(child.first, name) == 0)
+                return child.second;
+
+        unsigned nodeIdx = static_cast<unsigned>(td.nodes.size());
+        td.nodes[parentIdx].children.push_back(std::make_pair(name, nodeIdx));
+
+        Node node;
+        node.name = name;
+        node.numCalls = 0;
+        node.totalTime = 0;
+        td.nodes.push_back(node);
+
+        return nodeIdx;
+    }
+
+    static int commRank_()
+    {
+        int rank = 0;
+#if HAVE_MPI
+        int initialized;
+        MPI_Initialized(&initialized);
+        if (initialized)
+            MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+#endif
+        return rank;
+    }
+
+    // collect a string from each process on the first one. the result is empty on all
+    // other processes
+    static std::vector<std::string> gatherStrings_(const std::string& localString)
+    {
+        std::vector<std::string> result;
+
+#if HAVE_MPI
+        int initialized;
+        MPI_Initialized(&initialized);
+        if (initialized) {
+            int rank, size;
+            MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+            MPI_Comm_size(MPI_COMM_WORLD, &size);
+
+            int localLength = static_cast<int>(localString.size());
+            std::vector<int> lengths(static_cast<std::size_t>(size));
+            MPI_Gather(&localLength, 1, MPI_INT,
+                       lengths.data(), 1, MPI_INT,
+                       /*root=*/0, MPI_COMM_WORLD);
+
+            std::vector<int> offsets(static_cast<std::size_t>(size), 0);
+            for (int i = 1; i < size; ++i)
+                offsets[i] = offsets[i - 1] + lengths[i - 1];
+
+            std::vector<char> buffer(std::max(1, offsets.back() + lengths.back()));
+            MPI_Gatherv(const_cast<char *>(localString.data()), localLength, MPI_CHAR,
+                        buffer.data(), lengths.data(), offsets.data(), MPI_CHAR,
+                        /*root=*/0, MPI_COMM_WORLD);
+
+            if (rank == 0)
+                for (int i = 0; i < size; ++i)
+                    result.push_back(std::string(buffer.data() + offsets[i],
+                                                 static_cast<std::size_t>(lengths[i])));
+            return result;
+        }
+#endif
+
+        result.push_back(localString);
+        return result;
+    }
+};
+
+/*!
+ * \ingroup Common
+ *
+ * \brief Records a profiling region for the lifetime of the object.
+ */
+class ProfileRegion
+{
+public:
+    explicit ProfileRegion(const char *name)
+        : active_(Profiler::beginRegion(name))
+    {}
+
+    ProfileRegion(const ProfileRegion&) = delete;
+
+    ~ProfileRegion()
+    {
+        if (active_)
+            Profiler::endRegion();
+    }
+
+private:
+    bool active_;
+};
+
+} // namespace Ewoms
+
+#endif
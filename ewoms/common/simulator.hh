@@ -29,11 +29,16 @@
 #define EWOMS_SIMULATOR_HH
 
 #include <ewoms/io/restart.hh>
+#include <ewoms/io/telemetrywriter.hh>
 #include <ewoms/common/parametersystem.hh>
 
 #include <ewoms/common/propertysystem.hh>
 #include <ewoms/common/timer.hh>
 #include <ewoms/common/timerguard.hh>
+#include <ewoms/common/profiler.hh>
+#include <ewoms/common/perfcounters.hh>
+#include <ewoms/common/memoryusage.hh>
+#include <ewoms/parallel/loadimbalancemonitor.hh>
 
 #include <dune/common/version.hh>
 #include <dune/common/parallel/mpihelper.hh>
@@ -56,6 +61,15 @@ NEW_PROP_TAG(EndTime);
 NEW_PROP_TAG(RestartTime);
 NEW_PROP_TAG(InitialTimeStepSize);
 NEW_PROP_TAG(PredeterminedTimeStepsFile);
+NEW_PROP_TAG(ThreadManager);
+NEW_PROP_TAG(EnableProfiling);
+NEW_PROP_TAG(ProfilingTraceFile);
+NEW_PROP_TAG(ProfilingEventsPerThread);
+NEW_PROP_TAG(TelemetryFile);
+NEW_PROP_TAG(PrintMemoryUsage);
+NEW_PROP_TAG(EnablePerfCounters);
+NEW_PROP_TAG(PerfCounterEvents);
+NEW_PROP_TAG(LoadImbalanceReportInterval);
 }
 
 /*!
@@ -78,6 +92,7 @@ class Simulator
     typedef typename GET_PROP_TYPE(TypeTag, GridView) GridView;
     typedef typename GET_PROP_TYPE(TypeTag, Model) Model;
     typedef typename GET_PROP_TYPE(TypeTag, Problem) Problem;
+    typedef typename GET_PROP_TYPE(TypeTag, ThreadManager) ThreadManager;
 
 
 public:
@@ -86,6 +101,25 @@ public:
 
     Simulator(bool verbose = true)
     {
+        // the event buffers of the profiler are large, so they are only allocated if
+        // profiling was requested. without them, no regions are recorded
+        if (EWOMS_GET_PARAM(TypeTag, bool, EnableProfiling)) {
+            Profiler::init(ThreadManager::maxThreads(),
+                           EWOMS_GET_PARAM(TypeTag, unsigned, ProfilingEventsPerThread));
+            Profiler::setEnabled(true);
+        }
+
+        if (EWOMS_GET_PARAM(TypeTag, bool, EnablePerfCounters))
+            PerfCounters::init(ThreadManager::maxThreads(),
+                               EWOMS_GET_PARAM(TypeTag, std::string, PerfCounterEvents),
+                               Dune::MPIHelper::getCollectiveCommunication().rank() == 0);
+
+        setupTimer_.setProfileRegion("setup");
+        executionTimer_.setProfileRegion("simulation");
+        prePostProcessTimer_.setProfileRegion("prepostprocess");
+        writeTimer_.setProfileRegion("write output");
+        writeTimer_.setPerfCounterPhase("write");
+
         Ewoms::TimerGuard setupTimerGuard(setupTimer_);
 
         setupTimer_.start();
@@ -115,6 +149,14 @@ public:
 
         finished_ = false;
 
+        numNewtonIterations_ = 0;
+        numLinearIterations_ = 0;
+
+        reportedLinearizationCost_ = 0.0;
+
+        telemetry_.open(EWOMS_GET_PARAM(TypeTag, std::string, TelemetryFile),
+                        Dune::MPIHelper::getCollectiveCommunication());
+
         if (verbose_)
             std::cout << "Allocating the grid\n" << std::flush;
         gridManager_.reset(new GridManager(*this));
@@ -135,6 +177,11 @@ public:
             std::cout << "Finish init of the model\n" << std::flush;
         model_->finishInit();
 
+        // take a sample before the problem is initialized because some problems
+        // release data which is only required for the initialization
+        if (EWOMS_GET_PARAM(TypeTag, int, PrintMemoryUsage) > 0)
+            sampleMemoryUsage();
+
         if (verbose_)
             std::cout << "Finish init of the problem\n" << std::flush;
         problem_->finishInit();
@@ -159,6 +206,33 @@ public:
         EWOMS_REGISTER_PARAM(TypeTag, std::string, PredeterminedTimeStepsFile,
                              "A file with a list of predetermined time step sizes (one "
                              "time step per line)");
+        EWOMS_REGISTER_PARAM(TypeTag, bool, EnableProfiling,
+                             "Record the time spent in the profiling regions and print "
+                             "a summary at the end of the simulation");
+        EWOMS_REGISTER_PARAM(TypeTag, std::string, ProfilingTraceFile,
+                             "The name of the file to which the profiling regions are "
+                             "written in the Chrome trace format");
+        EWOMS_REGISTER_PARAM(TypeTag, unsigned, ProfilingEventsPerThread,
+                             "The maximum number of profiling events which are kept for "
+                             "the trace of each thread");
+        EWOMS_REGISTER_PARAM(TypeTag, std::string, TelemetryFile,
+                             "The name of the file to which a JSON record is appended "
+                             "for each Newton iteration and each time step");
+        EWOMS_REGISTER_PARAM(TypeTag, int, PrintMemoryUsage,
+                             "Print the memory used by the subsystems of the simulator. "
+                             "0: never, 1: at the beginning and at the end of the "
+                             "simulation, 2: additionally after each time step");
+        EWOMS_REGISTER_PARAM(TypeTag, bool, EnablePerfCounters,
+                             "Sample the hardware performance counters of the CPU for the "
+                             "linearization, the linear solver, the Newton update and the "
+                             "output and print a summary at the end of the simulation");
+        EWOMS_REGISTER_PARAM(TypeTag, std::string, PerfCounterEvents,
+                             "The comma separated list of hardware performance counter "
+                             "events which are sampled using the names of the perf tool. "
+                             "Raw events can be specified as 'r<hex code>'");
+        EWOMS_REGISTER_PARAM(TypeTag, unsigned, LoadImbalanceReportInterval,
+                             "The number of time steps after which the load imbalance "
+                             "of the linearization is reported. 0 disables the report");
 
         GridManager::registerParameters();
         Model::registerParameters();
@@ -324,6 +398,54 @@ public:
     const Ewoms::Timer& writeTimer() const
     { return writeTimer_; }
 
+    /*!
+     * \brief Returns the total number of Newton iterations of the simulation.
+     */
+    unsigned long numNewtonIterations() const
+    { return numNewtonIterations_; }
+
+    /*!
+     * \brief Returns the total number of iterations of the linear solver of the
+     *        simulation.
+     */
+    unsigned long numLinearIterations() const
+    { return numLinearIterations_; }
+
+    /*!
+     * \brief Returns the sink for the telemetry records of the simulation.
+     *
+     * Records are only written if the TelemetryFile parameter has been specified.
+     */
+    TelemetryWriter& telemetry()
+    { return telemetry_; }
+
+    /*!
+     * \brief Determine the memory currently used by the subsystems of the simulator and
+     *        update their high-water marks.
+     *
+     * This only considers the local process.
+     */
+    void sampleMemoryUsage()
+    {
+        memoryReport_.beginSample();
+        gridManager_->reportMemoryUsage(memoryReport_);
+        model_->reportMemoryUsage(memoryReport_);
+        problem_->reportMemoryUsage(memoryReport_);
+        memoryReport_.endSample();
+    }
+
+    /*!
+     * \brief Print the memory currently used by the subsystems of the simulator and
+     *        their high-water marks.
+     *
+     * This is a collective operation. The table is only printed by the first process.
+     */
+    void printMemoryUsage()
+    {
+        sampleMemoryUsage();
+        memoryReport_.print(std::cout, gridView().comm());
+    }
+
     /*!
      * \brief Set the current time step size to a given value.
      *
@@ -584,6 +706,10 @@ public:
         }
         setupTimer_.stop();
 
+        int printMemoryUsageMode = EWOMS_GET_PARAM(TypeTag, int, PrintMemoryUsage);
+        if (printMemoryUsageMode > 0)
+            printMemoryUsage();
+
         executionTimer_.start();
         bool episodeBegins = episodeIsOver() || (timeStepIdx_ == 0);
         // do the time steps
@@ -633,6 +759,8 @@ public:
                 linearizeTimer_ += model.linearizeTimer();
                 solveTimer_ += model.solveTimer();
                 updateTimer_ += model.updateTimer();
+                numNewtonIterations_ += model.numNewtonIterations();
+                numLinearIterations_ += model.numLinearIterations();
 
                 throw;
             }
@@ -642,6 +770,8 @@ public:
             linearizeTimer_ += model.linearizeTimer();
             solveTimer_ += model.solveTimer();
             updateTimer_ += model.updateTimer();
+            numNewtonIterations_ += model.numNewtonIterations();
+            numLinearIterations_ += model.numLinearIterations();
 
             // post-process the current solution
             prePostProcessTimer_.start();
@@ -671,6 +801,19 @@ public:
             time_ += oldDt;
             ++timeStepIdx_;
 
+            if (printMemoryUsageMode > 1)
+                printMemoryUsage();
+            else if (printMemoryUsageMode > 0)
+                sampleMemoryUsage();
+
+            if (telemetry_.isEnabled() && PerfCounters::isEnabled())
+                writePerfCounterTelemetry_();
+
+            unsigned loadImbalanceInterval =
+                EWOMS_GET_PARAM(TypeTag, unsigned, LoadImbalanceReportInterval);
+            if (loadImbalanceInterval > 0 && timeStepIdx_ % loadImbalanceInterval == 0)
+                reportLoadImbalance_();
+
             prePostProcessTimer_.start();
             // notify the problem if an episode is finished
             if (episodeIsOver()) {
@@ -702,6 +845,20 @@ public:
         executionTimer_.stop();
 
         problem_->finalize();
+        telemetry_.flush();
+
+        if (printMemoryUsageMode > 0)
+            printMemoryUsage();
+
+        PerfCounters::printSummary(std::cout);
+
+        if (EWOMS_GET_PARAM(TypeTag, bool, EnableProfiling)) {
+            Profiler::printSummary(std::cout);
+
+            const std::string& traceFile = EWOMS_GET_PARAM(TypeTag, std::string, ProfilingTraceFile);
+            if (!traceFile.empty())
+                Profiler::writeChromeTrace(traceFile);
+        }
     }
 
     /*!
@@ -853,6 +1010,58 @@ public:
     }
 
 private:
+    // print the load imbalance of the linearization since the last report
+    void reportLoadImbalance_()
+    {
+        const auto& linearizer = model_->linearizer();
+
+        // the costs are reset if the linearizer is re-created
+        double localCost = linearizer.localCost();
+        if (localCost < reportedLinearizationCost_)
+            reportedLinearizationCost_ = 0.0;
+
+        loadImbalance_.update(localCost - reportedLinearizationCost_, gridView().comm());
+        reportedLinearizationCost_ = localCost;
+
+        if (verbose_)
+            loadImbalance_.print(std::cout, "the linearization");
+
+        if (telemetry_.isEnabled()) {
+            TelemetryRecord record("load_imbalance");
+            record.add("time_step", timeStepIdx_)
+                .add("min_cost", loadImbalance_.minCost())
+                .add("mean_cost", loadImbalance_.meanCost())
+                .add("max_cost", loadImbalance_.maxCost())
+                .add("slowest_rank", loadImbalance_.slowestRank())
+                .add("imbalance", loadImbalance_.imbalance())
+                .add("idle_fraction", loadImbalance_.idleFraction());
+            telemetry_.write(record);
+        }
+    }
+
+    // write the hardware performance counters of the phases since the last time step
+    void writePerfCounterTelemetry_()
+    {
+        std::vector<PerfCounters::PhaseTotals> totals = PerfCounters::globalTotals();
+
+        TelemetryRecord record("perf_counters");
+        record.add("time_step", timeStepIdx_);
+        for (unsigned phaseIdx = 0; phaseIdx < totals.size(); ++phaseIdx) {
+            PerfCounters::PhaseTotals delta = totals[phaseIdx];
+            if (phaseIdx < perfCounterTotals_.size())
+                delta = PerfCounters::difference(totals[phaseIdx], perfCounterTotals_[phaseIdx]);
+            if (delta.numCalls == 0)
+                continue;
+
+            record.add(delta.name + "_time", delta.time);
+            for (const auto& metric : PerfCounters::derivedMetrics(delta))
+                record.add(delta.name + "_" + metric.first, metric.second);
+        }
+        telemetry_.write(record);
+
+        perfCounterTotals_ = totals;
+    }
+
     std::unique_ptr<GridManager> gridManager_;
     std::unique_ptr<Model> model_;
     std::unique_ptr<Problem> problem_;
@@ -868,6 +1077,13 @@ private:
     Ewoms::Timer solveTimer_;
     Ewoms::Timer updateTimer_;
     Ewoms::Timer writeTimer_;
+    unsigned long numNewtonIterations_;
+    unsigned long numLinearIterations_;
+    TelemetryWriter telemetry_;
+    MemoryReport memoryReport_;
+    LoadImbalanceMonitor loadImbalance_;
+    double reportedLinearizationCost_;
+    std::vector<PerfCounters::PhaseTotals> perfCounterTotals_;
 
     std::vector<Scalar> forcedTimeSteps_;
     Scalar startTime_;
@@ -28,6 +28,9 @@
 #ifndef EWOMS_TIMER_HH
 #define EWOMS_TIMER_HH
 
+#include "profiler.hh"
+#include "perfcounters.hh"
+
 #include <chrono>
 
 #if HAVE_MPI
@@ -44,6 +47,12 @@ namespace Ewoms {
  * used by all threads of a single process and the CPU time used by
  * the overall simulation. (i.e., the time used by all threads of all
  * involved processes.)
+ *
+ * If a profiling region is associated with a timer, the region is recorded by
+ * Ewoms::Profiler whenever the timer is active. Similarly, the hardware performance
+ * counters are sampled by Ewoms::PerfCounters if the timer is associated with a counter
+ * phase. Since Ewoms::TimerGuard stops the timer, the region and the phase are also
+ * closed properly if an exception is thrown.
  */
 class Timer
 {
@@ -54,13 +63,41 @@ class Timer
     };
 public:
     Timer()
+        : profileRegion_(0)
+        , isProfiling_(false)
+        , perfCounterPhase_(-1)
+        , isCounting_(false)
     { halt(); }
 
+    /*!
+     * \brief Set the name of the profiling region which is recorded while the timer is
+     *        active.
+     *
+     * The name must be a string literal. Passing 0 disables profiling for the timer.
+     */
+    void setProfileRegion(const char *name)
+    { profileRegion_ = name; }
+
+    /*!
+     * \brief Set the name of the phase for which the hardware performance counters are
+     *        accumulated while the timer is active.
+     *
+     * The name must be a string literal. Passing 0 disables the counters for the timer.
+     */
+    void setPerfCounterPhase(const char *name)
+    { perfCounterPhase_ = name ? PerfCounters::phaseIndex(name) : -1; }
+
     /*!
      * \brief Start counting the time resources used by the simulation.
      */
     void start()
     {
+        endProfiling_();
+        if (profileRegion_)
+            isProfiling_ = Profiler::beginRegion(profileRegion_);
+        if (perfCounterPhase_ >= 0)
+            isCounting_ = PerfCounters::beginPhase(perfCounterPhase_);
+
         isStopped_ = false;
         measure_(startTime_);
     }
@@ -88,6 +125,7 @@ public:
                                     - startTime_.cputimeData)/CLOCKS_PER_SEC;
         }
 
+        endProfiling_();
         isStopped_ = true;
 
         return realTimeElapsed_;
@@ -98,6 +136,7 @@ public:
      */
     void halt()
     {
+        endProfiling_();
         isStopped_ = true;
         cpuTimeElapsed_ = 0.0;
         realTimeElapsed_ = 0.0;
@@ -197,6 +236,17 @@ public:
     }
 
 private:
+    void endProfiling_()
+    {
+        if (isProfiling_)
+            Profiler::endRegion();
+        isProfiling_ = false;
+
+        if (isCounting_)
+            PerfCounters::endPhase(perfCounterPhase_);
+        isCounting_ = false;
+    }
+
     // measure the current time and put it into the object passed via
     // the argument.
     static void measure_(TimeData& timeData)
@@ -211,6 +261,10 @@ private:
     double cpuTimeElapsed_;
     double realTimeElapsed_;
     TimeData startTime_;
+    const char *profileRegion_;
+    bool isProfiling_;
+    int perfCounterPhase_;
+    bool isCounting_;
 };
 } // namespace Ewoms
 
@@ -36,6 +36,8 @@ namespace Ewoms {
  *
  * \brief A simple class which makes sure that a timer gets stopped if an exception is
  *        thrown.
+ *
+ * This also closes the profiling region of the timer (if any).
  */
 class TimerGuard
 {
@@ -45,15 +45,17 @@
 #include "fvbaseprimaryvariables.hh"
 #include "fvbaseintensivequantities.hh"
 #include "fvbaseextensivequantities.hh"
+#include "fvbasetimestepcontroller.hh"
 
 #include <ewoms/parallel/gridcommhandles.hh>
 #include <ewoms/parallel/threadmanager.hh>
+#include <ewoms/parallel/firsttouchallocator.hh>
 #include <ewoms/linear/nullborderlistmanager.hh>
 #include <ewoms/common/simulator.hh>
 #include <ewoms/aux/baseauxiliarymodule.hh>
-#include <ewoms/common/alignedallocator.hh>
 #include <ewoms/common/timer.hh>
 #include <ewoms/common/timerguard.hh>
+#include <ewoms/common/memoryusage.hh>
 
 #include <opm/material/common/MathToolbox.hpp>
 #include <opm/common/Valgrind.hpp>
@@ -74,6 +76,7 @@
 
 #include <limits>
 #include <list>
+#include <memory>
 #include <sstream>
 #include <string>
 #include <vector>
@@ -128,6 +131,19 @@ public:
 //! Newton solver
 SET_INT_PROP(FvBaseDiscretization, MaxTimeStepDivisions, 10);
 
+//! By default, the time step size is determined by the number of Newton iterations
+SET_TYPE_PROP(FvBaseDiscretization, TimeStepController,
+              Ewoms::IterationCountTimeStepController<TypeTag>);
+
+//! Allow the time step size to grow directly after a failed time step by default
+SET_INT_PROP(FvBaseDiscretization, TimeStepGrowthDelay, 0);
+
+//! Do not limit the growth of the time step size by default
+SET_SCALAR_PROP(FvBaseDiscretization, TimeStepMaxGrowthFactor, 1e100);
+
+//! Target a relative change of the solution of 10% per time step
+SET_SCALAR_PROP(FvBaseDiscretization, PidTimeStepTolerance, 0.1);
+
 /*!
  * \brief A vector of quanties, each for one equation.
  */
@@ -173,9 +189,23 @@ SET_TYPE_PROP(FvBaseDiscretization, PrimaryVariables, Ewoms::FvBasePrimaryVariab
 
 /*!
  * \brief The type of a solution for the whole grid at a fixed time.
+ *
+ * The first-touch allocator distributes the memory pages of the solutions over the NUMA
+ * nodes of the threads which work on them. If dune-fem is available, the solutions are
+ * stored by its discrete functions which always use the default allocator.
  */
-SET_TYPE_PROP(FvBaseDiscretization, SolutionVector,
-              Dune::BlockVector<typename GET_PROP_TYPE(TypeTag, PrimaryVariables)>);
+SET_PROP(FvBaseDiscretization, SolutionVector)
+{
+private:
+    typedef typename GET_PROP_TYPE(TypeTag, PrimaryVariables) PrimaryVariables;
+#if HAVE_DUNE_FEM
+    typedef std::allocator<PrimaryVariables> Allocator;
+#else
+    typedef Ewoms::FirstTouchAllocator<PrimaryVariables, alignof(PrimaryVariables)> Allocator;
+#endif
+public:
+    typedef Dune::BlockVector<PrimaryVariables, Allocator> type;
+};
 
 /*!
  * \brief The class representing intensive quantities.
@@ -196,8 +226,18 @@ SET_TYPE_PROP(FvBaseDiscretization, ConstraintsContext, Ewoms::FvBaseConstraints
  */
 SET_TYPE_PROP(FvBaseDiscretization, ThreadManager, Ewoms::ThreadManager<TypeTag>);
 SET_INT_PROP(FvBaseDiscretization, ThreadsPerProcess, 1);
+SET_STRING_PROP(FvBaseDiscretization, ThreadAffinity, "none");
 SET_BOOL_PROP(FvBaseDiscretization, UseLinearizationLock, true);
 
+//! Relinearize all elements in every Newton iteration by default
+SET_BOOL_PROP(FvBaseDiscretization, EnableActiveSetLinearization, false);
+
+//! Relinearize the elements adjacent to DOFs whose solution changed by more than 10^-6
+SET_SCALAR_PROP(FvBaseDiscretization, ActiveSetLinearizationTolerance, 1e-6);
+
+//! Evaluate the intensive quantities while the elements are linearized by default
+SET_BOOL_PROP(FvBaseDiscretization, PrecomputeIntensiveQuantities, false);
+
 /*!
  * \brief Linearizer for the global system of equations.
  */
@@ -219,6 +259,9 @@ SET_BOOL_PROP(FvBaseDiscretization, EnableGridAdaptation, false);
 //! Enable the VTK output by default
 SET_BOOL_PROP(FvBaseDiscretization, EnableVtkOutput, true);
 
+//! Do not write snapshot files by default
+SET_BOOL_PROP(FvBaseDiscretization, EnableSnapshotOutput, false);
+
 //! Set the format of the VTK output to ASCII by default
 SET_INT_PROP(FvBaseDiscretization, VtkOutputFormat, Dune::VTK::ascii);
 
@@ -296,7 +339,10 @@ class FvBaseDiscretization
         historySize = GET_PROP_VALUE(TypeTag, TimeDiscHistorySize),
     };
 
-    typedef std::vector<IntensiveQuantities, Ewoms::aligned_allocator<IntensiveQuantities, alignof(IntensiveQuantities)> > IntensiveQuantitiesVector;
+    // the caches are allocated in the constructor by the main thread. the first-touch
+    // allocator distributes their memory pages over the NUMA nodes of the threads
+    typedef std::vector<IntensiveQuantities, Ewoms::FirstTouchAllocator<IntensiveQuantities, alignof(IntensiveQuantities)> > IntensiveQuantitiesVector;
+    typedef Dune::BlockVector<EqVector, Ewoms::FirstTouchAllocator<EqVector, alignof(EqVector)> > StorageCacheVector;
 
     typedef typename GridView::template Codim<0>::Entity Element;
     typedef typename GridView::template Codim<0>::Iterator ElementIterator;
@@ -382,6 +428,9 @@ public:
 
         enableStorageCache_ = EWOMS_GET_PARAM(TypeTag, bool, EnableStorageCache);
 
+        numNewtonIterations_ = 0;
+        numLinearIterations_ = 0;
+
         size_t numDof = asImp_().numGridDof();
         for (unsigned timeIdx = 0; timeIdx < historySize; ++timeIdx) {
             solution_[timeIdx].reset(new DiscreteFunction("solution", space_));
@@ -428,6 +477,7 @@ public:
 
         EWOMS_REGISTER_PARAM(TypeTag, bool, EnableGridAdaptation, "Enable adaptive grid refinement/coarsening");
         EWOMS_REGISTER_PARAM(TypeTag, bool, EnableVtkOutput, "Global switch for turing on writing VTK files");
+        EWOMS_REGISTER_PARAM(TypeTag, bool, EnableSnapshotOutput, "Global switch for turning on writing memory-mappable binary snapshot files");
         EWOMS_REGISTER_PARAM(TypeTag, bool, EnableThermodynamicHints, "Enable thermodynamic hints");
         EWOMS_REGISTER_PARAM(TypeTag, bool, EnableIntensiveQuantityCache, "Turn on caching of intensive quantities");
         EWOMS_REGISTER_PARAM(TypeTag, bool, EnableStorageCache, "Store previous storage terms and avoid re-calculating them.");
@@ -504,6 +554,9 @@ public:
                           false);
             }
         }
+
+        updateThreadPartition_();
+        updateDofOwners_();
     }
 
     /*!
@@ -690,6 +743,69 @@ public:
         }
     }
 
+    /*!
+     * \brief Update all entries of the intensive quantity cache for a time index which
+     *        are not up to date.
+     *
+     * The intensive quantities of the primary degrees of freedom of each element are
+     * evaluated back to back in a separate sweep over the grid. This keeps the code and
+     * the data of the constitutive relations hot instead of interleaving their
+     * evaluation with the computation of the fluxes. A degree of freedom may be a
+     * primary degree of freedom of several elements (e.g., the vertices for the
+     * vertex-centered finite volume method), so its intensive quantities are only
+     * evaluated for the first of these elements. Each cache entry is thus written by a
+     * single thread. If the cache for the intensive quantities is disabled, this method
+     * does nothing.
+     *
+     * \param timeIdx The index used by the time discretization.
+     */
+    void updateIntensiveQuantityCache(unsigned timeIdx = 0) const
+    {
+        if (!enableIntensiveQuantitiesCache_())
+            return;
+
+        ThreadedEntityIterator<GridView, /*codim=*/0>
+            threadedElemIt(gridView_, threadElementBegins_);
+#ifdef _OPENMP
+#pragma omp parallel
+#endif
+        {
+            // Attention: the variables below are thread specific and thus cannot be
+            // moved in front of the #pragma!
+            ElementContext elemCtx(simulator_);
+            ElementIterator elemIt = threadedElemIt.beginParallel();
+            for (; !threadedElemIt.isFinished(elemIt); elemIt = threadedElemIt.increment()) {
+                const Element& elem = *elemIt;
+#if DUNE_VERSION_NEWER(DUNE_COMMON, 2,4)
+                unsigned elemIdx = static_cast<unsigned>(elementMapper_.index(elem));
+#else
+                unsigned elemIdx = static_cast<unsigned>(elementMapper_.map(elem));
+#endif
+
+                // skip the element if the intensive quantities of all primary degrees
+                // of freedom which it is responsible for are already up to date
+                elemCtx.updatePrimaryStencil(elem);
+                bool upToDate = true;
+                size_t numPrimaryDof = elemCtx.numPrimaryDof(timeIdx);
+                for (unsigned dofIdx = 0; dofIdx < numPrimaryDof && upToDate; ++dofIdx) {
+                    unsigned globalIdx = elemCtx.globalSpaceIndex(dofIdx, timeIdx);
+                    if (dofOwnerElement_[globalIdx] == elemIdx)
+                        upToDate = intensiveQuantityCacheUpToDate_[timeIdx][globalIdx];
+                }
+                if (upToDate)
+                    continue;
+
+                elemCtx.updateStencil(elem);
+                for (unsigned dofIdx = 0; dofIdx < numPrimaryDof; ++dofIdx) {
+                    unsigned globalIdx = elemCtx.globalSpaceIndex(dofIdx, timeIdx);
+                    if (dofOwnerElement_[globalIdx] == elemIdx
+                        && !intensiveQuantityCacheUpToDate_[timeIdx][globalIdx])
+                        elemCtx.updateCachedIntensiveQuantities(dofIdx, timeIdx);
+                }
+            }
+        }
+    }
+
     /*!
      * \brief Move the intensive quantities for a given time index to the back.
      *
@@ -1118,6 +1234,22 @@ public:
         return 1.0/std::max(absPv, 1.0);
     }
 
+    /*!
+     * \brief Returns true if a primary variable of a degree of freedom should be
+     *        considered by time-step controllers which are driven by the change of
+     *        the solution.
+     *
+     * By default, all primary variables are considered. Models which use primary
+     * variables with a varying meaning should restrict this to quantities like
+     * pressures and saturations.
+     *
+     * \param globalDofIdx The global index of the degree of freedom
+     * \param pvIdx The index of the primary variable
+     */
+    bool primaryVarControlsTimeStep(unsigned globalDofIdx OPM_UNUSED,
+                                    unsigned pvIdx OPM_UNUSED) const
+    { return true; }
+
     /*!
      * \brief Returns the relative weight of an equation
      *
@@ -1186,6 +1318,8 @@ public:
             linearizeTimer_ += newtonMethod_.linearizeTimer();
             solveTimer_ += newtonMethod_.solveTimer();
             updateTimer_ += newtonMethod_.updateTimer();
+            numNewtonIterations_ = static_cast<unsigned>(newtonMethod_.numIterations());
+            numLinearIterations_ = newtonMethod_.numLinearIterations();
 
             throw;
         }
@@ -1194,6 +1328,8 @@ public:
         linearizeTimer_ += newtonMethod_.linearizeTimer();
         solveTimer_ += newtonMethod_.solveTimer();
         updateTimer_ += newtonMethod_.updateTimer();
+        numNewtonIterations_ = static_cast<unsigned>(newtonMethod_.numIterations());
+        numLinearIterations_ = newtonMethod_.numLinearIterations();
 
         prePostProcessTimer_.start();
         if (converged)
@@ -1425,6 +1561,18 @@ public:
     size_t numTotalDof() const
     { return asImp_().numGridDof() + numAuxiliaryDof(); }
 
+    /*!
+     * \brief Returns the first element of each thread for the static partition of the
+     *        elements.
+     *
+     * This is meant to be passed to Ewoms::ThreadedEntityIterator. The iterators are
+     * determined once for each grid, so that the threads do not need to step through
+     * the elements which precede their own ones for each sweep over the grid. The
+     * result is empty if ThreadManager::staticPartitioning() is false.
+     */
+    const std::vector<ElementIterator>& threadElementBegins() const
+    { return threadElementBegins_; }
+
     /*!
      * \brief Mapper to convert the Dune entities of the
      *        discretization's degrees of freedoms are to indices.
@@ -1735,7 +1883,96 @@ public:
     const Ewoms::Timer& updateTimer() const
     { return updateTimer_; }
 
+    /*!
+     * \brief Returns the number of Newton iterations of the last call to update().
+     */
+    unsigned numNewtonIterations() const
+    { return numNewtonIterations_; }
+
+    /*!
+     * \brief Returns the number of iterations of the linear solver of the last call to
+     *        update().
+     */
+    unsigned numLinearIterations() const
+    { return numLinearIterations_; }
+
+    /*!
+     * \brief Add the memory used by the model to a report.
+     *
+     * This covers the solutions of all time indices, the caches, the linearized system
+     * of equations and the linear solver.
+     */
+    void reportMemoryUsage(MemoryReport& report) const
+    {
+        size_t solutionBytes = 0;
+        size_t intQuantsBytes = 0;
+        size_t storageBytes = 0;
+        for (unsigned timeIdx = 0; timeIdx < historySize; ++timeIdx) {
+            if (solution_[timeIdx])
+                solutionBytes += dynamicMemoryUsage(solution(timeIdx));
+
+            // the intensive quantities are assumed not to allocate memory themselves
+            intQuantsBytes +=
+                intensiveQuantityCache_[timeIdx].capacity()*sizeof(IntensiveQuantities)
+                + dynamicMemoryUsage(intensiveQuantityCacheUpToDate_[timeIdx]);
+            storageBytes += dynamicMemoryUsage(storageCache_[timeIdx]);
+        }
+        intQuantsBytes += dynamicMemoryUsage(dofOwnerElement_);
+
+        report.add("solution", solutionBytes);
+        report.add("intensive quantity cache", intQuantsBytes);
+        report.add("storage cache", storageBytes);
+        report.add("dof volumes",
+                   dynamicMemoryUsage(dofTotalVolume_) + dynamicMemoryUsage(isLocalDof_));
+
+        linearizer_->reportMemoryUsage(report);
+        newtonMethod_.reportMemoryUsage(report);
+    }
+
 protected:
+    // determine the first element of each thread for the static partition of the
+    // elements
+    void updateThreadPartition_()
+    {
+        threadElementBegins_.clear();
+        if (!ThreadManager::staticPartitioning())
+            return;
+
+        threadElementBegins_ =
+            ThreadedEntityIterator<GridView, /*codim=*/0>::partitionBegins(gridView_,
+                                                                         ThreadManager::maxThreads());
+    }
+
+    // determine the element which is responsible for evaluating the intensive quantities
+    // of each degree of freedom in updateIntensiveQuantityCache(). this is the first
+    // element which contains the degree of freedom as a primary one.
+    void updateDofOwners_()
+    {
+        dofOwnerElement_.clear();
+        if (!enableIntensiveQuantitiesCache_())
+            return;
+
+        dofOwnerElement_.resize(asImp_().numGridDof(), std::numeric_limits<unsigned>::max());
+        Stencil stencil(gridView_, asImp_().dofMapper());
+        ElementIterator elemIt = gridView_.template begin</*codim=*/0>();
+        const ElementIterator& elemEndIt = gridView_.template end</*codim=*/0>();
+        for (; elemIt != elemEndIt; ++elemIt) {
+            const Element& elem = *elemIt;
+#if DUNE_VERSION_NEWER(DUNE_COMMON, 2,4)
+            unsigned elemIdx = static_cast<unsigned>(elementMapper_.index(elem));
+#else
+            unsigned elemIdx = static_cast<unsigned>(elementMapper_.map(elem));
+#endif
+
+            stencil.updatePrimaryTopology(elem);
+            for (unsigned dofIdx = 0; dofIdx < stencil.numPrimaryDof(); ++dofIdx) {
+                unsigned globalIdx = stencil.globalSpaceIndex(dofIdx);
+                if (dofOwnerElement_[globalIdx] == std::numeric_limits<unsigned>::max())
+                    dofOwnerElement_[globalIdx] = elemIdx;
+            }
+        }
+    }
+
     void resizeAndResetIntensiveQuantitiesCache_()
     {
         // allocate the storage cache
@@ -1822,6 +2059,8 @@ protected:
     Ewoms::Timer linearizeTimer_;
     Ewoms::Timer solveTimer_;
     Ewoms::Timer updateTimer_;
+    unsigned numNewtonIterations_;
+    unsigned numLinearIterations_;
 
     // calculates the local jacobian matrix for a given element
     std::vector<LocalLinearizer> localLinearizer_;
@@ -1832,7 +2071,10 @@ protected:
     // cur is the current iterative solution, prev the converged
     // solution of the previous time step
     mutable IntensiveQuantitiesVector intensiveQuantityCache_[historySize];
-    mutable std::vector<bool> intensiveQuantityCacheUpToDate_[historySize];
+    // the flags are bytes instead of bits so that different threads can update the flags
+    // of different degrees of freedom concurrently
+    mutable std::vector<unsigned char> intensiveQuantityCacheUpToDate_[historySize];
+    std::vector<unsigned> dofOwnerElement_;
 
     DiscreteFunctionSpace space_;
     mutable std::array< std::unique_ptr< DiscreteFunction >, historySize > solution_;
@@ -1850,7 +2092,8 @@ protected:
     std::vector<bool> isLocalDof_;
 
     bool enableGridAdaptation_;
-    mutable GlobalEqVector storageCache_[historySize];
+    mutable StorageCacheVector storageCache_[historySize];
+    std::vector<ElementIterator> threadElementBegins_;
     bool enableStorageCache_;
 };
 } // namespace Ewoms
@@ -225,6 +225,30 @@ public:
     void updatePrimaryIntensiveQuantities(unsigned timeIdx)
     { updateIntensiveQuantities_(timeIdx, numPrimaryDof(timeIdx)); }
 
+    /*!
+     * \brief Compute the intensive quantities of a single sub-control volume of the
+     *        current element from the model's solution and store them in the model's
+     *        cache.
+     *
+     * In contrast to updatePrimaryIntensiveQuantities(), the cache is not queried and
+     * the gradients are not updated. The stencil of the element must be up to date.
+     *
+     * \param dofIdx The local index in the current element of the sub-control volume
+     *               which should be updated.
+     * \param timeIdx The index of the solution vector used by the time discretization.
+     */
+    void updateCachedIntensiveQuantities(unsigned dofIdx, unsigned timeIdx)
+    {
+        unsigned globalIdx = globalSpaceIndex(dofIdx, timeIdx);
+
+        dofVars_[dofIdx].thermodynamicHint[timeIdx] =
+            model().thermodynamicHint(globalIdx, timeIdx);
+        updateSingleIntQuants_(model().solution(timeIdx)[globalIdx], dofIdx, timeIdx);
+        model().updateCachedIntensiveQuantities(dofVars_[dofIdx].intensiveQuantities[timeIdx],
+                                                globalIdx,
+                                                timeIdx);
+    }
+
     /*!
      * \brief Compute the intensive quantities of a single sub-control volume of the
      *        current element for a single time index.
@@ -34,13 +34,20 @@
 #include <ewoms/parallel/threadmanager.hh>
 #include <ewoms/parallel/threadedentityiterator.hh>
 #include <ewoms/aux/baseauxiliarymodule.hh>
+#include <ewoms/common/parametersystem.hh>
+#include <ewoms/common/profiler.hh>
+#include <ewoms/common/memoryusage.hh>
 
 #include <opm/common/ErrorMacros.hpp>
 #include <opm/common/Exceptions.hpp>
 
 #include <dune/common/fvector.hh>
 #include <dune/common/fmatrix.hh>
+#include <dune/common/version.hh>
 
+#include <algorithm>
+#include <chrono>
+#include <cmath>
 #include <type_traits>
 #include <iostream>
 #include <vector>
@@ -59,6 +66,29 @@ class EcfvDiscretization;
  * This class assumes that these system of equations to be linearized are stemming from
  * models that use an finite volume scheme for spatial discretization and an Euler
  * scheme for time discretization.
+ *
+ * If the EnableActiveSetLinearization parameter is set, the contributions of each
+ * element to the Jacobian matrix are kept between Newton iterations. Within a time step,
+ * only the elements which contain at least one degree of freedom whose primary
+ * variables changed by more than the relative tolerance specified by the
+ * ActiveSetLinearizationTolerance parameter since it was last considered are
+ * linearized again. For all other elements, only the local residual is evaluated and
+ * the Jacobian contributions of the previous linearization are reused. The residual
+ * and thus the convergence criterion of the Newton method are therefore always exact;
+ * only the Jacobian matrix is approximate. Elements which are coupled to auxiliary
+ * equations (e.g., wells) are always linearized and the first iteration of each time
+ * step linearizes the whole grid. Note that this roughly doubles the memory required
+ * for the linearized system of equations and that the savings are largest if the
+ * partial derivatives are computed using finite differences.
+ *
+ * If the PrecomputeIntensiveQuantities parameter is set and the cache for the
+ * intensive quantities is enabled, the intensive quantities of all degrees of freedom
+ * are updated in a separate sweep over the grid before the elements are linearized, so
+ * that the linearization of the elements only needs to look them up.
+ *
+ * If the load imbalance is monitored, the time spent for the linearization of the
+ * elements is measured by each thread. These costs are accumulated until resetCosts()
+ * is called.
  */
 template<class TypeTag>
 class FvBaseLinearizer
@@ -99,6 +129,8 @@ class FvBaseLinearizer
     typedef Dune::FieldMatrix<Scalar, numEq, numEq> MatrixBlock;
     typedef Dune::FieldVector<Scalar, numEq> VectorBlock;
 
+    typedef std::chrono::high_resolution_clock Clock;
+
     static const bool linearizeNonLocalElements = GET_PROP_VALUE(TypeTag, LinearizeNonLocalElements);
 
     // copying the linearizer is not a good idea
@@ -111,6 +143,10 @@ public:
         simulatorPtr_ = 0;
 
         matrix_ = 0;
+        numActiveDof_ = 0;
+
+        measureCosts_ = false;
+        auxiliaryCost_ = 0.0;
     }
 
     ~FvBaseLinearizer()
@@ -126,7 +162,17 @@ public:
      * \brief Register all run-time parameters for the Jacobian linearizer.
      */
     static void registerParameters()
-    { }
+    {
+        EWOMS_REGISTER_PARAM(TypeTag, bool, EnableActiveSetLinearization,
+                             "Only relinearize the elements for which the solution "
+                             "changed significantly during a time step");
+        EWOMS_REGISTER_PARAM(TypeTag, Scalar, ActiveSetLinearizationTolerance,
+                             "The relative change of a primary variable above which "
+                             "the adjacent elements are relinearized");
+        EWOMS_REGISTER_PARAM(TypeTag, bool, PrecomputeIntensiveQuantities,
+                             "Update the cached intensive quantities of all degrees of "
+                             "freedom before the elements are linearized");
+    }
 
     /*!
      * \brief Initialize the linearizer.
@@ -142,6 +188,11 @@ public:
         simulatorPtr_ = &simulator;
         delete matrix_; // <- note that this even works for nullpointers!
         matrix_ = 0;
+
+        elementLinearizations_.clear();
+
+        measureCosts_ = EWOMS_GET_PARAM(TypeTag, unsigned, LoadImbalanceReportInterval) > 0;
+        resetCosts();
     }
 
     /*!
@@ -155,6 +206,8 @@ public:
     {
         delete matrix_; // <- note that this even works for nullpointers!
         matrix_ = 0;
+
+        elementLinearizations_.clear();
     }
 
     /*!
@@ -234,7 +287,111 @@ public:
     const std::map<unsigned, Constraints>& constraintsMap() const
     { return constraintsMap_; }
 
+    /*!
+     * \brief Returns the number of degrees of freedom which were considered to be active
+     *        by the last linearization.
+     *
+     * If the active set linearization is disabled, all degrees of freedom of the grid
+     * are active.
+     */
+    size_t numActiveDof() const
+    { return numActiveDof_; }
+
+    /*!
+     * \brief Returns the time in seconds spent for the linearization of the elements and
+     *        of the auxiliary equations of the local process since the last call to
+     *        resetCosts().
+     */
+    double localCost() const
+    {
+        double result = auxiliaryCost_;
+        for (double threadCost : threadCosts_)
+            result += threadCost;
+        return result;
+    }
+
+    /*!
+     * \brief Reset the measured linearization costs to zero.
+     */
+    void resetCosts()
+    {
+        if (measureCosts_)
+            threadCosts_.assign(ThreadManager::maxThreads(), 0.0);
+        else
+            threadCosts_.clear();
+        auxiliaryCost_ = 0.0;
+    }
+
+    /*!
+     * \brief Add the memory used by the linearized system of equations to a report.
+     */
+    void reportMemoryUsage(MemoryReport& report) const
+    {
+        report.add("jacobian matrix", matrix_ ? dynamicMemoryUsage(*matrix_) : 0);
+        report.add("residual", dynamicMemoryUsage(residual_));
+
+        // the element contributions kept by the active set linearization and the
+        // bookkeeping of the degrees of freedom
+        size_t elemBytes = dynamicMemoryUsage(elementLinearizations_);
+        for (const auto& elemLin : elementLinearizations_)
+            elemBytes +=
+                elemLin.dofIndices.capacity()*sizeof(unsigned)
+                + elemLin.jacobian.capacity()*sizeof(MatrixBlock);
+        elemBytes += dynamicMemoryUsage(isCoupledToAuxiliary_);
+        elemBytes += dynamicMemoryUsage(isActiveDof_);
+        elemBytes += linearizationPoint_.capacity()*sizeof(typename SolutionVector::block_type);
+        elemBytes += dynamicMemoryUsage(constraintsMap_);
+        report.add("linearizer element data", elemBytes);
+    }
+
+    /*!
+     * \brief Add the contributions of an element which were computed by a local
+     *        linearizer to the global Jacobian matrix and to the global residual.
+     *
+     * This is only called internally by linearize(). It is public so that the cost of
+     * the global scatter can be measured in isolation. Note that the caller is
+     * responsible for locking if multiple threads are used.
+     */
+    template <class LocalLinearizer>
+    void addToGlobalSystem(const ElementContext& elemCtx,
+                           const LocalLinearizer& localLinearizer)
+    {
+        size_t numPrimaryDof = elemCtx.numPrimaryDof(/*timeIdx=*/0);
+        size_t numDof = elemCtx.numDof(/*timeIdx=*/0);
+        for (unsigned primaryDofIdx = 0; primaryDofIdx < numPrimaryDof; ++ primaryDofIdx) {
+            unsigned globI = elemCtx.globalSpaceIndex(/*spaceIdx=*/primaryDofIdx, /*timeIdx=*/0);
+
+            // update the right hand side
+            residual_[globI] += localLinearizer.residual(primaryDofIdx);
+
+            // update the global Jacobian matrix
+            for (unsigned dofIdx = 0; dofIdx < numDof; ++ dofIdx) {
+                unsigned globJ = elemCtx.globalSpaceIndex(/*spaceIdx=*/dofIdx, /*timeIdx=*/0);
+
+                (*matrix_)[globJ][globI] += localLinearizer.jacobian(dofIdx, primaryDofIdx);
+            }
+        }
+    }
+
 private:
+    // the contributions of a single element to the linearized system of equations
+    struct ElementLinearization
+    {
+        ElementLinearization()
+            : numPrimaryDof(0)
+            , coupledToAuxiliary(false)
+        {}
+
+        // the global indices of the element's degrees of freedom. the primary ones come
+        // first
+        std::vector<unsigned> dofIndices;
+        unsigned numPrimaryDof;
+        bool coupledToAuxiliary;
+
+        // the Jacobian blocks, stored as [primaryDofIdx*dofIndices.size() + dofIdx]
+        std::vector<MatrixBlock> jacobian;
+    };
+
     Simulator& simulator_()
     { return *simulatorPtr_; }
     const Simulator& simulator_() const
@@ -265,9 +422,8 @@ private:
         createMatrix_();
 
         // initialize the Jacobian matrix and the vector for the residual function
-        *matrix_ = 0;
         residual_.resize(model_().numTotalDof());
-        residual_ = 0;
+        resetSystem_();
 
         // create the per-thread context objects
         elementCtx_.resize(ThreadManager::maxThreads());
@@ -312,6 +468,17 @@ private:
         for (unsigned auxModIdx = 0; auxModIdx < numAuxMod; ++auxModIdx)
             model.auxiliaryModule(auxModIdx)->addNeighbors(neighbors);
 
+        // remember which degrees of freedom of the grid are coupled to the auxiliary
+        // equations. the contributions of the elements which contain them cannot be
+        // reused by the active set linearization because the auxiliary degrees of
+        // freedom are not tracked.
+        size_t numGridDof = model.numGridDof();
+        isCoupledToAuxiliary_.assign(numGridDof, false);
+        for (unsigned dofIdx = 0; dofIdx < numGridDof; ++ dofIdx) {
+            if (!neighbors[dofIdx].empty() && *neighbors[dofIdx].rbegin() >= numGridDof)
+                isCoupledToAuxiliary_[dofIdx] = true;
+        }
+
         // allocate space for the rows of the matrix
         for (unsigned dofIdx = 0; dofIdx < numAllDof; ++ dofIdx)
             matrix_->setrowsize(dofIdx, neighbors[dofIdx].size());
@@ -395,12 +562,35 @@ private:
 
         applyConstraintsToSolution_();
 
+        // if the contributions of the elements are kept, the ones of the elements which
+        // did not change significantly since the last iteration are reused. this is only
+        // possible within a time step because the storage term of the previous time
+        // level and the time step size change between time steps.
+        bool activeSet = enableActiveSetLinearization_();
+        bool relinearizeAll =
+            !activeSet
+            || model_().newtonMethod().numIterations() == 0
+            || elementLinearizations_.empty();
+        if (activeSet) {
+            if (elementLinearizations_.empty())
+                elementLinearizations_.resize(static_cast<size_t>(gridView_().size(/*codim=*/0)));
+            updateActiveDofs_(relinearizeAll);
+        }
+        else
+            numActiveDof_ = model_().numGridDof();
+
+        if (EWOMS_GET_PARAM(TypeTag, bool, PrecomputeIntensiveQuantities))
+            model_().updateIntensiveQuantityCache(/*timeIdx=*/0);
+
         // relinearize the elements...
-        ThreadedEntityIterator<GridView, /*codim=*/0> threadedElemIt(gridView_());
+        ThreadedEntityIterator<GridView, /*codim=*/0>
+            threadedElemIt(gridView_(), model_().threadElementBegins());
 #ifdef _OPENMP
 #pragma omp parallel
 #endif
         {
+            ProfileRegion profileRegion("element loop");
+
             ElementIterator elemIt = threadedElemIt.beginParallel();
             ElementIterator nextElemIt = elemIt;
             for (; !threadedElemIt.isFinished(elemIt); elemIt = nextElemIt) {
@@ -421,17 +611,45 @@ private:
                 if (!linearizeNonLocalElements && elem.partitionType() != Dune::InteriorEntity)
                     continue;
 
-                linearizeElement_(elem);
+                Clock::time_point startTime;
+                if (measureCosts_)
+                    startTime = Clock::now();
+
+                if (activeSet) {
+                    ElementLinearization& elemLin = elementLinearizations_[elementIndex_(elem)];
+                    if (!relinearizeAll && !isActive_(elemLin))
+                        evalElementResidual_(elem, elemLin);
+                    else
+                        linearizeElement_(elem, &elemLin);
+                }
+                else
+                    linearizeElement_(elem);
+
+                // each thread only accumulates its own cost, so no locking is required
+                if (measureCosts_)
+                    threadCosts_[ThreadManager::threadId()] += secondsSince_(startTime);
             }
         }
 
         applyConstraintsToLinearization_();
 
+        Clock::time_point startTime;
+        if (measureCosts_)
+            startTime = Clock::now();
         linearizeAuxiliaryEquations_();
+        if (measureCosts_)
+            auxiliaryCost_ += secondsSince_(startTime);
+    }
+
+    static double secondsSince_(const Clock::time_point& startTime)
+    {
+        return std::chrono::duration_cast<std::chrono::duration<double> >(
+            Clock::now() - startTime).count();
     }
 
-    // linearize an element in the interior of the process' grid partition
-    void linearizeElement_(const Element& elem)
+    // linearize an element in the interior of the process' grid partition. if elemLin is
+    // specified, the contributions of the element are also stored there.
+    void linearizeElement_(const Element& elem, ElementLinearization* elemLin = 0)
     {
         unsigned threadId = ThreadManager::threadId();
 
@@ -439,25 +657,89 @@ private:
         auto& localLinearizer = model_().localLinearizer(threadId);
 
         // the actual work of linearization is done by the local linearizer class
-        elementCtx->updateAll(elem);
-        localLinearizer.linearize(*elementCtx);
+        {
+            ProfileRegion profileRegion("intensive quantities");
+            elementCtx->updateAll(elem);
+        }
+        {
+            ProfileRegion profileRegion("local residual");
+            localLinearizer.linearize(*elementCtx);
+        }
+
+        if (elemLin)
+            storeElementLinearization_(*elemLin, *elementCtx, localLinearizer);
 
         // update the right hand side and the Jacobian matrix
+        ProfileRegion profileRegion("scatter");
         if (GET_PROP_VALUE(TypeTag, UseLinearizationLock))
             globalMatrixMutex_.lock();
 
-        size_t numPrimaryDof = elementCtx->numPrimaryDof(/*timeIdx=*/0);
-        for (unsigned primaryDofIdx = 0; primaryDofIdx < numPrimaryDof; ++ primaryDofIdx) {
-            unsigned globI = elementCtx->globalSpaceIndex(/*spaceIdx=*/primaryDofIdx, /*timeIdx=*/0);
+        addToGlobalSystem(*elementCtx, localLinearizer);
 
-            // update the right hand side
-            residual_[globI] += localLinearizer.residual(primaryDofIdx);
+        if (GET_PROP_VALUE(TypeTag, UseLinearizationLock))
+            globalMatrixMutex_.unlock();
+    }
 
-            // update the global Jacobian matrix
-            for (unsigned dofIdx = 0; dofIdx < elementCtx->numDof(/*timeIdx=*/0); ++ dofIdx) {
-                unsigned globJ = elementCtx->globalSpaceIndex(/*spaceIdx=*/dofIdx, /*timeIdx=*/0);
+    // keep the contributions of an element for later Newton iterations
+    template <class LocalLinearizer>
+    void storeElementLinearization_(ElementLinearization& elemLin,
+                                    const ElementContext& elemCtx,
+                                    const LocalLinearizer& localLinearizer)
+    {
+        size_t numDof = elemCtx.numDof(/*timeIdx=*/0);
+        size_t numPrimaryDof = elemCtx.numPrimaryDof(/*timeIdx=*/0);
+
+        elemLin.numPrimaryDof = static_cast<unsigned>(numPrimaryDof);
+        elemLin.dofIndices.resize(numDof);
+        elemLin.jacobian.resize(numPrimaryDof*numDof);
+        elemLin.coupledToAuxiliary = false;
+
+        for (unsigned dofIdx = 0; dofIdx < numDof; ++ dofIdx) {
+            unsigned globIdx = elemCtx.globalSpaceIndex(/*spaceIdx=*/dofIdx, /*timeIdx=*/0);
+            elemLin.dofIndices[dofIdx] = globIdx;
+            if (isCoupledToAuxiliary_[globIdx])
+                elemLin.coupledToAuxiliary = true;
+        }
 
-                (*matrix_)[globJ][globI] += localLinearizer.jacobian(dofIdx, primaryDofIdx);
+        for (unsigned primaryDofIdx = 0; primaryDofIdx < numPrimaryDof; ++ primaryDofIdx)
+            for (unsigned dofIdx = 0; dofIdx < numDof; ++ dofIdx)
+                elemLin.jacobian[primaryDofIdx*numDof + dofIdx] =
+                    localLinearizer.jacobian(dofIdx, primaryDofIdx);
+    }
+
+    // evaluate the local residual of an element which does not need to be relinearized
+    // and add it to the global system of equations together with the Jacobian
+    // contributions of the element's last linearization
+    void evalElementResidual_(const Element& elem, const ElementLinearization& elemLin)
+    {
+        unsigned threadId = ThreadManager::threadId();
+
+        ElementContext *elementCtx = elementCtx_[threadId];
+        auto& localResidual = model_().localResidual(threadId);
+
+        {
+            ProfileRegion profileRegion("intensive quantities");
+            elementCtx->updateAll(elem);
+        }
+        {
+            ProfileRegion profileRegion("local residual");
+            localResidual.eval(*elementCtx);
+        }
+        const auto& resid = localResidual.residual();
+
+        ProfileRegion profileRegion("scatter");
+        if (GET_PROP_VALUE(TypeTag, UseLinearizationLock))
+            globalMatrixMutex_.lock();
+
+        size_t numDof = elemLin.dofIndices.size();
+        for (unsigned primaryDofIdx = 0; primaryDofIdx < elemLin.numPrimaryDof; ++ primaryDofIdx) {
+            unsigned globI = elemLin.dofIndices[primaryDofIdx];
+
+            for (unsigned eqIdx = 0; eqIdx < numEq; ++ eqIdx)
+                residual_[globI][eqIdx] += Toolbox::value(resid[primaryDofIdx][eqIdx]);
+            for (unsigned dofIdx = 0; dofIdx < numDof; ++ dofIdx) {
+                unsigned globJ = elemLin.dofIndices[dofIdx];
+                (*matrix_)[globJ][globI] += elemLin.jacobian[primaryDofIdx*numDof + dofIdx];
             }
         }
 
@@ -465,6 +747,66 @@ private:
             globalMatrixMutex_.unlock();
     }
 
+    // returns true if an element needs to be relinearized
+    bool isActive_(const ElementLinearization& elemLin) const
+    {
+        if (elemLin.dofIndices.empty() || elemLin.coupledToAuxiliary)
+            return true;
+
+        for (unsigned dofIdx = 0; dofIdx < elemLin.dofIndices.size(); ++ dofIdx)
+            if (isActiveDof_[elemLin.dofIndices[dofIdx]])
+                return true;
+
+        return false;
+    }
+
+    // determine the degrees of freedom whose primary variables changed significantly
+    // since they have been considered to be active the last time
+    void updateActiveDofs_(bool relinearizeAll)
+    {
+        const auto& model = model_();
+        const auto& solution = model.solution(/*timeIdx=*/0);
+        size_t numGridDof = model.numGridDof();
+        Scalar tolerance = EWOMS_GET_PARAM(TypeTag, Scalar, ActiveSetLinearizationTolerance);
+
+        if (relinearizeAll) {
+            linearizationPoint_.resize(numGridDof);
+            for (unsigned dofIdx = 0; dofIdx < numGridDof; ++ dofIdx)
+                linearizationPoint_[dofIdx] = solution[dofIdx];
+            isActiveDof_.assign(numGridDof, true);
+            numActiveDof_ = numGridDof;
+            return;
+        }
+
+        numActiveDof_ = 0;
+        for (unsigned dofIdx = 0; dofIdx < numGridDof; ++ dofIdx) {
+            bool active = isCoupledToAuxiliary_[dofIdx];
+            for (unsigned pvIdx = 0; pvIdx < numEq && !active; ++ pvIdx) {
+                Scalar delta = solution[dofIdx][pvIdx] - linearizationPoint_[dofIdx][pvIdx];
+                if (std::abs(delta)*model.primaryVarWeight(dofIdx, pvIdx) > tolerance)
+                    active = true;
+            }
+
+            isActiveDof_[dofIdx] = active;
+            if (active) {
+                linearizationPoint_[dofIdx] = solution[dofIdx];
+                ++ numActiveDof_;
+            }
+        }
+    }
+
+    unsigned elementIndex_(const Element& elem) const
+    {
+#if DUNE_VERSION_NEWER(DUNE_COMMON, 2,4)
+        return static_cast<unsigned>(elementMapper_().index(elem));
+#else
+        return static_cast<unsigned>(elementMapper_().map(elem));
+#endif
+    }
+
+    static bool enableActiveSetLinearization_()
+    { return EWOMS_GET_PARAM(TypeTag, bool, EnableActiveSetLinearization); }
+
     void linearizeAuxiliaryEquations_()
     {
         auto& model = model_();
@@ -536,6 +878,17 @@ private:
     // the right-hand side
     GlobalEqVector residual_;
 
+    // the data required for the active set linearization
+    std::vector<ElementLinearization> elementLinearizations_;
+    std::vector<bool> isCoupledToAuxiliary_;
+    std::vector<bool> isActiveDof_;
+    std::vector<typename SolutionVector::block_type> linearizationPoint_;
+    size_t numActiveDof_;
+
+    bool measureCosts_;
+    std::vector<double> threadCosts_;
+    double auxiliaryCost_;
+
 
     OmpMutex globalMatrixMutex_;
 };
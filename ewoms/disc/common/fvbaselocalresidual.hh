@@ -32,6 +32,7 @@
 
 #include <ewoms/common/parametersystem.hh>
 #include <ewoms/common/alignedallocator.hh>
+#include <ewoms/common/profiler.hh>
 
 #include <opm/common/Valgrind.hpp>
 #include <opm/common/Unused.hpp>
@@ -163,10 +164,16 @@ public:
         residual = 0.0;
 
         // evaluate the flux terms
-        asImp_().evalFluxes(residual, elemCtx, /*timeIdx=*/0);
+        {
+            ProfileRegion profileRegion("fluxes");
+            asImp_().evalFluxes(residual, elemCtx, /*timeIdx=*/0);
+        }
 
         // evaluate the storage and the source terms
-        asImp_().evalVolumeTerms_(residual, elemCtx);
+        {
+            ProfileRegion profileRegion("storage and sources");
+            asImp_().evalVolumeTerms_(residual, elemCtx);
+        }
 
         // evaluate the boundary conditions
         asImp_().evalBoundary_(residual, elemCtx, /*timeIdx=*/0);
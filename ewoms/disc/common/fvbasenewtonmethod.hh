@@ -142,6 +142,17 @@ protected:
         }
     }
 
+    /*!
+     * \copydoc NewtonMethod::evalResidual_
+     */
+    void evalResidual_(GlobalEqVector& residual)
+    {
+        // the overlap is only synchronized at the beginning of an iteration, but the
+        // residual of the border DOFs depends on it
+        model_().syncOverlap();
+        model_().globalResidual(residual);
+    }
+
     /*!
      * \brief Indicates the beginning of a Newton iteration.
      */
@@ -29,9 +29,13 @@
 #define EWOMS_FV_BASE_PROBLEM_HH
 
 #include "fvbaseproperties.hh"
+#include "fvbasetimestepcontroller.hh"
 
 #include <ewoms/io/vtkmultiwriter.hh>
+#include <ewoms/io/snapshotwriter.hh>
 #include <ewoms/io/restart.hh>
+#include <ewoms/io/telemetrywriter.hh>
+#include <ewoms/common/memoryusage.hh>
 #include <ewoms/disc/common/restrictprolong.hh>
 
 #include <opm/common/Unused.hpp>
@@ -64,12 +68,14 @@ private:
 
     static const int vtkOutputFormat = GET_PROP_VALUE(TypeTag, VtkOutputFormat);
     typedef Ewoms::VtkMultiWriter<GridView, vtkOutputFormat> VtkMultiWriter;
+    typedef Ewoms::SnapshotWriter<GridView> SnapshotWriter;
 
     typedef typename GET_PROP_TYPE(TypeTag, Model) Model;
     typedef typename GET_PROP_TYPE(TypeTag, Scalar) Scalar;
     typedef typename GET_PROP_TYPE(TypeTag, Simulator) Simulator;
     typedef typename GET_PROP_TYPE(TypeTag, ThreadManager) ThreadManager;
     typedef typename GET_PROP_TYPE(TypeTag, NewtonMethod) NewtonMethod;
+    typedef typename GET_PROP_TYPE(TypeTag, TimeStepController) TimeStepController;
 
     typedef typename GET_PROP_TYPE(TypeTag, VertexMapper) VertexMapper;
     typedef typename GET_PROP_TYPE(TypeTag, ElementMapper) ElementMapper;
@@ -115,6 +121,8 @@ public:
         , boundingBoxMax_(-std::numeric_limits<double>::max())
         , simulator_(simulator)
         , defaultVtkWriter_(0)
+        , snapshotWriter_(0)
+        , timeStepController_(simulator)
     {
         // calculate the bounding box of the local partition of the grid view
         VertexIterator vIt = gridView_.template begin<dim>();
@@ -134,6 +142,15 @@ public:
 
         if (enableVtkOutput_())
             defaultVtkWriter_ = new VtkMultiWriter(gridView_, asImp_().name());
+
+        if (enableSnapshotOutput_())
+            snapshotWriter_ = new SnapshotWriter(gridView_, asImp_().name());
+    }
+
+    ~FvBaseProblem()
+    {
+        delete defaultVtkWriter_;
+        delete snapshotWriter_;
     }
 
     /*!
@@ -150,6 +167,8 @@ public:
         EWOMS_REGISTER_PARAM(TypeTag, unsigned, MaxTimeStepDivisions,
                              "The maximum number of divisions by two of the timestep size "
                              "before the simulation bails out");
+
+        TimeStepController::registerParameters();
     }
 
     /*!
@@ -179,6 +198,9 @@ public:
 
         if (enableVtkOutput_())
             defaultVtkWriter_->gridChanged();
+
+        if (enableSnapshotOutput_())
+            snapshotWriter_->gridChanged();
     }
 
     /*!
@@ -326,6 +348,15 @@ public:
                   << "Doing nothing!\n";
     }
 
+    /*!
+     * \brief Add the memory used by the problem to a report.
+     *
+     * The generic problem does not keep any significant amount of data, so this does
+     * nothing by default.
+     */
+    void reportMemoryUsage(MemoryReport& report OPM_UNUSED) const
+    { }
+
     /*!
      * \brief Called after the simulation has been run sucessfully.
      */
@@ -399,16 +430,36 @@ public:
             simulator().setTimeStepSize(minTimeStepSize);
         }
 
+        // the statistics of all attempts to do the time step
+        unsigned numNewtonIterations = 0;
+        unsigned numLinearIterations = 0;
+        unsigned numCuts = 0;
+        double times[4] = { 0.0, 0.0, 0.0, 0.0 };
+
         for (unsigned i = 0; i < maxFails; ++i) {
             bool converged = model().update();
-            if (converged)
+
+            numNewtonIterations += model().numNewtonIterations();
+            numLinearIterations += model().numLinearIterations();
+            times[0] += model().prePostProcessTimer().realTimeElapsed();
+            times[1] += model().linearizeTimer().realTimeElapsed();
+            times[2] += model().solveTimer().realTimeElapsed();
+            times[3] += model().updateTimer().realTimeElapsed();
+
+            if (converged) {
+                writeTimeStepTelemetry_(/*converged=*/true, numCuts,
+                                        numNewtonIterations, numLinearIterations, times);
+                timeStepController_.timeStepSucceeded(simulator().timeStepSize());
                 return;
+            }
 
             Scalar dt = simulator().timeStepSize();
+            timeStepController_.timeStepFailed(dt);
             Scalar nextDt = dt / 2;
             if (nextDt < minTimeStepSize)
                 break; // give up: we can't make the time step smaller anymore!
             simulator().setTimeStepSize(nextDt);
+            ++numCuts;
 
             // update failed
             if (gridView().comm().rank() == 0)
@@ -417,6 +468,8 @@ public:
                           << nextDt << " seconds\n" << std::flush;
         }
 
+        writeTimeStepTelemetry_(/*converged=*/false, numCuts,
+                                numNewtonIterations, numLinearIterations, times);
         OPM_THROW(std::runtime_error,
                    "Newton solver didn't converge after "
                    << maxFails << " time-step divisions. dt="
@@ -431,7 +484,7 @@ public:
     Scalar nextTimeStepSize()
     {
         Scalar dtNext = std::min(EWOMS_GET_PARAM(TypeTag, Scalar, MaxTimeStepSize),
-                                 newtonMethod().suggestTimeStepSize(simulator().timeStepSize()));
+                                 timeStepController_.suggestTimeStepSize(simulator().timeStepSize()));
 
         if (dtNext < simulator().maxTimeStepSize()
             && simulator().maxTimeStepSize() < dtNext*2)
@@ -552,6 +605,18 @@ public:
      */
     const NewtonMethod& newtonMethod() const
     { return model().newtonMethod(); }
+
+    /*!
+     * \brief Returns the object which determines the size of the next time step.
+     */
+    TimeStepController& timeStepController()
+    { return timeStepController_; }
+
+    /*!
+     * \brief Returns the object which determines the size of the next time step.
+     */
+    const TimeStepController& timeStepController() const
+    { return timeStepController_; }
     // \}
 
     /*!
@@ -593,6 +658,8 @@ public:
     {
         if (enableVtkOutput_())
             defaultVtkWriter_->serialize(res);
+        if (enableSnapshotOutput_())
+            snapshotWriter_->serialize(res);
     }
 
     /*!
@@ -610,6 +677,8 @@ public:
     {
         if (enableVtkOutput_())
             defaultVtkWriter_->deserialize(res);
+        if (enableSnapshotOutput_())
+            snapshotWriter_->deserialize(res);
     }
 
     /*!
@@ -629,6 +698,8 @@ public:
 
         if (enableVtkOutput_())
             defaultVtkWriter_->beginWrite(t);
+        if (enableSnapshotOutput_())
+            snapshotWriter_->beginWrite(t);
 
         model().prepareOutputFields();
 
@@ -636,6 +707,11 @@ public:
             model().appendOutputFields(*defaultVtkWriter_);
             defaultVtkWriter_->endWrite();
         }
+
+        if (enableSnapshotOutput_()) {
+            model().appendOutputFields(*snapshotWriter_);
+            snapshotWriter_->endWrite();
+        }
     }
 
     /*!
@@ -649,6 +725,38 @@ private:
     bool enableVtkOutput_() const
     { return EWOMS_GET_PARAM(TypeTag, bool, EnableVtkOutput); }
 
+    bool enableSnapshotOutput_() const
+    { return EWOMS_GET_PARAM(TypeTag, bool, EnableSnapshotOutput); }
+
+    // append the record for the current time step to the telemetry stream. this is
+    // collective because the timings of all processes are reduced
+    void writeTimeStepTelemetry_(bool converged,
+                                 unsigned numCuts,
+                                 unsigned numNewtonIterations,
+                                 unsigned numLinearIterations,
+                                 double *times)
+    {
+        auto& telemetry = simulator().telemetry();
+        if (!telemetry.isEnabled())
+            return;
+
+        gridView().comm().max(times, 4);
+
+        TelemetryRecord record("time_step");
+        record.add("time_step", simulator().timeStepIndex())
+            .add("time", static_cast<double>(simulator().time()))
+            .add("dt", static_cast<double>(simulator().timeStepSize()))
+            .add("converged", converged)
+            .add("num_cuts", numCuts)
+            .add("newton_iterations", numNewtonIterations)
+            .add("linear_iterations", numLinearIterations)
+            .add("pre_post_process_time", times[0])
+            .add("linearize_time", times[1])
+            .add("solve_time", times[2])
+            .add("update_time", times[3]);
+        telemetry.write(record);
+    }
+
     //! Returns the implementation of the problem (i.e. static polymorphism)
     Implementation& asImp_()
     { return *static_cast<Implementation *>(this); }
@@ -667,6 +775,8 @@ private:
     // Attributes required for the actual simulation
     Simulator& simulator_;
     mutable VtkMultiWriter *defaultVtkWriter_;
+    SnapshotWriter *snapshotWriter_;
+    TimeStepController timeStepController_;
 };
 
 } // namespace Ewoms
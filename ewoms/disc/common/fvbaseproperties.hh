@@ -161,6 +161,7 @@ NEW_PROP_TAG(GridCommHandleFactory);
  */
 NEW_PROP_TAG(ThreadManager);
 NEW_PROP_TAG(ThreadsPerProcess);
+NEW_PROP_TAG(ThreadAffinity);
 
 //! use locking to prevent race conditions when linearizing the global system of
 //! equations in multi-threaded mode. (setting this property to true is always save, but
@@ -168,6 +169,24 @@ NEW_PROP_TAG(ThreadsPerProcess);
 //! discretizations do not need this.)
 NEW_PROP_TAG(UseLinearizationLock);
 
+/*!
+ * \brief Specify whether only the elements which changed significantly during a time
+ *        step should be relinearized.
+ */
+NEW_PROP_TAG(EnableActiveSetLinearization);
+
+/*!
+ * \brief The relative change of a primary variable above which the elements adjacent to
+ *        a degree of freedom are relinearized by the active set linearization.
+ */
+NEW_PROP_TAG(ActiveSetLinearizationTolerance);
+
+/*!
+ * \brief Specify whether the cached intensive quantities of all degrees of freedom are
+ *        updated in a separate sweep before the elements are linearized.
+ */
+NEW_PROP_TAG(PrecomputeIntensiveQuantities);
+
 // high-level simulation control
 
 //! Manages the simulation time
@@ -189,6 +208,15 @@ NEW_PROP_TAG(EnableGridAdaptation);
  */
 NEW_PROP_TAG(EnableVtkOutput);
 
+/*!
+ * \brief Global switch to enable or disable writing the output fields to a binary
+ *        snapshot file
+ *
+ * The snapshot file can be memory mapped for random access by Ewoms::SnapshotReader and
+ * be converted to VTK using the snapshot2vtu utility.
+ */
+NEW_PROP_TAG(EnableSnapshotOutput);
+
 /*!
  * \brief Specify the format the VTK output is written to disk
  *
@@ -223,6 +251,21 @@ NEW_PROP_TAG(MinTimeStepSize);
  */
 NEW_PROP_TAG(MaxTimeStepDivisions);
 
+//! The class which determines the size of the next time step
+NEW_PROP_TAG(TimeStepController);
+
+/*!
+ * \brief The number of time steps after a failed time step during which the time step
+ *        size is not increased.
+ */
+NEW_PROP_TAG(TimeStepGrowthDelay);
+
+//! The maximum factor by which the time step size is increased between two time steps
+NEW_PROP_TAG(TimeStepMaxGrowthFactor);
+
+//! The relative change of the solution per time step targeted by the PID controller
+NEW_PROP_TAG(PidTimeStepTolerance);
+
 /*!
  * \brief Specify whether all intensive quantities for the grid should be
  *        cached in the discretization.
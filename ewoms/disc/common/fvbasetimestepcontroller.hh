@@ -0,0 +1,310 @@
+// -*- mode: C++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*-
+// vi: set et ts=4 sw=4 sts=4:
+/*
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+
+  Consult the COPYING file in the top-level source directory of this
+  module for the precise wording of the license and the list of
+  copyright holders.
+*/
+/*!
+ * \file
+ *
+ * \brief The classes which determine the size of the next time step of a simulation.
+ */
+#ifndef EWOMS_FV_BASE_TIME_STEP_CONTROLLER_HH
+#define EWOMS_FV_BASE_TIME_STEP_CONTROLLER_HH
+
+#include "fvbaseproperties.hh"
+
+#include <ewoms/common/propertysystem.hh>
+#include <ewoms/common/parametersystem.hh>
+
+#include <opm/common/Unused.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <vector>
+
+namespace Ewoms {
+namespace Properties {
+NEW_PROP_TAG(Scalar);
+NEW_PROP_TAG(Simulator);
+NEW_PROP_TAG(NumEq);
+NEW_PROP_TAG(TimeStepController);
+NEW_PROP_TAG(TimeStepGrowthDelay);
+NEW_PROP_TAG(TimeStepMaxGrowthFactor);
+NEW_PROP_TAG(PidTimeStepTolerance);
+}
+
+/*!
+ * \ingroup FiniteVolumeDiscretizations
+ *
+ * \brief The base class of all time-step controllers.
+ *
+ * The problem notifies the controller about each successful and each failed attempt
+ * to solve a time step and asks it for the size of the next time step after the
+ * solution has been accepted. Implementations only need to provide the
+ * suggestTimeStepSize_() method. The base class applies a history-aware policy to the
+ * result of this method: The step size is never increased by more than a factor of
+ * TimeStepMaxGrowthFactor and it is not increased at all during the
+ * TimeStepGrowthDelay time steps which follow a time step that needed to be cut. This
+ * avoids oscillations between aggressive growth and expensive failures.
+ */
+template <class TypeTag, class Implementation>
+class TimeStepControllerBase
+{
+    typedef typename GET_PROP_TYPE(TypeTag, Scalar) Scalar;
+    typedef typename GET_PROP_TYPE(TypeTag, Simulator) Simulator;
+
+public:
+    TimeStepControllerBase(Simulator& simulator)
+        : simulator_(simulator)
+        , stepsSinceCut_(std::numeric_limits<unsigned>::max())
+        , stepWasCut_(false)
+    { }
+
+    /*!
+     * \brief Register all run-time parameters of the time-step controller.
+     */
+    static void registerParameters()
+    {
+        EWOMS_REGISTER_PARAM(TypeTag, unsigned, TimeStepGrowthDelay,
+                             "The number of time steps after a cut of the time step "
+                             "size during which the time step size is not increased");
+        EWOMS_REGISTER_PARAM(TypeTag, Scalar, TimeStepMaxGrowthFactor,
+                             "The maximum factor by which the time step size is "
+                             "increased between two time steps");
+    }
+
+    /*!
+     * \brief Called by the problem if the solution of the current time step failed
+     *        and it is retried using a smaller time step size.
+     *
+     * \param dt The time step size which did not work
+     */
+    void timeStepFailed(Scalar dt OPM_UNUSED)
+    { stepWasCut_ = true; }
+
+    /*!
+     * \brief Called by the problem after the current time step has been solved
+     *        successfully.
+     *
+     * At this point, the solution of the last time level is still available.
+     *
+     * \param dt The size of the time step which was solved
+     */
+    void timeStepSucceeded(Scalar dt OPM_UNUSED)
+    {
+        if (stepWasCut_)
+            stepsSinceCut_ = 0;
+        else if (stepsSinceCut_ < std::numeric_limits<unsigned>::max())
+            ++stepsSinceCut_;
+        stepWasCut_ = false;
+    }
+
+    /*!
+     * \brief Returns the size of the next time step.
+     *
+     * \param dt The size of the time step which has just been solved
+     */
+    Scalar suggestTimeStepSize(Scalar dt) const
+    {
+        Scalar dtNext = asImp_().suggestTimeStepSize_(dt);
+
+        Scalar maxGrowth = EWOMS_GET_PARAM(TypeTag, Scalar, TimeStepMaxGrowthFactor);
+        if (stepsSinceCut_ < EWOMS_GET_PARAM(TypeTag, unsigned, TimeStepGrowthDelay))
+            maxGrowth = 1.0;
+
+        return std::min(dtNext, dt*maxGrowth);
+    }
+
+protected:
+    Simulator& simulator_;
+
+private:
+    const Implementation& asImp_() const
+    { return *static_cast<const Implementation*>(this); }
+
+    unsigned stepsSinceCut_;
+    bool stepWasCut_;
+};
+
+/*!
+ * \ingroup FiniteVolumeDiscretizations
+ *
+ * \brief A time-step controller which uses the number of Newton iterations of the last
+ *        time step.
+ *
+ * This simply forwards to the suggestTimeStepSize() method of the Newton method, i.e.,
+ * it scales the time step size by the deviation of the number of iterations from the
+ * NewtonTargetIterations parameter.
+ */
+template <class TypeTag>
+class IterationCountTimeStepController
+    : public TimeStepControllerBase<TypeTag, IterationCountTimeStepController<TypeTag> >
+{
+    typedef TimeStepControllerBase<TypeTag, IterationCountTimeStepController<TypeTag> > ParentType;
+    typedef typename GET_PROP_TYPE(TypeTag, Scalar) Scalar;
+    typedef typename GET_PROP_TYPE(TypeTag, Simulator) Simulator;
+
+    friend ParentType;
+
+public:
+    IterationCountTimeStepController(Simulator& simulator)
+        : ParentType(simulator)
+    { }
+
+protected:
+    Scalar suggestTimeStepSize_(Scalar dt) const
+    { return this->simulator_.model().newtonMethod().suggestTimeStepSize(dt); }
+};
+
+/*!
+ * \ingroup FiniteVolumeDiscretizations
+ *
+ * \brief A PID time-step controller which is driven by the relative change of the
+ *        solution.
+ *
+ * The relative change of a time step is the largest relative change of the discrete
+ * L2-norm of any primary variable, i.e.,
+ * \f[ e = \max_i \frac{\|u_i^{n+1} - u_i^n\|}{\|u_i^{n+1}\|} \f]
+ * The model's primaryVarControlsTimeStep() method decides which primary variables of
+ * a degree of freedom contribute to these norms. This allows models to exclude
+ * variables like the switching variable of the black-oil model, whose value jumps if
+ * its meaning changes.
+ * If this exceeds the tolerance given by the PidTimeStepTolerance parameter, the time
+ * step size is reduced proportionally. Otherwise, the size of the next time step is
+ * determined from the last three relative changes using the PID controller proposed
+ * by Soderlind (Numerical Algorithms 31, 2002):
+ * \f[ \Delta t^{n+1} = \Delta t^n
+ *     \left(\frac{e^{n-1}}{e^n}\right)^{k_P}
+ *     \left(\frac{tol}{e^n}\right)^{k_I}
+ *     \left(\frac{(e^{n-1})^2}{e^n e^{n-2}}\right)^{k_D} \f]
+ */
+template <class TypeTag>
+class PidTimeStepController
+    : public TimeStepControllerBase<TypeTag, PidTimeStepController<TypeTag> >
+{
+    typedef TimeStepControllerBase<TypeTag, PidTimeStepController<TypeTag> > ParentType;
+    typedef typename GET_PROP_TYPE(TypeTag, Scalar) Scalar;
+    typedef typename GET_PROP_TYPE(TypeTag, Simulator) Simulator;
+
+    enum { numEq = GET_PROP_VALUE(TypeTag, NumEq) };
+
+    friend ParentType;
+
+public:
+    PidTimeStepController(Simulator& simulator)
+        : ParentType(simulator)
+    {
+        Scalar tol = EWOMS_GET_PARAM(TypeTag, Scalar, PidTimeStepTolerance);
+        errors_.resize(3, tol);
+    }
+
+    /*!
+     * \copydoc TimeStepControllerBase::registerParameters
+     */
+    static void registerParameters()
+    {
+        ParentType::registerParameters();
+
+        EWOMS_REGISTER_PARAM(TypeTag, Scalar, PidTimeStepTolerance,
+                             "The relative change of the solution per time step "
+                             "targeted by the PID time-step controller");
+    }
+
+    /*!
+     * \copydoc TimeStepControllerBase::timeStepSucceeded
+     */
+    void timeStepSucceeded(Scalar dt)
+    {
+        ParentType::timeStepSucceeded(dt);
+
+        // the relative change must not be zero because we divide by it
+        Scalar e = std::max(relativeChange_(), std::numeric_limits<Scalar>::epsilon());
+        errors_[0] = errors_[1];
+        errors_[1] = errors_[2];
+        errors_[2] = e;
+    }
+
+protected:
+    /*!
+     * \brief Returns the relative change of the solution during the time step which
+     *        has just been solved.
+     */
+    Scalar relativeChange_() const
+    {
+        const auto& model = this->simulator_.model();
+        const auto& u = model.solution(/*timeIdx=*/0);
+        const auto& uOld = model.solution(/*timeIdx=*/1);
+
+        Scalar deltaNorm2[numEq] = {};
+        Scalar norm2[numEq] = {};
+        for (unsigned dofIdx = 0; dofIdx < model.numGridDof(); ++dofIdx) {
+            if (!model.isLocalDof(dofIdx))
+                continue;
+
+            for (unsigned pvIdx = 0; pvIdx < numEq; ++pvIdx) {
+                if (!model.primaryVarControlsTimeStep(dofIdx, pvIdx))
+                    continue;
+
+                Scalar delta = u[dofIdx][pvIdx] - uOld[dofIdx][pvIdx];
+                deltaNorm2[pvIdx] += delta*delta;
+                norm2[pvIdx] += u[dofIdx][pvIdx]*u[dofIdx][pvIdx];
+            }
+        }
+
+        const auto& comm = this->simulator_.gridView().comm();
+        comm.sum(deltaNorm2, numEq);
+        comm.sum(norm2, numEq);
+
+        Scalar result = 0.0;
+        for (unsigned pvIdx = 0; pvIdx < numEq; ++pvIdx) {
+            if (norm2[pvIdx] > 0.0)
+                result = std::max(result, std::sqrt(deltaNorm2[pvIdx]/norm2[pvIdx]));
+        }
+
+        return result;
+    }
+
+    Scalar suggestTimeStepSize_(Scalar dt) const
+    {
+        // the gains of the controller
+        const Scalar kP = 0.075;
+        const Scalar kI = 0.175;
+        const Scalar kD = 0.01;
+
+        Scalar tol = EWOMS_GET_PARAM(TypeTag, Scalar, PidTimeStepTolerance);
+        if (errors_[2] > tol)
+            // the solution changed too much, so we only use the integral part
+            return dt*tol/errors_[2];
+
+        return
+            dt
+            * std::pow(errors_[1]/errors_[2], kP)
+            * std::pow(tol/errors_[2], kI)
+            * std::pow(errors_[1]*errors_[1]/(errors_[2]*errors_[0]), kD);
+    }
+
+private:
+    // the relative changes of the last three time steps, the most recent one is last
+    std::vector<Scalar> errors_;
+};
+} // namespace Ewoms
+
+#endif
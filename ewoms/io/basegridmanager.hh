@@ -29,6 +29,9 @@
 
 #include <ewoms/common/propertysystem.hh>
 #include <ewoms/common/parametersystem.hh>
+#include <ewoms/common/memoryusage.hh>
+
+#include <opm/common/Unused.hpp>
 
 #include <dune/common/version.hh>
 
@@ -123,6 +126,15 @@ public:
     void loadBalance()
     { asImp_().grid().loadBalance(); }
 
+    /*!
+     * \brief Add the memory used by the grid manager to a report.
+     *
+     * The DUNE grids do not expose their memory footprint, so this does nothing by
+     * default. Grid managers which keep additional data should overload this method.
+     */
+    void reportMemoryUsage(MemoryReport& report OPM_UNUSED) const
+    { }
+
 protected:
     // this method should be called after the grid has been allocated
     void finalizeInit_()
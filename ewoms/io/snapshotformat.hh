@@ -0,0 +1,163 @@
+// -*- mode: C++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*-
+// vi: set et ts=4 sw=4 sts=4:
+/*
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+
+  Consult the COPYING file in the top-level source directory of this
+  module for the precise wording of the license and the list of
+  copyright holders.
+*/
+/*!
+ * \file
+ *
+ * \brief The on-disk layout of the binary snapshot files which are written by
+ *        Ewoms::SnapshotWriter and read by Ewoms::SnapshotReader.
+ *
+ * A snapshot file consists of a fixed-size header at the beginning of the file, the
+ * data section and the index. All arrays of the data section start at an offset which
+ * is a multiple of Snapshot::alignment, so they can be used directly after the file
+ * has been mapped into memory. The index is always located after the data of the last
+ * time step and is rewritten each time a step gets appended. Its layout is:
+ *
+ * \code
+ * IndexHeader
+ * numGrids x { GridRecord, numRanks x RankExtent }
+ * numSteps x { StepRecord, StepRecord::numFields x FieldRecord }
+ * \endcode
+ *
+ * Each array in the data section holds the pieces of all processes back to back,
+ * ordered by rank. The offset of the piece of a given rank thus follows from the
+ * RankExtent records of the grid which is used by the time step. Field values are
+ * always stored as 64 bit floating point numbers with the components of an entity
+ * being consecutive, i.e., vectorial and tensorial fields are interleaved.
+ */
+#ifndef EWOMS_SNAPSHOT_FORMAT_HH
+#define EWOMS_SNAPSHOT_FORMAT_HH
+
+#include <cstdint>
+#include <cstring>
+
+namespace Ewoms {
+namespace Snapshot {
+//! The magic string at the beginning of each snapshot file
+static const char magic[8] = { 'E', 'W', 'M', 'S', 'S', 'N', 'A', 'P' };
+
+//! The version of the file format
+static const uint32_t formatVersion = 1;
+
+//! Used to detect files which have been written on a machine with a different endianess
+static const uint32_t byteOrderMark = 0x01020304;
+
+//! The alignment of all arrays in the data section [bytes]
+static const uint64_t alignment = 64;
+
+//! The maximum length of field names including the terminating zero
+static const unsigned maxNameLength = 64;
+
+//! Round an offset up to the next multiple of the alignment
+static inline uint64_t align(uint64_t offset)
+{ return (offset + alignment - 1)/alignment*alignment; }
+
+/*!
+ * \brief The header at the beginning of a snapshot file.
+ */
+struct FileHeader
+{
+    char magic[8];
+    uint32_t version;
+    uint32_t byteOrderMark;
+    uint32_t alignment;
+    uint32_t numRanks;
+    uint32_t dimension;
+    uint32_t reserved0;
+    uint64_t indexOffset;
+    uint64_t indexSize;
+    uint64_t dataEnd;
+    uint64_t reserved1;
+};
+
+/*!
+ * \brief The header of the index.
+ */
+struct IndexHeader
+{
+    uint32_t numGrids;
+    uint32_t numSteps;
+    uint64_t reserved;
+};
+
+/*!
+ * \brief Describes the geometry of the grid which is used by a set of time steps.
+ *
+ * The points are stored as three 64 bit floating point coordinates, connectivity and
+ * offsets as 64 bit integers and the cell types as the unsigned 8 bit VTK cell type
+ * identifiers. The connectivity refers to the rank-local point indices.
+ */
+struct GridRecord
+{
+    uint64_t pointsOffset;
+    uint64_t connectivityOffset;
+    uint64_t offsetsOffset;
+    uint64_t typesOffset;
+};
+
+/*!
+ * \brief The number of entities of a grid which belong to a given process.
+ */
+struct RankExtent
+{
+    uint64_t numCells;
+    uint64_t numPoints;
+    uint64_t numCorners;
+};
+
+/*!
+ * \brief Describes a single time step.
+ */
+struct StepRecord
+{
+    double time;
+    uint32_t gridIdx;
+    uint32_t numFields;
+};
+
+//! Specifies whether a field is attached to the cells or the points of the grid
+enum EntityType {
+    cellEntity = 0,
+    pointEntity = 1
+};
+
+/*!
+ * \brief Describes a single field of a time step.
+ */
+struct FieldRecord
+{
+    char name[maxNameLength];
+    uint32_t entityType;
+    uint32_t numComponents;
+    uint64_t offset;
+};
+
+static_assert(sizeof(FileHeader) == 64, "Unexpected size of the file header");
+static_assert(sizeof(IndexHeader) == 16, "Unexpected size of the index header");
+static_assert(sizeof(GridRecord) == 32, "Unexpected size of the grid records");
+static_assert(sizeof(RankExtent) == 24, "Unexpected size of the rank extents");
+static_assert(sizeof(StepRecord) == 16, "Unexpected size of the step records");
+static_assert(sizeof(FieldRecord) == 80, "Unexpected size of the field records");
+} // namespace Snapshot
+} // namespace Ewoms
+
+#endif
@@ -0,0 +1,400 @@
+// -*- mode: C++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*-
+// vi: set et ts=4 sw=4 sts=4:
+/*
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+
+  Consult the COPYING file in the top-level source directory of this
+  module for the precise wording of the license and the list of
+  copyright holders.
+*/
+/*!
+ * \file
+ *
+ * \copydoc Ewoms::SnapshotReader
+ */
+#ifndef EWOMS_SNAPSHOT_READER_HH
+#define EWOMS_SNAPSHOT_READER_HH
+
+#include "snapshotformat.hh"
+
+#include <opm/common/Exceptions.hpp>
+#include <opm/common/ErrorMacros.hpp>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+
+namespace Ewoms {
+/*!
+ * \brief Provides random access to the files written by Ewoms::SnapshotWriter.
+ *
+ * The file is mapped into memory and only its index is parsed, so the pointers which
+ * are returned by this class point directly into the mapping. Accessing a field of a
+ * single time step thus only touches the pages which hold this field.
+ *
+ * The pieces of the individual processes are kept separate: Cell and point indices
+ * are local to the process which wrote them. The data of all processes of a given field
+ * is nevertheless contiguous, i.e., the pointer returned by fieldData() for the first
+ * process can be used to access the values of all cells or points at once.
+ */
+class SnapshotReader
+{
+    struct GridInfo
+    {
+        Snapshot::GridRecord record;
+        std::vector<Snapshot::RankExtent> extents;
+
+        // the index of the first entity of each process within the arrays
+        std::vector<uint64_t> cellsBegin;
+        std::vector<uint64_t> pointsBegin;
+        std::vector<uint64_t> cornersBegin;
+    };
+
+    struct StepInfo
+    {
+        Snapshot::StepRecord record;
+        std::vector<Snapshot::FieldRecord> fields;
+    };
+
+public:
+    SnapshotReader()
+        : fd_(-1)
+        , data_(0)
+        , size_(0)
+    { std::memset(&header_, 0, sizeof(header_)); }
+
+    explicit SnapshotReader(const std::string& fileName)
+        : fd_(-1)
+        , data_(0)
+        , size_(0)
+    {
+        std::memset(&header_, 0, sizeof(header_));
+        open(fileName);
+    }
+
+    ~SnapshotReader()
+    { close(); }
+
+    /*!
+     * \brief Map a snapshot file into memory and parse its index.
+     */
+    void open(const std::string& fileName)
+    {
+        close();
+
+        fd_ = ::open(fileName.c_str(), O_RDONLY);
+        if (fd_ < 0)
+            OPM_THROW(std::runtime_error,
+                      "Could not open snapshot file '" << fileName << "': "
+                      << std::strerror(errno));
+
+        struct stat st;
+        if (::fstat(fd_, &st) != 0)
+            OPM_THROW(std::runtime_error,
+                      "Could not determine the size of snapshot file '" << fileName << "'");
+        size_ = static_cast<size_t>(st.st_size);
+        if (size_ < sizeof(Snapshot::FileHeader))
+            OPM_THROW(std::runtime_error,
+                      "File '" << fileName << "' is too small to be a snapshot file");
+
+        void *p = ::mmap(0, size_, PROT_READ, MAP_SHARED, fd_, 0);
+        if (p == MAP_FAILED)
+            OPM_THROW(std::runtime_error,
+                      "Could not map snapshot file '" << fileName << "': "
+                      << std::strerror(errno));
+        data_ = static_cast<const char*>(p);
+
+        std::memcpy(&header_, data_, sizeof(header_));
+        if (std::memcmp(header_.magic, Snapshot::magic, sizeof(header_.magic)) != 0)
+            OPM_THROW(std::runtime_error,
+                      "File '" << fileName << "' is not a snapshot file");
+        if (header_.byteOrderMark != Snapshot::byteOrderMark)
+            OPM_THROW(std::runtime_error,
+                      "Snapshot file '" << fileName << "' uses a different byte order");
+        if (header_.version != Snapshot::formatVersion)
+            OPM_THROW(std::runtime_error,
+                      "Snapshot file '" << fileName << "' uses the unsupported format "
+                      "version " << header_.version);
+        if (header_.indexOffset + header_.indexSize > size_)
+            OPM_THROW(std::runtime_error,
+                      "Snapshot file '" << fileName << "' is truncated");
+
+        parseIndex_();
+    }
+
+    /*!
+     * \brief Unmap the file.
+     */
+    void close()
+    {
+        if (data_)
+            ::munmap(const_cast<char*>(data_), size_);
+        if (fd_ >= 0)
+            ::close(fd_);
+
+        fd_ = -1;
+        data_ = 0;
+        size_ = 0;
+        grids_.clear();
+        steps_.clear();
+    }
+
+    /*!
+     * \brief Returns the number of processes which wrote the file.
+     */
+    unsigned numRanks() const
+    { return header_.numRanks; }
+
+    /*!
+     * \brief Returns the dimension of the grid.
+     */
+    unsigned dimension() const
+    { return header_.dimension; }
+
+    /*!
+     * \brief Returns the number of grids, i.e., the number of times the grid changed
+     *        plus one.
+     */
+    unsigned numGrids() const
+    { return static_cast<unsigned>(grids_.size()); }
+
+    /*!
+     * \brief Returns the number of time steps.
+     */
+    unsigned numSteps() const
+    { return static_cast<unsigned>(steps_.size()); }
+
+    /*!
+     * \brief Returns the time of a time step.
+     */
+    double time(unsigned stepIdx) const
+    { return steps_.at(stepIdx).record.time; }
+
+    /*!
+     * \brief Returns the index of the grid which is used by a time step.
+     */
+    unsigned gridIndex(unsigned stepIdx) const
+    { return steps_.at(stepIdx).record.gridIdx; }
+
+    /*!
+     * \brief Returns the number of fields of a time step.
+     */
+    unsigned numFields(unsigned stepIdx) const
+    { return static_cast<unsigned>(steps_.at(stepIdx).fields.size()); }
+
+    /*!
+     * \brief Returns the name of a field.
+     */
+    std::string fieldName(unsigned stepIdx, unsigned fieldIdx) const
+    { return field_(stepIdx, fieldIdx).name; }
+
+    /*!
+     * \brief Returns the index of a field given its name or -1 if the time step does
+     *        not contain a field of this name.
+     */
+    int fieldIndex(unsigned stepIdx, const std::string& name) const
+    {
+        const auto& fields = steps_.at(stepIdx).fields;
+        for (size_t fieldIdx = 0; fieldIdx < fields.size(); ++fieldIdx)
+            if (name == fields[fieldIdx].name)
+                return static_cast<int>(fieldIdx);
+        return -1;
+    }
+
+    /*!
+     * \brief Returns true iff a field is attached to the cells of the grid.
+     */
+    bool isCellField(unsigned stepIdx, unsigned fieldIdx) const
+    { return field_(stepIdx, fieldIdx).entityType == Snapshot::cellEntity; }
+
+    /*!
+     * \brief Returns the number of values per entity of a field.
+     */
+    unsigned numComponents(unsigned stepIdx, unsigned fieldIdx) const
+    { return field_(stepIdx, fieldIdx).numComponents; }
+
+    /*!
+     * \brief Returns the number of entities of a field which have been written by a
+     *        given process.
+     */
+    uint64_t numEntities(unsigned stepIdx, unsigned fieldIdx, unsigned rankIdx) const
+    {
+        const auto& extent = grids_.at(gridIndex(stepIdx)).extents.at(rankIdx);
+        return isCellField(stepIdx, fieldIdx) ? extent.numCells : extent.numPoints;
+    }
+
+    /*!
+     * \brief Returns a pointer to the values of a field which have been written by a
+     *        given process.
+     *
+     * The components of an entity are consecutive.
+     */
+    const double *fieldData(unsigned stepIdx, unsigned fieldIdx, unsigned rankIdx) const
+    {
+        const auto& grid = grids_.at(gridIndex(stepIdx));
+        const auto& field = field_(stepIdx, fieldIdx);
+        uint64_t entityBegin =
+            isCellField(stepIdx, fieldIdx)
+            ? grid.cellsBegin.at(rankIdx)
+            : grid.pointsBegin.at(rankIdx);
+
+        return array_<double>(field.offset + entityBegin*field.numComponents*sizeof(double));
+    }
+
+    /*!
+     * \brief Returns the number of cells of a grid which belong to a process.
+     */
+    uint64_t numCells(unsigned gridIdx, unsigned rankIdx) const
+    { return grids_.at(gridIdx).extents.at(rankIdx).numCells; }
+
+    /*!
+     * \brief Returns the number of points of a grid which belong to a process.
+     */
+    uint64_t numPoints(unsigned gridIdx, unsigned rankIdx) const
+    { return grids_.at(gridIdx).extents.at(rankIdx).numPoints; }
+
+    /*!
+     * \brief Returns the size of the connectivity array of a process.
+     */
+    uint64_t numCorners(unsigned gridIdx, unsigned rankIdx) const
+    { return grids_.at(gridIdx).extents.at(rankIdx).numCorners; }
+
+    /*!
+     * \brief Returns the three coordinates of each point of a process.
+     */
+    const double *points(unsigned gridIdx, unsigned rankIdx) const
+    {
+        const auto& grid = grids_.at(gridIdx);
+        return array_<double>(grid.record.pointsOffset
+                              + grid.pointsBegin.at(rankIdx)*3*sizeof(double));
+    }
+
+    /*!
+     * \brief Returns the process-local point indices of the corners of each cell.
+     */
+    const int64_t *connectivity(unsigned gridIdx, unsigned rankIdx) const
+    {
+        const auto& grid = grids_.at(gridIdx);
+        return array_<int64_t>(grid.record.connectivityOffset
+                               + grid.cornersBegin.at(rankIdx)*sizeof(int64_t));
+    }
+
+    /*!
+     * \brief Returns the end of the corners of each cell in the connectivity array.
+     */
+    const int64_t *offsets(unsigned gridIdx, unsigned rankIdx) const
+    {
+        const auto& grid = grids_.at(gridIdx);
+        return array_<int64_t>(grid.record.offsetsOffset
+                               + grid.cellsBegin.at(rankIdx)*sizeof(int64_t));
+    }
+
+    /*!
+     * \brief Returns the VTK cell type of each cell.
+     */
+    const uint8_t *types(unsigned gridIdx, unsigned rankIdx) const
+    {
+        const auto& grid = grids_.at(gridIdx);
+        return array_<uint8_t>(grid.record.typesOffset
+                               + grid.cellsBegin.at(rankIdx)*sizeof(uint8_t));
+    }
+
+private:
+    void parseIndex_()
+    {
+        uint64_t pos = header_.indexOffset;
+
+        Snapshot::IndexHeader indexHeader;
+        read_(pos, &indexHeader, sizeof(indexHeader));
+
+        grids_.resize(indexHeader.numGrids);
+        for (size_t gridIdx = 0; gridIdx < grids_.size(); ++gridIdx) {
+            GridInfo& grid = grids_[gridIdx];
+            read_(pos, &grid.record, sizeof(grid.record));
+
+            grid.extents.resize(header_.numRanks);
+            read_(pos, grid.extents.data(), grid.extents.size()*sizeof(Snapshot::RankExtent));
+
+            grid.cellsBegin.resize(header_.numRanks);
+            grid.pointsBegin.resize(header_.numRanks);
+            grid.cornersBegin.resize(header_.numRanks);
+            uint64_t cellIdx = 0, pointIdx = 0, cornerIdx = 0;
+            for (size_t rankIdx = 0; rankIdx < header_.numRanks; ++rankIdx) {
+                grid.cellsBegin[rankIdx] = cellIdx;
+                grid.pointsBegin[rankIdx] = pointIdx;
+                grid.cornersBegin[rankIdx] = cornerIdx;
+                cellIdx += grid.extents[rankIdx].numCells;
+                pointIdx += grid.extents[rankIdx].numPoints;
+                cornerIdx += grid.extents[rankIdx].numCorners;
+            }
+        }
+
+        steps_.resize(indexHeader.numSteps);
+        for (size_t stepIdx = 0; stepIdx < steps_.size(); ++stepIdx) {
+            StepInfo& step = steps_[stepIdx];
+            read_(pos, &step.record, sizeof(step.record));
+            if (step.record.gridIdx >= grids_.size())
+                OPM_THROW(std::runtime_error,
+                          "Time step " << stepIdx << " of the snapshot file refers to "
+                          "the non-existing grid " << step.record.gridIdx);
+
+            step.fields.resize(step.record.numFields);
+            read_(pos, step.fields.data(), step.fields.size()*sizeof(Snapshot::FieldRecord));
+
+            // make sure that the names are always terminated
+            for (auto& field : step.fields)
+                field.name[Snapshot::maxNameLength - 1] = 0;
+        }
+    }
+
+    void read_(uint64_t& pos, void *dest, size_t numBytes) const
+    {
+        if (pos + numBytes > header_.indexOffset + header_.indexSize)
+            OPM_THROW(std::runtime_error, "The index of the snapshot file is corrupt");
+
+        std::memcpy(dest, data_ + pos, numBytes);
+        pos += numBytes;
+    }
+
+    const Snapshot::FieldRecord& field_(unsigned stepIdx, unsigned fieldIdx) const
+    { return steps_.at(stepIdx).fields.at(fieldIdx); }
+
+    template <class T>
+    const T *array_(uint64_t offset) const
+    {
+        if (offset > size_)
+            OPM_THROW(std::runtime_error, "The snapshot file is truncated");
+        return reinterpret_cast<const T*>(data_ + offset);
+    }
+
+    int fd_;
+    const char *data_;
+    size_t size_;
+
+    Snapshot::FileHeader header_;
+    std::vector<GridInfo> grids_;
+    std::vector<StepInfo> steps_;
+};
+} // namespace Ewoms
+
+#endif
@@ -0,0 +1,715 @@
+// -*- mode: C++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*-
+// vi: set et ts=4 sw=4 sts=4:
+/*
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+
+  Consult the COPYING file in the top-level source directory of this
+  module for the precise wording of the license and the list of
+  copyright holders.
+*/
+/*!
+ * \file
+ *
+ * \copydoc Ewoms::SnapshotWriter
+ */
+#ifndef EWOMS_SNAPSHOT_WRITER_HH
+#define EWOMS_SNAPSHOT_WRITER_HH
+
+#include "snapshotformat.hh"
+
+#include <ewoms/io/baseoutputwriter.hh>
+
+#include <opm/common/Exceptions.hpp>
+#include <opm/common/ErrorMacros.hpp>
+
+#include <dune/common/version.hh>
+#include <dune/grid/common/gridenums.hh>
+#include <dune/grid/common/mcmgmapper.hh>
+#include <dune/grid/io/file/vtk/common.hh>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace Ewoms {
+/*!
+ * \brief Writes the output fields of all time steps into a single binary file which
+ *        can be accessed randomly by mapping it into memory.
+ *
+ * The layout of the file is described in ewoms/io/snapshotformat.hh. In contrast to
+ * VTK, extracting a few fields of a few time steps does not require to parse the whole
+ * data set, see Ewoms::SnapshotReader. The files can be converted to VTK using the
+ * snapshot2vtu utility.
+ *
+ * All processes write their pieces of the data directly into the shared file, so no
+ * communication except for exchanging the number of local entities is required.
+ *
+ * If a simulation is restarted, the time steps which have been written before the
+ * restart point are kept and the new ones are appended to them.
+ */
+template <class GridView>
+class SnapshotWriter : public BaseOutputWriter
+{
+    enum { dim = GridView::dimension };
+
+    typedef Dune::MultipleCodimMultipleGeomTypeMapper<GridView, Dune::MCMGVertexLayout> VertexMapper;
+    typedef Dune::MultipleCodimMultipleGeomTypeMapper<GridView, Dune::MCMGElementLayout> ElementMapper;
+
+    struct AttachedField
+    {
+        std::string name;
+        Snapshot::EntityType entityType;
+        unsigned numComponents;
+        std::vector<double> values;
+    };
+
+public:
+    typedef BaseOutputWriter::ScalarBuffer ScalarBuffer;
+    typedef BaseOutputWriter::VectorBuffer VectorBuffer;
+    typedef BaseOutputWriter::TensorBuffer TensorBuffer;
+
+    SnapshotWriter(const GridView& gridView,
+                   const std::string& simName = "")
+        : gridView_(gridView)
+        , elementMapper_(gridView)
+        , vertexMapper_(gridView)
+    {
+        fileName_ = (simName.empty()) ? "sim" : simName;
+        fileName_ += ".ewsnap";
+
+        commRank_ = gridView.comm().rank();
+        commSize_ = gridView.comm().size();
+
+        fd_ = -1;
+        gridDirty_ = true;
+        curTime_ = 0.0;
+        dataEnd_ = Snapshot::align(sizeof(Snapshot::FileHeader));
+        numRestartSteps_ = 0;
+    }
+
+    ~SnapshotWriter()
+    {
+        if (fd_ >= 0)
+            ::close(fd_);
+    }
+
+    /*!
+     * \brief Returns the name of the file which is written.
+     */
+    const std::string& fileName() const
+    { return fileName_; }
+
+    /*!
+     * \brief Updates the internal data structures after mesh refinement.
+     *
+     * If the grid changes between two calls of beginWrite(), this method _must_ be
+     * called before the second beginWrite()!
+     */
+    void gridChanged()
+    {
+        elementMapper_.update();
+        vertexMapper_.update();
+        gridDirty_ = true;
+    }
+
+    /*!
+     * \copydoc BaseOutputWriter::beginWrite
+     */
+    void beginWrite(double t)
+    {
+        curTime_ = t;
+        if (gridDirty_)
+            extractGeometry_();
+    }
+
+    /*!
+     * \copydoc BaseOutputWriter::attachScalarVertexData
+     */
+    void attachScalarVertexData(ScalarBuffer& buf, std::string name)
+    { attachScalar_(buf, name, Snapshot::pointEntity); }
+
+    /*!
+     * \copydoc BaseOutputWriter::attachScalarElementData
+     */
+    void attachScalarElementData(ScalarBuffer& buf, std::string name)
+    { attachScalar_(buf, name, Snapshot::cellEntity); }
+
+    /*!
+     * \copydoc BaseOutputWriter::attachVectorVertexData
+     */
+    void attachVectorVertexData(VectorBuffer& buf, std::string name)
+    { attachVector_(buf, name, Snapshot::pointEntity); }
+
+    /*!
+     * \copydoc BaseOutputWriter::attachVectorElementData
+     */
+    void attachVectorElementData(VectorBuffer& buf, std::string name)
+    { attachVector_(buf, name, Snapshot::cellEntity); }
+
+    /*!
+     * \copydoc BaseOutputWriter::attachTensorVertexData
+     */
+    void attachTensorVertexData(TensorBuffer& buf, std::string name)
+    { attachTensor_(buf, name, Snapshot::pointEntity); }
+
+    /*!
+     * \copydoc BaseOutputWriter::attachTensorElementData
+     */
+    void attachTensorElementData(TensorBuffer& buf, std::string name)
+    { attachTensor_(buf, name, Snapshot::cellEntity); }
+
+    /*!
+     * \brief Append the attached fields of the current time step to the file.
+     *
+     * If the onlyDiscard argument is true, the attached fields are dropped without
+     * writing anything.
+     */
+    void endWrite(bool onlyDiscard = false)
+    {
+        if (!onlyDiscard) {
+            openFile_();
+
+            uint64_t cursor = dataEnd_;
+            if (gridDirty_)
+                writeGeometry_(cursor);
+
+            Snapshot::StepRecord stepRecord;
+            stepRecord.time = curTime_;
+            stepRecord.gridIdx = static_cast<uint32_t>(grids_.size() - 1);
+            stepRecord.numFields = static_cast<uint32_t>(attachedFields_.size());
+            steps_.push_back(stepRecord);
+            stepFields_.push_back(std::vector<Snapshot::FieldRecord>());
+
+            for (size_t fieldIdx = 0; fieldIdx < attachedFields_.size(); ++fieldIdx) {
+                const AttachedField& field = attachedFields_[fieldIdx];
+
+                Snapshot::FieldRecord fieldRecord;
+                std::memset(&fieldRecord, 0, sizeof(fieldRecord));
+                std::strncpy(fieldRecord.name,
+                             field.name.c_str(),
+                             Snapshot::maxNameLength - 1);
+                fieldRecord.entityType = field.entityType;
+                fieldRecord.numComponents = field.numComponents;
+
+                bool isCellData = (field.entityType == Snapshot::cellEntity);
+                writeDistributed_(cursor,
+                                  fieldRecord.offset,
+                                  field.values.data(),
+                                  isCellData ? cellsBegin_() : pointsBegin_(),
+                                  isCellData ? cellIdx_.size() : pointIdx_.size(),
+                                  isCellData ? totalCells_() : totalPoints_(),
+                                  field.numComponents*sizeof(double));
+
+                stepFields_.back().push_back(fieldRecord);
+            }
+
+            dataEnd_ = cursor;
+
+            // the index may only be rewritten once all processes are done with writing
+            // their data because it is located where the data of the current step went.
+            gridView_.comm().barrier();
+            if (commRank_ == 0)
+                writeIndex_();
+        }
+
+        attachedFields_.clear();
+    }
+
+    /*!
+     * \brief Write the writer's state to a restart file.
+     */
+    template <class Restarter>
+    void serialize(Restarter& res)
+    {
+        res.serializeSectionBegin("SnapshotWriter");
+        res.serializeStream() << steps_.size() << " " << dataEnd_ << "\n";
+        res.serializeSectionEnd();
+    }
+
+    /*!
+     * \brief Read the writer's state from a restart file.
+     *
+     * The time steps which have been written before the restart file was created are
+     * kept and the next one is appended to them. Steps which have been written after
+     * the restart file was created are discarded.
+     */
+    template <class Restarter>
+    void deserialize(Restarter& res)
+    {
+        res.deserializeSectionBegin("SnapshotWriter");
+        res.deserializeStream() >> numRestartSteps_ >> dataEnd_;
+        std::string dummy;
+        std::getline(res.deserializeStream(), dummy);
+        res.deserializeSectionEnd();
+
+        if (fd_ >= 0) {
+            ::close(fd_);
+            fd_ = -1;
+        }
+        grids_.clear();
+        gridExtents_.clear();
+        steps_.clear();
+        stepFields_.clear();
+        gridDirty_ = true;
+    }
+
+private:
+    void attachScalar_(const ScalarBuffer& buf,
+                       const std::string& name,
+                       Snapshot::EntityType entityType)
+    {
+        const auto& entityIdx = (entityType == Snapshot::cellEntity) ? cellIdx_ : pointIdx_;
+
+        AttachedField& field = newField_(name, entityType, /*numComponents=*/1);
+        field.values.resize(entityIdx.size());
+        for (size_t i = 0; i < entityIdx.size(); ++i)
+            field.values[i] = buf[entityIdx[i]];
+    }
+
+    void attachVector_(const VectorBuffer& buf,
+                       const std::string& name,
+                       Snapshot::EntityType entityType)
+    {
+        const auto& entityIdx = (entityType == Snapshot::cellEntity) ? cellIdx_ : pointIdx_;
+
+        unsigned n = buf.empty() ? 1 : static_cast<unsigned>(buf[0].size());
+        AttachedField& field = newField_(name, entityType, n);
+        field.values.resize(entityIdx.size()*n);
+        for (size_t i = 0; i < entityIdx.size(); ++i) {
+            const auto& v = buf[entityIdx[i]];
+            for (unsigned compIdx = 0; compIdx < n; ++compIdx)
+                field.values[i*n + compIdx] = v[compIdx];
+        }
+    }
+
+    // like the VTK writers, each column of a tensor is stored as a separate field
+    // called "name[colIdx]".
+    void attachTensor_(const TensorBuffer& buf,
+                       const std::string& name,
+                       Snapshot::EntityType entityType)
+    {
+        const auto& entityIdx = (entityType == Snapshot::cellEntity) ? cellIdx_ : pointIdx_;
+        if (buf.empty())
+            return;
+
+        unsigned numRows = static_cast<unsigned>(buf[0].N());
+        unsigned numCols = static_cast<unsigned>(buf[0].M());
+        for (unsigned colIdx = 0; colIdx < numCols; ++colIdx) {
+            std::ostringstream oss;
+            oss << name << "[" << colIdx << "]";
+
+            AttachedField& field = newField_(oss.str(), entityType, numRows);
+            field.values.resize(entityIdx.size()*numRows);
+            for (size_t i = 0; i < entityIdx.size(); ++i)
+                for (unsigned rowIdx = 0; rowIdx < numRows; ++rowIdx)
+                    field.values[i*numRows + rowIdx] = buf[entityIdx[i]][rowIdx][colIdx];
+        }
+    }
+
+    AttachedField& newField_(const std::string& name,
+                             Snapshot::EntityType entityType,
+                             unsigned numComponents)
+    {
+        if (name.size() >= Snapshot::maxNameLength)
+            OPM_THROW(std::runtime_error,
+                      "The name of field '" << name << "' is too long for snapshot output "
+                      "(at most " << Snapshot::maxNameLength - 1 << " characters are possible)");
+
+        attachedFields_.push_back(AttachedField());
+        AttachedField& field = attachedFields_.back();
+        field.name = name;
+        field.entityType = entityType;
+        field.numComponents = numComponents;
+        return field;
+    }
+
+    void extractGeometry_()
+    {
+        cellIdx_.clear();
+        pointIdx_.clear();
+        coords_.clear();
+        connectivity_.clear();
+        offsets_.clear();
+        types_.clear();
+
+        // assign a consecutive index to all vertices which are used by interior elements
+        std::vector<int> vertexIdxMap(static_cast<size_t>(vertexMapper_.size()), -1);
+
+        auto elemIt = gridView_.template begin</*codim=*/0, Dune::Interior_Partition>();
+        const auto& elemEndIt = gridView_.template end</*codim=*/0, Dune::Interior_Partition>();
+        for (; elemIt != elemEndIt; ++elemIt) {
+            const auto& elem = *elemIt;
+            const auto& geom = elem.geometry();
+            const Dune::GeometryType gt = elem.type();
+
+#if DUNE_VERSION_NEWER(DUNE_COMMON, 2, 4)
+            cellIdx_.push_back(static_cast<size_t>(elementMapper_.index(elem)));
+#else
+            cellIdx_.push_back(static_cast<size_t>(elementMapper_.map(elem)));
+#endif
+
+            int numCorners = geom.corners();
+            for (int vtkCornerIdx = 0; vtkCornerIdx < numCorners; ++vtkCornerIdx) {
+                int duneCornerIdx = Dune::VTK::renumber(gt, vtkCornerIdx);
+#if DUNE_VERSION_NEWER(DUNE_COMMON, 2, 4)
+                size_t vIdx = static_cast<size_t>(vertexMapper_.subIndex(elem, duneCornerIdx, dim));
+#else
+                size_t vIdx = static_cast<size_t>(vertexMapper_.map(elem, duneCornerIdx, dim));
+#endif
+                if (vertexIdxMap[vIdx] < 0) {
+                    vertexIdxMap[vIdx] = static_cast<int>(pointIdx_.size());
+                    pointIdx_.push_back(vIdx);
+
+                    const auto& pos = geom.corner(duneCornerIdx);
+                    for (unsigned i = 0; i < 3; ++i)
+                        coords_.push_back((i < pos.size()) ? pos[i] : 0.0);
+                }
+                connectivity_.push_back(vertexIdxMap[vIdx]);
+            }
+
+            offsets_.push_back(static_cast<int64_t>(connectivity_.size()));
+            types_.push_back(static_cast<uint8_t>(Dune::VTK::geometryType(gt)));
+        }
+    }
+
+    void writeGeometry_(uint64_t& cursor)
+    {
+        // exchange the number of entities of all processes. these determine where the
+        // pieces of the individual processes are located within each array.
+        std::vector<unsigned long> localSizes(3);
+        localSizes[0] = cellIdx_.size();
+        localSizes[1] = pointIdx_.size();
+        localSizes[2] = connectivity_.size();
+
+        std::vector<unsigned long> allSizes(3*static_cast<size_t>(commSize_));
+        gridView_.comm().allgather(localSizes.data(), 3, allSizes.data());
+
+        extents_.resize(static_cast<size_t>(commSize_));
+        for (size_t rankIdx = 0; rankIdx < extents_.size(); ++rankIdx) {
+            extents_[rankIdx].numCells = allSizes[3*rankIdx + 0];
+            extents_[rankIdx].numPoints = allSizes[3*rankIdx + 1];
+            extents_[rankIdx].numCorners = allSizes[3*rankIdx + 2];
+        }
+
+        uint64_t cornersBegin = 0;
+        uint64_t totalCorners = 0;
+        for (int rankIdx = 0; rankIdx < commSize_; ++rankIdx) {
+            if (rankIdx < commRank_)
+                cornersBegin += extents_[static_cast<size_t>(rankIdx)].numCorners;
+            totalCorners += extents_[static_cast<size_t>(rankIdx)].numCorners;
+        }
+
+        Snapshot::GridRecord gridRecord;
+        writeDistributed_(cursor, gridRecord.pointsOffset, coords_.data(),
+                          pointsBegin_(), pointIdx_.size(), totalPoints_(),
+                          3*sizeof(double));
+        writeDistributed_(cursor, gridRecord.connectivityOffset, connectivity_.data(),
+                          cornersBegin, connectivity_.size(), totalCorners,
+                          sizeof(int64_t));
+        writeDistributed_(cursor, gridRecord.offsetsOffset, offsets_.data(),
+                          cellsBegin_(), cellIdx_.size(), totalCells_(),
+                          sizeof(int64_t));
+        writeDistributed_(cursor, gridRecord.typesOffset, types_.data(),
+                          cellsBegin_(), cellIdx_.size(), totalCells_(),
+                          sizeof(uint8_t));
+
+        grids_.push_back(gridRecord);
+        gridExtents_.push_back(extents_);
+        gridDirty_ = false;
+    }
+
+    // reserve an aligned array for the entities of all processes at the cursor and
+    // write the piece of the local process into it
+    void writeDistributed_(uint64_t& cursor,
+                           uint64_t& arrayOffset,
+                           const void *localData,
+                           uint64_t localBegin,
+                           uint64_t localSize,
+                           uint64_t globalSize,
+                           size_t entitySize)
+    {
+        arrayOffset = Snapshot::align(cursor);
+        cursor = arrayOffset + globalSize*entitySize;
+
+        writeAt_(arrayOffset + localBegin*entitySize, localData, localSize*entitySize);
+    }
+
+    uint64_t cellsBegin_() const
+    {
+        uint64_t n = 0;
+        for (int rankIdx = 0; rankIdx < commRank_; ++rankIdx)
+            n += extents_[static_cast<size_t>(rankIdx)].numCells;
+        return n;
+    }
+
+    uint64_t pointsBegin_() const
+    {
+        uint64_t n = 0;
+        for (int rankIdx = 0; rankIdx < commRank_; ++rankIdx)
+            n += extents_[static_cast<size_t>(rankIdx)].numPoints;
+        return n;
+    }
+
+    uint64_t totalCells_() const
+    {
+        uint64_t n = 0;
+        for (size_t rankIdx = 0; rankIdx < extents_.size(); ++rankIdx)
+            n += extents_[rankIdx].numCells;
+        return n;
+    }
+
+    uint64_t totalPoints_() const
+    {
+        uint64_t n = 0;
+        for (size_t rankIdx = 0; rankIdx < extents_.size(); ++rankIdx)
+            n += extents_[rankIdx].numPoints;
+        return n;
+    }
+
+    void openFile_()
+    {
+        if (fd_ >= 0)
+            return;
+
+        if (numRestartSteps_ > 0) {
+            // continue the file of the simulation which is restarted
+            fd_ = ::open(fileName_.c_str(), O_RDWR);
+            if (fd_ < 0)
+                OPM_THROW(std::runtime_error,
+                          "Could not open snapshot file '" << fileName_ << "' to append "
+                          "to it: " << std::strerror(errno));
+            readIndex_();
+
+            // the index is located where the data of the next time step goes, so
+            // nothing may be written before all processes have read it
+            gridView_.comm().barrier();
+            return;
+        }
+
+        // the first process creates the file, the others open it after it exists
+        if (commRank_ == 0) {
+            fd_ = ::open(fileName_.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+            if (fd_ < 0)
+                OPM_THROW(std::runtime_error,
+                          "Could not create snapshot file '" << fileName_ << "': "
+                          << std::strerror(errno));
+            writeIndex_();
+        }
+
+        gridView_.comm().barrier();
+
+        if (commRank_ != 0) {
+            fd_ = ::open(fileName_.c_str(), O_WRONLY);
+            if (fd_ < 0)
+                OPM_THROW(std::runtime_error,
+                          "Could not open snapshot file '" << fileName_ << "': "
+                          << std::strerror(errno));
+        }
+    }
+
+    // write the index behind the data of the last time step and update the header
+    void writeIndex_()
+    {
+        std::vector<char> index;
+        Snapshot::IndexHeader indexHeader;
+        indexHeader.numGrids = static_cast<uint32_t>(grids_.size());
+        indexHeader.numSteps = static_cast<uint32_t>(steps_.size());
+        indexHeader.reserved = 0;
+        append_(index, &indexHeader, sizeof(indexHeader));
+
+        for (size_t gridIdx = 0; gridIdx < grids_.size(); ++gridIdx) {
+            append_(index, &grids_[gridIdx], sizeof(Snapshot::GridRecord));
+            append_(index,
+                    gridExtents_[gridIdx].data(),
+                    gridExtents_[gridIdx].size()*sizeof(Snapshot::RankExtent));
+        }
+
+        for (size_t stepIdx = 0; stepIdx < steps_.size(); ++stepIdx) {
+            append_(index, &steps_[stepIdx], sizeof(Snapshot::StepRecord));
+            append_(index,
+                    stepFields_[stepIdx].data(),
+                    stepFields_[stepIdx].size()*sizeof(Snapshot::FieldRecord));
+        }
+
+        Snapshot::FileHeader header;
+        std::memset(&header, 0, sizeof(header));
+        std::memcpy(header.magic, Snapshot::magic, sizeof(header.magic));
+        header.version = Snapshot::formatVersion;
+        header.byteOrderMark = Snapshot::byteOrderMark;
+        header.alignment = static_cast<uint32_t>(Snapshot::alignment);
+        header.numRanks = static_cast<uint32_t>(commSize_);
+        header.dimension = dim;
+        header.indexOffset = Snapshot::align(dataEnd_);
+        header.indexSize = index.size();
+        header.dataEnd = dataEnd_;
+
+        writeAt_(header.indexOffset, index.data(), index.size());
+        if (::ftruncate(fd_, static_cast<off_t>(header.indexOffset + header.indexSize)) != 0)
+            OPM_THROW(std::runtime_error,
+                      "Could not truncate snapshot file '" << fileName_ << "': "
+                      << std::strerror(errno));
+
+        // the header is written last, so a reader never sees an index which has not
+        // been completely written
+        writeAt_(0, &header, sizeof(header));
+    }
+
+    // restore the records of the time steps which are kept from the index of an existing
+    // file. the grid is written again with the next time step.
+    void readIndex_()
+    {
+        Snapshot::FileHeader header;
+        readAt_(0, &header, sizeof(header));
+        if (std::memcmp(header.magic, Snapshot::magic, sizeof(header.magic)) != 0
+            || header.version != Snapshot::formatVersion
+            || header.byteOrderMark != Snapshot::byteOrderMark)
+            OPM_THROW(std::runtime_error,
+                      "File '" << fileName_ << "' is not a snapshot file which can be "
+                      "appended to");
+        if (header.numRanks != static_cast<uint32_t>(commSize_))
+            OPM_THROW(std::runtime_error,
+                      "Snapshot file '" << fileName_ << "' has been written by "
+                      << header.numRanks << " processes, but " << commSize_
+                      << " are used to append to it");
+
+        std::vector<char> index(header.indexSize);
+        readAt_(header.indexOffset, index.data(), index.size());
+        const char *pos = index.data();
+        const char *end = pos + index.size();
+        auto read = [&](void *dest, size_t numBytes) {
+            if (pos + numBytes > end)
+                OPM_THROW(std::runtime_error,
+                          "The index of snapshot file '" << fileName_ << "' is corrupt");
+            std::memcpy(dest, pos, numBytes);
+            pos += numBytes;
+        };
+
+        Snapshot::IndexHeader indexHeader;
+        read(&indexHeader, sizeof(indexHeader));
+        if (indexHeader.numSteps < numRestartSteps_)
+            OPM_THROW(std::runtime_error,
+                      "Snapshot file '" << fileName_ << "' contains only "
+                      << indexHeader.numSteps << " time steps, but " << numRestartSteps_
+                      << " have been written before the restart");
+
+        grids_.resize(indexHeader.numGrids);
+        gridExtents_.resize(indexHeader.numGrids);
+        for (size_t gridIdx = 0; gridIdx < grids_.size(); ++gridIdx) {
+            read(&grids_[gridIdx], sizeof(Snapshot::GridRecord));
+            gridExtents_[gridIdx].resize(static_cast<size_t>(commSize_));
+            read(gridExtents_[gridIdx].data(),
+                 gridExtents_[gridIdx].size()*sizeof(Snapshot::RankExtent));
+        }
+
+        steps_.resize(numRestartSteps_);
+        stepFields_.resize(numRestartSteps_);
+        for (size_t stepIdx = 0; stepIdx < steps_.size(); ++stepIdx) {
+            read(&steps_[stepIdx], sizeof(Snapshot::StepRecord));
+            stepFields_[stepIdx].resize(steps_[stepIdx].numFields);
+            read(stepFields_[stepIdx].data(),
+                 stepFields_[stepIdx].size()*sizeof(Snapshot::FieldRecord));
+        }
+
+        // drop the grids which have only been used by the discarded time steps
+        size_t numGrids = steps_.back().gridIdx + 1;
+        if (numGrids > grids_.size())
+            OPM_THROW(std::runtime_error,
+                      "The index of snapshot file '" << fileName_ << "' is corrupt");
+        grids_.resize(numGrids);
+        gridExtents_.resize(numGrids);
+    }
+
+    static void append_(std::vector<char>& blob, const void *data, size_t numBytes)
+    {
+        const char *begin = static_cast<const char*>(data);
+        blob.insert(blob.end(), begin, begin + numBytes);
+    }
+
+    void writeAt_(uint64_t offset, const void *data, size_t numBytes) const
+    {
+        const char *buf = static_cast<const char*>(data);
+        while (numBytes > 0) {
+            ssize_t n = ::pwrite(fd_, buf, numBytes, static_cast<off_t>(offset));
+            if (n < 0) {
+                if (errno == EINTR)
+                    continue;
+                OPM_THROW(std::runtime_error,
+                          "Could not write to snapshot file '" << fileName_ << "': "
+                          << std::strerror(errno));
+            }
+
+            buf += n;
+            offset += static_cast<uint64_t>(n);
+            numBytes -= static_cast<size_t>(n);
+        }
+    }
+
+    void readAt_(uint64_t offset, void *data, size_t numBytes) const
+    {
+        char *buf = static_cast<char*>(data);
+        while (numBytes > 0) {
+            ssize_t n = ::pread(fd_, buf, numBytes, static_cast<off_t>(offset));
+            if (n < 0 && errno == EINTR)
+                continue;
+            if (n <= 0)
+                OPM_THROW(std::runtime_error,
+                          "Could not read from snapshot file '" << fileName_ << "'");
+
+            buf += n;
+            offset += static_cast<uint64_t>(n);
+            numBytes -= static_cast<size_t>(n);
+        }
+    }
+
+    const GridView gridView_;
+    ElementMapper elementMapper_;
+    VertexMapper vertexMapper_;
+
+    std::string fileName_;
+    int commRank_;
+    int commSize_;
+    int fd_;
+
+    double curTime_;
+    uint64_t dataEnd_;
+    size_t numRestartSteps_;
+    std::vector<AttachedField> attachedFields_;
+
+    // the geometry of the local process
+    bool gridDirty_;
+    std::vector<size_t> cellIdx_;
+    std::vector<size_t> pointIdx_;
+    std::vector<double> coords_;
+    std::vector<int64_t> connectivity_;
+    std::vector<int64_t> offsets_;
+    std::vector<uint8_t> types_;
+    std::vector<Snapshot::RankExtent> extents_;
+
+    // the contents of the index
+    std::vector<Snapshot::GridRecord> grids_;
+    std::vector<std::vector<Snapshot::RankExtent> > gridExtents_;
+    std::vector<Snapshot::StepRecord> steps_;
+    std::vector<std::vector<Snapshot::FieldRecord> > stepFields_;
+};
+} // namespace Ewoms
+
+#endif
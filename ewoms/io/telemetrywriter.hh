@@ -0,0 +1,209 @@
+// -*- mode: C++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*-
+// vi: set et ts=4 sw=4 sts=4:
+/*
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+
+  Consult the COPYING file in the top-level source directory of this
+  module for the precise wording of the license and the list of
+  copyright holders.
+*/
+/*!
+ * \file
+ *
+ * \copydoc Ewoms::TelemetryWriter
+ */
+#ifndef EWOMS_TELEMETRY_WRITER_HH
+#define EWOMS_TELEMETRY_WRITER_HH
+
+#include <opm/common/ErrorMacros.hpp>
+
+#include <cmath>
+#include <fstream>
+#include <iomanip>
+#include <memory>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+
+namespace Ewoms {
+/*!
+ * \ingroup Common
+ *
+ * \brief A single record of the telemetry stream, i.e., a flat JSON object.
+ */
+class TelemetryRecord
+{
+public:
+    /*!
+     * \brief Start a record of a given type.
+     *
+     * The type is stored as the "type" attribute of the record.
+     */
+    explicit TelemetryRecord(const std::string& type)
+    {
+        oss_ << std::setprecision(10);
+        oss_ << "{\"type\":\"" << type << "\"";
+    }
+
+    TelemetryRecord& add(const std::string& name, bool value)
+    {
+        oss_ << ",\"" << name << "\":" << (value ? "true" : "false");
+        return *this;
+    }
+
+    TelemetryRecord& add(const std::string& name, int value)
+    {
+        oss_ << ",\"" << name << "\":" << value;
+        return *this;
+    }
+
+    TelemetryRecord& add(const std::string& name, unsigned value)
+    {
+        oss_ << ",\"" << name << "\":" << value;
+        return *this;
+    }
+
+    TelemetryRecord& add(const std::string& name, double value)
+    {
+        // JSON does not know about infinity or NaN
+        oss_ << ",\"" << name << "\":";
+        if (std::isfinite(value))
+            oss_ << value;
+        else
+            oss_ << "null";
+        return *this;
+    }
+
+    TelemetryRecord& add(const std::string& name, const std::string& value)
+    {
+        oss_ << ",\"" << name << "\":\"" << value << "\"";
+        return *this;
+    }
+
+    /*!
+     * \brief Returns the record as a single line of JSON without the newline.
+     */
+    std::string str() const
+    { return oss_.str() + "}"; }
+
+private:
+    std::ostringstream oss_;
+};
+
+/*!
+ * \ingroup Common
+ *
+ * \brief Writes telemetry records to a file in the JSON-lines format.
+ *
+ * The records are written by the first process only. Any quantities which differ
+ * between processes must thus be reduced by the caller before a record is written. To
+ * allow this, isEnabled() returns the same value on all processes. The output is
+ * buffered and written to disk whenever the buffer is full, when flush() is called
+ * and when the object is destroyed.
+ */
+class TelemetryWriter
+{
+    static const size_t bufferSize = 64*1024;
+
+public:
+    TelemetryWriter()
+        : enabled_(false)
+    {}
+
+    ~TelemetryWriter()
+    { flush(); }
+
+    /*!
+     * \brief Start writing the records to a given file.
+     *
+     * If the file name is empty, no records will be written. This method is
+     * collective: if the first process cannot open the file, all processes throw an
+     * exception.
+     *
+     * \param fileName The name of the file. Existing files are overwritten.
+     * \param comm The collective communication object of the processes which take
+     *             part in the simulation
+     */
+    template <class CollectiveCommunication>
+    void open(const std::string& fileName, const CollectiveCommunication& comm)
+    {
+        flush();
+        os_.reset();
+
+        enabled_ = !fileName.empty();
+        if (!enabled_)
+            return;
+
+        int failed = 0;
+        if (comm.rank() == 0) {
+            os_.reset(new std::ofstream(fileName));
+            if (os_->good())
+                buffer_.reserve(bufferSize);
+            else {
+                os_.reset();
+                failed = 1;
+            }
+        }
+
+        if (comm.max(failed))
+            OPM_THROW(std::runtime_error,
+                      "Could not open telemetry file '" << fileName << "'");
+    }
+
+    /*!
+     * \brief Returns true if records are written.
+     */
+    bool isEnabled() const
+    { return enabled_; }
+
+    /*!
+     * \brief Append a record to the stream.
+     *
+     * This is a no-op on all but the first process.
+     */
+    void write(const TelemetryRecord& record)
+    {
+        if (!os_)
+            return;
+
+        buffer_ += record.str();
+        buffer_ += '\n';
+        if (buffer_.size() >= bufferSize)
+            flush();
+    }
+
+    /*!
+     * \brief Write all buffered records to disk.
+     */
+    void flush()
+    {
+        if (!os_ || buffer_.empty())
+            return;
+
+        os_->write(buffer_.data(), static_cast<std::streamsize>(buffer_.size()));
+        os_->flush();
+        buffer_.clear();
+    }
+
+private:
+    bool enabled_;
+    std::unique_ptr<std::ofstream> os_;
+    std::string buffer_;
+};
+
+} // namespace Ewoms
+
+#endif
@@ -30,6 +30,7 @@
 #include <opm/material/densead/Math.hpp>
 
 #include "vtkmultiwriter.hh"
+#include "snapshotwriter.hh"
 #include "baseoutputmodule.hh"
 
 #include <ewoms/common/propertysystem.hh>
@@ -47,6 +48,7 @@ NEW_TYPE_TAG(VtkBlackOil);
 
 // create the property tags needed for the multi phase module
 NEW_PROP_TAG(EnableVtkOutput);
+NEW_PROP_TAG(EnableSnapshotOutput);
 NEW_PROP_TAG(VtkOutputFormat);
 NEW_PROP_TAG(VtkWriteGasDissolutionFactor);
 NEW_PROP_TAG(VtkWriteOilVaporizationFactor);
@@ -100,6 +102,7 @@ class VtkBlackOilModule : public BaseOutputModule<TypeTag>
 
     static const int vtkFormat = GET_PROP_VALUE(TypeTag, VtkOutputFormat);
     typedef Ewoms::VtkMultiWriter<GridView, vtkFormat> VtkMultiWriter;
+    typedef Ewoms::SnapshotWriter<GridView> SnapshotWriter;
 
     enum { oilPhaseIdx = FluidSystem::oilPhaseIdx };
     enum { gasPhaseIdx = FluidSystem::gasPhaseIdx };
@@ -203,7 +206,8 @@ public:
      */
     void processElement(const ElementContext& elemCtx)
     {
-        if (!EWOMS_GET_PARAM(TypeTag, bool, EnableVtkOutput))
+        if (!EWOMS_GET_PARAM(TypeTag, bool, EnableVtkOutput)
+            && !EWOMS_GET_PARAM(TypeTag, bool, EnableSnapshotOutput))
             return;
 
         typedef Opm::MathToolbox<Evaluation> Toolbox;
@@ -292,8 +296,8 @@ public:
      */
     void commitBuffers(BaseOutputWriter& baseWriter)
     {
-        VtkMultiWriter *vtkWriter = dynamic_cast<VtkMultiWriter*>(&baseWriter);
-        if (!vtkWriter)
+        if (!dynamic_cast<VtkMultiWriter*>(&baseWriter)
+            && !dynamic_cast<SnapshotWriter*>(&baseWriter))
             return;
 
         if (gasDissolutionFactorOutput_())
@@ -28,6 +28,7 @@
 #define EWOMS_VTK_COMPOSITION_MODULE_HH
 
 #include "vtkmultiwriter.hh"
+#include "snapshotwriter.hh"
 #include "baseoutputmodule.hh"
 
 #include <ewoms/common/propertysystem.hh>
@@ -50,6 +51,7 @@ NEW_PROP_TAG(VtkWriteFugacities);
 NEW_PROP_TAG(VtkWriteFugacityCoeffs);
 NEW_PROP_TAG(VtkOutputFormat);
 NEW_PROP_TAG(EnableVtkOutput);
+NEW_PROP_TAG(EnableSnapshotOutput);
 
 // set default values for what quantities to output
 SET_BOOL_PROP(VtkComposition, VtkWriteMassFractions, false);
@@ -90,6 +92,7 @@ class VtkCompositionModule : public BaseOutputModule<TypeTag>
 
     static const int vtkFormat = GET_PROP_VALUE(TypeTag, VtkOutputFormat);
     typedef Ewoms::VtkMultiWriter<GridView, vtkFormat> VtkMultiWriter;
+    typedef Ewoms::SnapshotWriter<GridView> SnapshotWriter;
 
     typedef typename ParentType::ComponentBuffer ComponentBuffer;
     typedef typename ParentType::PhaseComponentBuffer PhaseComponentBuffer;
@@ -151,7 +154,9 @@ public:
     {
         typedef Opm::MathToolbox<Evaluation> Toolbox;
 
-        if (!EWOMS_GET_PARAM(TypeTag, bool, EnableVtkOutput))
+        if (!EWOMS_GET_PARAM(TypeTag, bool, EnableVtkOutput)
+
+            && !EWOMS_GET_PARAM(TypeTag, bool, EnableSnapshotOutput))
             return;
 
         for (unsigned i = 0; i < elemCtx.numPrimaryDof(/*timeIdx=*/0); ++i) {
@@ -212,8 +217,8 @@ public:
      */
     void commitBuffers(BaseOutputWriter& baseWriter)
     {
-        VtkMultiWriter *vtkWriter = dynamic_cast<VtkMultiWriter*>(&baseWriter);
-        if (!vtkWriter) {
+        if (!dynamic_cast<VtkMultiWriter*>(&baseWriter)
+            && !dynamic_cast<SnapshotWriter*>(&baseWriter)) {
             return;
         }
 
@@ -29,6 +29,7 @@
 #define EWOMS_VTK_DIFFUSION_MODULE_HH
 
 #include "vtkmultiwriter.hh"
+#include "snapshotwriter.hh"
 #include "baseoutputmodule.hh"
 
 #include <ewoms/common/propertysystem.hh>
@@ -49,6 +50,7 @@ NEW_PROP_TAG(VtkWriteDiffusionCoefficients);
 NEW_PROP_TAG(VtkWriteEffectiveDiffusionCoefficients);
 NEW_PROP_TAG(VtkOutputFormat);
 NEW_PROP_TAG(EnableVtkOutput);
+NEW_PROP_TAG(EnableSnapshotOutput);
 
 // set default values for what quantities to output
 SET_BOOL_PROP(VtkDiffusion, VtkWriteTortuosities, false);
@@ -86,6 +88,7 @@ class VtkDiffusionModule : public BaseOutputModule<TypeTag>
 
     static const int vtkFormat = GET_PROP_VALUE(TypeTag, VtkOutputFormat);
     typedef Ewoms::VtkMultiWriter<GridView, vtkFormat> VtkMultiWriter;
+    typedef Ewoms::SnapshotWriter<GridView> SnapshotWriter;
 
     enum { numPhases = GET_PROP_VALUE(TypeTag, NumPhases) };
     enum { numComponents = GET_PROP_VALUE(TypeTag, NumComponents) };
@@ -132,7 +135,8 @@ public:
      */
     void processElement(const ElementContext& elemCtx)
     {
-        if (!EWOMS_GET_PARAM(TypeTag, bool, EnableVtkOutput))
+        if (!EWOMS_GET_PARAM(TypeTag, bool, EnableVtkOutput)
+            && !EWOMS_GET_PARAM(TypeTag, bool, EnableSnapshotOutput))
             return;
 
         for (unsigned i = 0; i < elemCtx.numPrimaryDof(/*timeIdx=*/0); ++i) {
@@ -159,8 +163,8 @@ public:
      */
     void commitBuffers(BaseOutputWriter& baseWriter)
     {
-        VtkMultiWriter *vtkWriter = dynamic_cast<VtkMultiWriter*>(&baseWriter);
-        if (!vtkWriter) {
+        if (!dynamic_cast<VtkMultiWriter*>(&baseWriter)
+            && !dynamic_cast<SnapshotWriter*>(&baseWriter)) {
             return;
         }
 
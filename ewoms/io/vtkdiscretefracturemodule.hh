@@ -28,6 +28,7 @@
 #define EWOMS_VTK_DISCRETE_FRACTURE_MODULE_HH
 
 #include "vtkmultiwriter.hh"
+#include "snapshotwriter.hh"
 #include "baseoutputmodule.hh"
 
 #include <ewoms/common/propertysystem.hh>
@@ -55,6 +56,7 @@ NEW_PROP_TAG(VtkWriteFractureFilterVelocities);
 NEW_PROP_TAG(VtkWriteFractureVolumeFraction);
 NEW_PROP_TAG(VtkOutputFormat);
 NEW_PROP_TAG(EnableVtkOutput);
+NEW_PROP_TAG(EnableSnapshotOutput);
 NEW_PROP_TAG(DiscBaseOutputModule);
 
 // set default values for what quantities to output
@@ -97,6 +99,7 @@ class VtkDiscreteFractureModule : public BaseOutputModule<TypeTag>
 
     static const int vtkFormat = GET_PROP_VALUE(TypeTag, VtkOutputFormat);
     typedef Ewoms::VtkMultiWriter<GridView, vtkFormat> VtkMultiWriter;
+    typedef Ewoms::SnapshotWriter<GridView> SnapshotWriter;
 
     enum { dim = GridView::dimension };
     enum { dimWorld = GridView::dimensionworld };
@@ -174,7 +177,8 @@ public:
      */
     void processElement(const ElementContext& elemCtx)
     {
-        if (!EWOMS_GET_PARAM(TypeTag, bool, EnableVtkOutput))
+        if (!EWOMS_GET_PARAM(TypeTag, bool, EnableVtkOutput)
+            && !EWOMS_GET_PARAM(TypeTag, bool, EnableSnapshotOutput))
             return;
 
         const auto& fractureMapper = elemCtx.simulator().gridManager().fractureMapper();
@@ -258,8 +262,8 @@ public:
      */
     void commitBuffers(BaseOutputWriter& baseWriter)
     {
-        VtkMultiWriter *vtkWriter = dynamic_cast<VtkMultiWriter*>(&baseWriter);
-        if (!vtkWriter) {
+        if (!dynamic_cast<VtkMultiWriter*>(&baseWriter)
+            && !dynamic_cast<SnapshotWriter*>(&baseWriter)) {
             return;
         }
 
@@ -28,6 +28,7 @@
 #define EWOMS_VTK_ENERGY_MODULE_HH
 
 #include "vtkmultiwriter.hh"
+#include "snapshotwriter.hh"
 #include "baseoutputmodule.hh"
 
 #include <ewoms/common/propertysystem.hh>
@@ -47,6 +48,7 @@ NEW_PROP_TAG(VtkWriteInternalEnergies);
 NEW_PROP_TAG(VtkWriteEnthalpies);
 NEW_PROP_TAG(VtkOutputFormat);
 NEW_PROP_TAG(EnableVtkOutput);
+NEW_PROP_TAG(EnableSnapshotOutput);
 
 // set default values for what quantities to output
 SET_BOOL_PROP(VtkEnergy, VtkWriteSolidHeatCapacity, false);
@@ -88,6 +90,7 @@ class VtkEnergyModule : public BaseOutputModule<TypeTag>
 
     typedef typename Opm::MathToolbox<Evaluation> Toolbox;
     typedef Ewoms::VtkMultiWriter<GridView, vtkFormat> VtkMultiWriter;
+    typedef Ewoms::SnapshotWriter<GridView> SnapshotWriter;
 
 public:
     VtkEnergyModule(const Simulator& simulator)
@@ -137,7 +140,8 @@ public:
      */
     void processElement(const ElementContext& elemCtx)
     {
-        if (!EWOMS_GET_PARAM(TypeTag, bool, EnableVtkOutput))
+        if (!EWOMS_GET_PARAM(TypeTag, bool, EnableVtkOutput)
+            && !EWOMS_GET_PARAM(TypeTag, bool, EnableSnapshotOutput))
             return;
 
         for (unsigned i = 0; i < elemCtx.numPrimaryDof(/*timeIdx=*/0); ++i) {
@@ -164,8 +168,8 @@ public:
      */
     void commitBuffers(BaseOutputWriter& baseWriter)
     {
-        VtkMultiWriter *vtkWriter = dynamic_cast<VtkMultiWriter*>(&baseWriter);
-        if (!vtkWriter) {
+        if (!dynamic_cast<VtkMultiWriter*>(&baseWriter)
+            && !dynamic_cast<SnapshotWriter*>(&baseWriter)) {
             return;
         }
 
@@ -28,6 +28,7 @@
 #define EWOMS_VTK_MULTI_PHASE_MODULE_HH
 
 #include "vtkmultiwriter.hh"
+#include "snapshotwriter.hh"
 #include "baseoutputmodule.hh"
 
 #include <ewoms/common/propertysystem.hh>
@@ -59,6 +60,7 @@ NEW_PROP_TAG(VtkWritePotentialGradients);
 NEW_PROP_TAG(VtkWriteFilterVelocities);
 NEW_PROP_TAG(VtkOutputFormat);
 NEW_PROP_TAG(EnableVtkOutput);
+NEW_PROP_TAG(EnableSnapshotOutput);
 NEW_PROP_TAG(Evaluation);
 
 // set default values for what quantities to output
@@ -109,6 +111,7 @@ class VtkMultiPhaseModule : public BaseOutputModule<TypeTag>
 
     static const int vtkFormat = GET_PROP_VALUE(TypeTag, VtkOutputFormat);
     typedef Ewoms::VtkMultiWriter<GridView, vtkFormat> VtkMultiWriter;
+    typedef Ewoms::SnapshotWriter<GridView> SnapshotWriter;
 
     typedef Opm::MathToolbox<Evaluation> Toolbox;
 
@@ -209,7 +212,9 @@ public:
     {
         typedef Opm::MathToolbox<Evaluation> Toolbox;
 
-        if (!EWOMS_GET_PARAM(TypeTag, bool, EnableVtkOutput))
+        if (!EWOMS_GET_PARAM(TypeTag, bool, EnableVtkOutput)
+
+            && !EWOMS_GET_PARAM(TypeTag, bool, EnableSnapshotOutput))
             return;
 
         const auto& problem = elemCtx.problem();
@@ -308,8 +313,8 @@ public:
      */
     void commitBuffers(BaseOutputWriter& baseWriter)
     {
-        VtkMultiWriter *vtkWriter = dynamic_cast<VtkMultiWriter*>(&baseWriter);
-        if (!vtkWriter)
+        if (!dynamic_cast<VtkMultiWriter*>(&baseWriter)
+            && !dynamic_cast<SnapshotWriter*>(&baseWriter))
             return;
 
         if (pressureOutput_())
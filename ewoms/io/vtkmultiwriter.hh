@@ -31,6 +31,7 @@
 #include "vtkscalarfunction.hh"
 #include "vtkvectorfunction.hh"
 #include "vtktensorfunction.hh"
+#include "vtknativewriter.hh"
 
 #include <ewoms/io/baseoutputwriter.hh>
 
@@ -58,6 +59,9 @@ namespace Ewoms {
  * This class automatically keeps the meta file up to date and
  * simplifies writing datasets consisting of multiple files. (i.e.
  * multiple time steps or grid refinements within a time step.)
+ *
+ * If vtkFormat is one of the values of Ewoms::VtkNative::OutputType, the
+ * data is written by Ewoms::VtkNativeWriter instead of Dune::VTKWriter.
  */
 template <class GridView, int vtkFormat>
 class VtkMultiWriter : public BaseOutputWriter
@@ -67,6 +71,9 @@ class VtkMultiWriter : public BaseOutputWriter
     typedef Dune::MultipleCodimMultipleGeomTypeMapper<GridView, Dune::MCMGVertexLayout> VertexMapper;
     typedef Dune::MultipleCodimMultipleGeomTypeMapper<GridView, Dune::MCMGElementLayout> ElementMapper;
 
+    typedef Ewoms::VtkNativeWriter<GridView, ElementMapper, VertexMapper> NativeWriter;
+    static const bool useNativeWriter = VtkNative::isNativeFormat(vtkFormat);
+
 public:
     typedef BaseOutputWriter::Scalar Scalar;
     typedef BaseOutputWriter::Vector Vector;
@@ -97,6 +104,8 @@ public:
         }
 
         curWriterNum_ = 0;
+        curWriter_ = 0;
+        nativeWriter_ = 0;
 
         commRank_ = gridView.comm().rank();
         commSize_ = gridView.comm().size();
@@ -105,6 +114,7 @@ public:
     ~VtkMultiWriter()
     {
         finishMultiFile_();
+        delete nativeWriter_;
 
         if (commRank_ == 0)
             multiFile_.close();
@@ -127,6 +137,10 @@ public:
     {
         elementMapper_.update();
         vertexMapper_.update();
+
+        // the geometry of the grid needs to be re-encoded for the next file
+        delete nativeWriter_;
+        nativeWriter_ = 0;
     }
 
     /*!
@@ -141,7 +155,18 @@ public:
         curTime_ = t;
         curOutFileName_ = fileName_();
 
-        curWriter_ = new VtkWriter(gridView_, Dune::VTK::conforming);
+        if (useNativeWriter) {
+            // the native writer is kept alive between files to avoid encoding the
+            // geometry of the grid for each of them
+            if (!nativeWriter_)
+                nativeWriter_ = new NativeWriter(gridView_,
+                                                 elementMapper_,
+                                                 vertexMapper_,
+                                                 VtkNative::isCompressed(vtkFormat),
+                                                 VtkNative::isFloat32(vtkFormat));
+        }
+        else
+            curWriter_ = new VtkWriter(gridView_, Dune::VTK::conforming);
         ++curWriterNum_;
     }
 
@@ -194,6 +219,11 @@ public:
     {
         sanitizeScalarBuffer_(buf);
 
+        if (useNativeWriter) {
+            nativeWriter_->addScalarData(buf, name, /*isCellData=*/false);
+            return;
+        }
+
         typedef Ewoms::VtkScalarFunction<GridView, VertexMapper> VtkFn;
         FunctionPtr fnPtr(new VtkFn(name,
                                     gridView_,
@@ -222,6 +252,11 @@ public:
     {
         sanitizeScalarBuffer_(buf);
 
+        if (useNativeWriter) {
+            nativeWriter_->addScalarData(buf, name, /*isCellData=*/true);
+            return;
+        }
+
         typedef Ewoms::VtkScalarFunction<GridView, ElementMapper> VtkFn;
         FunctionPtr fnPtr(new VtkFn(name,
                                     gridView_,
@@ -251,6 +286,11 @@ public:
     {
         sanitizeVectorBuffer_(buf);
 
+        if (useNativeWriter) {
+            nativeWriter_->addVectorData(buf, name, /*isCellData=*/false);
+            return;
+        }
+
         typedef Ewoms::VtkVectorFunction<GridView, VertexMapper> VtkFn;
         FunctionPtr fnPtr(new VtkFn(name,
                                     gridView_,
@@ -265,6 +305,11 @@ public:
      */
     void attachTensorVertexData(TensorBuffer& buf, std::string name)
     {
+        if (useNativeWriter) {
+            nativeWriter_->addTensorData(buf, name, /*isCellData=*/false);
+            return;
+        }
+
         typedef Ewoms::VtkTensorFunction<GridView, VertexMapper> VtkFn;
 
         for (unsigned colIdx = 0; colIdx < buf[0].N(); ++colIdx) {
@@ -300,6 +345,11 @@ public:
     {
         sanitizeVectorBuffer_(buf);
 
+        if (useNativeWriter) {
+            nativeWriter_->addVectorData(buf, name, /*isCellData=*/true);
+            return;
+        }
+
         typedef Ewoms::VtkVectorFunction<GridView, ElementMapper> VtkFn;
         FunctionPtr fnPtr(new VtkFn(name,
                                     gridView_,
@@ -314,6 +364,11 @@ public:
      */
     void attachTensorElementData(TensorBuffer& buf, std::string name)
     {
+        if (useNativeWriter) {
+            nativeWriter_->addTensorData(buf, name, /*isCellData=*/true);
+            return;
+        }
+
         typedef Ewoms::VtkTensorFunction<GridView, ElementMapper> VtkFn;
 
         for (unsigned colIdx = 0; colIdx < buf[0].N(); ++colIdx) {
@@ -342,8 +397,11 @@ public:
         if (!onlyDiscard) {
             std::string fileName;
             // write the actual data as vtu or vtp (plus the pieces file in the parallel case)
-            fileName = curWriter_->write(/*name=*/curOutFileName_.c_str(),
-                                         static_cast<Dune::VTK::OutputType>(vtkFormat));
+            if (useNativeWriter)
+                fileName = nativeWriter_->write(/*name=*/curOutFileName_);
+            else
+                fileName = curWriter_->write(/*name=*/curOutFileName_.c_str(),
+                                             static_cast<Dune::VTK::OutputType>(vtkFormat));
 
             // determine name to write into the multi-file for the
             // current time step
@@ -356,6 +414,9 @@ public:
 
         // discard managed objects and the current VTK writer
         delete curWriter_;
+        curWriter_ = 0;
+        if (nativeWriter_)
+            nativeWriter_->discardData();
         while (managedScalarBuffers_.begin() != managedScalarBuffers_.end()) {
             delete managedScalarBuffers_.front();
             managedScalarBuffers_.pop_front();
@@ -509,6 +570,7 @@ private:
     int commRank_; // rank of the current process in the communicator
 
     VtkWriter *curWriter_;
+    NativeWriter *nativeWriter_;
     double curTime_;
     std::string curOutFileName_;
     int curWriterNum_;
@@ -0,0 +1,584 @@
+// -*- mode: C++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*-
+// vi: set et ts=4 sw=4 sts=4:
+/*
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+
+  Consult the COPYING file in the top-level source directory of this
+  module for the precise wording of the license and the list of
+  copyright holders.
+*/
+/*!
+ * \file
+ *
+ * \copydoc Ewoms::VtkNativeWriter
+ */
+#ifndef EWOMS_VTK_NATIVE_WRITER_HH
+#define EWOMS_VTK_NATIVE_WRITER_HH
+
+#include <ewoms/io/baseoutputwriter.hh>
+#include <ewoms/io/vtkscalarfunction.hh>
+
+#include <opm/common/Exceptions.hpp>
+#include <opm/common/ErrorMacros.hpp>
+
+#include <dune/common/version.hh>
+#include <dune/grid/common/gridenums.hh>
+#include <dune/grid/io/file/vtk/common.hh>
+
+#if HAVE_ZLIB
+#include <zlib.h>
+#endif
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace Ewoms {
+namespace VtkNative {
+/*!
+ * \brief Output formats which are handled by Ewoms::VtkNativeWriter.
+ *
+ * These values can be used for the VtkOutputFormat property as an alternative to the
+ * ones defined by Dune::VTK::OutputType. They are chosen such that they never collide
+ * with the latter.
+ */
+enum OutputType {
+    //! raw binary data in the appended section of the VTU files
+    appendedRaw = 0x100,
+
+    //! zlib compressed binary data in the appended section of the VTU files
+    appendedZlib = 0x101,
+
+    //! like appendedRaw, but floating point values are written using single precision
+    appendedRawFloat32 = 0x102,
+
+    //! like appendedZlib, but floating point values are written using single precision
+    appendedZlibFloat32 = 0x103
+};
+
+//! Returns true if an output format needs to be handled by Ewoms::VtkNativeWriter
+static inline constexpr bool isNativeFormat(int vtkFormat)
+{ return (vtkFormat & 0x100) != 0; }
+
+//! Returns true if an output format specifies zlib compressed data
+static inline constexpr bool isCompressed(int vtkFormat)
+{ return (vtkFormat & 0x001) != 0; }
+
+//! Returns true if an output format specifies single precision floating point values
+static inline constexpr bool isFloat32(int vtkFormat)
+{ return (vtkFormat & 0x002) != 0; }
+} // namespace VtkNative
+
+/*!
+ * \brief Writes the VTU files of a single time step without using Dune::VTKWriter.
+ *
+ * In contrast to Dune::VTKWriter, this class does not evaluate the fields element by
+ * element using virtual function calls but converts the attached buffers to the
+ * (optionally zlib compressed) binary representation of the appended section of the
+ * VTU file in one pass. If more than one process is involved, each process writes its
+ * own piece and the first process writes the PVTU file which references them.
+ *
+ * The geometry of the grid is only encoded once. An object of this class can thus be
+ * used to write any number of time steps as long as the grid does not change.
+ */
+template <class GridView, class ElementMapper, class VertexMapper>
+class VtkNativeWriter
+{
+    enum { dim = GridView::dimension };
+
+    typedef BaseOutputWriter::ScalarBuffer ScalarBuffer;
+    typedef BaseOutputWriter::VectorBuffer VectorBuffer;
+    typedef BaseOutputWriter::TensorBuffer TensorBuffer;
+
+    // the values are sanitized in the same way as for Dune::VTKWriter
+    typedef Ewoms::VtkScalarFunction<GridView, ElementMapper> ScalarFunction;
+
+    // VTK uses 64 bit headers for the sizes of the binary blobs
+    typedef uint64_t HeaderType;
+
+    // the size of the blocks which are individually compressed. (this is the default
+    // used by VTK itself.)
+    static const size_t compressionBlockSize = 32768;
+
+    struct DataArray
+    {
+        std::string name;
+        std::string type;
+        unsigned numComponents;
+        std::vector<char> blob;
+    };
+
+public:
+    VtkNativeWriter(const GridView& gridView,
+                    const ElementMapper& elementMapper,
+                    const VertexMapper& vertexMapper,
+                    bool compress,
+                    bool singlePrecision)
+        : gridView_(gridView)
+        , elementMapper_(elementMapper)
+        , vertexMapper_(vertexMapper)
+        , compress_(compress)
+        , singlePrecision_(singlePrecision)
+    {
+#if !HAVE_ZLIB
+        if (compress_) {
+            if (gridView_.comm().rank() == 0)
+                std::cerr << "Warning: zlib compressed VTK output was requested but zlib is "
+                          << "not available. Writing uncompressed data instead.\n";
+            compress_ = false;
+        }
+#endif
+
+        extractGeometry_();
+    }
+
+    /*!
+     * \brief Discard all fields which have been added so far.
+     *
+     * The encoded geometry of the grid is kept, so the object can be used for the next
+     * file afterwards.
+     */
+    void discardData()
+    {
+        pointDataArrays_.clear();
+        cellDataArrays_.clear();
+    }
+
+    /*!
+     * \brief Add a scalar field to the output.
+     *
+     * \param isCellData Specifies whether the buffer is indexed by the element or by the
+     *                   vertex mapper.
+     */
+    void addScalarData(const ScalarBuffer& buf, const std::string& name, bool isCellData)
+    {
+        const auto& entityIdx = isCellData ? cellIdx_ : pointIdx_;
+
+        std::vector<double> values(entityIdx.size());
+        for (size_t i = 0; i < entityIdx.size(); ++i)
+            values[i] = ScalarFunction::sanitize(buf[entityIdx[i]]);
+
+        addFloatArray_(isCellData, name, /*numComponents=*/1, values);
+    }
+
+    /*!
+     * \brief Add a vectorial field to the output.
+     *
+     * Two-dimensional vectors are padded with a zero third component so that they can be
+     * directly used for glyphs.
+     */
+    void addVectorData(const VectorBuffer& buf, const std::string& name, bool isCellData)
+    {
+        const auto& entityIdx = isCellData ? cellIdx_ : pointIdx_;
+
+        unsigned n = buf.empty() ? 1 : static_cast<unsigned>(buf[0].size());
+        unsigned numComponents = (n == 2) ? 3 : n;
+        std::vector<double> values(entityIdx.size()*numComponents, 0.0);
+        for (size_t i = 0; i < entityIdx.size(); ++i) {
+            const auto& v = buf[entityIdx[i]];
+            for (unsigned compIdx = 0; compIdx < n; ++compIdx)
+                values[i*numComponents + compIdx] = ScalarFunction::sanitize(v[compIdx]);
+        }
+
+        addFloatArray_(isCellData, name, numComponents, values);
+    }
+
+    /*!
+     * \brief Add a tensorial field to the output.
+     *
+     * Like for Dune::VTKWriter, each column of the tensor is written as a separate
+     * vectorial field called "name[colIdx]". Like vectors, two-dimensional columns are
+     * padded with a zero third component.
+     */
+    void addTensorData(const TensorBuffer& buf, const std::string& name, bool isCellData)
+    {
+        const auto& entityIdx = isCellData ? cellIdx_ : pointIdx_;
+        if (buf.empty())
+            return;
+
+        unsigned numRows = static_cast<unsigned>(buf[0].N());
+        unsigned numCols = static_cast<unsigned>(buf[0].M());
+        unsigned numComponents = (numRows == 2) ? 3 : numRows;
+        for (unsigned colIdx = 0; colIdx < numCols; ++colIdx) {
+            std::ostringstream oss;
+            oss << name << "[" << colIdx << "]";
+
+            std::vector<double> values(entityIdx.size()*numComponents, 0.0);
+            for (size_t i = 0; i < entityIdx.size(); ++i)
+                for (unsigned rowIdx = 0; rowIdx < numRows; ++rowIdx)
+                    values[i*numComponents + rowIdx] =
+                        ScalarFunction::sanitize(buf[entityIdx[i]][rowIdx][colIdx]);
+
+            addFloatArray_(isCellData, oss.str(), numComponents, values);
+        }
+    }
+
+    /*!
+     * \brief Write the piece of the local process and, in the parallel case, the
+     *        PVTU file to disk.
+     *
+     * \return The name of the file which ought to be referenced by the PVD file.
+     */
+    std::string write(const std::string& baseName)
+    {
+        int commRank = gridView_.comm().rank();
+        int commSize = gridView_.comm().size();
+
+        if (commSize == 1) {
+            std::string fileName = baseName + ".vtu";
+            writePiece_(fileName);
+            return fileName;
+        }
+
+        writePiece_(pieceFileName_(baseName, commRank, commSize));
+        std::string pvtuFileName = parallelFileName_(baseName, commSize);
+        if (commRank == 0)
+            writeParallelHeader_(pvtuFileName, baseName, commSize);
+
+        // make sure that the PVTU file is never referenced before all pieces exist
+        gridView_.comm().barrier();
+
+        return pvtuFileName;
+    }
+
+private:
+    void extractGeometry_()
+    {
+        // assign a consecutive index to all vertices which are used by interior elements
+        std::vector<int> vertexIdxMap(static_cast<size_t>(vertexMapper_.size()), -1);
+
+        std::vector<int64_t> connectivity;
+        std::vector<int64_t> offsets;
+        std::vector<uint8_t> types;
+        std::vector<double> coords;
+
+        auto elemIt = gridView_.template begin</*codim=*/0, Dune::Interior_Partition>();
+        const auto& elemEndIt = gridView_.template end</*codim=*/0, Dune::Interior_Partition>();
+        for (; elemIt != elemEndIt; ++elemIt) {
+            const auto& elem = *elemIt;
+            const auto& geom = elem.geometry();
+            const Dune::GeometryType gt = elem.type();
+
+#if DUNE_VERSION_NEWER(DUNE_COMMON, 2, 4)
+            cellIdx_.push_back(static_cast<size_t>(elementMapper_.index(elem)));
+#else
+            cellIdx_.push_back(static_cast<size_t>(elementMapper_.map(elem)));
+#endif
+
+            int numCorners = geom.corners();
+            for (int vtkCornerIdx = 0; vtkCornerIdx < numCorners; ++vtkCornerIdx) {
+                // VTK uses a different ordering of the corners for some element types
+                int duneCornerIdx = Dune::VTK::renumber(gt, vtkCornerIdx);
+#if DUNE_VERSION_NEWER(DUNE_COMMON, 2, 4)
+                size_t vIdx = static_cast<size_t>(vertexMapper_.subIndex(elem, duneCornerIdx, dim));
+#else
+                size_t vIdx = static_cast<size_t>(vertexMapper_.map(elem, duneCornerIdx, dim));
+#endif
+                if (vertexIdxMap[vIdx] < 0) {
+                    vertexIdxMap[vIdx] = static_cast<int>(pointIdx_.size());
+                    pointIdx_.push_back(vIdx);
+
+                    const auto& pos = geom.corner(duneCornerIdx);
+                    for (unsigned i = 0; i < 3; ++i)
+                        coords.push_back((i < pos.size()) ? pos[i] : 0.0);
+                }
+                connectivity.push_back(vertexIdxMap[vIdx]);
+            }
+
+            offsets.push_back(static_cast<int64_t>(connectivity.size()));
+            types.push_back(static_cast<uint8_t>(Dune::VTK::geometryType(gt)));
+        }
+
+        pointsArray_.name = "Coordinates";
+        pointsArray_.numComponents = 3;
+        pointsArray_.type = floatTypeName_();
+        encodeFloat_(pointsArray_.blob, coords);
+
+        cellArrays_.resize(3);
+        cellArrays_[0].name = "connectivity";
+        cellArrays_[0].type = "Int64";
+        cellArrays_[0].numComponents = 1;
+        encode_(cellArrays_[0].blob, connectivity.data(), connectivity.size()*sizeof(int64_t));
+
+        cellArrays_[1].name = "offsets";
+        cellArrays_[1].type = "Int64";
+        cellArrays_[1].numComponents = 1;
+        encode_(cellArrays_[1].blob, offsets.data(), offsets.size()*sizeof(int64_t));
+
+        cellArrays_[2].name = "types";
+        cellArrays_[2].type = "UInt8";
+        cellArrays_[2].numComponents = 1;
+        encode_(cellArrays_[2].blob, types.data(), types.size()*sizeof(uint8_t));
+    }
+
+    void addFloatArray_(bool isCellData,
+                        const std::string& name,
+                        unsigned numComponents,
+                        const std::vector<double>& values)
+    {
+        auto& arrays = isCellData ? cellDataArrays_ : pointDataArrays_;
+        arrays.push_back(DataArray());
+
+        DataArray& array = arrays.back();
+        array.name = name;
+        array.type = floatTypeName_();
+        array.numComponents = numComponents;
+        encodeFloat_(array.blob, values);
+    }
+
+    std::string floatTypeName_() const
+    { return singlePrecision_ ? "Float32" : "Float64"; }
+
+    void encodeFloat_(std::vector<char>& blob, const std::vector<double>& values) const
+    {
+        if (!singlePrecision_) {
+            encode_(blob, values.data(), values.size()*sizeof(double));
+            return;
+        }
+
+        // make sure that all values can be displayed by paraview, i.e., clamp them to
+        // the range which is representable by single precision floating point values
+        std::vector<float> tmp(values.size());
+        for (size_t i = 0; i < values.size(); ++i) {
+            double v = values[i];
+            if (std::abs(v) < static_cast<double>(std::numeric_limits<float>::min()))
+                v = 0.0;
+            else if (v > static_cast<double>(std::numeric_limits<float>::max()))
+                v = static_cast<double>(std::numeric_limits<float>::max());
+            else if (v < -static_cast<double>(std::numeric_limits<float>::max()))
+                v = -static_cast<double>(std::numeric_limits<float>::max());
+            tmp[i] = static_cast<float>(v);
+        }
+        encode_(blob, tmp.data(), tmp.size()*sizeof(float));
+    }
+
+    // convert a chunk of memory to the representation used by the appended section
+    void encode_(std::vector<char>& blob, const void *data, size_t numBytes) const
+    {
+        const char *bytes = static_cast<const char*>(data);
+
+        if (!compress_) {
+            HeaderType header = numBytes;
+            blob.resize(sizeof(header) + numBytes);
+            std::memcpy(blob.data(), &header, sizeof(header));
+            if (numBytes > 0)
+                std::memcpy(blob.data() + sizeof(header), bytes, numBytes);
+            return;
+        }
+
+#if HAVE_ZLIB
+        // the header of compressed data consists of the number of blocks, the
+        // uncompressed size of a block, the uncompressed size of the last block and the
+        // compressed sizes of all blocks
+        size_t numBlocks = (numBytes + compressionBlockSize - 1)/compressionBlockSize;
+        size_t lastBlockSize = numBytes - (numBlocks > 0 ? (numBlocks - 1)*compressionBlockSize : 0);
+
+        std::vector<HeaderType> header(3 + numBlocks);
+        header[0] = numBlocks;
+        header[1] = compressionBlockSize;
+        header[2] = lastBlockSize;
+
+        std::vector<char> compressed;
+        std::vector<Bytef> blockBuf(compressBound(compressionBlockSize));
+        for (size_t blockIdx = 0; blockIdx < numBlocks; ++blockIdx) {
+            size_t blockBegin = blockIdx*compressionBlockSize;
+            size_t blockSize = std::min(static_cast<size_t>(compressionBlockSize), numBytes - blockBegin);
+
+            uLongf compressedSize = static_cast<uLongf>(blockBuf.size());
+            int ret = compress2(blockBuf.data(),
+                                &compressedSize,
+                                reinterpret_cast<const Bytef*>(bytes + blockBegin),
+                                static_cast<uLong>(blockSize),
+                                Z_DEFAULT_COMPRESSION);
+            if (ret != Z_OK)
+                OPM_THROW(std::runtime_error,
+                          "zlib compression of VTK data failed (error code " << ret << ")");
+
+            header[3 + blockIdx] = compressedSize;
+            compressed.insert(compressed.end(),
+                              reinterpret_cast<const char*>(blockBuf.data()),
+                              reinterpret_cast<const char*>(blockBuf.data()) + compressedSize);
+        }
+
+        size_t headerBytes = header.size()*sizeof(HeaderType);
+        blob.resize(headerBytes + compressed.size());
+        std::memcpy(blob.data(), header.data(), headerBytes);
+        if (!compressed.empty())
+            std::memcpy(blob.data() + headerBytes, compressed.data(), compressed.size());
+#endif
+    }
+
+    void writeDataArrayTag_(std::ostream& os, const DataArray& array, uint64_t& offset) const
+    {
+        os << "     <DataArray type=\"" << array.type << "\""
+           << " Name=\"" << array.name << "\""
+           << " NumberOfComponents=\"" << array.numComponents << "\""
+           << " format=\"appended\""
+           << " offset=\"" << offset << "\"/>\n";
+        offset += array.blob.size();
+    }
+
+    void writePiece_(const std::string& fileName) const
+    {
+        std::ofstream os(fileName.c_str(), std::ios::out | std::ios::binary);
+        if (!os.good())
+            OPM_THROW(std::runtime_error, "Could not open VTK file '" << fileName << "'");
+
+        os << "<?xml version=\"1.0\"?>\n"
+           << "<VTKFile type=\"UnstructuredGrid\" version=\"1.0\""
+           << " byte_order=\"" << byteOrder_() << "\""
+           << " header_type=\"UInt64\"";
+        if (compress_)
+            os << " compressor=\"vtkZLibDataCompressor\"";
+        os << ">\n"
+           << " <UnstructuredGrid>\n"
+           << "  <Piece NumberOfPoints=\"" << pointIdx_.size() << "\""
+           << " NumberOfCells=\"" << cellIdx_.size() << "\">\n";
+
+        uint64_t offset = 0;
+        os << "   <PointData>\n";
+        for (const auto& array : pointDataArrays_)
+            writeDataArrayTag_(os, array, offset);
+        os << "   </PointData>\n";
+
+        os << "   <CellData>\n";
+        for (const auto& array : cellDataArrays_)
+            writeDataArrayTag_(os, array, offset);
+        os << "   </CellData>\n";
+
+        os << "   <Points>\n";
+        writeDataArrayTag_(os, pointsArray_, offset);
+        os << "   </Points>\n";
+
+        os << "   <Cells>\n";
+        for (const auto& array : cellArrays_)
+            writeDataArrayTag_(os, array, offset);
+        os << "   </Cells>\n";
+
+        os << "  </Piece>\n"
+           << " </UnstructuredGrid>\n"
+           << " <AppendedData encoding=\"raw\">\n"
+           << "_";
+
+        // the blobs must be written in exactly the same order as their tags
+        for (const auto& array : pointDataArrays_)
+            os.write(array.blob.data(), static_cast<std::streamsize>(array.blob.size()));
+        for (const auto& array : cellDataArrays_)
+            os.write(array.blob.data(), static_cast<std::streamsize>(array.blob.size()));
+        os.write(pointsArray_.blob.data(), static_cast<std::streamsize>(pointsArray_.blob.size()));
+        for (const auto& array : cellArrays_)
+            os.write(array.blob.data(), static_cast<std::streamsize>(array.blob.size()));
+
+        os << "\n </AppendedData>\n"
+           << "</VTKFile>\n";
+    }
+
+    void writeParallelHeader_(const std::string& fileName,
+                              const std::string& baseName,
+                              int commSize) const
+    {
+        std::ofstream os(fileName.c_str());
+        if (!os.good())
+            OPM_THROW(std::runtime_error, "Could not open VTK file '" << fileName << "'");
+
+        os << "<?xml version=\"1.0\"?>\n"
+           << "<VTKFile type=\"PUnstructuredGrid\" version=\"1.0\""
+           << " byte_order=\"" << byteOrder_() << "\""
+           << " header_type=\"UInt64\"";
+        if (compress_)
+            os << " compressor=\"vtkZLibDataCompressor\"";
+        os << ">\n"
+           << " <PUnstructuredGrid GhostLevel=\"0\">\n";
+
+        os << "  <PPointData>\n";
+        for (const auto& array : pointDataArrays_)
+            writePDataArrayTag_(os, array);
+        os << "  </PPointData>\n";
+
+        os << "  <PCellData>\n";
+        for (const auto& array : cellDataArrays_)
+            writePDataArrayTag_(os, array);
+        os << "  </PCellData>\n";
+
+        os << "  <PPoints>\n";
+        writePDataArrayTag_(os, pointsArray_);
+        os << "  </PPoints>\n";
+
+        for (int rank = 0; rank < commSize; ++rank)
+            os << "  <Piece Source=\"" << pieceFileName_(baseName, rank, commSize) << "\"/>\n";
+
+        os << " </PUnstructuredGrid>\n"
+           << "</VTKFile>\n";
+    }
+
+    void writePDataArrayTag_(std::ostream& os, const DataArray& array) const
+    {
+        os << "   <PDataArray type=\"" << array.type << "\""
+           << " Name=\"" << array.name << "\""
+           << " NumberOfComponents=\"" << array.numComponents << "\"/>\n";
+    }
+
+    static const char *byteOrder_()
+    {
+        const uint16_t probe = 1;
+        return (*reinterpret_cast<const char*>(&probe) == 1) ? "LittleEndian" : "BigEndian";
+    }
+
+    // use the same naming scheme for the pieces as Dune::VTKWriter
+    static std::string pieceFileName_(const std::string& baseName, int rank, int commSize)
+    {
+        std::ostringstream oss;
+        oss << "s" << std::setw(4) << std::setfill('0') << commSize
+            << "-p" << std::setw(4) << std::setfill('0') << rank
+            << "-" << baseName << ".vtu";
+        return oss.str();
+    }
+
+    static std::string parallelFileName_(const std::string& baseName, int commSize)
+    {
+        std::ostringstream oss;
+        oss << "s" << std::setw(4) << std::setfill('0') << commSize
+            << "-" << baseName << ".pvtu";
+        return oss.str();
+    }
+
+    const GridView gridView_;
+    const ElementMapper& elementMapper_;
+    const VertexMapper& vertexMapper_;
+
+    bool compress_;
+    bool singlePrecision_;
+
+    // the indices of the buffers' entries which are written to the file
+    std::vector<size_t> cellIdx_;
+    std::vector<size_t> pointIdx_;
+
+    DataArray pointsArray_;
+    std::vector<DataArray> cellArrays_;
+    std::vector<DataArray> pointDataArrays_;
+    std::vector<DataArray> cellDataArrays_;
+};
+} // namespace Ewoms
+
+#endif
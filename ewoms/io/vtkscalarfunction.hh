@@ -123,9 +123,18 @@ public:
             OPM_THROW(std::logic_error, "Only element and vertex based vector "
                                         " fields are supported so far.");
 
-        return static_cast<double>(static_cast<float>(buf_[idx]));
+        return sanitize(buf_[idx]);
     }
 
+    /*!
+     * \brief Convert a value to the representation which ends up in the VTK file.
+     *
+     * Values are rounded to single precision, which avoids numbers that cannot be
+     * parsed by some VTK readers (e.g., subnormal double precision values).
+     */
+    static double sanitize(double value)
+    { return static_cast<double>(static_cast<float>(value)); }
+
 private:
     const std::string name_;
     const GridView gridView_;
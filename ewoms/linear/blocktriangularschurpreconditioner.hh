@@ -0,0 +1,351 @@
+// -*- mode: C++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*-
+// vi: set et ts=4 sw=4 sts=4:
+/*
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+
+  Consult the COPYING file in the top-level source directory of this
+  module for the precise wording of the license and the list of
+  copyright holders.
+*/
+/*!
+ * \file
+ *
+ * \copydoc Ewoms::Linear::BlockTriangularSchurPreconditioner
+ */
+#ifndef EWOMS_BLOCK_TRIANGULAR_SCHUR_PRECONDITIONER_HH
+#define EWOMS_BLOCK_TRIANGULAR_SCHUR_PRECONDITIONER_HH
+
+#include <ewoms/common/propertysystem.hh>
+#include <ewoms/common/parametersystem.hh>
+
+#include <dune/istl/bcrsmatrix.hh>
+#include <dune/istl/bvector.hh>
+#include <dune/istl/preconditioners.hh>
+#include <dune/common/fmatrix.hh>
+#include <dune/common/fvector.hh>
+
+#include <memory>
+#include <vector>
+
+namespace Ewoms {
+namespace Properties {
+NEW_PROP_TAG(Scalar);
+NEW_PROP_TAG(GridView);
+NEW_PROP_TAG(Indices);
+NEW_PROP_TAG(OverlappingMatrix);
+NEW_PROP_TAG(OverlappingVector);
+NEW_PROP_TAG(PreconditionerRelaxation);
+} // namespace Properties
+
+namespace Linear {
+
+/*!
+ * \ingroup Linear
+ *
+ * \brief A block-triangular preconditioner for saddle point problems like the ones of
+ *        the Stokes equations.
+ *
+ * The unknowns of each degree of freedom are split into the velocity components, which
+ * must be numVelocities consecutive entries starting at velocity0Idx for both the
+ * primary variables and the equations, and the remaining "scalar" unknowns (pressure,
+ * composition and temperature). If the linear system is written as
+ * \f[ \begin{pmatrix} A & G \\ B & C \end{pmatrix}
+ *     \begin{pmatrix} u \\ s \end{pmatrix} = \begin{pmatrix} r_u \\ r_s \end{pmatrix} \f]
+ * with the velocities \f$u\f$ and the scalar unknowns \f$s\f$, the preconditioner
+ * is the block upper triangular matrix
+ * \f[ P = \begin{pmatrix} \hat{A} & G \\ 0 & \hat{S} \end{pmatrix} \;, \f]
+ * where \f$\hat{A}\f$ is the ILU(0) decomposition of the velocity block and
+ * \f$\hat{S}\f$ is a block diagonal approximation of the Schur complement
+ * \f$S = C - B A^{-1} G\f$:
+ * \f[ \hat{S}_{ii} = C_{ii} - \sum_j B_{ij} \mathrm{diag}(A_{jj})^{-1} G_{ji} \f]
+ * For the Stokes equations, the pressure part of \f$\hat{S}\f$ scales like the
+ * lumped pressure mass matrix divided by the viscosity, i.e., it is the classical
+ * pressure-mass-matrix approximation of the Schur complement, but it is computed from
+ * the matrix alone and thus exhibits the correct sign and scaling for any
+ * discretization of the equations.
+ *
+ * The preconditioner only considers the rows it is given. In parallel, it is used as
+ * the sequential preconditioner of the process-local part of an overlapping matrix
+ * like all other preconditioners.
+ */
+template <class Matrix, class Vector, int velocity0Idx, int numVelocities>
+class BlockTriangularSchurPreconditioner
+    : public Dune::Preconditioner<Vector, Vector>
+{
+    typedef typename Matrix::field_type Scalar;
+    typedef typename Matrix::block_type MatrixBlock;
+
+    enum { numEq = MatrixBlock::rows };
+    enum { numScalars = numEq - numVelocities };
+
+    static_assert(0 <= velocity0Idx && velocity0Idx + numVelocities <= numEq,
+                  "The velocity components must be part of the matrix blocks");
+    static_assert(numScalars > 0,
+                  "The block-triangular Schur preconditioner requires at least one "
+                  "non-velocity unknown");
+
+    typedef Dune::FieldMatrix<Scalar, numVelocities, numVelocities> VelocityMatrixBlock;
+    typedef Dune::FieldVector<Scalar, numVelocities> VelocityVectorBlock;
+    typedef Dune::BCRSMatrix<VelocityMatrixBlock> VelocityMatrix;
+    typedef Dune::BlockVector<VelocityVectorBlock> VelocityVector;
+    typedef Dune::SeqILU0<VelocityMatrix, VelocityVector, VelocityVector> VelocityPreconditioner;
+
+    typedef Dune::FieldMatrix<Scalar, numScalars, numScalars> SchurBlock;
+    typedef Dune::FieldVector<Scalar, numScalars> SchurVectorBlock;
+
+public:
+    typedef Matrix matrix_type;
+    typedef Vector domain_type;
+    typedef Vector range_type;
+    typedef typename Vector::field_type field_type;
+
+    enum { category = Dune::SolverCategory::sequential };
+
+    /*!
+     * \brief Create the preconditioner.
+     *
+     * \param M The matrix of the linear system
+     * \param relaxationFactor The relaxation factor of the ILU(0) decomposition of the
+     *                         velocity block
+     */
+    BlockTriangularSchurPreconditioner(const Matrix& M, Scalar relaxationFactor)
+        : M_(M)
+    {
+        // the indices of the non-velocity unknowns within a block
+        unsigned scalarIdx = 0;
+        for (unsigned i = 0; i < numEq; ++i)
+            if (!isVelocity_(i))
+                scalarIndices_[scalarIdx++] = i;
+
+        createVelocityMatrix_();
+        velocityPreconditioner_.reset(new VelocityPreconditioner(velocityMatrix_,
+                                                                 relaxationFactor));
+        createSchurBlocks_();
+
+        velocityRhs_.resize(M_.N());
+        velocitySolution_.resize(M_.N());
+    }
+
+    /*!
+     * \brief Prepare the preconditioner.
+     */
+    virtual void pre(domain_type&, range_type&)
+    {}
+
+    /*!
+     * \brief Apply the preconditioner, i.e., solve \f$P v = d\f$.
+     */
+    virtual void apply(domain_type& v, const range_type& d)
+    {
+        const unsigned n = static_cast<unsigned>(M_.N());
+
+        // solve for the scalar unknowns using the approximate Schur complement
+        for (unsigned rowIdx = 0; rowIdx < n; ++rowIdx) {
+            SchurVectorBlock rs;
+            for (unsigned a = 0; a < numScalars; ++a)
+                rs[a] = d[rowIdx][scalarIndices_[a]];
+
+            SchurVectorBlock ys;
+            invSchurBlocks_[rowIdx].mv(rs, ys);
+            for (unsigned a = 0; a < numScalars; ++a)
+                v[rowIdx][scalarIndices_[a]] = ys[a];
+        }
+
+        // subtract the influence of the scalar unknowns from the momentum equations
+        for (unsigned rowIdx = 0; rowIdx < n; ++rowIdx) {
+            VelocityVectorBlock& rv = velocityRhs_[rowIdx];
+            for (unsigned b = 0; b < numVelocities; ++b)
+                rv[b] = d[rowIdx][velocity0Idx + b];
+
+            auto colIt = M_[rowIdx].begin();
+            const auto& colEndIt = M_[rowIdx].end();
+            for (; colIt != colEndIt; ++colIt) {
+                const MatrixBlock& block = *colIt;
+                const auto& vCol = v[colIt.index()];
+                for (unsigned b = 0; b < numVelocities; ++b)
+                    for (unsigned a = 0; a < numScalars; ++a)
+                        rv[b] -= block[velocity0Idx + b][scalarIndices_[a]]*vCol[scalarIndices_[a]];
+            }
+        }
+
+        // solve for the velocities
+        velocitySolution_ = 0.0;
+        velocityPreconditioner_->apply(velocitySolution_, velocityRhs_);
+        for (unsigned rowIdx = 0; rowIdx < n; ++rowIdx)
+            for (unsigned b = 0; b < numVelocities; ++b)
+                v[rowIdx][velocity0Idx + b] = velocitySolution_[rowIdx][b];
+    }
+
+    /*!
+     * \brief Clean up the preconditioner.
+     */
+    virtual void post(domain_type&)
+    {}
+
+private:
+    static bool isVelocity_(unsigned idx)
+    { return velocity0Idx <= static_cast<int>(idx) && static_cast<int>(idx) < velocity0Idx + numVelocities; }
+
+    // extract the velocity-velocity part of the matrix
+    void createVelocityMatrix_()
+    {
+        const size_t n = M_.N();
+        velocityMatrix_.setSize(n, n, M_.nonzeroes());
+        velocityMatrix_.setBuildMode(VelocityMatrix::row_wise);
+        auto rowIt = velocityMatrix_.createbegin();
+        const auto& rowEndIt = velocityMatrix_.createend();
+        for (; rowIt != rowEndIt; ++rowIt) {
+            auto colIt = M_[rowIt.index()].begin();
+            const auto& colEndIt = M_[rowIt.index()].end();
+            for (; colIt != colEndIt; ++colIt)
+                rowIt.insert(colIt.index());
+        }
+
+        for (unsigned rowIdx = 0; rowIdx < n; ++rowIdx) {
+            auto colIt = M_[rowIdx].begin();
+            const auto& colEndIt = M_[rowIdx].end();
+            for (; colIt != colEndIt; ++colIt) {
+                const MatrixBlock& src = *colIt;
+                VelocityMatrixBlock& dest = velocityMatrix_[rowIdx][colIt.index()];
+                for (unsigned b = 0; b < numVelocities; ++b)
+                    for (unsigned c = 0; c < numVelocities; ++c)
+                        dest[b][c] = src[velocity0Idx + b][velocity0Idx + c];
+            }
+        }
+    }
+
+    // compute the inverses of the diagonal blocks of the approximate Schur complement
+    void createSchurBlocks_()
+    {
+        const unsigned n = static_cast<unsigned>(M_.N());
+
+        // the inverse of the diagonal of the velocity block
+        std::vector<VelocityVectorBlock> invVelocityDiag(n);
+        for (unsigned rowIdx = 0; rowIdx < n; ++rowIdx) {
+            const VelocityMatrixBlock& diagBlock = velocityMatrix_[rowIdx][rowIdx];
+            for (unsigned b = 0; b < numVelocities; ++b)
+                invVelocityDiag[rowIdx][b] =
+                    (diagBlock[b][b] != 0.0) ? 1.0/diagBlock[b][b] : 0.0;
+        }
+
+        invSchurBlocks_.resize(n);
+        for (unsigned rowIdx = 0; rowIdx < n; ++rowIdx) {
+            SchurBlock& S = invSchurBlocks_[rowIdx];
+            const MatrixBlock& diagBlock = M_[rowIdx][rowIdx];
+            for (unsigned a = 0; a < numScalars; ++a)
+                for (unsigned c = 0; c < numScalars; ++c)
+                    S[a][c] = diagBlock[scalarIndices_[a]][scalarIndices_[c]];
+
+            // S_ii -= B_ij diag(A_jj)^-1 G_ji
+            auto colIt = M_[rowIdx].begin();
+            const auto& colEndIt = M_[rowIdx].end();
+            for (; colIt != colEndIt; ++colIt) {
+                unsigned colIdx = static_cast<unsigned>(colIt.index());
+                auto transIt = M_[colIdx].find(rowIdx);
+                if (transIt == M_[colIdx].end())
+                    continue;
+
+                const MatrixBlock& B = *colIt;
+                const MatrixBlock& G = *transIt;
+                for (unsigned a = 0; a < numScalars; ++a) {
+                    for (unsigned c = 0; c < numScalars; ++c) {
+                        Scalar tmp = 0.0;
+                        for (unsigned b = 0; b < numVelocities; ++b)
+                            tmp +=
+                                B[scalarIndices_[a]][velocity0Idx + b]
+                                * invVelocityDiag[colIdx][b]
+                                * G[velocity0Idx + b][scalarIndices_[c]];
+                        S[a][c] -= tmp;
+                    }
+                }
+            }
+
+            // this throws a Dune::FMatrixError if the block is singular, which makes the
+            // linear solver backend give up on the preconditioner
+            S.invert();
+        }
+    }
+
+    const Matrix& M_;
+    unsigned scalarIndices_[numScalars];
+
+    VelocityMatrix velocityMatrix_;
+    std::unique_ptr<VelocityPreconditioner> velocityPreconditioner_;
+    std::vector<SchurBlock> invSchurBlocks_;
+
+    VelocityVector velocityRhs_;
+    VelocityVector velocitySolution_;
+};
+
+/*!
+ * \ingroup Linear
+ *
+ * \brief Preconditioner wrapper for the block-triangular Schur complement
+ *        preconditioner of the Stokes models.
+ *
+ * This requires the Indices of the model to provide the velocity0Idx attribute.
+ */
+template <class TypeTag>
+class PreconditionerWrapperBlockTriangularSchur
+{
+    typedef typename GET_PROP_TYPE(TypeTag, Scalar) Scalar;
+    typedef typename GET_PROP_TYPE(TypeTag, GridView) GridView;
+    typedef typename GET_PROP_TYPE(TypeTag, Indices) Indices;
+    typedef typename GET_PROP_TYPE(TypeTag, OverlappingMatrix) OverlappingMatrix;
+    typedef typename GET_PROP_TYPE(TypeTag, OverlappingVector) OverlappingVector;
+
+    static_assert(Indices::velocity0Idx == Indices::momentum0EqIdx,
+                  "The velocity components and the momentum equations must exhibit the "
+                  "same indices");
+
+public:
+    typedef BlockTriangularSchurPreconditioner<OverlappingMatrix,
+                                               OverlappingVector,
+                                               Indices::velocity0Idx,
+                                               GridView::dimensionworld> SequentialPreconditioner;
+
+    PreconditionerWrapperBlockTriangularSchur()
+        : seqPreCond_(0)
+    {}
+
+    static void registerParameters()
+    {
+        EWOMS_REGISTER_PARAM(TypeTag, Scalar, PreconditionerRelaxation,
+                             "The relaxation factor of the preconditioner");
+    }
+
+    void prepare(OverlappingMatrix& matrix)
+    {
+        Scalar relaxationFactor = EWOMS_GET_PARAM(TypeTag, Scalar, PreconditionerRelaxation);
+        seqPreCond_ = new SequentialPreconditioner(matrix, relaxationFactor);
+    }
+
+    SequentialPreconditioner& get()
+    { return *seqPreCond_; }
+
+    void cleanup()
+    {
+        delete seqPreCond_;
+        seqPreCond_ = 0;
+    }
+
+private:
+    SequentialPreconditioner *seqPreCond_;
+};
+
+}} // namespace Linear, Ewoms
+
+#endif
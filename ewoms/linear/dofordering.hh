@@ -0,0 +1,270 @@
+// -*- mode: C++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*-
+// vi: set et ts=4 sw=4 sts=4:
+/*
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+
+  Consult the COPYING file in the top-level source directory of this
+  module for the precise wording of the license and the list of
+  copyright holders.
+*/
+/*!
+ * \file
+ *
+ * \brief Algorithms which compute locality preserving orderings of the rows of a linear
+ *        system of equations.
+ *
+ * All functions of this file produce a vector which contains the original indices in
+ * the new order, i.e., ordering[newIdx] == oldIdx.
+ */
+#ifndef EWOMS_DOF_ORDERING_HH
+#define EWOMS_DOF_ORDERING_HH
+
+#include "overlaptypes.hh"
+
+#include <dune/common/fvector.hh>
+
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <utility>
+#include <vector>
+
+namespace Ewoms {
+namespace Linear {
+
+/*!
+ * \brief Returns the index of a row of a BCRS matrix which is suitable as the starting
+ *        point of the Cuthill-McKee algorithm.
+ *
+ * This is a node of the last level of a breadth-first search which starts at a given
+ * row and which exhibits the smallest number of neighbors within this level. It is
+ * thus usually "far away" from the starting point, which reduces the bandwidth of the
+ * reordered matrix.
+ */
+template <class BCRSMatrix>
+unsigned cuthillMcKeeStartIndex(const BCRSMatrix& A,
+                                const std::vector<unsigned>& degree,
+                                unsigned startIdx,
+                                std::vector<int>& stamp,
+                                int curStamp)
+{
+    std::vector<unsigned> level(1, startIdx);
+    std::vector<unsigned> nextLevel;
+    stamp[startIdx] = curStamp;
+    while (true) {
+        nextLevel.clear();
+        for (unsigned rowIdx : level) {
+            auto colIt = A[rowIdx].begin();
+            const auto& colEndIt = A[rowIdx].end();
+            for (; colIt != colEndIt; ++colIt) {
+                unsigned colIdx = static_cast<unsigned>(colIt.index());
+                if (stamp[colIdx] == curStamp)
+                    continue;
+
+                stamp[colIdx] = curStamp;
+                nextLevel.push_back(colIdx);
+            }
+        }
+
+        if (nextLevel.empty())
+            break;
+        level.swap(nextLevel);
+    }
+
+    unsigned result = level[0];
+    for (unsigned idx : level)
+        if (degree[idx] < degree[result])
+            result = idx;
+    return result;
+}
+
+/*!
+ * \brief Computes the reverse Cuthill-McKee ordering of the sparsity pattern of a BCRS
+ *        matrix.
+ *
+ * This ordering reduces the bandwidth of the matrix, which improves the cache
+ * efficiency of matrix-vector products and the quality of incomplete factorizations.
+ * Unconnected parts of the matrix are ordered one after another.
+ *
+ * \param ordering The resulting ordering. ordering[newIdx] is the original index.
+ * \param A The matrix which's sparsity pattern is considered
+ */
+template <class BCRSMatrix>
+void reverseCuthillMcKeeOrdering(std::vector<Index>& ordering, const BCRSMatrix& A)
+{
+    const unsigned n = static_cast<unsigned>(A.N());
+    ordering.clear();
+    ordering.reserve(n);
+
+    std::vector<unsigned> degree(n);
+    for (unsigned rowIdx = 0; rowIdx < n; ++rowIdx)
+        degree[rowIdx] = static_cast<unsigned>(A[rowIdx].size());
+
+    // the candidates for the start of each connected component of the graph sorted by
+    // their degree
+    std::vector<unsigned> candidates(n);
+    for (unsigned rowIdx = 0; rowIdx < n; ++rowIdx)
+        candidates[rowIdx] = rowIdx;
+    auto lessDegree =
+        [&degree](unsigned a, unsigned b) -> bool
+        { return degree[a] < degree[b]; };
+    std::stable_sort(candidates.begin(), candidates.end(), lessDegree);
+
+    std::vector<bool> isNumbered(n, false);
+    std::vector<int> stamp(n, -1);
+    std::vector<unsigned> neighbors;
+    int curStamp = 0;
+    for (unsigned candIdx = 0; candIdx < n; ++candIdx) {
+        if (isNumbered[candidates[candIdx]])
+            continue;
+
+        unsigned startIdx =
+            cuthillMcKeeStartIndex(A, degree, candidates[candIdx], stamp, curStamp++);
+
+        // breadth-first search which numbers the neighbors of each row by increasing
+        // degree
+        size_t head = ordering.size();
+        ordering.push_back(static_cast<Index>(startIdx));
+        isNumbered[startIdx] = true;
+        while (head < ordering.size()) {
+            unsigned rowIdx = static_cast<unsigned>(ordering[head++]);
+
+            neighbors.clear();
+            auto colIt = A[rowIdx].begin();
+            const auto& colEndIt = A[rowIdx].end();
+            for (; colIt != colEndIt; ++colIt) {
+                unsigned colIdx = static_cast<unsigned>(colIt.index());
+                if (isNumbered[colIdx])
+                    continue;
+
+                isNumbered[colIdx] = true;
+                neighbors.push_back(colIdx);
+            }
+
+            std::stable_sort(neighbors.begin(), neighbors.end(), lessDegree);
+            for (unsigned colIdx : neighbors)
+                ordering.push_back(static_cast<Index>(colIdx));
+        }
+    }
+
+    std::reverse(ordering.begin(), ordering.end());
+}
+
+/*!
+ * \brief Returns the position of a point on the Hilbert curve.
+ *
+ * This uses the algorithm described in J. Skilling: "Programming the Hilbert curve",
+ * AIP Conference Proceedings 707, 2004.
+ *
+ * \param coords The integer coordinates of the point. Each coordinate must be smaller
+ *               than 2^numBits. The array is modified by this function.
+ * \param numBits The number of bits per coordinate
+ */
+template <int dim>
+uint64_t hilbertIndex(uint32_t (&coords)[dim], unsigned numBits)
+{
+    const uint32_t M = uint32_t(1) << (numBits - 1);
+
+    // inverse undo
+    for (uint32_t Q = M; Q > 1; Q >>= 1) {
+        uint32_t P = Q - 1;
+        for (unsigned i = 0; i < dim; ++i) {
+            if (coords[i] & Q)
+                coords[0] ^= P;
+            else {
+                uint32_t t = (coords[0] ^ coords[i]) & P;
+                coords[0] ^= t;
+                coords[i] ^= t;
+            }
+        }
+    }
+
+    // gray encode
+    for (unsigned i = 1; i < dim; ++i)
+        coords[i] ^= coords[i - 1];
+    uint32_t t = 0;
+    for (uint32_t Q = M; Q > 1; Q >>= 1)
+        if (coords[dim - 1] & Q)
+            t ^= Q - 1;
+    for (unsigned i = 0; i < dim; ++i)
+        coords[i] ^= t;
+
+    // interleave the bits of the transposed coordinates
+    uint64_t result = 0;
+    for (int bitIdx = static_cast<int>(numBits) - 1; bitIdx >= 0; --bitIdx)
+        for (unsigned i = 0; i < dim; ++i)
+            result = (result << 1) | ((coords[i] >> bitIdx) & 1);
+
+    return result;
+}
+
+/*!
+ * \brief Computes an ordering of a set of points which follows the Hilbert space
+ *        filling curve through their bounding box.
+ *
+ * Points which are close in space are thus also close in the resulting ordering. In
+ * contrast to the reverse Cuthill-McKee ordering, this does not need the connectivity
+ * of the points.
+ *
+ * \param ordering The resulting ordering. ordering[newIdx] is the original index.
+ * \param positions The spatial positions of the points
+ */
+template <class Scalar, int dim>
+void hilbertCurveOrdering(std::vector<Index>& ordering,
+                          const std::vector<Dune::FieldVector<Scalar, dim> >& positions)
+{
+    // the number of bits per coordinate. the resulting index must fit into 64 bits
+    const unsigned numBits = std::min<unsigned>(20, 63/dim);
+    const Scalar maxCoord = static_cast<Scalar>((uint32_t(1) << numBits) - 1);
+
+    Dune::FieldVector<Scalar, dim> minPos(std::numeric_limits<Scalar>::max());
+    Dune::FieldVector<Scalar, dim> maxPos(-std::numeric_limits<Scalar>::max());
+    for (const auto& pos : positions) {
+        for (unsigned i = 0; i < dim; ++i) {
+            minPos[i] = std::min(minPos[i], pos[i]);
+            maxPos[i] = std::max(maxPos[i], pos[i]);
+        }
+    }
+
+    std::vector<std::pair<uint64_t, Index> > keys(positions.size());
+    for (unsigned pointIdx = 0; pointIdx < positions.size(); ++pointIdx) {
+        uint32_t coords[dim];
+        for (unsigned i = 0; i < dim; ++i) {
+            Scalar extent = maxPos[i] - minPos[i];
+            Scalar x = 0.0;
+            if (extent > 0.0)
+                x = (positions[pointIdx][i] - minPos[i])/extent;
+            coords[i] = static_cast<uint32_t>(x*maxCoord);
+        }
+
+        keys[pointIdx].first = hilbertIndex<dim>(coords, numBits);
+        keys[pointIdx].second = static_cast<Index>(pointIdx);
+    }
+
+    std::stable_sort(keys.begin(), keys.end(),
+                     [](const std::pair<uint64_t, Index>& a,
+                        const std::pair<uint64_t, Index>& b) -> bool
+                     { return a.first < b.first; });
+
+    ordering.resize(keys.size());
+    for (unsigned i = 0; i < keys.size(); ++i)
+        ordering[i] = keys[i].second;
+}
+
+} // namespace Linear
+} // namespace Ewoms
+
+#endif
@@ -32,6 +32,7 @@
 #include "globalindices.hh"
 
 #include <ewoms/parallel/mpibuffer.hh>
+#include <ewoms/common/memoryusage.hh>
 
 #include <algorithm>
 #include <limits>
@@ -61,12 +62,19 @@ public:
     /*!
      * \brief Constructs the foreign overlap given a BCRS matrix and
      *        an initial list of border indices.
+     *
+     * If an ordering of the native indices is given, the domestic indices of the
+     * process' local rows follow it instead of the native order. This can be used to
+     * improve the memory locality of the linear solver (cf. dofordering.hh). The
+     * ordering must contain each native index exactly once and ordering[i] is the
+     * native index of the i-th row.
      */
     template <class BCRSMatrix>
     DomesticOverlapFromBCRSMatrix(const BCRSMatrix& A,
                                   const BorderList& borderList,
                                   const BlackList& blackList,
-                                  unsigned overlapSize)
+                                  unsigned overlapSize,
+                                  const std::vector<Index>& nativeOrdering = std::vector<Index>())
         : foreignOverlap_(A, borderList, blackList, overlapSize)
         , blackList_(blackList)
         , globalIndices_(foreignOverlap_)
@@ -87,6 +95,7 @@ public:
         blackList_.updateNativeToDomesticMap(*this);
 
         setupDebugMapping_();
+        setupOrdering_(nativeOrdering);
     }
 
     void check() const
@@ -268,6 +277,25 @@ public:
     void print() const
     { globalIndices_.print(); }
 
+    /*!
+     * \brief Returns the number of bytes allocated by the index maps of the overlap.
+     *
+     * This includes the foreign overlap and the global indices.
+     */
+    size_t memoryUsage() const
+    {
+        return
+            foreignOverlap_.memoryUsage()
+            + globalIndices_.memoryUsage()
+            + dynamicMemoryUsage(domesticOverlapWithPeer_)
+            + dynamicMemoryUsage(domesticOverlapByIndex_)
+            + dynamicMemoryUsage(borderDistance_)
+            + dynamicMemoryUsage(masterRank_)
+            + dynamicMemoryUsage(static_cast<const std::set<ProcessRank>&>(peerSet_))
+            + dynamicMemoryUsage(internalToExternal_)
+            + dynamicMemoryUsage(externalToInternal_);
+    }
+
     /*!
      * \brief Returns a domestic index given a global one
      */
@@ -395,10 +423,32 @@ protected:
         }
 
         // receive our overlap from the processes to all peer processes
+        std::vector<std::vector<IndexDistanceNpeers> > peerIndices(peerSet_.size());
         peerIt = peerSet_.begin();
-        for (; peerIt != peerEndIt; ++peerIt) {
+        for (unsigned peerIdx = 0; peerIt != peerEndIt; ++peerIt, ++peerIdx) {
             ProcessRank peerRank = *peerIt;
-            receiveIndicesFromPeer_(peerRank);
+            receiveIndicesFromPeer_(peerRank, peerIndices[peerIdx]);
+        }
+
+        // add the received indices which are not yet known to the domestic indices.
+        // this is done in a single step because the map from global to domestic
+        // indices is a sorted array.
+        std::vector<Index> newGlobalIndices;
+        for (const auto& indices : peerIndices)
+            for (const auto& idx : indices)
+                if (!globalIndices_.hasGlobalIndex(idx.index))
+                    newGlobalIndices.push_back(idx.index);
+        globalIndices_.addIndices(newGlobalIndices);
+
+        size_t newSize = globalIndices_.numDomestic();
+        borderDistance_.resize(newSize, std::numeric_limits<int>::max());
+        domesticOverlapByIndex_.resize(newSize);
+
+        // extend the domestic overlap
+        peerIt = peerSet_.begin();
+        for (unsigned peerIdx = 0; peerIt != peerEndIt; ++peerIt, ++peerIdx) {
+            ProcessRank peerRank = *peerIt;
+            addDomesticOverlap_(peerRank, peerIndices[peerIdx]);
         }
 
         // wait until all send operations complete
@@ -489,39 +539,40 @@ protected:
         delete indicesSendBuffer_[peerRank];
     }
 
-    void receiveIndicesFromPeer_(ProcessRank peerRank)
+    void receiveIndicesFromPeer_(ProcessRank peerRank,
+                                 std::vector<IndexDistanceNpeers>& indices)
     {
 #if HAVE_MPI
         // receive the number of additional indices
-        int numIndices = -1;
         MpiBuffer<size_t> numIndicesRecvBuff(1);
         numIndicesRecvBuff.receive(peerRank);
-        numIndices = static_cast<int>(numIndicesRecvBuff[0]);
+        size_t numIndices = numIndicesRecvBuff[0];
 
         // receive the additional indices themselfs
-        MpiBuffer<IndexDistanceNpeers> recvBuff(static_cast<size_t>(numIndices));
+        MpiBuffer<IndexDistanceNpeers> recvBuff(numIndices);
         recvBuff.receive(peerRank);
-        for (unsigned i = 0; i < static_cast<unsigned>(numIndices); ++i) {
-            Index globalIdx = recvBuff[i].index;
-            BorderDistance borderDistance = recvBuff[i].borderDistance;
-
-            // if the index is not already known, add it to the
-            // domestic indices
-            if (!globalIndices_.hasGlobalIndex(globalIdx)) {
-                Index newDomesticIdx = static_cast<Index>(globalIndices_.numDomestic());
-                globalIndices_.addIndex(newDomesticIdx, globalIdx);
-
-                size_t newSize = globalIndices_.numDomestic();
-                borderDistance_.resize(newSize, std::numeric_limits<int>::max());
-                domesticOverlapByIndex_.resize(newSize);
-            }
+
+        indices.resize(numIndices);
+        for (unsigned i = 0; i < numIndices; ++i)
+            indices[i] = recvBuff[i];
+#endif // HAVE_MPI
+    }
+
+    void addDomesticOverlap_(ProcessRank peerRank,
+                             const std::vector<IndexDistanceNpeers>& indices)
+    {
+        auto& overlapWithPeer = domesticOverlapWithPeer_[peerRank];
+        overlapWithPeer.reserve(indices.size());
+        for (const auto& idx : indices) {
+            Index globalIdx = idx.index;
+            BorderDistance borderDistance = idx.borderDistance;
 
             // convert the global index into a domestic one
             Index domesticIdx = globalIndices_.globalToDomestic(globalIdx);
 
             // extend the domestic overlap
-            domesticOverlapByIndex_[static_cast<unsigned>(domesticIdx)][static_cast<unsigned>(peerRank)] = borderDistance;
-            domesticOverlapWithPeer_[static_cast<unsigned>(peerRank)].push_back(domesticIdx);
+            domesticOverlapByIndex_[static_cast<unsigned>(domesticIdx)][peerRank] = borderDistance;
+            overlapWithPeer.push_back(domesticIdx);
 
             //assert(borderDistance >= 0);
             assert(globalIdx >= 0);
@@ -531,7 +582,6 @@ protected:
 
             borderDistance_[static_cast<unsigned>(domesticIdx)] = std::min(borderDistance, borderDistance_[static_cast<unsigned>(domesticIdx)]);
         }
-#endif // HAVE_MPI
     }
 
     // this method is intended to set up the code mapping code for
@@ -546,19 +596,50 @@ protected:
     void setupDebugMapping_()
     {}
 
-    // this method is intended to map domestic indices to the ones
-    // used by a sequential grid.
-    //
-    // by default, this method does nothing
+    // permute the domestic indices of the local rows so that they follow a given
+    // ordering of the native indices. the indices of the domestic overlap are not
+    // affected.
+    void setupOrdering_(const std::vector<Index>& nativeOrdering)
+    {
+        internalToExternal_.clear();
+        externalToInternal_.clear();
+        if (nativeOrdering.size() != numNative())
+            return;
+
+        size_t nLocal = numLocal();
+        internalToExternal_.resize(nLocal, -1);
+        externalToInternal_.resize(nLocal, -1);
+
+        Index externalIdx = 0;
+        for (Index nativeIdx : nativeOrdering) {
+            Index localIdx = foreignOverlap_.nativeToLocal(nativeIdx);
+            if (localIdx < 0)
+                continue; // black-listed index
+
+            internalToExternal_[static_cast<unsigned>(localIdx)] = externalIdx;
+            externalToInternal_[static_cast<unsigned>(externalIdx)] = localIdx;
+            ++ externalIdx;
+        }
+        assert(externalIdx == static_cast<Index>(nLocal));
+    }
+
+    // this method maps the internal domestic indices to the ones seen by the users of
+    // the overlap. by default, it does nothing, but the local rows may have been
+    // reordered by setupOrdering_().
     Index mapInternalToExternal_(Index internalIdx) const
-    { return internalIdx; }
+    {
+        if (internalIdx < 0 || static_cast<size_t>(internalIdx) >= internalToExternal_.size())
+            return internalIdx;
+        return internalToExternal_[static_cast<unsigned>(internalIdx)];
+    }
 
-    // this method is intended to map the indices used by a sequential
-    // to grid domestic indices ones.
-    //
-    // by default, this method does nothing
+    // the inverse of mapInternalToExternal_()
     Index mapExternalToInternal_(Index externalIdx) const
-    { return externalIdx; }
+    {
+        if (externalIdx < 0 || static_cast<size_t>(externalIdx) >= externalToInternal_.size())
+            return externalIdx;
+        return externalToInternal_[static_cast<unsigned>(externalIdx)];
+    }
 
     ProcessRank myRank_;
     unsigned worldSize_;
@@ -575,6 +656,9 @@ protected:
     std::map<ProcessRank, MpiBuffer<IndexDistanceNpeers> *> indicesSendBuffer_;
     GlobalIndices globalIndices_;
     PeerSet peerSet_;
+
+    std::vector<Index> internalToExternal_;
+    std::vector<Index> externalToInternal_;
 };
 
 } // namespace Linear
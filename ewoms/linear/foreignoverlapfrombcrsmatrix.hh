@@ -31,6 +31,7 @@
 #include "blacklist.hh"
 
 #include <ewoms/parallel/mpibuffer.hh>
+#include <ewoms/common/memoryusage.hh>
 
 #include <opm/common/Unused.hpp>
 
@@ -42,6 +43,7 @@
 #include <algorithm>
 #include <iostream>
 #include <map>
+#include <utility>
 #include <vector>
 
 #if HAVE_MPI
@@ -92,6 +94,7 @@ public:
 
         // calculate the set of local indices on the border (beware:
         // _not_ the native ones)
+        isLocalBorderIndex_.resize(numLocal(), false);
         auto it = borderList.begin();
         const auto& endIt = borderList.end();
         for (; it != endIt; ++it) {
@@ -99,9 +102,13 @@ public:
             if (localIdx < 0)
                 continue;
 
-            localBorderIndices_.insert(localIdx);
+            isLocalBorderIndex_[static_cast<unsigned>(localIdx)] = true;
         }
 
+        // sort the border list by the index and the peer rank to allow fast lookups of
+        // the indices on the peers
+        createBorderPeerIndices_();
+
         // compute the set of processes which are neighbors of the
         // local process ...
         neighborPeerSet_.update(borderList);
@@ -149,7 +156,12 @@ public:
      * \brief Returns true iff a local index is a border index.
      */
     bool isBorder(Index localIdx) const
-    { return localBorderIndices_.count(localIdx) > 0; }
+    {
+        return
+            localIdx >= 0
+            && static_cast<size_t>(localIdx) < isLocalBorderIndex_.size()
+            && isLocalBorderIndex_[static_cast<unsigned>(localIdx)];
+    }
 
     /*!
      * \brief Returns true iff a local index is a border index shared with a
@@ -206,8 +218,7 @@ public:
      * \brief Return the map of (peer rank, border distance) for a given local
      * index.
      */
-    const std::map<ProcessRank, BorderDistance> &
-    foreignOverlapByLocalIndex(Index localIdx) const
+    const PeerDistanceMap& foreignOverlapByLocalIndex(Index localIdx) const
     {
         assert(isLocal(localIdx));
         return foreignOverlapByLocalIndex_[static_cast<unsigned>(localIdx)];
@@ -343,6 +354,22 @@ public:
         }
     }
 
+    /*!
+     * \brief Returns the number of bytes allocated by the index maps of the foreign
+     *        overlap.
+     */
+    size_t memoryUsage() const
+    {
+        return
+            dynamicMemoryUsage(nativeToLocalIndices_)
+            + dynamicMemoryUsage(localToNativeIndices_)
+            + dynamicMemoryUsage(masterRank_)
+            + dynamicMemoryUsage(isLocalBorderIndex_)
+            + dynamicMemoryUsage(borderPeerIndices_)
+            + dynamicMemoryUsage(foreignOverlapByLocalIndex_)
+            + dynamicMemoryUsage(foreignOverlapByRank_);
+    }
+
 protected:
     // extend the foreign overlaps by 'overlapSize' levels. this uses
     // a greedy algorithm which extends the region by one level and
@@ -402,19 +429,6 @@ protected:
                 else if (foreignOverlapByLocalIndex_[static_cast<unsigned>(localColIdx)].count(peerRank) > 0)
                     continue;
 
-                // check whether the new index is already in the overlap
-                bool hasIndex = false;
-                typename SeedList::iterator sIt = nextSeedList.begin();
-                typename SeedList::iterator sEndIt = nextSeedList.end();
-                for (; sIt != sEndIt; ++sIt) {
-                    if (sIt->index == nativeColIdx && sIt->peerRank == peerRank) {
-                        hasIndex = true;
-                        break;
-                    }
-                }
-                if (hasIndex)
-                    continue; // we already have this index
-
                 // add the current processes to the seed list for the
                 // next overlap level
                 IndexRankDist newTuple;
@@ -425,6 +439,9 @@ protected:
             }
         }
 
+        // an index may be reachable from several seeds. only keep the first one
+        removeDuplicateSeeds_(nextSeedList);
+
         // clear the old seed list to save some memory
         seedList.clear();
 
@@ -453,18 +470,69 @@ protected:
         numLocal_ = localToNativeIndices_.size();
     }
 
-    Index localToPeerIdx_(Index localIdx, ProcessRank peerRank) const
+    void createBorderPeerIndices_()
     {
+        borderPeerIndices_.clear();
+        borderPeerIndices_.reserve(borderList_.size());
         auto it = borderList_.begin();
         const auto& endIt = borderList_.end();
-        for (; it != endIt; ++it) {
-            if (it->localIdx == localIdx && it->peerRank == peerRank)
-                return it->peerIdx;
-        }
+        for (; it != endIt; ++it)
+            borderPeerIndices_.push_back(*it);
+
+        // the sort must be stable because the first entry in the border list wins
+        std::stable_sort(borderPeerIndices_.begin(), borderPeerIndices_.end(),
+                         [](const BorderIndex& a, const BorderIndex& b)
+                         {
+                             return
+                                 a.localIdx < b.localIdx
+                                 || (a.localIdx == b.localIdx && a.peerRank < b.peerRank);
+                         });
+    }
+
+    Index localToPeerIdx_(Index localIdx, ProcessRank peerRank) const
+    {
+        auto it = std::lower_bound(borderPeerIndices_.begin(), borderPeerIndices_.end(),
+                                   std::make_pair(localIdx, peerRank),
+                                   [](const BorderIndex& a, const std::pair<Index, ProcessRank>& key)
+                                   {
+                                       return
+                                           a.localIdx < key.first
+                                           || (a.localIdx == key.first && a.peerRank < key.second);
+                                   });
+        if (it != borderPeerIndices_.end() && it->localIdx == localIdx && it->peerRank == peerRank)
+            return it->peerIdx;
 
         return -1;
     }
 
+    // remove all but the first entry for each (index, peer rank) pair from a seed list.
+    // the order of the remaining entries is not changed.
+    static void removeDuplicateSeeds_(SeedList& seedList)
+    {
+        typedef std::pair<std::pair<Index, ProcessRank>, size_t> KeyPos;
+        std::vector<KeyPos> keys;
+        keys.reserve(seedList.size());
+        size_t pos = 0;
+        for (const auto& seed : seedList)
+            keys.push_back(KeyPos(std::make_pair(seed.index, seed.peerRank), pos++));
+
+        // for equal keys, the entry which comes first in the list is sorted first
+        std::sort(keys.begin(), keys.end());
+
+        std::vector<bool> isDuplicate(keys.size(), false);
+        for (size_t i = 1; i < keys.size(); ++i)
+            if (keys[i].first == keys[i - 1].first)
+                isDuplicate[keys[i].second] = true;
+
+        pos = 0;
+        for (auto it = seedList.begin(); it != seedList.end(); ++pos) {
+            if (isDuplicate[pos])
+                it = seedList.erase(it);
+            else
+                ++it;
+        }
+    }
+
     template <class BCRSMatrix>
     void addNonNeighborOverlapIndices_(const BCRSMatrix& A OPM_UNUSED,
                                        SeedList& seedList,
@@ -577,19 +645,7 @@ protected:
                 if (distIt != foreignOverlapByLocalIndex_[static_cast<unsigned>(localIdx)].end())
                     continue;
 
-                // make sure the index is not already in the seed list
-                bool inSeedList = false;
-                auto seedIt = seedList.begin();
-                const auto& seedEndIt = seedList.end();
-                for (; seedIt != seedEndIt; ++seedIt) {
-                    if (seedIt->index == localIdx && seedIt->peerRank == peerRank) {
-                        inSeedList = true;
-                        break;
-                    }
-                }
-                if (inSeedList)
-                    continue;
-
+                // duplicates in the seed list are removed below
                 IndexRankDist seedEntry;
                 seedEntry.index = localIdx;
                 seedEntry.peerRank = peerRank;
@@ -601,6 +657,9 @@ protected:
             }
         }
 
+        // make sure that the indices are not already in the seed list
+        removeDuplicateSeeds_(seedList);
+
         // make sure all data was send
         peerIt = neighborPeerSet().begin();
         for (; peerIt != peerEndIt; ++peerIt) {
@@ -681,9 +740,12 @@ protected:
     // index
     std::vector<ProcessRank> masterRank_;
 
-    // set of all local indices which are on the border of some remote
+    // specifies for each local index whether it is on the border of some remote
     // process
-    std::set<Index> localBorderIndices_;
+    std::vector<bool> isLocalBorderIndex_;
+
+    // the border list sorted by the index and the peer rank
+    std::vector<BorderIndex> borderPeerIndices_;
 
     // stores the set of process ranks which are in the overlap for a
     // given row index "owned" by the current rank. The second value
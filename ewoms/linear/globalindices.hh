@@ -33,10 +33,10 @@
 #include <dune/istl/operators.hh>
 
 #include <algorithm>
-#include <set>
-#include <map>
+#include <cassert>
 #include <iostream>
-#include <tuple>
+#include <utility>
+#include <vector>
 
 #if HAVE_MPI
 #include <mpi.h>
@@ -44,20 +44,32 @@
 
 #include "overlaptypes.hh"
 
+#include <ewoms/parallel/mpibuffer.hh>
+#include <ewoms/common/memoryusage.hh>
+
 namespace Ewoms {
 namespace Linear {
 /*!
  * \brief This class maps domestic row indices to and from "global"
  *        indices which is used to construct an algebraic overlap
  *        for the parallel linear solvers.
+ *
+ * The global indices of the indices for which a process is the master are numbered
+ * consecutively starting at the number of such indices on all processes of lower
+ * rank. This offset is determined using a prefix sum over all processes, and the global
+ * indices of the border indices for which some other process is the master are then
+ * exchanged with the neighboring processes only. The mapping from the domestic to the
+ * global indices is a flat array while the inverse mapping is stored as an array of
+ * (global index, domestic index) pairs which is sorted by the global index.
  */
 template <class ForeignOverlap>
 class GlobalIndices
 {
     GlobalIndices(const GlobalIndices& ) = delete;
 
-    typedef std::map<Index, Index> GlobalToDomesticMap;
-    typedef std::map<Index, Index> DomesticToGlobalMap;
+    typedef std::pair<Index, Index> GlobalDomesticPair;
+    typedef std::vector<GlobalDomesticPair> GlobalToDomesticMap;
+    typedef std::vector<Index> DomesticToGlobalMap;
 
 public:
     GlobalIndices(const ForeignOverlap& foreignOverlap)
@@ -87,9 +99,11 @@ public:
      */
     Index domesticToGlobal(Index domesticIdx) const
     {
-        assert(domesticToGlobal_.find(domesticIdx) != domesticToGlobal_.end());
+        assert(0 <= domesticIdx
+               && static_cast<size_t>(domesticIdx) < domesticToGlobal_.size());
+        assert(domesticToGlobal_[static_cast<unsigned>(domesticIdx)] >= 0);
 
-        return domesticToGlobal_.find(domesticIdx)->second;
+        return domesticToGlobal_[static_cast<unsigned>(domesticIdx)];
     }
 
     /*!
@@ -97,12 +111,13 @@ public:
      */
     Index globalToDomestic(Index globalIdx) const
     {
-        const auto& tmp = globalToDomestic_.find(globalIdx);
+        auto it = std::lower_bound(globalToDomestic_.begin(), globalToDomestic_.end(),
+                                   globalIdx, globalLess_);
 
-        if (tmp == globalToDomestic_.end())
+        if (it == globalToDomestic_.end() || it->first != globalIdx)
             return -1;
 
-        return tmp->second;
+        return it->second;
     }
 
     /*!
@@ -123,63 +138,58 @@ public:
 
     /*!
      * \brief Add an index to the domestic<->global mapping.
+     *
+     * Since the inverse mapping is a sorted array, adding a single index is linear in
+     * the number of domestic indices. Use addIndices() to add many indices at once.
      */
     void addIndex(Index domesticIdx, Index globalIdx)
     {
-        domesticToGlobal_[domesticIdx] = globalIdx;
-        globalToDomestic_[globalIdx] = domesticIdx;
-        numDomestic_ = domesticToGlobal_.size();
-
-        assert(domesticToGlobal_.size() == globalToDomestic_.size());
+        setDomesticToGlobal_(domesticIdx, globalIdx);
+
+        auto it = std::lower_bound(globalToDomestic_.begin(), globalToDomestic_.end(),
+                                   globalIdx, globalLess_);
+        if (it != globalToDomestic_.end() && it->first == globalIdx)
+            it->second = domesticIdx;
+        else
+            globalToDomestic_.insert(it, GlobalDomesticPair(globalIdx, domesticIdx));
+        numDomestic_ = globalToDomestic_.size();
     }
 
     /*!
-     * \brief Send a border index to a remote process.
+     * \brief Add a set of global indices to the domestic indices.
+     *
+     * Global indices which are already known are ignored. The new domestic indices are
+     * numbered consecutively starting at numDomestic() in the ascending order of the
+     * global indices.
      */
-    void sendBorderIndex(ProcessRank peerRank, Index domesticIdx, Index peerLocalIdx)
+    void addIndices(std::vector<Index> globalIndices)
     {
-#if HAVE_MPI
-        PeerIndexGlobalIndex sendBuf;
-        sendBuf.peerIdx = peerLocalIdx;
-        sendBuf.globalIdx = domesticToGlobal(domesticIdx);
-        MPI_Send(&sendBuf,                     // buff
-                 sizeof(PeerIndexGlobalIndex), // count
-                 MPI_BYTE,                     // data type
-                 static_cast<int>(peerRank),   // peer process
-                 0,                            // tag
-                 MPI_COMM_WORLD);              // communicator
-#endif
-    }
+        std::sort(globalIndices.begin(), globalIndices.end());
+        globalIndices.erase(std::unique(globalIndices.begin(), globalIndices.end()),
+                            globalIndices.end());
 
-    /*!
-     * \brief Receive an index on the border from a remote
-     *        process and add it the translation maps.
-     */
-    void receiveBorderIndex(ProcessRank peerRank)
-    {
-#if HAVE_MPI
-        PeerIndexGlobalIndex recvBuf;
-        MPI_Recv(&recvBuf,                     // buff
-                 sizeof(PeerIndexGlobalIndex), // count
-                 MPI_BYTE,                     // data type
-                 static_cast<int>(peerRank),   // peer process
-                 0,                            // tag
-                 MPI_COMM_WORLD,               // communicator
-                 MPI_STATUS_IGNORE);           // status
-
-        Index domesticIdx = foreignOverlap_.nativeToLocal(recvBuf.peerIdx);
-        if (domesticIdx >= 0) {
-            Index globalIdx = recvBuf.globalIdx;
-            addIndex(domesticIdx, globalIdx);
+        size_t numOld = globalToDomestic_.size();
+        for (Index globalIdx : globalIndices) {
+            if (hasGlobalIndex_(globalIdx, numOld))
+                continue;
+
+            Index domesticIdx = static_cast<Index>(globalToDomestic_.size());
+            setDomesticToGlobal_(domesticIdx, globalIdx);
+            globalToDomestic_.push_back(GlobalDomesticPair(globalIdx, domesticIdx));
         }
-#endif // HAVE_MPI
+
+        // both the old and the new entries are sorted, so they only need to be merged
+        std::inplace_merge(globalToDomestic_.begin(),
+                           globalToDomestic_.begin() + static_cast<std::ptrdiff_t>(numOld),
+                           globalToDomestic_.end());
+        numDomestic_ = globalToDomestic_.size();
     }
 
     /*!
      * \brief Return true iff a given global index already exists
      */
     bool hasGlobalIndex(Index globalIdx) const
-    { return globalToDomestic_.find(globalIdx) != globalToDomestic_.end(); }
+    { return globalToDomestic(globalIdx) >= 0; }
 
     /*!
      * \brief Prints the global indices of all domestic indices
@@ -196,134 +206,149 @@ public:
         std::cout << "\n" << std::flush;
     }
 
+    /*!
+     * \brief Returns the number of bytes allocated by the index maps.
+     */
+    size_t memoryUsage() const
+    { return dynamicMemoryUsage(globalToDomestic_) + dynamicMemoryUsage(domesticToGlobal_); }
+
 protected:
-    // retrieve the offset for the indices where we are master in the
-    // global index list
+    // number the indices for which the current process is the master and retrieve the
+    // global indices of the remaining local indices from their masters
     void buildGlobalIndices_()
     {
+        Index numMaster = 0;
+        for (unsigned i = 0; i < foreignOverlap_.numLocal(); ++i)
+            if (foreignOverlap_.iAmMasterOf(static_cast<Index>(i)))
+                ++numMaster;
+
+        // the offset of the current process is the number of master indices of all
+        // processes with a lower rank
+        domesticOffset_ = 0;
 #if HAVE_MPI
-        numDomestic_ = 0;
-#else
-        numDomestic_ = foreignOverlap_.numLocal();
-#endif
-
-#if HAVE_MPI
-        if (myRank_ == 0) {
-            // the first rank starts at index zero
+        MPI_Exscan(&numMaster, &domesticOffset_, 1, MPI_INT, MPI_SUM, MPI_COMM_WORLD);
+        if (myRank_ == 0)
+            // the result of MPI_Exscan() is undefined on the first rank
             domesticOffset_ = 0;
-        }
-        else {
-            // all other ranks retrieve their offset from the next
-            // lower rank
-            MPI_Recv(&domesticOffset_, // buffer
-                     1,                // count
-                     MPI_INT,          // data type
-                     static_cast<int>(myRank_ - 1), // peer rank
-                     0,                // tag
-                     MPI_COMM_WORLD,   // communicator
-                     MPI_STATUS_IGNORE);
-        }
+#endif // HAVE_MPI
 
-        // create maps for all indices for which the current process
-        // is the master
-        int numMaster = 0;
+        domesticToGlobal_.assign(foreignOverlap_.numLocal(), -1);
+        globalToDomestic_.clear();
+        globalToDomestic_.reserve(foreignOverlap_.numLocal());
+
+        Index globalIdx = domesticOffset_;
         for (unsigned i = 0; i < foreignOverlap_.numLocal(); ++i) {
             if (!foreignOverlap_.iAmMasterOf(static_cast<Index>(i)))
                 continue;
 
-            addIndex(static_cast<Index>(i),
-                     static_cast<Index>(domesticOffset_ + numMaster));
-            ++numMaster;
+            domesticToGlobal_[i] = globalIdx;
+            globalToDomestic_.push_back(GlobalDomesticPair(globalIdx, static_cast<Index>(i)));
+            ++globalIdx;
         }
 
-        if (myRank_ < mpiSize_ - 1) {
-            // send the domestic offset plus the number of master
-            // indices to the process which is one rank higher
-            int tmp = domesticOffset_ + numMaster;
-            MPI_Send(&tmp,            // buff
-                     1,               // count
-                     MPI_INT,         // data type
-                     static_cast<int>(myRank_ + 1), // peer rank
-                     0,               // tag
-                     MPI_COMM_WORLD); // communicator
-        }
+        exchangeBorderIndices_();
 
-        typename PeerSet::const_iterator peerIt;
-        typename PeerSet::const_iterator peerEndIt = peerSet_().end();
-        // receive the border indices from the lower ranks
-        peerIt = peerSet_().begin();
-        for (; peerIt != peerEndIt; ++peerIt) {
-            if (*peerIt < myRank_)
-                receiveBorderFrom_(*peerIt);
-        }
-
-        // send the border indices to the higher ranks
-        peerIt = peerSet_().begin();
-        for (; peerIt != peerEndIt; ++peerIt) {
-            if (*peerIt > myRank_)
-                sendBorderTo_(*peerIt);
-        }
-
-        // receive the border indices from the higher ranks
-        peerIt = peerSet_().begin();
-        for (; peerIt != peerEndIt; ++peerIt) {
-            if (*peerIt > myRank_)
-                receiveBorderFrom_(*peerIt);
-        }
-
-        // send the border indices to the lower ranks
-        peerIt = peerSet_().begin();
-        for (; peerIt != peerEndIt; ++peerIt) {
-            if (*peerIt < myRank_)
-                sendBorderTo_(*peerIt);
-        }
-#endif // HAVE_MPI
+        std::sort(globalToDomestic_.begin(), globalToDomestic_.end());
+        globalToDomestic_.erase(std::unique(globalToDomestic_.begin(), globalToDomestic_.end()),
+                                globalToDomestic_.end());
+        numDomestic_ = globalToDomestic_.size();
     }
 
-    void sendBorderTo_(ProcessRank peerRank)
+    // send the global indices of the border indices for which the current process is
+    // the master to the neighboring processes and receive the ones for which a neighbor
+    // is the master. the messages to and from all neighbors are in flight concurrently.
+    void exchangeBorderIndices_()
     {
 #if HAVE_MPI
-        // send (local index on myRank, global index) pairs to the
-        // peers
-        BorderList::const_iterator borderIt = borderList_().begin();
-        BorderList::const_iterator borderEndIt = borderList_().end();
+        std::vector<ProcessRank> peers(peerSet_().begin(), peerSet_().end());
+        size_t numPeers = peers.size();
+
+        // collect the (index on the peer, global index) pairs for each peer
+        std::vector<std::vector<PeerIndexGlobalIndex> > sendIndices(numPeers);
+        auto borderIt = borderList_().begin();
+        const auto& borderEndIt = borderList_().end();
         for (; borderIt != borderEndIt; ++borderIt) {
-            ProcessRank borderPeer = borderIt->peerRank;
-            BorderDistance borderDistance = borderIt->borderDistance;
-            if (borderPeer != peerRank || borderDistance != 0)
+            if (borderIt->borderDistance != 0)
                 continue;
 
             Index localIdx = foreignOverlap_.nativeToLocal(borderIt->localIdx);
-            Index peerIdx = borderIt->peerIdx;
             assert(localIdx >= 0);
-            if (foreignOverlap_.iAmMasterOf(localIdx)) {
-                sendBorderIndex(borderPeer, localIdx, peerIdx);
+            if (!foreignOverlap_.iAmMasterOf(localIdx))
+                continue;
+
+            auto peerIt = std::lower_bound(peers.begin(), peers.end(), borderIt->peerRank);
+            assert(peerIt != peers.end() && *peerIt == borderIt->peerRank);
+
+            PeerIndexGlobalIndex tmp;
+            tmp.peerIdx = borderIt->peerIdx;
+            tmp.globalIdx = domesticToGlobal_[static_cast<unsigned>(localIdx)];
+            sendIndices[static_cast<size_t>(peerIt - peers.begin())].push_back(tmp);
+        }
+
+        // send the indices to all peers
+        std::vector<MpiBuffer<unsigned> > numIndicesSendBufs(numPeers);
+        std::vector<MpiBuffer<PeerIndexGlobalIndex> > indicesSendBufs(numPeers);
+        for (size_t peerIdx = 0; peerIdx < numPeers; ++peerIdx) {
+            const auto& peerIndices = sendIndices[peerIdx];
+
+            numIndicesSendBufs[peerIdx].resize(1);
+            numIndicesSendBufs[peerIdx][0] = static_cast<unsigned>(peerIndices.size());
+            numIndicesSendBufs[peerIdx].send(peers[peerIdx]);
+
+            indicesSendBufs[peerIdx].resize(peerIndices.size());
+            for (size_t i = 0; i < peerIndices.size(); ++i)
+                indicesSendBufs[peerIdx][i] = peerIndices[i];
+            indicesSendBufs[peerIdx].send(peers[peerIdx]);
+        }
+
+        // receive the global indices of the indices for which the peers are the
+        // masters
+        for (size_t peerIdx = 0; peerIdx < numPeers; ++peerIdx) {
+            MpiBuffer<unsigned> numIndicesRecvBuf(1);
+            numIndicesRecvBuf.receive(peers[peerIdx]);
+
+            MpiBuffer<PeerIndexGlobalIndex> indicesRecvBuf(numIndicesRecvBuf[0]);
+            indicesRecvBuf.receive(peers[peerIdx]);
+
+            for (size_t i = 0; i < indicesRecvBuf.size(); ++i) {
+                Index domesticIdx = foreignOverlap_.nativeToLocal(indicesRecvBuf[i].peerIdx);
+                if (domesticIdx < 0)
+                    continue;
+
+                Index globalIdx = indicesRecvBuf[i].globalIdx;
+                domesticToGlobal_[static_cast<unsigned>(domesticIdx)] = globalIdx;
+                globalToDomestic_.push_back(GlobalDomesticPair(globalIdx, domesticIdx));
             }
         }
+
+        // make sure that all data was sent
+        for (size_t peerIdx = 0; peerIdx < numPeers; ++peerIdx) {
+            numIndicesSendBufs[peerIdx].wait();
+            indicesSendBufs[peerIdx].wait();
+        }
 #endif // HAVE_MPI
     }
 
-    void receiveBorderFrom_(ProcessRank peerRank)
+    void setDomesticToGlobal_(Index domesticIdx, Index globalIdx)
     {
-#if HAVE_MPI
-        // retrieve the global indices for which we are not master
-        // from the processes with lower rank
-        BorderList::const_iterator borderIt = borderList_().begin();
-        BorderList::const_iterator borderEndIt = borderList_().end();
-        for (; borderIt != borderEndIt; ++borderIt) {
-            ProcessRank borderPeer = borderIt->peerRank;
-            BorderDistance borderDistance = borderIt->borderDistance;
-            if (borderPeer != peerRank || borderDistance != 0)
-                continue;
+        assert(domesticIdx >= 0);
+        if (static_cast<size_t>(domesticIdx) >= domesticToGlobal_.size())
+            domesticToGlobal_.resize(static_cast<size_t>(domesticIdx) + 1, -1);
+        domesticToGlobal_[static_cast<unsigned>(domesticIdx)] = globalIdx;
+    }
 
-            Index nativeIdx = borderIt->localIdx;
-            Index localIdx = foreignOverlap_.nativeToLocal(nativeIdx);
-            if (localIdx >= 0 && foreignOverlap_.masterRank(localIdx) == borderPeer)
-                receiveBorderIndex(borderPeer);
-        }
-#endif // HAVE_MPI
+    // returns true if a global index is contained in the first n entries of the
+    // sorted global to domestic map
+    bool hasGlobalIndex_(Index globalIdx, size_t n) const
+    {
+        auto endIt = globalToDomestic_.begin() + static_cast<std::ptrdiff_t>(n);
+        auto it = std::lower_bound(globalToDomestic_.begin(), endIt, globalIdx, globalLess_);
+        return it != endIt && it->first == globalIdx;
     }
 
+    static bool globalLess_(const GlobalDomesticPair& entry, Index globalIdx)
+    { return entry.first < globalIdx; }
+
     const PeerSet& peerSet_() const
     { return foreignOverlap_.peerSet(); }
 
@@ -333,7 +358,7 @@ protected:
     ProcessRank myRank_;
     size_t mpiSize_;
 
-    int domesticOffset_;
+    Index domesticOffset_;
     size_t numDomestic_;
     const ForeignOverlap& foreignOverlap_;
 
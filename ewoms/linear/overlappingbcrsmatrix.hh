@@ -31,6 +31,8 @@
 #include <ewoms/linear/globalindices.hh>
 #include <ewoms/linear/blacklist.hh>
 #include <ewoms/parallel/mpibuffer.hh>
+#include <ewoms/common/profiler.hh>
+#include <ewoms/common/memoryusage.hh>
 
 #include <opm/common/Valgrind.hpp>
 
@@ -41,6 +43,7 @@
 #include <set>
 #include <map>
 #include <iostream>
+#include <utility>
 #include <vector>
 #include <memory>
 
@@ -59,7 +62,9 @@ public:
     typedef Ewoms::Linear::DomesticOverlapFromBCRSMatrix Overlap;
 
 private:
-    typedef std::vector<std::set<Index> > Entries;
+    // the (row, column) pairs of the matrix entries. the array is sorted before the
+    // sparsity pattern is created
+    typedef std::vector<std::pair<Index, Index> > Entries;
 
 public:
     typedef typename ParentType::ColIterator ColIterator;
@@ -72,13 +77,20 @@ public:
         : ParentType(other)
     {}
 
+    /*!
+     * \brief Create the overlapping matrix from a non-overlapping one.
+     *
+     * \copydetails DomesticOverlapFromBCRSMatrix::DomesticOverlapFromBCRSMatrix
+     */
     template <class NativeBCRSMatrix>
     OverlappingBCRSMatrix(const NativeBCRSMatrix& nativeMatrix,
                           const BorderList& borderList,
                           const BlackList& blackList,
-                          unsigned overlapSize)
+                          unsigned overlapSize,
+                          const std::vector<Index>& nativeOrdering = std::vector<Index>())
     {
-        overlap_ = std::make_shared<Overlap>(nativeMatrix, borderList, blackList, overlapSize);
+        overlap_ = std::make_shared<Overlap>(nativeMatrix, borderList, blackList,
+                                             overlapSize, nativeOrdering);
         myRank_ = 0;
 #if HAVE_MPI
         MPI_Comm_rank(MPI_COMM_WORLD, &myRank_);
@@ -176,6 +188,18 @@ public:
         }
     }
 
+    /*!
+     * \brief Returns the number of bytes allocated by the matrix.
+     *
+     * This does not include the memory used by the overlap.
+     */
+    size_t memoryUsage() const
+    {
+        return
+            dynamicMemoryUsage(static_cast<const ParentType&>(*this))
+            + dynamicMemoryUsage(entries_);
+    }
+
     void print() const
     {
         overlap_->print();
@@ -258,6 +282,8 @@ public:
     // communicates and adds up the contents of overlapping rows
     void syncAdd()
     {
+        ProfileRegion profileRegion("halo exchange");
+
         // first, send all entries to the peers
         const PeerSet& peerSet = overlap_->peerSet();
         typename PeerSet::const_iterator peerIt = peerSet.begin();
@@ -289,6 +315,8 @@ public:
     // the master
     void syncCopy()
     {
+        ProfileRegion profileRegion("halo exchange");
+
         // first, send all entries to the peers
         const PeerSet& peerSet = overlap_->peerSet();
         typename PeerSet::const_iterator peerIt = peerSet.begin();
@@ -336,7 +364,8 @@ private:
         /////////
         // first, add all local matrix entries
         /////////
-        entries_.resize(overlap_->numDomestic());
+        entries_.clear();
+        entries_.reserve(nativeMatrix.nonzeroes());
         for (unsigned nativeRowIdx = 0; nativeRowIdx < nativeMatrix.N(); ++nativeRowIdx) {
             int domesticRowIdx = overlap_->nativeToDomestic(static_cast<Index>(nativeRowIdx));
             if (domesticRowIdx < 0)
@@ -357,7 +386,7 @@ private:
                 if (domesticColIdx < 0)
                     continue;
 
-                entries_[static_cast<unsigned>(domesticRowIdx)].insert(domesticColIdx);
+                entries_.push_back(std::make_pair(domesticRowIdx, domesticColIdx));
             }
         }
 
@@ -401,43 +430,37 @@ private:
         // actually initialize the BCRS matrix structure
         /////////
 
+        // sort the entries by row and column and remove the duplicates
+        std::sort(entries_.begin(), entries_.end());
+        entries_.erase(std::unique(entries_.begin(), entries_.end()), entries_.end());
+
         // set the row sizes
         size_t numDomestic = overlap_->numDomestic();
-        for (unsigned rowIdx = 0; rowIdx < numDomestic; ++rowIdx) {
-            unsigned numCols = 0;
-            const auto& colIndices = entries_[rowIdx];
-            auto colIdxIt = colIndices.begin();
-            const auto& colIdxEndIt = colIndices.end();
-            for (; colIdxIt != colIdxEndIt; ++colIdxIt) {
-                if (*colIdxIt < 0)
-                    // the matrix for the local process does not know about this DOF
-                    continue;
-
-                ++numCols;
-            }
+        std::vector<unsigned> rowSizes(numDomestic, 0);
+        for (const auto& entry : entries_) {
+            if (entry.second < 0)
+                // the matrix for the local process does not know about this DOF
+                continue;
 
-            this->setrowsize(rowIdx, numCols);
+            ++rowSizes[static_cast<unsigned>(entry.first)];
         }
+        for (unsigned rowIdx = 0; rowIdx < numDomestic; ++rowIdx)
+            this->setrowsize(rowIdx, rowSizes[rowIdx]);
         this->endrowsizes();
 
         // set the indices
-        for (unsigned rowIdx = 0; rowIdx < numDomestic; ++rowIdx) {
-            const auto& colIndices = entries_[rowIdx];
-
-            auto colIdxIt = colIndices.begin();
-            const auto& colIdxEndIt = colIndices.end();
-            for (; colIdxIt != colIdxEndIt; ++colIdxIt) {
-                if (*colIdxIt < 0)
-                    // the matrix for the local process does not know about this DOF
-                    continue;
+        for (const auto& entry : entries_) {
+            if (entry.second < 0)
+                // the matrix for the local process does not know about this DOF
+                continue;
 
-                this->addindex(rowIdx, static_cast<unsigned>(*colIdxIt));
-            }
+            this->addindex(static_cast<unsigned>(entry.first),
+                           static_cast<unsigned>(entry.second));
         }
         this->endindices();
 
         // free the memory occupied by the array of the matrix entries
-        entries_.clear();
+        Entries().swap(entries_);
     }
 
     // send the overlap indices to a peer
@@ -456,19 +479,16 @@ private:
         rowIndicesSendBuff_[peerRank] = new MpiBuffer<Index>(numOverlapRows);
         rowSizesSendBuff_[peerRank] = new MpiBuffer<unsigned>(numOverlapRows);
 
-        // compute the sets of the indices of the entries which need to be send to the peer
-        typedef std::set<int> ColumnIndexSet;
-        typedef std::map<int, ColumnIndexSet> EntryTuples;
-
-        EntryTuples entryIndices;
-        unsigned numEntries = 0; // <- total number of matrix entries to be send to the peer
+        // compute the global column indices of the entries which need to be send to
+        // the peer. the indices of each row are sorted and unique.
+        std::vector<Index> entryColIndices;
+        std::vector<Index> rowColIndices;
         for (unsigned overlapOffset = 0; overlapOffset < numOverlapRows; ++overlapOffset) {
             Index domesticRowIdx = overlap_->foreignOverlapOffsetToDomesticIdx(peerRank, overlapOffset);
             Index nativeRowIdx = overlap_->domesticToNative(domesticRowIdx);
             Index globalRowIdx = overlap_->domesticToGlobal(domesticRowIdx);
 
-            ColumnIndexSet& colIndices = entryIndices[globalRowIdx];
-
+            rowColIndices.clear();
             auto nativeColIt = nativeMatrix[static_cast<unsigned>(nativeRowIdx)].begin();
             const auto& nativeColEndIt = nativeMatrix[static_cast<unsigned>(nativeRowIdx)].end();
             for (; nativeColIt != nativeColEndIt; ++nativeColIt) {
@@ -486,32 +506,24 @@ private:
                     // entry.
                     continue;
 
-                Index globalColIdx = overlap_->domesticToGlobal(domesticColIdx);
-                colIndices.insert(globalColIdx);
-                ++numEntries;
+                rowColIndices.push_back(overlap_->domesticToGlobal(domesticColIdx));
             }
-        };
 
-        // fill the send buffers
-        entryColIndicesSendBuff_[peerRank] = new MpiBuffer<Index>(numEntries);
-        Index overlapEntryIdx = 0;
-        for (unsigned overlapOffset = 0; overlapOffset < numOverlapRows; ++overlapOffset) {
-            Index domesticRowIdx = overlap_->foreignOverlapOffsetToDomesticIdx(peerRank, overlapOffset);
-            Index globalRowIdx = overlap_->domesticToGlobal(domesticRowIdx);
+            std::sort(rowColIndices.begin(), rowColIndices.end());
+            rowColIndices.erase(std::unique(rowColIndices.begin(), rowColIndices.end()),
+                                rowColIndices.end());
 
             (*rowIndicesSendBuff_[peerRank])[overlapOffset] = globalRowIdx;
-
-            const ColumnIndexSet& colIndexSet = entryIndices[globalRowIdx];
-            auto* rssb = rowSizesSendBuff_[peerRank];
-            (*rssb)[overlapOffset] = static_cast<unsigned>(colIndexSet.size());
-            for (auto it = colIndexSet.begin(); it != colIndexSet.end(); ++it) {
-                int globalColIdx = *it;
-
-                (*entryColIndicesSendBuff_[peerRank])[static_cast<unsigned>(overlapEntryIdx)] = globalColIdx;
-                ++ overlapEntryIdx;
-            }
+            (*rowSizesSendBuff_[peerRank])[overlapOffset] = static_cast<unsigned>(rowColIndices.size());
+            entryColIndices.insert(entryColIndices.end(), rowColIndices.begin(), rowColIndices.end());
         }
 
+        // fill the send buffer for the column indices
+        size_t numEntries = entryColIndices.size(); // <- total number of matrix entries to be send to the peer
+        entryColIndicesSendBuff_[peerRank] = new MpiBuffer<Index>(numEntries);
+        for (size_t i = 0; i < numEntries; ++i)
+            (*entryColIndicesSendBuff_[peerRank])[i] = entryColIndices[i];
+
         // actually communicate with the peer
         rowSizesSendBuff_[peerRank]->send(peerRank);
         rowIndicesSendBuff_[peerRank]->send(peerRank);
@@ -565,7 +577,7 @@ private:
             Index domRowIdx = (*rowIndicesRecvBuff_[peerRank])[i];
             for (unsigned j = 0; j < (*rowSizesRecvBuff_[peerRank])[i]; ++j) {
                 Index domColIdx = (*entryColIndicesRecvBuff_[peerRank])[k];
-                entries_[static_cast<unsigned>(domRowIdx)].insert(domColIdx);
+                entries_.push_back(std::make_pair(domRowIdx, domColIdx));
                 ++k;
             }
         }
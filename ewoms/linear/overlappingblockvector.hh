@@ -30,6 +30,7 @@
 #include "overlaptypes.hh"
 
 #include <ewoms/parallel/mpibuffer.hh>
+#include <ewoms/common/profiler.hh>
 #include <opm/common/Valgrind.hpp>
 
 #include <dune/istl/bvector.hh>
@@ -173,6 +174,8 @@ public:
      */
     void sync()
     {
+        ProfileRegion profileRegion("halo exchange");
+
         typename PeerSet::const_iterator peerIt;
         typename PeerSet::const_iterator peerEndIt = overlap_->peerSet().end();
 
@@ -200,6 +203,8 @@ public:
      */
     void syncAdd()
     {
+        ProfileRegion profileRegion("halo exchange");
+
         typename PeerSet::const_iterator peerIt;
         typename PeerSet::const_iterator peerEndIt = overlap_->peerSet().end();
 
@@ -227,6 +232,8 @@ public:
      */
     void syncAddBorder()
     {
+        ProfileRegion profileRegion("halo exchange");
+
         typename PeerSet::const_iterator peerIt;
         typename PeerSet::const_iterator peerEndIt = overlap_->peerSet().end();
 
@@ -29,10 +29,14 @@
 #ifndef EWOMS_OVERLAP_TYPES_HH
 #define EWOMS_OVERLAP_TYPES_HH
 
+#include <ewoms/common/memoryusage.hh>
+
+#include <algorithm>
 #include <set>
 #include <list>
 #include <vector>
 #include <map>
+#include <utility>
 #include <cstddef>
 
 namespace Ewoms {
@@ -170,10 +174,74 @@ typedef std::vector<IndexDistanceNpeers> OverlapWithPeer;
  */
 typedef std::map<ProcessRank, OverlapWithPeer> OverlapByRank;
 
+/*!
+ * \brief Maps the ranks of the processes which see an index to the distance of the
+ *        index to their border.
+ *
+ * Since an index is usually only seen by a handful of processes, the entries are stored
+ * in a flat array which is sorted by the rank instead of a node based map. The
+ * interface is the subset of the one of std::map which is used by the overlap classes.
+ */
+class PeerDistanceMap
+{
+    typedef std::pair<ProcessRank, BorderDistance> Entry;
+    typedef std::vector<Entry> Storage;
+
+public:
+    typedef Storage::const_iterator const_iterator;
+
+    const_iterator begin() const
+    { return entries_.begin(); }
+
+    const_iterator end() const
+    { return entries_.end(); }
+
+    size_t size() const
+    { return entries_.size(); }
+
+    bool empty() const
+    { return entries_.empty(); }
+
+    const_iterator find(ProcessRank peerRank) const
+    {
+        auto it = std::lower_bound(entries_.begin(), entries_.end(), peerRank, rankLess_);
+        if (it != entries_.end() && it->first == peerRank)
+            return it;
+        return entries_.end();
+    }
+
+    size_t count(ProcessRank peerRank) const
+    { return (find(peerRank) != end()) ? 1 : 0; }
+
+    /*!
+     * \brief Returns the border distance for a peer rank. The entry is created with a
+     *        distance of zero if it does not exist yet.
+     */
+    BorderDistance& operator[](ProcessRank peerRank)
+    {
+        auto it = std::lower_bound(entries_.begin(), entries_.end(), peerRank, rankLess_);
+        if (it == entries_.end() || it->first != peerRank)
+            it = entries_.insert(it, Entry(peerRank, 0));
+        return it->second;
+    }
+
+    /*!
+     * \brief Returns the number of bytes allocated on the heap.
+     */
+    size_t memoryUsage() const
+    { return entries_.capacity()*sizeof(Entry); }
+
+private:
+    static bool rankLess_(const Entry& entry, ProcessRank peerRank)
+    { return entry.first < peerRank; }
+
+    Storage entries_;
+};
+
 /*!
  * \brief Maps each index to a list of processes .
  */
-typedef std::vector<std::map<ProcessRank, BorderDistance> > OverlapByIndex;
+typedef std::vector<PeerDistanceMap> OverlapByIndex;
 
 /*!
  * \brief The list of domestic indices are owned by peer rank.
@@ -187,6 +255,11 @@ typedef std::vector<Index> DomesticOverlapWithPeer;
 typedef std::map<ProcessRank, DomesticOverlapWithPeer> DomesticOverlapByRank;
 
 } // namespace Linear
+
+template <>
+inline std::size_t dynamicMemoryUsage<Linear::PeerDistanceMap>(const Linear::PeerDistanceMap& m)
+{ return m.memoryUsage(); }
+
 } // namespace Ewoms
 
 #endif
@@ -177,7 +177,7 @@ protected:
         const auto& gridView = this->simulator_.gridView();
         typedef CombinedCriterion<OverlappingVector, decltype(gridView.comm())> CCC;
 
-        Scalar linearSolverTolerance = EWOMS_GET_PARAM(TypeTag, Scalar, LinearSolverTolerance);
+        Scalar linearSolverTolerance = this->tolerance_;
         Scalar linearSolverAbsTolerance = this->simulator_.model().newtonMethod().tolerance() / 10.0;
 
         convCrit_.reset(new CCC(gridView.comm(),
@@ -200,7 +200,11 @@ protected:
     }
 
     bool runSolver_(std::shared_ptr<RawLinearSolver> solver)
-    { return solver->apply(*this->overlappingx_); }
+    {
+        bool converged = solver->apply(*this->overlappingx_);
+        this->numIterations_ = solver->report().iterations();
+        return converged;
+    }
 
     void cleanupSolver_()
     { /* nothing to do */ }
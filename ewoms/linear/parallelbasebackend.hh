@@ -34,8 +34,11 @@
 #include <ewoms/linear/overlappingoperator.hh>
 #include <ewoms/linear/parallelbasebackend.hh>
 #include <ewoms/linear/istlpreconditionerwrappers.hh>
+#include <ewoms/linear/dofordering.hh>
 
 #include <ewoms/common/genericguard.hh>
+#include <ewoms/common/profiler.hh>
+#include <ewoms/common/memoryusage.hh>
 #include <ewoms/common/propertysystem.hh>
 #include <ewoms/common/parametersystem.hh>
 
@@ -43,9 +46,14 @@
 
 #include <dune/common/fvector.hh>
 
+#include <opm/common/ErrorMacros.hpp>
+#include <opm/common/Exceptions.hpp>
+
 #include <sstream>
 #include <memory>
 #include <iostream>
+#include <string>
+#include <vector>
 
 namespace Ewoms {
 namespace Properties {
@@ -58,6 +66,7 @@ NEW_PROP_TAG(JacobianMatrix);
 NEW_PROP_TAG(GlobalEqVector);
 NEW_PROP_TAG(VertexMapper);
 NEW_PROP_TAG(GridView);
+NEW_PROP_TAG(Stencil);
 
 NEW_PROP_TAG(BorderListCreator);
 NEW_PROP_TAG(Overlap);
@@ -107,6 +116,15 @@ NEW_PROP_TAG(PreconditionerOrder);
 
 //! The relaxation factor of the preconditioner
 NEW_PROP_TAG(PreconditionerRelaxation);
+
+/*!
+ * \brief The ordering of the rows of the linear system used by the linear solver.
+ *
+ * Possible values are "natural" (the order of the degrees of freedom of the
+ * discretization), "rcm" (reverse Cuthill-McKee) and "hilbert" (the order of the
+ * centers of the degrees of freedom along a Hilbert curve).
+ */
+NEW_PROP_TAG(LinearSolverOrdering);
 }} // namespace Properties, Ewoms
 
 namespace Ewoms {
@@ -136,6 +154,13 @@ namespace Linear {
  *            that it is computationally cheaper because it does not
  *            need to consider things which are only required for
  *            higher orders
+ *
+ * The rows of the linear system can be reordered to improve the cache efficiency of
+ * the solver and the quality of incomplete factorizations via the LinearSolverOrdering
+ * parameter. The ordering is computed each time the structure of the linear system
+ * changes and it is only applied to the process-local copy of the system which is
+ * used by the solver, i.e., the indices of the degrees of freedom seen by the rest of
+ * the simulator are not affected.
  */
 template <class TypeTag>
 class ParallelBaseBackend
@@ -149,6 +174,7 @@ protected:
     typedef typename GET_PROP_TYPE(TypeTag, GlobalEqVector) Vector;
     typedef typename GET_PROP_TYPE(TypeTag, BorderListCreator) BorderListCreator;
     typedef typename GET_PROP_TYPE(TypeTag, GridView) GridView;
+    typedef typename GET_PROP_TYPE(TypeTag, Stencil) Stencil;
 
     typedef typename GET_PROP_TYPE(TypeTag, Overlap) Overlap;
     typedef typename GET_PROP_TYPE(TypeTag, OverlappingVector) OverlappingVector;
@@ -171,10 +197,13 @@ public:
     ParallelBaseBackend(const Simulator& simulator)
         : simulator_(simulator)
         , gridSequenceNumber_( -1 )
+        , numIterations_(0)
     {
         overlappingMatrix_ = nullptr;
         overlappingb_ = nullptr;
         overlappingx_ = nullptr;
+
+        tolerance_ = EWOMS_GET_PARAM(TypeTag, Scalar, LinearSolverTolerance);
     }
 
     ~ParallelBaseBackend()
@@ -193,6 +222,9 @@ public:
                              "The maximum number of iterations of the linear solver");
         EWOMS_REGISTER_PARAM(TypeTag, int, LinearSolverVerbosity,
                              "The verbosity level of the linear solver");
+        EWOMS_REGISTER_PARAM(TypeTag, std::string, LinearSolverOrdering,
+                             "The ordering of the rows of the linear system used by "
+                             "the linear solver. Possible values: natural, rcm, hilbert");
 
         PreconditionerWrapper::registerParameters();
     }
@@ -204,8 +236,61 @@ public:
     void eraseMatrix()
     { cleanup_(); }
 
+    /*!
+     * \brief Set the reduction of the residual which the linear solver ought to achieve.
+     *
+     * The value is used by all subsequent calls to solve(). Initially, it is set to the
+     * value of the LinearSolverTolerance parameter. This is used by the Newton method to
+     * adapt the accuracy of the linear solver to the progress of the non-linear
+     * iterations.
+     */
+    void setTolerance(Scalar value)
+    { tolerance_ = value; }
+
+    /*!
+     * \brief Returns the reduction of the residual which the linear solver ought to
+     *        achieve.
+     */
+    Scalar tolerance() const
+    { return tolerance_; }
+
+    /*!
+     * \brief Returns the number of iterations used by the last call to solve().
+     */
+    unsigned numIterations() const
+    { return numIterations_; }
+
+    /*!
+     * \brief Add the memory used by the linear solver to a report.
+     *
+     * The memory used by the preconditioner is not included because the ISTL
+     * preconditioners do not expose it.
+     */
+    void reportMemoryUsage(MemoryReport& report) const
+    {
+        typedef Dune::BlockVector<typename OverlappingVector::block_type> BlockVector;
+
+        size_t matrixBytes = 0;
+        size_t overlapBytes = 0;
+        size_t vectorBytes = 0;
+        if (overlappingMatrix_) {
+            matrixBytes = overlappingMatrix_->memoryUsage();
+            overlapBytes = overlappingMatrix_->overlap().memoryUsage();
+        }
+        if (overlappingb_)
+            vectorBytes += dynamicMemoryUsage(static_cast<const BlockVector&>(*overlappingb_));
+        if (overlappingx_)
+            vectorBytes += dynamicMemoryUsage(static_cast<const BlockVector&>(*overlappingx_));
+
+        report.add("overlapping matrix", matrixBytes);
+        report.add("overlap index maps", overlapBytes);
+        report.add("linear solver vectors", vectorBytes);
+    }
+
     void prepareMatrix(const Matrix& M)
     {
+        ProfileRegion profileRegion("matrix setup");
+
         // make sure that the overlapping matrix and block vectors
         // have been created
         prepare_(M);
@@ -247,8 +332,13 @@ public:
     bool solve(Vector& x)
     {
         (*overlappingx_) = 0.0;
+        numIterations_ = 0;
 
-        auto parPreCond = asImp_().preparePreconditioner_();
+        std::shared_ptr<ParallelPreconditioner> parPreCond;
+        {
+            ProfileRegion profileRegion("preconditioner setup");
+            parPreCond = asImp_().preparePreconditioner_();
+        }
 
         auto cleanupPrecondFn =
             [this]() -> void
@@ -271,7 +361,11 @@ public:
         GenericGuard<decltype(cleanupSolverFn)> solverGuard(cleanupSolverFn);
 
         // run the linear solver and have some fun
-        bool result = asImp_().runSolver_(solver);
+        bool result;
+        {
+            ProfileRegion profileRegion("krylov solver");
+            result = asImp_().runSolver_(solver);
+        }
 
         // copy the result back to the non-overlapping vector
         overlappingx_->assignTo(x);
@@ -302,12 +396,17 @@ protected:
         BorderListCreator borderListCreator(simulator_.gridView(),
                                             simulator_.model().dofMapper());
 
+        // determine the order of the rows used by the solver
+        std::vector<Index> nativeOrdering;
+        computeOrdering_(nativeOrdering, M);
+
         // create the overlapping Jacobian matrix
         unsigned overlapSize = EWOMS_GET_PARAM(TypeTag, unsigned, LinearSolverOverlapSize);
         overlappingMatrix_ = new OverlappingMatrix(M,
                                                    borderListCreator.borderList(),
                                                    borderListCreator.blackList(),
-                                                   overlapSize);
+                                                   overlapSize,
+                                                   nativeOrdering);
 
         // create the overlapping vectors for the residual and the
         // solution
@@ -317,6 +416,48 @@ protected:
         // writeOverlapToVTK_();
     }
 
+    // compute the ordering of the native rows of the linear system which is requested
+    // by the LinearSolverOrdering parameter. an empty ordering means the natural one.
+    void computeOrdering_(std::vector<Index>& ordering, const Matrix& M) const
+    {
+        ordering.clear();
+
+        const std::string& orderingName =
+            EWOMS_GET_PARAM(TypeTag, std::string, LinearSolverOrdering);
+        if (orderingName == "natural")
+            return;
+        else if (orderingName == "rcm")
+            reverseCuthillMcKeeOrdering(ordering, M);
+        else if (orderingName == "hilbert") {
+            const auto& model = simulator_.model();
+            size_t numGridDof = model.numGridDof();
+
+            // collect the centers of all degrees of freedom of the grid
+            typedef Dune::FieldVector<Scalar, dimWorld> GlobalPosition;
+            std::vector<GlobalPosition> dofPositions(numGridDof);
+            Stencil stencil(simulator_.gridView(), model.dofMapper());
+            auto elemIt = simulator_.gridView().template begin</*codim=*/0>();
+            const auto& elemEndIt = simulator_.gridView().template end</*codim=*/0>();
+            for (; elemIt != elemEndIt; ++elemIt) {
+                stencil.update(*elemIt);
+                for (unsigned dofIdx = 0; dofIdx < stencil.numPrimaryDof(); ++dofIdx) {
+                    unsigned globalIdx = stencil.globalSpaceIndex(dofIdx);
+                    dofPositions[globalIdx] = stencil.subControlVolume(dofIdx).globalPos();
+                }
+            }
+
+            hilbertCurveOrdering(ordering, dofPositions);
+
+            // the degrees of freedom of the auxiliary equations do not have a position,
+            // so they are ordered after the ones of the grid
+            for (size_t auxIdx = numGridDof; auxIdx < M.N(); ++auxIdx)
+                ordering.push_back(static_cast<Index>(auxIdx));
+        }
+        else
+            OPM_THROW(std::runtime_error,
+                      "Unknown ordering for the linear solver: '" << orderingName << "'");
+    }
+
     void rescale_()
     {
         const auto& overlap = overlappingMatrix_->overlap();
@@ -418,6 +559,8 @@ protected:
 
     const Simulator& simulator_;
     int gridSequenceNumber_;
+    Scalar tolerance_;
+    unsigned numIterations_;
 
     OverlappingMatrix *overlappingMatrix_;
     OverlappingVector *overlappingb_;
@@ -490,6 +633,9 @@ SET_INT_PROP(ParallelBaseLinearSolver, LinearSolverOverlapSize, 2);
 
 //! set the default number of maximum iterations for the linear solver
 SET_INT_PROP(ParallelBaseLinearSolver, LinearSolverMaxIterations, 1000);
+
+//! do not reorder the linear system by default
+SET_STRING_PROP(ParallelBaseLinearSolver, LinearSolverOrdering, "natural");
 } // namespace Properties
 } // namespace Ewoms
 
@@ -119,7 +119,8 @@ protected:
     {
         return solverWrapper_.get(parOperator,
                                   parScalarProduct,
-                                  parPreCond);
+                                  parPreCond,
+                                  this->tolerance_);
     }
 
     void cleanupSolver_()
@@ -131,6 +132,7 @@ protected:
     {
         Dune::InverseOperatorResult result;
         solver->apply(*this->overlappingx_, *this->overlappingb_, result);
+        this->numIterations_ = static_cast<unsigned>(result.iterations);
         return result.converged;
     }
 
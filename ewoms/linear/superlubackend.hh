@@ -30,6 +30,7 @@
 #if HAVE_SUPERLU
 
 #include <ewoms/common/parametersystem.hh>
+#include <ewoms/common/memoryusage.hh>
 
 #include <opm/common/Unused.hpp>
 
@@ -87,6 +88,14 @@ public:
     void eraseMatrix()
     { }
 
+    /*!
+     * \brief Set the reduction of the residual which the linear solver ought to achieve.
+     *
+     * SuperLU is a direct solver, so this is a no-op.
+     */
+    void setTolerance(Scalar value OPM_UNUSED)
+    { }
+
     void prepareMatrix(const Matrix& M)
     {
         M_ = &M;
@@ -100,6 +109,28 @@ public:
     bool solve(Vector& x)
     { return SuperLUSolve_<Scalar, TypeTag, Matrix, Vector>::solve_(*M_, x, *b_); }
 
+    /*!
+     * \brief Returns the number of iterations used by the last call to solve().
+     *
+     * SuperLU is a direct solver, so this is always zero.
+     */
+    unsigned numIterations() const
+    { return 0; }
+
+    /*!
+     * \brief Add the memory used by the linear solver to a report.
+     *
+     * The factorization is created and destroyed within solve(), so the backend itself
+     * does not keep any memory between linearizations. The entries are still added so
+     * that all backends report the same subsystems.
+     */
+    void reportMemoryUsage(MemoryReport& report) const
+    {
+        report.add("overlapping matrix", 0);
+        report.add("overlap index maps", 0);
+        report.add("linear solver vectors", 0);
+    }
+
 private:
     const Matrix* M_;
     Vector* b_;
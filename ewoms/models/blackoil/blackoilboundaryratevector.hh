@@ -107,6 +107,9 @@ public:
                 density = insideIntQuants.fluidState().density(phaseIdx);
 
             for (unsigned compIdx = 0; compIdx < numComponents; ++compIdx) {
+                if (!Indices::componentIsActive(compIdx))
+                    continue;
+
                 Scalar molarity;
                 if (fluidState.pressure(phaseIdx) > insideIntQuants.fluidState().pressure(phaseIdx))
                     molarity =
@@ -118,7 +121,8 @@ public:
 
                 // add advective flux of current component in current
                 // phase
-                (*this)[conti0EqIdx + compIdx] += extQuants.volumeFlux(phaseIdx) * molarity;
+                unsigned activeCompIdx = Indices::canonicalToActiveComponentIndex(compIdx);
+                (*this)[conti0EqIdx + activeCompIdx] += extQuants.volumeFlux(phaseIdx) * molarity;
             }
         }
 
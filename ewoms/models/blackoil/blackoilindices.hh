@@ -28,6 +28,8 @@
 #ifndef EWOMS_BLACK_OIL_INDICES_HH
 #define EWOMS_BLACK_OIL_INDICES_HH
 
+#include <opm/common/Unused.hpp>
+
 namespace Ewoms {
 
 /*!
@@ -38,6 +40,15 @@ namespace Ewoms {
 template <int PVOffset = 0>
 struct BlackOilIndices
 {
+    //! Is the water phase considered by the model?
+    static const bool waterEnabled = true;
+
+    //! Is the gas phase considered by the model?
+    static const bool gasEnabled = true;
+
+    //! The number of fluid phases considered by the model
+    static const int numPhases = 3;
+
     // Primary variable indices
 
     //! The index of the water saturation
@@ -66,6 +77,27 @@ struct BlackOilIndices
 
     //! The number of equations
     static const int numEq = 3;
+
+    /*!
+     * \brief Returns true iff the conservation equation of a component of the fluid
+     *        system is considered by the model.
+     */
+    static bool componentIsActive(unsigned compIdx OPM_UNUSED)
+    { return true; }
+
+    /*!
+     * \brief Returns the offset of the conservation equation of a component of the fluid
+     *        system relative to conti0EqIdx.
+     */
+    static unsigned canonicalToActiveComponentIndex(unsigned compIdx)
+    { return compIdx; }
+
+    /*!
+     * \brief Returns the index of the fluid system's component which is conserved by the
+     *        equation at a given offset relative to conti0EqIdx.
+     */
+    static unsigned activeToCanonicalComponentIndex(unsigned activeCompIdx)
+    { return activeCompIdx; }
 };
 
 } // namespace Ewoms
@@ -109,11 +109,16 @@ public:
         unsigned pvtRegionIdx = priVars.pvtRegionIndex();
         fluidState_.setPvtRegionIndex(pvtRegionIdx);
 
-        // extract the water and the gas saturations for convenience
-        Evaluation Sw = priVars.makeEvaluation(Indices::waterSaturationIdx, timeIdx);
+        // extract the water and the gas saturations for convenience. phases which are
+        // disabled at compile time are always absent
+        Evaluation Sw = 0.0;
+        if (Indices::waterEnabled)
+            Sw = priVars.makeEvaluation(Indices::waterSaturationIdx, timeIdx);
 
         Evaluation Sg;
-        if (priVars.primaryVarsMeaning() == PrimaryVariables::Sw_po_Sg)
+        if (Indices::compositionSwitchIdx < 0)
+            Sg = 0.0;
+        else if (priVars.primaryVarsMeaning() == PrimaryVariables::Sw_po_Sg)
             // -> threephase case
             Sg = priVars.makeEvaluation(Indices::compositionSwitchIdx, timeIdx);
         else if (priVars.primaryVarsMeaning() == PrimaryVariables::Sw_pg_Rv)
@@ -81,7 +81,7 @@ public:
         storage = 0.0;
 
         for (unsigned phaseIdx = 0; phaseIdx < numPhases; ++phaseIdx) {
-            if (!FluidSystem::phaseIsActive(phaseIdx))
+            if (!phaseIsConsidered_(phaseIdx))
                 continue;
 
             unsigned compIdx = FluidSystem::solventComponentIndex(phaseIdx);
@@ -90,18 +90,21 @@ public:
                 * Toolbox::template decay<LhsEval>(fs.invB(phaseIdx))
                 * Toolbox::template decay<LhsEval>(intQuants.porosity());
 
-            storage[conti0EqIdx + compIdx] += surfaceVolume;
+            storage[contiEqIdx_(compIdx)] += surfaceVolume;
 
             // account for dissolved gas
-            if (phaseIdx == oilPhaseIdx && FluidSystem::enableDissolvedGas()) {
-                storage[conti0EqIdx + gasCompIdx] +=
+            if (Indices::gasEnabled
+                && phaseIdx == oilPhaseIdx
+                && FluidSystem::enableDissolvedGas())
+            {
+                storage[contiEqIdx_(gasCompIdx)] +=
                     Toolbox::template decay<LhsEval>(intQuants.fluidState().Rs())
                     * surfaceVolume;
             }
 
             // account for vaporized oil
             if (phaseIdx == gasPhaseIdx && FluidSystem::enableVaporizedOil()) {
-                storage[conti0EqIdx + oilCompIdx] +=
+                storage[contiEqIdx_(oilCompIdx)] +=
                     Toolbox::template decay<LhsEval>(intQuants.fluidState().Rv())
                     * surfaceVolume;
             }
@@ -109,15 +112,18 @@ public:
 
         // convert surface volumes to component masses
         unsigned pvtRegionIdx = intQuants.pvtRegionIndex();
-        storage[conti0EqIdx + waterCompIdx] *=
-            FluidSystem::referenceDensity(waterPhaseIdx, pvtRegionIdx);
-        storage[conti0EqIdx + gasCompIdx] *=
-            FluidSystem::referenceDensity(gasPhaseIdx, pvtRegionIdx);
-        storage[conti0EqIdx + oilCompIdx] *=
+        if (Indices::waterEnabled)
+            storage[contiEqIdx_(waterCompIdx)] *=
+                FluidSystem::referenceDensity(waterPhaseIdx, pvtRegionIdx);
+        if (Indices::gasEnabled)
+            storage[contiEqIdx_(gasCompIdx)] *=
+                FluidSystem::referenceDensity(gasPhaseIdx, pvtRegionIdx);
+        storage[contiEqIdx_(oilCompIdx)] *=
             FluidSystem::referenceDensity(oilPhaseIdx, pvtRegionIdx);
 
-        // deal with the two-phase cases
-        if (FluidSystem::numActivePhases() != 3) {
+        // deal with the two-phase cases if the model considers all three phases. (if a
+        // phase is disabled at compile time, it does not exhibit an equation.)
+        if (Indices::numPhases == 3 && FluidSystem::numActivePhases() != 3) {
             assert(FluidSystem::numActivePhases() == 2);
             const auto& priVars = elemCtx.primaryVars(dofIdx, timeIdx);
             if (!FluidSystem::phaseIsActive(oilPhaseIdx)) {
@@ -151,13 +157,13 @@ public:
     {
         assert(timeIdx == 0);
 
-        for (unsigned compIdx = 0; compIdx < numComponents; ++ compIdx)
-            flux[conti0EqIdx + compIdx] = 0.0;
+        for (unsigned eqIdx = 0; eqIdx < numEq; ++ eqIdx)
+            flux[eqIdx] = 0.0;
 
         const ExtensiveQuantities& extQuants = elemCtx.extensiveQuantities(scvfIdx, timeIdx);
         unsigned interiorIdx = extQuants.interiorIndex();
         for (unsigned phaseIdx = 0; phaseIdx < numPhases; ++ phaseIdx) {
-            if (!FluidSystem::phaseIsActive(phaseIdx))
+            if (!phaseIsConsidered_(phaseIdx))
                 continue;
 
             unsigned upIdx = static_cast<unsigned>(extQuants.upstreamIndex(phaseIdx));
@@ -196,13 +202,16 @@ protected:
             Toolbox::template decay<UpEval>(fs.invB(phaseIdx))
             * extQuants.volumeFlux(phaseIdx);
 
-        flux[conti0EqIdx + compIdx] +=
+        flux[contiEqIdx_(compIdx)] +=
             surfaceVolumeFlux *
             FluidSystem::referenceDensity(phaseIdx, pvtRegionIdx);
 
         // dissolved gas (in the oil phase).
-        if (phaseIdx == oilPhaseIdx && FluidSystem::enableDissolvedGas()) {
-            flux[conti0EqIdx + gasCompIdx] +=
+        if (Indices::gasEnabled
+            && phaseIdx == oilPhaseIdx
+            && FluidSystem::enableDissolvedGas())
+        {
+            flux[contiEqIdx_(gasCompIdx)] +=
                 FluidSystem::referenceDensity(gasPhaseIdx, pvtRegionIdx)
                 * Toolbox::template decay<UpEval>(fs.Rs())
                 * surfaceVolumeFlux;
@@ -210,13 +219,29 @@ protected:
 
         // vaporized oil (in the gas phase).
         if (phaseIdx == gasPhaseIdx && FluidSystem::enableVaporizedOil()) {
-            flux[conti0EqIdx + oilCompIdx] +=
+            flux[contiEqIdx_(oilCompIdx)] +=
                 FluidSystem::referenceDensity(oilPhaseIdx, pvtRegionIdx)
                 * Toolbox::template decay<UpEval>(fs.Rv())
                 * surfaceVolumeFlux;
         }
     }
 
+    // returns true iff a fluid phase is active and not disabled at compile time
+    static bool phaseIsConsidered_(unsigned phaseIdx)
+    {
+        if (!FluidSystem::phaseIsActive(phaseIdx))
+            return false;
+        if (phaseIdx == waterPhaseIdx)
+            return Indices::waterEnabled;
+        if (phaseIdx == gasPhaseIdx)
+            return Indices::gasEnabled;
+        return true;
+    }
+
+    // returns the index of the conservation equation of a component
+    static unsigned contiEqIdx_(unsigned compIdx)
+    { return conti0EqIdx + Indices::canonicalToActiveComponentIndex(compIdx); }
+
 };
 
 } // namespace Ewoms
@@ -32,6 +32,7 @@
 
 #include "blackoilproblem.hh"
 #include "blackoilindices.hh"
+#include "blackoiltwophaseindices.hh"
 #include "blackoilextensivequantities.hh"
 #include "blackoilprimaryvariables.hh"
 #include "blackoilintensivequantities.hh"
@@ -173,6 +174,19 @@ public:
  * The primary variables used by this model are:
  * - The pressure of the phase with the lowest index
  * - The two saturations of the phases with the lowest indices
+ *
+ * If it is known at compile time that either the water or the gas phase is not
+ * present, the model can be instantiated with only two equations by setting the
+ * \c Indices property to Ewoms::BlackOilTwoPhaseIndices, e.g.
+ * \code
+ * SET_PROP(MyProblemTypeTag, Indices)
+ * {
+ *     typedef typename GET_PROP_TYPE(TypeTag, FluidSystem) FluidSystem;
+ *     typedef Ewoms::BlackOilTwoPhaseIndices<FluidSystem, FluidSystem::gasCompIdx> type;
+ * };
+ * \endcode
+ * for an oil-water model. The disabled phase must then also be inactive in the fluid
+ * system.
  */
 template<class TypeTag >
 class BlackOilModel
@@ -234,11 +248,12 @@ public:
     {
         std::ostringstream oss;
 
-        if (pvIdx == Indices::waterSaturationIdx)
+        int pvIdx2 = static_cast<int>(pvIdx);
+        if (pvIdx2 == Indices::waterSaturationIdx)
             oss << "saturation_" << FluidSystem::phaseName(FluidSystem::waterPhaseIdx);
-        else if (pvIdx == Indices::pressureSwitchIdx)
+        else if (pvIdx2 == Indices::pressureSwitchIdx)
             oss << "pressure_switching";
-        else if (pvIdx == Indices::compositionSwitchIdx)
+        else if (pvIdx2 == Indices::compositionSwitchIdx)
             oss << "composition_switching";
         else
             assert(false);
@@ -253,8 +268,10 @@ public:
     {
         std::ostringstream oss;
 
-        if (Indices::conti0EqIdx <= eqIdx && eqIdx < Indices::conti0EqIdx + numComponents)
-            oss << "conti_" << FluidSystem::phaseName(eqIdx - Indices::conti0EqIdx);
+        if (Indices::conti0EqIdx <= eqIdx && eqIdx < Indices::conti0EqIdx + numEq) {
+            unsigned compIdx = Indices::activeToCanonicalComponentIndex(eqIdx - Indices::conti0EqIdx);
+            oss << "conti_" << FluidSystem::phaseName(compIdx);
+        }
         else
             assert(false);
 
@@ -272,16 +289,16 @@ public:
             return 1.0;
 
         // saturations are always in the range [0, 1]!
-        if (Indices::waterSaturationIdx == pvIdx)
+        if (Indices::waterSaturationIdx == static_cast<int>(pvIdx))
             return 1.0;
 
         // oil pressures usually are in the range of 100 to 500 bars for typical oil
         // reservoirs (which is the only relevant application for the black-oil model).
-        else if (Indices::pressureSwitchIdx == pvIdx)
+        else if (Indices::pressureSwitchIdx == static_cast<int>(pvIdx))
             return 1.0/300e5;
 
         // if the primary variable is either the gas saturation, Rs or Rv
-        assert(Indices::compositionSwitchIdx == pvIdx);
+        assert(Indices::compositionSwitchIdx == static_cast<int>(pvIdx));
 
         auto pvMeaning = this->solution(0)[globalDofIdx].primaryVarsMeaning();
         if (pvMeaning == PrimaryVariables::Sw_po_Sg)
@@ -294,6 +311,23 @@ public:
         }
     }
 
+    /*!
+     * \copydoc FvBaseDiscretization::primaryVarControlsTimeStep
+     *
+     * Only the pressure and the saturations are considered. The switching variable
+     * is ignored for the degrees of freedom where it represents Rs or Rv at the old
+     * or at the new time level because its value jumps if its meaning is changed.
+     */
+    bool primaryVarControlsTimeStep(unsigned globalDofIdx, unsigned pvIdx) const
+    {
+        if (Indices::compositionSwitchIdx != static_cast<int>(pvIdx))
+            return true;
+
+        return
+            this->solution(/*timeIdx=*/0)[globalDofIdx].primaryVarsMeaning() == PrimaryVariables::Sw_po_Sg
+            && this->solution(/*timeIdx=*/1)[globalDofIdx].primaryVarsMeaning() == PrimaryVariables::Sw_po_Sg;
+    }
+
     /*!
      * \copydoc FvBaseDiscretization::eqWeight
      */
@@ -446,16 +480,22 @@ public:
             assert(maxOilSaturation_.size() == nGridDofs);
             for (unsigned dofIdx = 0; dofIdx < nGridDofs; ++dofIdx) {
                 const PrimaryVariables& priVars = this->solution(/*timeIdx=*/0)[dofIdx];
+                Scalar Sw = 0.0;
+                if (Indices::waterEnabled)
+                    Sw = priVars[Indices::waterSaturationIdx];
+
                 Scalar So = 0.0;
                 switch (priVars.primaryVarsMeaning()) {
                 case PrimaryVariables::Sw_po_Sg:
-                    So = 1.0 - priVars[Indices::waterSaturationIdx] - priVars[Indices::compositionSwitchIdx];
+                    So = 1.0 - Sw;
+                    if (Indices::compositionSwitchIdx >= 0)
+                        So -= priVars[Indices::compositionSwitchIdx];
                     break;
                 case PrimaryVariables::Sw_pg_Rv:
                     So = 0.0;
                     break;
                 case PrimaryVariables::Sw_po_Rs:
-                    So = 1.0 - priVars[Indices::waterSaturationIdx];
+                    So = 1.0 - Sw;
                     break;
                 }
 
@@ -119,6 +119,10 @@ protected:
     {
         const auto& comm = this->simulator_.gridView().comm();
 
+        // the update might be applied more than once per iteration if the line search
+        // is enabled. only the switches of the last one are relevant.
+        numPriVarsSwitched_ = 0;
+
         int succeeded;
         try {
             ParentType::update_(nextSolution,
@@ -158,12 +162,12 @@ protected:
             Scalar delta = update[eqIdx];
 
             // limit changes in water saturation to 20%
-            if (eqIdx == Indices::waterSaturationIdx
+            if (static_cast<int>(eqIdx) == Indices::waterSaturationIdx
                 && std::abs(delta) > 0.2)
             {
                 delta = Ewoms::signum(delta)*0.2;
             }
-            else if (eqIdx == Indices::compositionSwitchIdx) {
+            else if (static_cast<int>(eqIdx) == Indices::compositionSwitchIdx) {
                 // the switching primary variable for composition is tricky because the
                 // "reasonable" value ranges it exhibits vary widely depending on its
                 // interpretation (it can represent Sg, Rs or Rv).  so far, we only limit
@@ -232,7 +232,10 @@ public:
         bool oilPresent = (fluidState.saturation(oilPhaseIdx) > 0.0);
 
         // determine the meaning of the primary variables
-        if ((gasPresent && oilPresent) || (!gasPresent && !oilPresent))
+        if (compositionSwitchIdx < 0)
+            // the gas phase is disabled at compile time, so there is nothing to switch
+            primaryVarsMeaning_ = Sw_po_Sg;
+        else if ((gasPresent && oilPresent) || (!gasPresent && !oilPresent))
             // gas and oil: both hydrocarbon phases are in equilibrium (i.e., saturated
             // with the "protagonist" component of the other phase.)
             primaryVarsMeaning_ = Sw_po_Sg;
@@ -256,14 +259,17 @@ public:
 
         // assign the actual primary variables
         if (primaryVarsMeaning() == Sw_po_Sg) {
-            (*this)[waterSaturationIdx] = FsToolbox::value(fluidState.saturation(waterPhaseIdx));
+            if (Indices::waterEnabled)
+                (*this)[waterSaturationIdx] = FsToolbox::value(fluidState.saturation(waterPhaseIdx));
             (*this)[pressureSwitchIdx] = FsToolbox::value(fluidState.pressure(oilPhaseIdx));
-            (*this)[compositionSwitchIdx] = FsToolbox::value(fluidState.saturation(gasPhaseIdx));
+            if (compositionSwitchIdx >= 0)
+                (*this)[compositionSwitchIdx] = FsToolbox::value(fluidState.saturation(gasPhaseIdx));
         }
         else if (primaryVarsMeaning() == Sw_po_Rs) {
             const auto& Rs = Opm::BlackOil::getRs_<FluidSystem, Scalar, FluidState>(fluidState, pvtRegionIdx_);
 
-            (*this)[waterSaturationIdx] = FsToolbox::value(fluidState.saturation(waterPhaseIdx));
+            if (Indices::waterEnabled)
+                (*this)[waterSaturationIdx] = FsToolbox::value(fluidState.saturation(waterPhaseIdx));
             (*this)[pressureSwitchIdx] = FsToolbox::value(fluidState.pressure(oilPhaseIdx));
             (*this)[compositionSwitchIdx] = Rs;
         }
@@ -271,7 +277,8 @@ public:
             assert(primaryVarsMeaning() == Sw_pg_Rv);
 
             const auto& Rv = Opm::BlackOil::getRv_<FluidSystem, Scalar, FluidState>(fluidState, pvtRegionIdx_);
-            (*this)[waterSaturationIdx] = FsToolbox::value(fluidState.saturation(waterPhaseIdx));
+            if (Indices::waterEnabled)
+                (*this)[waterSaturationIdx] = FsToolbox::value(fluidState.saturation(waterPhaseIdx));
             (*this)[pressureSwitchIdx] = FsToolbox::value(fluidState.pressure(gasPhaseIdx));
             (*this)[compositionSwitchIdx] = Rv;
         }
@@ -296,7 +303,13 @@ public:
         // required to be able to decide if the primary variables needs to be switched or
         // not, so it would be a waste to compute them.
 
-        Scalar Sw = (*this)[Indices::waterSaturationIdx];
+        // without the gas phase, the meaning of the primary variables never changes
+        if (compositionSwitchIdx < 0)
+            return false;
+
+        Scalar Sw = 0.0;
+        if (Indices::waterEnabled)
+            Sw = (*this)[Indices::waterSaturationIdx];
         if (primaryVarsMeaning() == Sw_po_Sg) {
             // both hydrocarbon phases are present.
             Scalar Sg = (*this)[Indices::compositionSwitchIdx];
@@ -362,7 +375,8 @@ public:
                 // switch back to phase equilibrium mode if the oil phase vanishes (i.e.,
                 // the water-only case)
                 setPrimaryVarsMeaning(Sw_po_Sg);
-                (*this)[Indices::waterSaturationIdx] = 1.0; // water saturation
+                if (Indices::waterEnabled)
+                    (*this)[Indices::waterSaturationIdx] = 1.0; // water saturation
                 (*this)[Indices::pressureSwitchIdx] = po;
                 (*this)[Indices::compositionSwitchIdx] = 0.0; // gas saturation
 
@@ -405,7 +419,8 @@ public:
                 computeCapillaryPressures_(pC, /*So=*/0.0, /*Sg=*/0.0, Sw, matParams);
                 Scalar po = pg + (pC[oilPhaseIdx] - pC[gasPhaseIdx]);
 
-                (*this)[Indices::waterSaturationIdx] = 1.0;
+                if (Indices::waterEnabled)
+                    (*this)[Indices::waterSaturationIdx] = 1.0;
                 (*this)[Indices::pressureSwitchIdx] = po;
                 (*this)[Indices::compositionSwitchIdx] = 0.0; // gas saturation
 
@@ -99,8 +99,13 @@ public:
         ParentType::operator=(value);
 
         // then, convert them to mass rates
-        for (unsigned compIdx = 0; compIdx < numComponents; ++compIdx)
-            (*this)[conti0EqIdx + compIdx] *= FluidSystem::molarMass(compIdx);
+        for (unsigned compIdx = 0; compIdx < numComponents; ++compIdx) {
+            if (!Indices::componentIsActive(compIdx))
+                continue;
+
+            unsigned activeCompIdx = Indices::canonicalToActiveComponentIndex(compIdx);
+            (*this)[conti0EqIdx + activeCompIdx] *= FluidSystem::molarMass(compIdx);
+        }
     }
 
     /*!
@@ -111,11 +116,16 @@ public:
                            unsigned phaseIdx,
                            const RhsEval& volume)
     {
-        for (unsigned compIdx = 0; compIdx < numComponents; ++compIdx)
-            (*this)[conti0EqIdx + compIdx] =
+        for (unsigned compIdx = 0; compIdx < numComponents; ++compIdx) {
+            if (!Indices::componentIsActive(compIdx))
+                continue;
+
+            unsigned activeCompIdx = Indices::canonicalToActiveComponentIndex(compIdx);
+            (*this)[conti0EqIdx + activeCompIdx] =
                 fluidState.density(phaseIdx)
                 * fluidState.massFraction(phaseIdx, compIdx)
                 * volume;
+        }
     }
 
     /*!
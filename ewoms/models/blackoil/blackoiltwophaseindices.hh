@@ -0,0 +1,123 @@
+// -*- mode: C++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*-
+// vi: set et ts=4 sw=4 sts=4:
+/*
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+
+  Consult the COPYING file in the top-level source directory of this
+  module for the precise wording of the license and the list of
+  copyright holders.
+*/
+/*!
+ * \file
+ *
+ * \copydoc Ewoms::BlackOilTwoPhaseIndices
+ */
+#ifndef EWOMS_BLACK_OIL_TWO_PHASE_INDICES_HH
+#define EWOMS_BLACK_OIL_TWO_PHASE_INDICES_HH
+
+#include <cassert>
+
+namespace Ewoms {
+
+/*!
+ * \ingroup BlackOilModel
+ *
+ * \brief The primary variable and equation indices for the black-oil model if one of
+ *        the water and gas phases is disabled at compile time.
+ *
+ * Using these indices instead of Ewoms::BlackOilIndices reduces the number of
+ * equations and primary variables of the black-oil model to two. This means that the
+ * blocks of the Jacobian matrix are 2x2 and that the evaluations used for automatic
+ * differentiation only need to carry two derivatives. The primary variables are the
+ * ones of the three-phase model without the one of the disabled phase, the equations
+ * are the conservation equations of the remaining components in the order of the
+ * fluid system. The oil phase must always be enabled.
+ *
+ * The indices of the primary variables which do not exist are negative.
+ *
+ * \tparam FluidSystem The black-oil fluid system used by the model
+ * \tparam disabledCompIdx The index of the fluid system's component which is not
+ *                         considered. This must be either the water or the gas
+ *                         component.
+ * \tparam PVOffset The first index in a primary variable vector.
+ */
+template <class FluidSystem, unsigned disabledCompIdx, int PVOffset = 0>
+struct BlackOilTwoPhaseIndices
+{
+    static_assert(disabledCompIdx == FluidSystem::waterCompIdx
+                  || disabledCompIdx == FluidSystem::gasCompIdx,
+                  "Only the water or the gas component can be disabled");
+
+    //! Is the water phase considered by the model?
+    static const bool waterEnabled = (disabledCompIdx != FluidSystem::waterCompIdx);
+
+    //! Is the gas phase considered by the model?
+    static const bool gasEnabled = (disabledCompIdx != FluidSystem::gasCompIdx);
+
+    //! The number of fluid phases considered by the model
+    static const int numPhases = 2;
+
+    // Primary variable indices
+
+    //! The index of the water saturation
+    static const int waterSaturationIdx = waterEnabled ? PVOffset + 0 : -1000;
+
+    /*!
+     * \brief Index of the oil pressure in a vector of primary variables
+     */
+    static const int pressureSwitchIdx = waterEnabled ? PVOffset + 1 : PVOffset + 0;
+
+    /*!
+     * \brief Index of the switching variable which determines the composition of the
+     *        hydrocarbon phases.
+     *
+     * This only exists if the gas phase is enabled.
+     */
+    static const int compositionSwitchIdx = gasEnabled ? PVOffset + 1 : -1000;
+
+    // indices of the equations
+
+    //! Index of the continuity equation of the first active component
+    static const int conti0EqIdx = PVOffset + 0;
+
+    //! The number of equations
+    static const int numEq = 2;
+
+    /*!
+     * \copydoc BlackOilIndices::componentIsActive
+     */
+    static bool componentIsActive(unsigned compIdx)
+    { return compIdx != disabledCompIdx; }
+
+    /*!
+     * \copydoc BlackOilIndices::canonicalToActiveComponentIndex
+     */
+    static unsigned canonicalToActiveComponentIndex(unsigned compIdx)
+    {
+        assert(componentIsActive(compIdx));
+        return (compIdx > disabledCompIdx) ? compIdx - 1 : compIdx;
+    }
+
+    /*!
+     * \copydoc BlackOilIndices::activeToCanonicalComponentIndex
+     */
+    static unsigned activeToCanonicalComponentIndex(unsigned activeCompIdx)
+    { return (activeCompIdx >= disabledCompIdx) ? activeCompIdx + 1 : activeCompIdx; }
+};
+
+} // namespace Ewoms
+
+#endif
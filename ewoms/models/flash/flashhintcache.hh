@@ -0,0 +1,239 @@
+// -*- mode: C++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*-
+// vi: set et ts=4 sw=4 sts=4:
+/*
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+
+  Consult the COPYING file in the top-level source directory of this
+  module for the precise wording of the license and the list of
+  copyright holders.
+*/
+/*!
+ * \file
+ *
+ * \copydoc Ewoms::FlashHintCache
+ */
+#ifndef EWOMS_FLASH_HINT_CACHE_HH
+#define EWOMS_FLASH_HINT_CACHE_HH
+
+#include "flashproperties.hh"
+
+#include <ewoms/parallel/locks.hh>
+
+#include <opm/material/common/MathToolbox.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <vector>
+
+namespace Ewoms {
+
+/*!
+ * \ingroup FlashModel
+ *
+ * \brief Stores the result of the last converged flash calculation of each degree of
+ *        freedom.
+ *
+ * In contrast to the thermodynamic hints provided by the discretization, this only
+ * keeps the phase pressures, saturations and compositions and the total molarities
+ * for which they were obtained. It thus does not require the cache for the intensive
+ * quantities and its memory footprint is much smaller. The data is used as the initial
+ * guess of the flash solver and to decide whether the phase split of a degree of
+ * freedom can be skipped.
+ *
+ * The intensive quantities of a degree of freedom may be updated by several threads at
+ * the same time, e.g., for the vertices which are shared by elements of different
+ * threads if the vertex-centered finite volume method is used. Each entry is thus
+ * protected by its own lock: get() copies an entry and store() overwrites it while
+ * holding the entry's lock.
+ */
+template <class TypeTag>
+class FlashHintCache
+{
+    typedef typename GET_PROP_TYPE(TypeTag, Scalar) Scalar;
+
+    enum { numPhases = GET_PROP_VALUE(TypeTag, NumPhases) };
+    enum { numComponents = GET_PROP_VALUE(TypeTag, NumComponents) };
+
+public:
+    /*!
+     * \brief The cached data of a single degree of freedom.
+     */
+    struct Entry
+    {
+        Entry()
+            : valid(false)
+        {}
+
+        Scalar totalMolarity[numComponents];
+        Scalar pressure[numPhases];
+        Scalar saturation[numPhases];
+        Scalar moleFraction[numPhases][numComponents];
+        bool valid;
+    };
+
+    /*!
+     * \brief Returns the number of degrees of freedom for which the cache has room.
+     */
+    size_t size() const
+    { return entries_.size(); }
+
+    /*!
+     * \brief Discards all entries and allocates room for a given number of degrees of
+     *        freedom.
+     */
+    void resize(size_t numDof)
+    {
+        entries_.clear();
+        entries_.resize(numDof);
+        locks_.resize(numDof);
+    }
+
+    /*!
+     * \brief Discards all entries.
+     */
+    void invalidate()
+    { std::fill(entries_.begin(), entries_.end(), Entry()); }
+
+    /*!
+     * \brief Copies the cached data of a degree of freedom.
+     *
+     * This method may be called concurrently with store() for the same degree of
+     * freedom.
+     *
+     * \param result The object which receives the cached data
+     * \param globalDofIdx The global space index of the degree of freedom
+     * \return true iff there is cached data for the degree of freedom
+     */
+    bool get(Entry& result, unsigned globalDofIdx) const
+    {
+        if (globalDofIdx >= entries_.size())
+            return false;
+
+        ScopedLock lock(locks_[globalDofIdx]);
+        result = entries_[globalDofIdx];
+        return result.valid;
+    }
+
+    /*!
+     * \brief Remembers the result of a converged flash calculation.
+     *
+     * This method may be called concurrently for the same degree of freedom.
+     *
+     * \param globalDofIdx The global space index of the degree of freedom
+     * \param fluidState The fluid state computed by the flash solver
+     * \param cTotal The total molarities of the components which were used for the flash
+     */
+    template <class FluidState, class ComponentVector>
+    void store(unsigned globalDofIdx,
+               const FluidState& fluidState,
+               const ComponentVector& cTotal)
+    {
+        if (globalDofIdx >= entries_.size())
+            return;
+
+        typedef typename FluidState::Scalar FsEval;
+        typedef Opm::MathToolbox<FsEval> FsToolbox;
+        typedef typename ComponentVector::value_type CEval;
+        typedef Opm::MathToolbox<CEval> CToolbox;
+
+        Entry e;
+        for (unsigned compIdx = 0; compIdx < numComponents; ++compIdx)
+            e.totalMolarity[compIdx] = CToolbox::value(cTotal[compIdx]);
+        for (unsigned phaseIdx = 0; phaseIdx < numPhases; ++phaseIdx) {
+            e.pressure[phaseIdx] = FsToolbox::value(fluidState.pressure(phaseIdx));
+            e.saturation[phaseIdx] = FsToolbox::value(fluidState.saturation(phaseIdx));
+            for (unsigned compIdx = 0; compIdx < numComponents; ++compIdx)
+                e.moleFraction[phaseIdx][compIdx] =
+                    FsToolbox::value(fluidState.moleFraction(phaseIdx, compIdx));
+        }
+        e.valid = true;
+
+        ScopedLock lock(locks_[globalDofIdx]);
+        entries_[globalDofIdx] = e;
+    }
+
+    /*!
+     * \brief Sets the pressures, saturations and compositions of a fluid state to the
+     *        ones of a cache entry.
+     *
+     * All other quantities of the fluid state (e.g., the temperature) are not touched.
+     */
+    template <class FluidState>
+    static void assign(FluidState& fluidState, const Entry& e)
+    {
+        for (unsigned phaseIdx = 0; phaseIdx < numPhases; ++phaseIdx) {
+            fluidState.setPressure(phaseIdx, e.pressure[phaseIdx]);
+            fluidState.setSaturation(phaseIdx, e.saturation[phaseIdx]);
+            for (unsigned compIdx = 0; compIdx < numComponents; ++compIdx)
+                fluidState.setMoleFraction(phaseIdx, compIdx, e.moleFraction[phaseIdx][compIdx]);
+        }
+    }
+
+    /*!
+     * \brief Returns the index of the only fluid phase which is present in a cache entry
+     *        or -1 if more than one phase is present.
+     */
+    static int singlePhaseIdx(const Entry& e)
+    {
+        // saturations of phases which are absent are zero up to the tolerance of the
+        // flash solver
+        const Scalar absentSaturation = 1e-10;
+
+        int result = -1;
+        for (unsigned phaseIdx = 0; phaseIdx < numPhases; ++phaseIdx) {
+            if (e.saturation[phaseIdx] <= absentSaturation)
+                continue;
+            if (result >= 0)
+                return -1;
+            result = static_cast<int>(phaseIdx);
+        }
+
+        return result;
+    }
+
+    /*!
+     * \brief Returns the largest change of the total molarity of any component relative
+     *        to the overall molarity of a cache entry.
+     */
+    template <class ComponentVector>
+    static Scalar relativeChange(const Entry& e, const ComponentVector& cTotal)
+    {
+        typedef typename ComponentVector::value_type CEval;
+        typedef Opm::MathToolbox<CEval> CToolbox;
+
+        Scalar sumCTotal = 0.0;
+        Scalar maxDelta = 0.0;
+        for (unsigned compIdx = 0; compIdx < numComponents; ++compIdx) {
+            sumCTotal += std::abs(e.totalMolarity[compIdx]);
+            maxDelta = std::max(maxDelta,
+                                std::abs(CToolbox::value(cTotal[compIdx])
+                                         - e.totalMolarity[compIdx]));
+        }
+
+        if (sumCTotal <= 0.0)
+            return std::numeric_limits<Scalar>::max();
+        return maxDelta/sumCTotal;
+    }
+
+private:
+    std::vector<Entry> entries_;
+    mutable std::vector<OmpMutex> locks_;
+};
+
+} // namespace Ewoms
+
+#endif
@@ -30,11 +30,13 @@
 
 #include "flashproperties.hh"
 #include "flashindices.hh"
+#include "flashhintcache.hh"
 
 #include <ewoms/models/common/energymodule.hh>
 #include <ewoms/models/common/diffusionmodule.hh>
 
 #include <opm/material/fluidstates/CompositionalFluidState.hpp>
+#include <opm/material/common/MathToolbox.hpp>
 #include <opm/common/Valgrind.hpp>
 
 #include <dune/common/fvector.hh>
@@ -77,8 +79,14 @@ class FlashIntensiveQuantities
     typedef typename GET_PROP_TYPE(TypeTag, Evaluation) Evaluation;
     typedef typename GET_PROP_TYPE(TypeTag, FluidSystem) FluidSystem;
     typedef typename GET_PROP_TYPE(TypeTag, FlashSolver) FlashSolver;
+    typedef Opm::MathToolbox<Evaluation> Toolbox;
+
+    typedef Ewoms::FlashHintCache<TypeTag> FlashHintCache;
+    typedef typename FlashHintCache::Entry FlashHint;
+    typedef typename FluidSystem::template ParameterCache<Evaluation> ParameterCache;
 
     typedef Dune::FieldVector<Evaluation, numComponents> ComponentVector;
+    typedef Dune::FieldVector<Evaluation, numPhases> PhaseVector;
     typedef Dune::FieldMatrix<Scalar, dimWorld, dimWorld> DimMatrix;
 
     typedef typename FluxModule::FluxIntensiveQuantities FluxIntensiveQuantities;
@@ -116,27 +124,76 @@ public:
         for (unsigned compIdx = 0; compIdx < numComponents; ++compIdx)
             cTotal[compIdx] = priVars.makeEvaluation(cTot0Idx + compIdx, timeIdx);
 
-        const auto *hint = elemCtx.thermodynamicHint(dofIdx, timeIdx);
-        if (hint) {
-            // use the same fluid state as the one of the hint, but
-            // make sure that we don't overwrite the temperature
-            // specified by the primary variables
-            Evaluation T = fluidState_.temperature(/*phaseIdx=*/0);
-            fluidState_.assign(hint->fluidState());
-            fluidState_.setTemperature(T);
-        }
-        else
-            FlashSolver::guessInitial(fluidState_, cTotal);
+        const auto& model = elemCtx.model();
+        unsigned globalDofIdx = elemCtx.globalSpaceIndex(dofIdx, timeIdx);
+        FlashHint flashHint;
+        bool haveFlashHint =
+            model.enableFlashHints()
+            && model.flashHintCache().get(flashHint, globalDofIdx);
 
-        // compute the phase compositions, densities and pressures
-        typename FluidSystem::template ParameterCache<Evaluation> paramCache;
+        ParameterCache paramCache;
         const MaterialLawParams& materialParams =
             problem.materialLawParams(elemCtx, dofIdx, timeIdx);
-        FlashSolver::template solve<MaterialLaw>(fluidState_,
-                                                 materialParams,
-                                                 paramCache,
-                                                 cTotal,
-                                                 flashTolerance);
+
+        bool phaseSplitSkipped = false;
+        if (haveFlashHint) {
+            // start at the result of the last flash calculation of the degree of
+            // freedom. the temperature is not touched by this.
+            FlashHintCache::assign(fluidState_, flashHint);
+
+            // if only a single phase was present and the total molarities did not
+            // change much since then, try to avoid the phase split altogether
+            Scalar skipTolerance = EWOMS_GET_PARAM(TypeTag, Scalar, FlashSkipTolerance);
+            int refPhaseIdx = FlashHintCache::singlePhaseIdx(flashHint);
+            if (refPhaseIdx >= 0
+                && FlashHintCache::relativeChange(flashHint, cTotal) < skipTolerance)
+            {
+                phaseSplitSkipped =
+                    updateSinglePhase_(paramCache,
+                                       materialParams,
+                                       cTotal,
+                                       static_cast<unsigned>(refPhaseIdx));
+            }
+        }
+        else {
+            const auto *hint = elemCtx.thermodynamicHint(dofIdx, timeIdx);
+            if (hint) {
+                // use the same fluid state as the one of the hint, but
+                // make sure that we don't overwrite the temperature
+                // specified by the primary variables
+                Evaluation T = fluidState_.temperature(/*phaseIdx=*/0);
+                fluidState_.assign(hint->fluidState());
+                fluidState_.setTemperature(T);
+            }
+            else
+                FlashSolver::guessInitial(fluidState_, cTotal);
+        }
+
+        if (!phaseSplitSkipped) {
+            // compute the phase compositions, densities and pressures
+            FlashSolver::template solve<MaterialLaw>(fluidState_,
+                                                     materialParams,
+                                                     paramCache,
+                                                     cTotal,
+                                                     flashTolerance);
+
+            // only the results of "real" flash calculations for the current solution
+            // are remembered. this makes sure that the reference state of the single
+            // phase shortcut does not drift away. the states which are perturbed by
+            // the finite difference linearizer are thus skipped; it stashes the
+            // intensive quantities of the degree of freedom before it perturbs
+            // them. also, only the primary degrees of freedom of the element are
+            // considered: for the element-centered finite volume method, this means
+            // that each entry is only written by the thread which linearizes the
+            // element.
+            if (timeIdx == 0
+                && model.enableFlashHints()
+                && !elemCtx.haveStashedIntensiveQuantities()
+                && dofIdx < elemCtx.numPrimaryDof(timeIdx))
+            {
+                model.mutableFlashHintCache().store(globalDofIdx, fluidState_, cTotal);
+            }
+        }
 
         // calculate relative permeabilities
         MaterialLaw::relativePermeabilities(relativePermeability_,
@@ -208,6 +265,125 @@ public:
     { return porosity_; }
 
 private:
+    /*!
+     * \brief Computes the fluid state of a degree of freedom under the assumption that
+     *        all of the fluid is in a single phase.
+     *
+     * The composition of this phase is given by the total molarities and its pressure
+     * is determined by the condition that its molar density must be equal to the sum
+     * of the total molarities. The compositions of the absent phases follow from the
+     * equality of the fugacities. If the sum of the mole fractions of any absent phase
+     * is larger than one, that phase is about to appear and the full flash calculation
+     * is required.
+     *
+     * \return true iff the fluid state could be computed this way. If false is
+     *         returned, the fluid state of the intensive quantities is left unchanged.
+     */
+    bool updateSinglePhase_(ParameterCache& paramCache,
+                            const MaterialLawParams& materialParams,
+                            const ComponentVector& cTotal,
+                            unsigned refPhaseIdx)
+    {
+        const int maxIter = 20;
+        const Scalar pressureTolerance = 1e-10;
+
+        FluidState fs(fluidState_);
+
+        Evaluation sumCTotal = 0.0;
+        for (unsigned compIdx = 0; compIdx < numComponents; ++compIdx)
+            sumCTotal += cTotal[compIdx];
+        if (Toolbox::value(sumCTotal) <= 0.0)
+            return false;
+
+        for (unsigned phaseIdx = 0; phaseIdx < numPhases; ++phaseIdx)
+            fs.setSaturation(phaseIdx, (phaseIdx == refPhaseIdx)?1.0:0.0);
+        for (unsigned compIdx = 0; compIdx < numComponents; ++compIdx)
+            fs.setMoleFraction(refPhaseIdx, compIdx, cTotal[compIdx]/sumCTotal);
+
+        // the pressure of the phase is found using Newton's method. the derivative of
+        // the molar density w.r.t. the pressure is approximated by finite differences.
+        Evaluation p = fs.pressure(refPhaseIdx);
+        for (int iterIdx = 0;; ++iterIdx) {
+            if (iterIdx >= maxIter)
+                return false;
+
+            fs.setPressure(refPhaseIdx, p);
+            paramCache.updatePhase(fs, refPhaseIdx);
+            fs.setDensity(refPhaseIdx, FluidSystem::density(fs, paramCache, refPhaseIdx));
+            Evaluation delta = fs.molarDensity(refPhaseIdx) - sumCTotal;
+
+            Scalar dp = 1e-7*(1.0 + std::abs(Toolbox::value(p)));
+            FluidState fsPerturbed(fs);
+            fsPerturbed.setPressure(refPhaseIdx, Toolbox::value(p) + dp);
+            paramCache.updatePhase(fsPerturbed, refPhaseIdx);
+            fsPerturbed.setDensity(refPhaseIdx,
+                                   FluidSystem::density(fsPerturbed, paramCache, refPhaseIdx));
+            Scalar dRhoMolar_dp =
+                (Toolbox::value(fsPerturbed.molarDensity(refPhaseIdx))
+                 - Toolbox::value(fs.molarDensity(refPhaseIdx)))/dp;
+
+            // incompressible phases do not determine their pressure
+            if (std::abs(dRhoMolar_dp*Toolbox::value(p)) < 1e-8*Toolbox::value(sumCTotal))
+                return false;
+
+            Evaluation deltaP = delta/dRhoMolar_dp;
+            p -= deltaP;
+            if (std::abs(Toolbox::value(deltaP)) < pressureTolerance*std::abs(Toolbox::value(p))) {
+                fs.setPressure(refPhaseIdx, p);
+                break;
+            }
+        }
+
+        PhaseVector pC;
+        MaterialLaw::capillaryPressures(pC, materialParams, fs);
+        for (unsigned phaseIdx = 0; phaseIdx < numPhases; ++phaseIdx)
+            if (phaseIdx != refPhaseIdx)
+                fs.setPressure(phaseIdx, p + (pC[phaseIdx] - pC[refPhaseIdx]));
+
+        // compute the fugacities of the present phase and use them to determine the
+        // compositions of the absent ones. for the fugacity coefficients of the absent
+        // phases, the composition of the last flash calculation is used.
+        paramCache.updateAll(fs);
+        for (unsigned phaseIdx = 0; phaseIdx < numPhases; ++phaseIdx)
+            for (unsigned compIdx = 0; compIdx < numComponents; ++compIdx)
+                fs.setFugacityCoefficient(phaseIdx, compIdx,
+                                          FluidSystem::fugacityCoefficient(fs, paramCache,
+                                                                           phaseIdx, compIdx));
+
+        for (unsigned phaseIdx = 0; phaseIdx < numPhases; ++phaseIdx) {
+            if (phaseIdx == refPhaseIdx)
+                continue;
+
+            Evaluation sumX = 0.0;
+            for (unsigned compIdx = 0; compIdx < numComponents; ++compIdx) {
+                const Evaluation& f = fs.fugacity(refPhaseIdx, compIdx);
+                Evaluation x =
+                    f/(fs.fugacityCoefficient(phaseIdx, compIdx)*fs.pressure(phaseIdx));
+                fs.setMoleFraction(phaseIdx, compIdx, x);
+                sumX += x;
+            }
+
+            if (Toolbox::value(sumX) >= 1.0)
+                return false;
+        }
+
+        // update the quantities which depend on the compositions of the absent phases
+        paramCache.updateAll(fs);
+        for (unsigned phaseIdx = 0; phaseIdx < numPhases; ++phaseIdx) {
+            fs.setDensity(phaseIdx, FluidSystem::density(fs, paramCache, phaseIdx));
+            if (phaseIdx == refPhaseIdx)
+                continue;
+
+            for (unsigned compIdx = 0; compIdx < numComponents; ++compIdx)
+                fs.setFugacityCoefficient(phaseIdx, compIdx,
+                                          FluidSystem::fugacityCoefficient(fs, paramCache,
+                                                                           phaseIdx, compIdx));
+        }
+
+        fluidState_.assign(fs);
+        return true;
+    }
+
     DimMatrix intrinsicPerm_;
     FluidState fluidState_;
     Evaluation porosity_;
@@ -38,6 +38,7 @@
 #include "flashintensivequantities.hh"
 #include "flashextensivequantities.hh"
 #include "flashindices.hh"
+#include "flashhintcache.hh"
 
 #include <ewoms/models/common/multiphasebasemodel.hh>
 #include <ewoms/models/common/energymodule.hh>
@@ -76,6 +77,12 @@ SET_TYPE_PROP(FlashModel, FlashSolver,
 //! Let the flash solver choose its tolerance by default
 SET_SCALAR_PROP(FlashModel, FlashTolerance, -1.0);
 
+//! Start the flash calculations at the result of the previous ones by default
+SET_BOOL_PROP(FlashModel, EnableFlashHints, true);
+
+//! Always compute the phase split by default
+SET_SCALAR_PROP(FlashModel, FlashSkipTolerance, 0.0);
+
 //! the Model property
 SET_TYPE_PROP(FlashModel, Model, Ewoms::FlashModel<TypeTag>);
 
@@ -101,10 +108,10 @@ SET_TYPE_PROP(FlashModel, Indices, Ewoms::FlashIndices<TypeTag, /*PVIdx=*/0>);
 // model, so let's try to minimize the number of required ones
 SET_BOOL_PROP(FlashModel, EnableIntensiveQuantityCache, true);
 
-// since thermodynamic hints are basically free if the cache for intensive quantities is
-// enabled, and this model usually shows quite a performance improvment if they are
-// enabled, let's enable them by default.
-SET_BOOL_PROP(FlashModel, EnableThermodynamicHints, true);
+// the flash hints provide the same initial guess for the flash solver as the generic
+// thermodynamic hints of the discretization, but they do not require to keep the full
+// intensive quantities around.
+SET_BOOL_PROP(FlashModel, EnableThermodynamicHints, false);
 
 // disable molecular diffusion by default
 SET_BOOL_PROP(FlashModel, EnableDiffusion, false);
@@ -214,8 +221,73 @@ public:
         EWOMS_REGISTER_PARAM(TypeTag, Scalar, FlashTolerance,
                              "The maximum tolerance for the flash solver to "
                              "consider the solution converged");
+        EWOMS_REGISTER_PARAM(TypeTag, bool, EnableFlashHints,
+                             "Use the result of the last flash calculation of each "
+                             "degree of freedom as the initial guess of the flash solver");
+        EWOMS_REGISTER_PARAM(TypeTag, Scalar, FlashSkipTolerance,
+                             "The relative change of the total molarities of a single "
+                             "phase degree of freedom since its last flash calculation "
+                             "below which the phase split is not recomputed. Only "
+                             "effective if flash hints are enabled. (0 means never)");
+    }
+
+    /*!
+     * \copydoc FvBaseDiscretization::finishInit
+     */
+    void finishInit()
+    {
+        flashHintCache_.resize(this->numGridDof());
+
+        ParentType::finishInit();
+    }
+
+    /*!
+     * \copydoc FvBaseDiscretization::updateBegin
+     */
+    void updateBegin()
+    {
+        ParentType::updateBegin();
+
+        // the grid may have been adapted since the last time step
+        if (flashHintCache_.size() != this->numGridDof())
+            flashHintCache_.resize(this->numGridDof());
+    }
+
+    /*!
+     * \copydoc FvBaseDiscretization::updateFailed
+     */
+    void updateFailed()
+    {
+        ParentType::updateFailed();
+
+        // the cached flash results belong to the solution which did not converge
+        flashHintCache_.invalidate();
     }
 
+    /*!
+     * \brief Returns true iff the results of the last flash calculation of each degree of
+     *        freedom should be used as the initial guess for the flash solver.
+     */
+    bool enableFlashHints() const
+    { return EWOMS_GET_PARAM(TypeTag, bool, EnableFlashHints); }
+
+    /*!
+     * \brief Returns the results of the last flash calculation of each degree of freedom.
+     */
+    const FlashHintCache<TypeTag>& flashHintCache() const
+    { return flashHintCache_; }
+
+    /*!
+     * \brief Returns the results of the last flash calculation of each degree of freedom
+     *        for writing.
+     *
+     * This is called while the intensive quantities are updated, i.e., in a context
+     * where the model is const and multiple threads are active. The cache protects each
+     * of its entries by a lock, so this is safe.
+     */
+    FlashHintCache<TypeTag>& mutableFlashHintCache() const
+    { return flashHintCache_; }
+
     /*!
      * \copydoc FvBaseDiscretization::name
      */
@@ -308,6 +380,9 @@ public:
         if (enableEnergy)
             this->addOutputModule(new Ewoms::VtkEnergyModule<TypeTag>(this->simulator_));
     }
+
+private:
+    mutable FlashHintCache<TypeTag> flashHintCache_;
 };
 
 } // namespace Ewoms
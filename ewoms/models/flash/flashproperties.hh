@@ -43,6 +43,11 @@ NEW_PROP_TAG(FluidSystem);
 NEW_PROP_TAG(FlashSolver);
 //! The maximum accepted error of the flash solver
 NEW_PROP_TAG(FlashTolerance);
+//! Use the results of the last flash calculation of each degree of freedom as hint?
+NEW_PROP_TAG(EnableFlashHints);
+//! The relative change of the total molarities below which the phase split of single
+//! phase degrees of freedom is not recomputed
+NEW_PROP_TAG(FlashSkipTolerance);
 
 //! The heat conduction law which ought to be used
 NEW_PROP_TAG(HeatConductionLaw);
@@ -416,6 +416,13 @@ public:
     bool switched() const
     { return numSwitched_ > 0; }
 
+    /*!
+     * \brief Return the number of degrees of freedom of all processes for which the
+     *        primary variables were switched after the last Newton iteration.
+     */
+    unsigned numSwitched() const
+    { return numSwitched_; }
+
     /*!
      * \copydoc FvBaseDiscretization::serializeEntity
      */
@@ -49,6 +49,12 @@ public:
     PvsNewtonMethod(Simulator& simulator) : ParentType(simulator)
     {}
 
+    /*!
+     * \copydoc NewtonMethod::numPriVarsSwitched
+     */
+    unsigned numPriVarsSwitched() const
+    { return this->model().numSwitched(); }
+
 protected:
     friend NewtonMethod<TypeTag>;
     friend ParentType;
@@ -43,6 +43,8 @@
 #include "stokesboundaryratevector.hh"
 
 #include <ewoms/linear/superlubackend.hh>
+#include <ewoms/linear/parallelbicgstabbackend.hh>
+#include <ewoms/linear/blocktriangularschurpreconditioner.hh>
 
 #include <opm/material/fluidsystems/GasPhase.hpp>
 #include <opm/material/fluidsystems/LiquidPhase.hpp>
@@ -104,12 +106,12 @@ SET_TYPE_PROP(StokesModel,
 //! Increase the raw tolerance of the newton method to 10^-7
 SET_SCALAR_PROP(StokesModel, NewtonRawTolerance, 1e-7);
 
-#if HAVE_SUPERLU
-SET_TAG_PROP(StokesModel, LinearSolverSplice, SuperLULinearSolver);
-#else
-#warning "No SuperLU installed. SuperLU is the recommended linear " \
-         "solver for the Stokes models."
-#endif
+//! Use BiCGStab preconditioned by a block-triangular Schur complement preconditioner
+//! by default. This also works for large 3D and for parallel problems. SuperLU can
+//! still be chosen using the LinearSolverSplice property.
+SET_TAG_PROP(StokesModel, LinearSolverSplice, ParallelBiCGStabLinearSolver);
+SET_TYPE_PROP(StokesModel, PreconditionerWrapper,
+              Ewoms::Linear::PreconditionerWrapperBlockTriangularSchur<TypeTag>);
 
 //! the Stokes model requires center gradients, and those are only available when using
 //! P1-finite-element gradients.
@@ -33,6 +33,8 @@
 #include <ewoms/common/parametersystem.hh>
 #include <ewoms/common/timer.hh>
 #include <ewoms/common/timerguard.hh>
+#include <ewoms/io/telemetrywriter.hh>
+#include <ewoms/common/memoryusage.hh>
 
 #include <dune/common/classname.hh>
 #include <opm/common/Unused.hpp>
@@ -142,6 +144,30 @@ NEW_PROP_TAG(NewtonTargetIterations);
 //! Number of maximum iterations for the Newton method.
 NEW_PROP_TAG(NewtonMaxIterations);
 
+/*!
+ * \brief Specifies whether the tolerance of the linear solver should be adapted to the
+ *        progress of the Newton method.
+ *
+ * If this is enabled, the reduction of the residual which is demanded from the linear
+ * solver is determined in each iteration using the forcing terms proposed by Eisenstat
+ * and Walker. Otherwise, the LinearSolverTolerance parameter is used for all iterations.
+ */
+NEW_PROP_TAG(NewtonAdaptiveLinearTolerance);
+
+//! The loosest tolerance of the linear solver if it is adapted to the Newton method
+NEW_PROP_TAG(NewtonMaxLinearTolerance);
+
+//! The tightest tolerance of the linear solver if it is adapted to the Newton method
+NEW_PROP_TAG(NewtonMinLinearTolerance);
+
+/*!
+ * \brief The maximum number of times the update of a Newton iteration is halved by the
+ *        line search.
+ *
+ * If this is 0, the line search is disabled and the full update is always applied.
+ */
+NEW_PROP_TAG(NewtonMaxLineSearchSteps);
+
 // set default values for the properties
 SET_TYPE_PROP(NewtonMethod, NewtonMethod, Ewoms::NewtonMethod<TypeTag>);
 SET_TYPE_PROP(NewtonMethod, NewtonConvergenceWriter, Ewoms::NullConvergenceWriter<TypeTag>);
@@ -153,6 +179,10 @@ SET_SCALAR_PROP(NewtonMethod, NewtonRawTolerance, 1e-8);
 SET_SCALAR_PROP(NewtonMethod, NewtonMaxError, 1e100);
 SET_INT_PROP(NewtonMethod, NewtonTargetIterations, 10);
 SET_INT_PROP(NewtonMethod, NewtonMaxIterations, 18);
+SET_BOOL_PROP(NewtonMethod, NewtonAdaptiveLinearTolerance, false);
+SET_SCALAR_PROP(NewtonMethod, NewtonMaxLinearTolerance, 0.1);
+SET_SCALAR_PROP(NewtonMethod, NewtonMinLinearTolerance, 1e-5);
+SET_INT_PROP(NewtonMethod, NewtonMaxLineSearchSteps, 0);
 } // namespace Properties
 } // namespace Ewoms
 
@@ -197,8 +227,19 @@ public:
         lastError_ = 1e100;
         error_ = 1e100;
         tolerance_ = EWOMS_GET_PARAM(TypeTag, Scalar, NewtonRawTolerance);
+        linearTolerance_ = EWOMS_GET_PARAM(TypeTag, Scalar, NewtonMaxLinearTolerance);
 
         numIterations_ = 0;
+        numLinearIterations_ = 0;
+
+        prePostProcessTimer_.setProfileRegion("newton prepostprocess");
+        linearizeTimer_.setProfileRegion("linearize");
+        solveTimer_.setProfileRegion("linear solve");
+        updateTimer_.setProfileRegion("newton update");
+
+        linearizeTimer_.setPerfCounterPhase("linearize");
+        solveTimer_.setPerfCounterPhase("solve");
+        updateTimer_.setPerfCounterPhase("update");
     }
 
     /*!
@@ -227,6 +268,19 @@ public:
         EWOMS_REGISTER_PARAM(TypeTag, Scalar, NewtonMaxError,
                              "The maximum error tolerated by the Newton "
                              "method to which does not cause an abort");
+        EWOMS_REGISTER_PARAM(TypeTag, bool, NewtonAdaptiveLinearTolerance,
+                             "Adapt the tolerance of the linear solver to the "
+                             "progress of the Newton method");
+        EWOMS_REGISTER_PARAM(TypeTag, Scalar, NewtonMaxLinearTolerance,
+                             "The loosest tolerance of the linear solver if it "
+                             "is adapted to the Newton method");
+        EWOMS_REGISTER_PARAM(TypeTag, Scalar, NewtonMinLinearTolerance,
+                             "The tightest tolerance of the linear solver if it "
+                             "is adapted to the Newton method");
+        EWOMS_REGISTER_PARAM(TypeTag, int, NewtonMaxLineSearchSteps,
+                             "The maximum number of times the update of a Newton "
+                             "iteration is halved by the line search (0 disables "
+                             "the line search)");
     }
 
     /*!
@@ -267,6 +321,28 @@ public:
     int numIterations() const
     { return numIterations_; }
 
+    /*!
+     * \brief Returns the total number of iterations of the linear solver used since the
+     *        Newton method was invoked.
+     */
+    unsigned numLinearIterations() const
+    { return numLinearIterations_; }
+
+    /*!
+     * \brief Add the memory used by the linear solver to a report.
+     */
+    void reportMemoryUsage(MemoryReport& report) const
+    { linearSolver_.reportMemoryUsage(report); }
+
+    /*!
+     * \brief Returns the number of degrees of freedom for which the interpretation of
+     *        the primary variables has changed for the most recent iteration.
+     *
+     * Models which switch their primary variables need to overload this method.
+     */
+    unsigned numPriVarsSwitched() const
+    { return 0; }
+
     /*!
      * \brief Set the index of current iteration.
      *
@@ -313,6 +389,7 @@ public:
         linearizeTimer_.halt();
         solveTimer_.halt();
         updateTimer_.halt();
+        numLinearIterations_ = 0;
 
         SolutionVector& nextSolution = model().solution(/*historyIdx=*/0);
         SolutionVector currentSolution(nextSolution);
@@ -336,6 +413,8 @@ public:
             // execute the method as long as the implementation thinks
             // that we should do another iteration
             while (asImp_().proceed_()) {
+                beginIterationTelemetry_();
+
                 // linearize the problem at the current solution
 
                 // notify the implementation that we're about to start
@@ -378,6 +457,7 @@ public:
                     asImp_().endIteration_(nextSolution, currentSolution);
                     prePostProcessTimer_.stop();
 
+                    writeIterationTelemetry_(numIterations_, /*linearSolverConverged=*/true);
                     break;
                 }
 
@@ -390,8 +470,13 @@ public:
 
                 solveTimer_.start();
                 solutionUpdate = 0;
+                if (EWOMS_GET_PARAM(TypeTag, bool, NewtonAdaptiveLinearTolerance)) {
+                    asImp_().updateLinearTolerance_();
+                    linearSolver_.setTolerance(linearTolerance_);
+                }
                 linearSolver_.prepareMatrix(M);
                 bool converged = linearSolver_.solve(solutionUpdate);
+                numLinearIterations_ += linearSolver_.numIterations();
                 solveTimer_.stop();
 
                 if (!converged) {
@@ -399,6 +484,8 @@ public:
                     if (asImp_().verbose_())
                         std::cout << "Newton: Linear solver did not converge\n" << std::flush;
 
+                    writeIterationTelemetry_(numIterations_ + 1, /*linearSolverConverged=*/false);
+
                     prePostProcessTimer_.start();
                     asImp_().failed_();
                     prePostProcessTimer_.stop();
@@ -421,6 +508,8 @@ public:
                                     b,
                                     solutionUpdate);
                 asImp_().update_(nextSolution, currentSolution, solutionUpdate, b);
+                if (EWOMS_GET_PARAM(TypeTag, int, NewtonMaxLineSearchSteps) > 0)
+                    asImp_().lineSearch_(nextSolution, currentSolution, solutionUpdate, b);
                 updateTimer_.stop();
 
                 if (asImp_().verbose_() && isatty(fileno(stdout)))
@@ -432,6 +521,8 @@ public:
                 prePostProcessTimer_.start();
                 asImp_().endIteration_(nextSolution, currentSolution);
                 prePostProcessTimer_.stop();
+
+                writeIterationTelemetry_(numIterations_, /*linearSolverConverged=*/true);
             }
         }
         catch (const Dune::Exception& e)
@@ -583,6 +674,7 @@ protected:
     void begin_(const SolutionVector& u  OPM_UNUSED)
     {
         numIterations_ = 0;
+        linearTolerance_ = EWOMS_GET_PARAM(TypeTag, Scalar, NewtonMaxLinearTolerance);
 
         if (EWOMS_GET_PARAM(TypeTag, bool, NewtonWriteConvergence))
             convergenceWriter_.beginTimeStep();
@@ -606,13 +698,32 @@ protected:
     void preSolve_(const SolutionVector& currentSolution  OPM_UNUSED,
                    const GlobalEqVector& currentResidual)
     {
-        const auto& constraintsMap = model().linearizer().constraintsMap();
         lastError_ = error_;
+        error_ = asImp_().residualError_(currentResidual);
+
+        // make sure that the error never grows beyond the maximum
+        // allowed one
+        if (error_ > EWOMS_GET_PARAM(TypeTag, Scalar, NewtonMaxError))
+            OPM_THROW(Opm::NumericalProblem,
+                      "Newton: Error " << error_
+                      << " is larger than maximum allowed error of "
+                      << EWOMS_GET_PARAM(TypeTag, Scalar, NewtonMaxError));
+    }
+
+    /*!
+     * \brief Calculate the error of a residual vector.
+     *
+     * The error is defined as the maximum of the weighted residual over all processes.
+     * Auxiliary and constraint degrees of freedom are not considered.
+     *
+     * \param residual The residual vector for which the error ought to be calculated
+     */
+    Scalar residualError_(const GlobalEqVector& residual) const
+    {
+        const auto& constraintsMap = model().linearizer().constraintsMap();
 
-        // calculate the error as the maximum weighted tolerance of
-        // the solution's residual
-        error_ = 0;
-        for (unsigned dofIdx = 0; dofIdx < currentResidual.size(); ++dofIdx) {
+        Scalar result = 0.0;
+        for (unsigned dofIdx = 0; dofIdx < residual.size(); ++dofIdx) {
             // do not consider auxiliary DOFs for the error
             if (dofIdx >= model().numGridDof() || model().dofTotalVolume(dofIdx) <= 0.0)
                 continue;
@@ -623,21 +734,101 @@ protected:
                     continue;
             }
 
-            const auto& r = currentResidual[dofIdx];
+            const auto& r = residual[dofIdx];
             for (unsigned eqIdx = 0; eqIdx < r.size(); ++eqIdx)
-                error_ = std::max(std::abs(r[eqIdx] * model().eqWeight(dofIdx, eqIdx)), error_);
+                result = std::max(std::abs(r[eqIdx] * model().eqWeight(dofIdx, eqIdx)), result);
         }
 
         // take the other processes into account
-        error_ = comm_.max(error_);
+        return comm_.max(result);
+    }
 
-        // make sure that the error never grows beyond the maximum
-        // allowed one
-        if (error_ > EWOMS_GET_PARAM(TypeTag, Scalar, NewtonMaxError))
-            OPM_THROW(Opm::NumericalProblem,
-                      "Newton: Error " << error_
-                      << " is larger than maximum allowed error of "
-                      << EWOMS_GET_PARAM(TypeTag, Scalar, NewtonMaxError));
+    /*!
+     * \brief Evaluate the residual of the non-linear system of equations for the
+     *        current solution.
+     *
+     * \param residual Stores the result
+     */
+    void evalResidual_(GlobalEqVector& residual)
+    { model().globalResidual(residual); }
+
+    /*!
+     * \brief Globalize the Newton method using a backtracking line search.
+     *
+     * This is called after update_() and checks if the error of the residual of the
+     * updated solution has been sufficiently reduced compared to the one of the
+     * current solution. If this is not the case, the update is halved and update_() is
+     * called again. Model specific chopping of the update is thus applied to each
+     * trial step. After NewtonMaxLineSearchSteps bisections, the last trial step is
+     * accepted and the convergence check is left to the remaining iterations.
+     *
+     * \param nextSolution The solution vector after the current iteration
+     * \param currentSolution The solution vector after the last iteration
+     * \param solutionUpdate The delta vector as calculated by solving the linear system
+     *                       of equations. It is scaled by the accepted step length.
+     * \param currentResidual The residual vector of the current Newton-Raphson iteraton
+     */
+    void lineSearch_(SolutionVector& nextSolution,
+                     const SolutionVector& currentSolution,
+                     GlobalEqVector& solutionUpdate,
+                     const GlobalEqVector& currentResidual)
+    {
+        // the sufficient decrease parameter of the Armijo condition
+        const Scalar alpha = 1e-4;
+        int maxSteps = EWOMS_GET_PARAM(TypeTag, int, NewtonMaxLineSearchSteps);
+
+        GlobalEqVector trialResidual(currentResidual.size());
+        Scalar lambda = 1.0;
+        for (int stepIdx = 0; ; ++stepIdx) {
+            asImp_().evalResidual_(trialResidual);
+            Scalar trialError = asImp_().residualError_(trialResidual);
+            if (trialError <= (1.0 - alpha*lambda)*error_ || stepIdx >= maxSteps)
+                break;
+
+            lambda /= 2;
+            solutionUpdate *= 0.5;
+            asImp_().update_(nextSolution, currentSolution, solutionUpdate, currentResidual);
+        }
+
+        if (lambda < 1.0)
+            endIterMsg() << ", line search: " << lambda;
+    }
+
+    /*!
+     * \brief Determine the tolerance of the linear solver for the current iteration.
+     *
+     * This uses the second choice of the forcing terms of Eisenstat and Walker (SIAM
+     * J. Sci. Comput. 17, 1996), i.e., the tolerance is set to 0.9*(error/lastError)^2
+     * for all but the first iteration. To avoid oversolving, the tolerance is neither
+     * allowed to drop much faster than in the previous iteration nor to be smaller than
+     * what is required to reach the tolerance of the Newton method. The result is
+     * always kept within the bounds given by the NewtonMinLinearTolerance and
+     * NewtonMaxLinearTolerance parameters.
+     */
+    void updateLinearTolerance_()
+    {
+        const Scalar gamma = 0.9;
+        Scalar maxTol = EWOMS_GET_PARAM(TypeTag, Scalar, NewtonMaxLinearTolerance);
+        Scalar minTol = EWOMS_GET_PARAM(TypeTag, Scalar, NewtonMinLinearTolerance);
+
+        Scalar eta = maxTol;
+        if (numIterations_ > 0 && lastError_ > 0.0) {
+            Scalar reduction = error_/lastError_;
+            eta = gamma*reduction*reduction;
+
+            // if the previous tolerance was loose, the observed reduction of the error
+            // is not a good indicator for the quality of the linearization
+            Scalar safeguard = gamma*linearTolerance_*linearTolerance_;
+            if (safeguard > 0.1)
+                eta = std::max(eta, safeguard);
+        }
+
+        // solving more accurately than required to reach convergence of the Newton
+        // method is a waste of time
+        if (error_ > 0.0)
+            eta = std::max(eta, 0.5*tolerance()/error_);
+
+        linearTolerance_ = std::min(maxTol, std::max(minTol, eta));
     }
 
     /*!
@@ -850,9 +1041,16 @@ protected:
     Scalar lastError_;
     Scalar tolerance_;
 
+    // the tolerance of the linear solver used for the current iteration if it is
+    // adapted to the progress of the Newton method
+    Scalar linearTolerance_;
+
     // actual number of iterations done so far
     int numIterations_;
 
+    // the number of iterations of the linear solver done so far
+    unsigned numLinearIterations_;
+
     // the linear solver
     LinearSolverBackend linearSolver_;
 
@@ -865,6 +1063,56 @@ protected:
     ConvergenceWriter convergenceWriter_;
 
 private:
+    // remember the state of the timers and of the linear iteration counter at the
+    // beginning of an iteration
+    void beginIterationTelemetry_()
+    {
+        if (!simulator_.telemetry().isEnabled())
+            return;
+
+        iterationStartTimes_[0] = prePostProcessTimer_.realTimeElapsed();
+        iterationStartTimes_[1] = linearizeTimer_.realTimeElapsed();
+        iterationStartTimes_[2] = solveTimer_.realTimeElapsed();
+        iterationStartTimes_[3] = updateTimer_.realTimeElapsed();
+        iterationStartLinearIterations_ = numLinearIterations_;
+    }
+
+    // append the record for the current iteration to the telemetry stream. this is
+    // collective because the timings of all processes are reduced
+    void writeIterationTelemetry_(int iterationIdx, bool linearSolverConverged)
+    {
+        auto& telemetry = simulator_.telemetry();
+        if (!telemetry.isEnabled())
+            return;
+
+        double times[4] = {
+            prePostProcessTimer_.realTimeElapsed() - iterationStartTimes_[0],
+            linearizeTimer_.realTimeElapsed() - iterationStartTimes_[1],
+            solveTimer_.realTimeElapsed() - iterationStartTimes_[2],
+            updateTimer_.realTimeElapsed() - iterationStartTimes_[3]
+        };
+        comm_.max(times, 4);
+
+        TelemetryRecord record("newton_iteration");
+        record.add("time_step", simulator_.timeStepIndex())
+            .add("time", static_cast<double>(simulator_.time()))
+            .add("dt", static_cast<double>(simulator_.timeStepSize()))
+            .add("iteration", iterationIdx)
+            .add("error", static_cast<double>(error_))
+            .add("linear_iterations", numLinearIterations_ - iterationStartLinearIterations_)
+            .add("linear_solver_converged", linearSolverConverged)
+            .add("converged", linearSolverConverged && asImp_().converged())
+            .add("num_pri_vars_switched", static_cast<unsigned>(asImp_().numPriVarsSwitched()))
+            .add("pre_post_process_time", times[0])
+            .add("linearize_time", times[1])
+            .add("solve_time", times[2])
+            .add("update_time", times[3]);
+        telemetry.write(record);
+    }
+
+    double iterationStartTimes_[4];
+    unsigned iterationStartLinearIterations_;
+
     Implementation& asImp_()
     { return *static_cast<Implementation *>(this); }
     const Implementation& asImp_() const
@@ -0,0 +1,115 @@
+// -*- mode: C++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*-
+// vi: set et ts=4 sw=4 sts=4:
+/*
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+
+  Consult the COPYING file in the top-level source directory of this
+  module for the precise wording of the license and the list of
+  copyright holders.
+*/
+/*!
+ * \file
+ *
+ * \copydoc Ewoms::FirstTouchAllocator
+ */
+#ifndef EWOMS_FIRST_TOUCH_ALLOCATOR_HH
+#define EWOMS_FIRST_TOUCH_ALLOCATOR_HH
+
+#include <ewoms/common/alignedallocator.hh>
+
+#include <unistd.h>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+namespace Ewoms {
+/*!
+ * \brief An aligned allocator which lets the OpenMP threads touch the pages of the
+ *        allocated memory.
+ *
+ * On NUMA systems, the operating system usually places a memory page on the node of the
+ * thread which writes to it first. Containers usually initialize their elements using
+ * the thread which allocates them, so all of their pages would end up on a single node.
+ * This allocator writes to each page of a newly allocated block before the container
+ * gets hold of it. The pages are split into contiguous blocks of equal size, one for
+ * each thread, which roughly matches the static partition of the grid used by
+ * Ewoms::ThreadedEntityIterator if the indices of the degrees of freedom follow the
+ * iteration order of the elements.
+ *
+ * If the allocation happens within a parallel region, the pages are not touched.
+ */
+template <class T, std::size_t Alignment>
+class FirstTouchAllocator : public aligned_allocator<T, Alignment>
+{
+    typedef aligned_allocator<T, Alignment> ParentType;
+
+public:
+    typedef typename ParentType::pointer pointer;
+    typedef typename ParentType::size_type size_type;
+    typedef typename ParentType::const_void_pointer const_void_pointer;
+
+    template<class U>
+    struct rebind {
+        typedef FirstTouchAllocator<U, Alignment> other;
+    };
+
+    FirstTouchAllocator() noexcept = default;
+
+    template<class U>
+    FirstTouchAllocator(const FirstTouchAllocator<U, Alignment>&) noexcept
+    {}
+
+    pointer allocate(size_type size, const_void_pointer hint = 0)
+    {
+        pointer p = ParentType::allocate(size, hint);
+        touchPages_(reinterpret_cast<char*>(p), sizeof(T)*size);
+        return p;
+    }
+
+private:
+    static void touchPages_(char* begin, size_type numBytes)
+    {
+#ifdef _OPENMP
+        if (numBytes == 0 || omp_in_parallel())
+            return;
+
+        const size_type pageSize = static_cast<size_type>(sysconf(_SC_PAGESIZE));
+        const long numPages = static_cast<long>((numBytes + pageSize - 1)/pageSize);
+#pragma omp parallel for schedule(static)
+        for (long pageIdx = 0; pageIdx < numPages; ++pageIdx)
+            begin[static_cast<size_type>(pageIdx)*pageSize] = 0;
+#else
+        // without threads, the memory is placed on the node of the allocating thread
+        // anyway
+        (void)begin;
+        (void)numBytes;
+#endif
+    }
+};
+
+template<class T1, class T2, std::size_t Alignment>
+inline bool operator==(const FirstTouchAllocator<T1, Alignment>&,
+                       const FirstTouchAllocator<T2, Alignment>&) noexcept
+{ return true; }
+
+template<class T1, class T2, std::size_t Alignment>
+inline bool operator!=(const FirstTouchAllocator<T1, Alignment>&,
+                       const FirstTouchAllocator<T2, Alignment>&) noexcept
+{ return false; }
+} // namespace Ewoms
+
+#endif
@@ -0,0 +1,140 @@
+// -*- mode: C++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*-
+// vi: set et ts=4 sw=4 sts=4:
+/*
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+
+  Consult the COPYING file in the top-level source directory of this
+  module for the precise wording of the license and the list of
+  copyright holders.
+*/
+/*!
+ * \file
+ *
+ * \copydoc Ewoms::LoadImbalanceMonitor
+ */
+#ifndef EWOMS_LOAD_IMBALANCE_MONITOR_HH
+#define EWOMS_LOAD_IMBALANCE_MONITOR_HH
+
+#include <iomanip>
+#include <ostream>
+#include <sstream>
+#include <string>
+
+namespace Ewoms {
+/*!
+ * \ingroup Common
+ *
+ * \brief Determines how evenly the measured work is distributed over the processes.
+ *
+ * Each process passes the time it spent for a given task (e.g., the linearization of
+ * its elements) to update(). The monitor then determines the minimum, the mean and the
+ * maximum over all processes. The imbalance is the ratio of the maximum and the mean
+ * minus one, i.e., it is zero if the work is perfectly balanced. Since all processes
+ * need to wait for the slowest one at the next synchronization point, the fraction of
+ * the time which the processes are idle on average is given by 1 - mean/max.
+ */
+class LoadImbalanceMonitor
+{
+public:
+    LoadImbalanceMonitor()
+        : minCost_(0.0)
+        , meanCost_(0.0)
+        , maxCost_(0.0)
+        , slowestRank_(0)
+    {}
+
+    /*!
+     * \brief Reduce the cost of the local process over all processes.
+     *
+     * This method is collective.
+     *
+     * \param localCost The cost of the local process, usually in seconds
+     * \param comm The collective communication object of the grid view
+     */
+    template <class CollectiveCommunication>
+    void update(double localCost, const CollectiveCommunication& comm)
+    {
+        minCost_ = comm.min(localCost);
+        maxCost_ = comm.max(localCost);
+        meanCost_ = comm.sum(localCost)/comm.size();
+
+        // the lowest rank which exhibits the maximum cost
+        int candidate = (localCost >= maxCost_) ? comm.rank() : comm.size();
+        slowestRank_ = comm.min(candidate);
+    }
+
+    /*!
+     * \brief The minimum cost of all processes.
+     */
+    double minCost() const
+    { return minCost_; }
+
+    /*!
+     * \brief The mean cost of all processes.
+     */
+    double meanCost() const
+    { return meanCost_; }
+
+    /*!
+     * \brief The maximum cost of all processes.
+     */
+    double maxCost() const
+    { return maxCost_; }
+
+    /*!
+     * \brief The rank of the process with the maximum cost.
+     */
+    int slowestRank() const
+    { return slowestRank_; }
+
+    /*!
+     * \brief The ratio of the maximum and the mean cost minus one.
+     */
+    double imbalance() const
+    { return (meanCost_ > 0.0) ? maxCost_/meanCost_ - 1.0 : 0.0; }
+
+    /*!
+     * \brief The fraction of the time the processes wait for the slowest one on average.
+     */
+    double idleFraction() const
+    { return (maxCost_ > 0.0) ? 1.0 - meanCost_/maxCost_ : 0.0; }
+
+    /*!
+     * \brief Print the result of the last update as a single line.
+     */
+    void print(std::ostream& os, const std::string& what) const
+    {
+        std::ostringstream oss;
+        oss << std::setprecision(3)
+            << "Load imbalance of " << what << ": "
+            << "min " << minCost_ << " s"
+            << ", mean " << meanCost_ << " s"
+            << ", max " << maxCost_ << " s (rank " << slowestRank_ << ")"
+            << ", imbalance " << imbalance()*100 << "%"
+            << ", idle " << idleFraction()*100 << "%\n";
+        os << oss.str() << std::flush;
+    }
+
+private:
+    double minCost_;
+    double meanCost_;
+    double maxCost_;
+    int slowestRank_;
+};
+
+} // namespace Ewoms
+
+#endif
@@ -31,6 +31,8 @@
 #include <mpi.h>
 #endif
 
+#include <opm/common/Unused.hpp>
+
 #include <stddef.h>
 
 #include <type_traits>
@@ -111,14 +113,17 @@ public:
     void receive(unsigned peerRank)
     {
 #if HAVE_MPI
-        MPI_Recv(data_,
-                 static_cast<int>(mpiDataSize_),
-                 mpiDataType_,
-                 static_cast<int>(peerRank),
-                 0, // tag
-                 MPI_COMM_WORLD,
-                 &mpiStatus_);
-        assert(!mpiStatus_.MPI_ERROR);
+        int OPM_OPTIM_UNUSED errorCode =
+            MPI_Recv(data_,
+                     static_cast<int>(mpiDataSize_),
+                     mpiDataType_,
+                     static_cast<int>(peerRank),
+                     0, // tag
+                     MPI_COMM_WORLD,
+                     &mpiStatus_);
+        // MPI_Recv() does not set the MPI_ERROR field of the status object, so the
+        // return value needs to be checked instead
+        assert(errorCode == MPI_SUCCESS);
 #endif // HAVE_MPI
     }
 
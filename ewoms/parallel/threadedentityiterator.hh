@@ -29,12 +29,27 @@
 
 #include <ewoms/parallel/locks.hh>
 
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#include <cstddef>
+#include <vector>
+
 namespace Ewoms {
 
 /*!
  * \brief Provides an STL-iterator like interface to iterate over the enties of a
  *        GridView in OpenMP threaded applications
  *
+ * By default, each thread gets the next entity which is not yet worked on by any other
+ * thread. If the first entity of each thread for a static partition is passed to the
+ * constructor, the entities are instead split into contiguous blocks of the iteration
+ * order, one for each thread, see partitionBegin(). The threads then always work on the
+ * same entities as long as the grid is unchanged. Since stepping to these entities takes
+ * time proportional to the size of the grid, they should be determined once for each
+ * grid using partitionBegins().
+ *
  * ATTENTION: This class must be instantiated in a sequential context!
  */
 template <class GridView, int codim>
@@ -42,18 +57,116 @@ class ThreadedEntityIterator
 {
     typedef typename GridView::template Codim<codim>::Entity Entity;
     typedef typename GridView::template Codim<codim>::Iterator EntityIterator;
+
+    // the iteration state of a thread for the static partition. the padding avoids
+    // false sharing
+    struct ThreadState
+    {
+        ThreadState(const EntityIterator& initialIt)
+            : it(initialIt)
+            , numRemaining(0)
+        {}
+
+        EntityIterator it;
+        size_t numRemaining;
+        char padding[64];
+    };
+
 public:
-    ThreadedEntityIterator(const GridView& gridView)
+    explicit ThreadedEntityIterator(const GridView& gridView)
         : gridView_(gridView)
         , sequentialIt_(gridView_.template begin<codim>())
         , sequentialEnd_(gridView.template end<codim>())
-    { }
+        , partitionBegins_(0)
+        , staticPartition_(false)
+        , numEntities_(0)
+    {}
+
+    /*!
+     * \brief Iterate over the entities using a static partition.
+     *
+     * \param gridView The grid view of the entities
+     * \param partitionBegins The first entity of each thread as computed by
+     *                        partitionBegins(). If this is empty, the entities are not
+     *                        statically partitioned. The vector must outlive the
+     *                        iterator.
+     */
+    ThreadedEntityIterator(const GridView& gridView,
+                           const std::vector<EntityIterator>& partitionBegins)
+        : gridView_(gridView)
+        , sequentialIt_(gridView_.template begin<codim>())
+        , sequentialEnd_(gridView.template end<codim>())
+        , partitionBegins_(&partitionBegins)
+        , staticPartition_(!partitionBegins.empty())
+        , numEntities_(0)
+    {
+        if (staticPartition_) {
+            numEntities_ = static_cast<size_t>(gridView_.size(codim));
+            threadStates_.resize(maxThreads_(), ThreadState(sequentialEnd_));
+        }
+    }
 
     ThreadedEntityIterator(const ThreadedEntityIterator& other) = default;
 
+    /*!
+     * \brief Returns the position in the iteration order of the first entity assigned
+     *        to a thread by the static partition.
+     *
+     * The entities of a thread end where the ones of the next thread begin.
+     */
+    static size_t partitionBegin(size_t numEntities, unsigned threadIdx, unsigned numThreads)
+    { return numEntities*threadIdx/numThreads; }
+
+    /*!
+     * \brief Returns the first entity of each thread for the static partition.
+     *
+     * This iterates over the grid view once. The result stays valid until the grid is
+     * changed.
+     */
+    static std::vector<EntityIterator> partitionBegins(const GridView& gridView,
+                                                       unsigned numThreads)
+    {
+        std::vector<EntityIterator> result;
+        size_t numEntities = static_cast<size_t>(gridView.size(codim));
+        size_t pos = 0;
+        EntityIterator it = gridView.template begin<codim>();
+        const EntityIterator& endIt = gridView.template end<codim>();
+        for (; it != endIt; ++it, ++pos)
+            while (result.size() < numThreads
+                   && pos >= partitionBegin(numEntities,
+                                            static_cast<unsigned>(result.size()),
+                                            numThreads))
+                result.push_back(it);
+
+        // threads which do not get any entities start at the end
+        while (result.size() < numThreads)
+            result.push_back(endIt);
+
+        return result;
+    }
+
     // begin iterating over the grid in parallel
     EntityIterator beginParallel()
     {
+        if (staticPartition_) {
+            unsigned threadIdx = threadIdx_();
+            unsigned numThreads = numThreads_();
+            size_t begin = partitionBegin(numEntities_, threadIdx, numThreads);
+            size_t end = partitionBegin(numEntities_, threadIdx + 1, numThreads);
+
+            ThreadState& state = threadStates_[threadIdx];
+            if (partitionBegins_->size() == numThreads)
+                state.it = (*partitionBegins_)[threadIdx];
+            else {
+                // the partition was computed for a different number of threads
+                state.it = gridView_.template begin<codim>();
+                for (size_t i = 0; i < begin; ++i)
+                    ++state.it;
+            }
+            state.numRemaining = end - begin;
+            return (state.numRemaining > 0) ? state.it : sequentialEnd_;
+        }
+
         mutex_.lock();
         auto tmp = sequentialIt_;
         if (sequentialIt_ != sequentialEnd_)
@@ -71,6 +184,18 @@ public:
     // thread
     EntityIterator increment()
     {
+        if (staticPartition_) {
+            ThreadState& state = threadStates_[threadIdx_()];
+            if (state.numRemaining <= 1) {
+                state.numRemaining = 0;
+                return sequentialEnd_;
+            }
+
+            --state.numRemaining;
+            ++state.it;
+            return state.it;
+        }
+
         mutex_.lock();
         auto tmp = sequentialIt_;
         if (sequentialIt_ != sequentialEnd_)
@@ -81,10 +206,42 @@ public:
     }
 
 private:
+    static unsigned threadIdx_()
+    {
+#ifdef _OPENMP
+        return static_cast<unsigned>(omp_get_thread_num());
+#else
+        return 0;
+#endif
+    }
+
+    static unsigned numThreads_()
+    {
+#ifdef _OPENMP
+        return static_cast<unsigned>(omp_get_num_threads());
+#else
+        return 1;
+#endif
+    }
+
+    static unsigned maxThreads_()
+    {
+#ifdef _OPENMP
+        return static_cast<unsigned>(omp_get_max_threads());
+#else
+        return 1;
+#endif
+    }
+
     GridView gridView_;
     EntityIterator sequentialIt_;
     EntityIterator sequentialEnd_;
 
+    const std::vector<EntityIterator>* partitionBegins_;
+    bool staticPartition_;
+    size_t numEntities_;
+    std::vector<ThreadState> threadStates_;
+
     OmpMutex mutex_;
 };
 } // namespace Ewoms
@@ -40,13 +40,35 @@
 
 #include <dune/common/version.hh>
 
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#if defined(_OPENMP) && defined(__linux__)
+#include <sched.h>
+#endif
+
 namespace Ewoms {
 namespace Properties {
 NEW_PROP_TAG(ThreadsPerProcess);
+NEW_PROP_TAG(ThreadAffinity);
 }
 
 /*!
  * \brief Simplifies multi-threaded capabilities.
+ *
+ * If the ThreadAffinity parameter is set to 'compact' or 'scatter', each OpenMP thread
+ * is pinned to a single CPU out of the ones which the process is allowed to run on
+ * (i.e., the binding of the MPI launcher is respected). 'compact' fills the CPUs of
+ * the first NUMA node before it continues with the next one, 'scatter' distributes the
+ * threads over the NUMA nodes in a round-robin fashion. Since memory pages are placed
+ * on the NUMA node of the thread which touches them first, pinned threads are only
+ * useful if each thread always works on the same part of the data. For this reason,
+ * the loops over the grid use a static partition of the elements if the threads are
+ * pinned, see staticPartitioning(). Pinning is only supported on Linux.
  */
 template <class TypeTag>
 class ThreadManager
@@ -69,6 +91,9 @@ public:
         EWOMS_REGISTER_PARAM(TypeTag, int, ThreadsPerProcess,
                              "The maximum number of threads to be instantiated per process "
                              "('-1' means 'automatic')");
+        EWOMS_REGISTER_PARAM(TypeTag, std::string, ThreadAffinity,
+                             "The policy used to pin the threads to CPUs. Possible values "
+                             "are 'none', 'compact' and 'scatter'");
     }
 
     static void init()
@@ -113,6 +138,19 @@ public:
 
         numThreads_ = omp_get_max_threads();
 #endif
+
+        const std::string& affinity = EWOMS_GET_PARAM(TypeTag, std::string, ThreadAffinity);
+        threadNumaNode_.assign(static_cast<size_t>(numThreads_), -1);
+        numNumaNodes_ = 1;
+        pinned_ = false;
+        if (affinity == "compact")
+            pinThreads_(/*scatter=*/false);
+        else if (affinity == "scatter")
+            pinThreads_(/*scatter=*/true);
+        else if (affinity != "none")
+            OPM_THROW(std::invalid_argument,
+                      "Unknown thread affinity policy '" << affinity << "'. Possible values "
+                      "are 'none', 'compact' and 'scatter'");
     }
 
     /*!
@@ -133,12 +171,157 @@ public:
 #endif
     }
 
+    /*!
+     * \brief Returns true if each thread always works on the same part of the grid.
+     *
+     * This is the case if the threads have been pinned to CPUs.
+     */
+    static bool staticPartitioning()
+    { return pinned_; }
+
+    /*!
+     * \brief Return the index of the NUMA node a thread has been pinned to.
+     *
+     * If the threads are not pinned or the NUMA topology is unknown, -1 is returned.
+     */
+    static int numaNode(unsigned threadId)
+    { return threadNumaNode_.empty() ? -1 : threadNumaNode_[threadId]; }
+
+    /*!
+     * \brief Return the number of NUMA nodes of the CPUs available to the process.
+     */
+    static unsigned numNumaNodes()
+    { return numNumaNodes_; }
+
 private:
+    // returns the CPUs of each NUMA node of the system. if the topology cannot be
+    // determined, a single node which contains all CPUs is assumed.
+    static std::vector<std::vector<int> > numaTopology_()
+    {
+        std::vector<std::vector<int> > result;
+        for (int nodeIdx = 0; ; ++nodeIdx) {
+            std::ostringstream fileName;
+            fileName << "/sys/devices/system/node/node" << nodeIdx << "/cpulist";
+            std::ifstream is(fileName.str());
+            if (!is.good())
+                break;
+
+            // the list is of the form "0-15,32-47"
+            std::vector<int> cpus;
+            std::string range;
+            while (std::getline(is, range, ',')) {
+                int first = -1;
+                int last = -1;
+                char dash;
+                std::istringstream iss(range);
+                iss >> first;
+                if (!(iss >> dash >> last))
+                    last = first;
+                for (int cpu = first; cpu >= 0 && cpu <= last; ++cpu)
+                    cpus.push_back(cpu);
+            }
+            result.push_back(cpus);
+        }
+
+        return result;
+    }
+
+    static void pinThreads_(bool scatter)
+    {
+#if defined(_OPENMP) && defined(__linux__)
+        cpu_set_t allowedCpus;
+        CPU_ZERO(&allowedCpus);
+        if (sched_getaffinity(0, sizeof(allowedCpus), &allowedCpus) != 0)
+            OPM_THROW(std::runtime_error, "Could not determine the CPUs available to the process");
+
+        // the CPUs available to the process grouped by their NUMA node
+        std::vector<std::vector<int> > nodeCpus;
+        std::vector<int> nodeIndices;
+        std::vector<std::vector<int> > topology = numaTopology_();
+        if (topology.empty()) {
+            topology.resize(1);
+            for (int cpu = 0; cpu < CPU_SETSIZE; ++cpu)
+                topology[0].push_back(cpu);
+        }
+        for (unsigned nodeIdx = 0; nodeIdx < topology.size(); ++nodeIdx) {
+            std::vector<int> cpus;
+            for (int cpu : topology[nodeIdx])
+                if (CPU_ISSET(cpu, &allowedCpus))
+                    cpus.push_back(cpu);
+            if (cpus.empty())
+                continue;
+            nodeCpus.push_back(cpus);
+            nodeIndices.push_back(static_cast<int>(nodeIdx));
+        }
+        if (nodeCpus.empty())
+            return;
+
+        // the order in which the threads are assigned to the CPUs
+        std::vector<int> cpuOrder;
+        std::vector<int> cpuNode;
+        if (scatter) {
+            size_t maxCpusPerNode = 0;
+            for (const auto& cpus : nodeCpus)
+                maxCpusPerNode = std::max(maxCpusPerNode, cpus.size());
+            for (size_t i = 0; i < maxCpusPerNode; ++i) {
+                for (unsigned nodeIdx = 0; nodeIdx < nodeCpus.size(); ++nodeIdx) {
+                    if (i < nodeCpus[nodeIdx].size()) {
+                        cpuOrder.push_back(nodeCpus[nodeIdx][i]);
+                        cpuNode.push_back(nodeIndices[nodeIdx]);
+                    }
+                }
+            }
+        }
+        else {
+            for (unsigned nodeIdx = 0; nodeIdx < nodeCpus.size(); ++nodeIdx) {
+                for (int cpu : nodeCpus[nodeIdx]) {
+                    cpuOrder.push_back(cpu);
+                    cpuNode.push_back(nodeIndices[nodeIdx]);
+                }
+            }
+        }
+
+        // the OpenMP runtimes keep the threads of the outermost parallel region alive,
+        // so the pinning applies to all subsequent parallel regions.
+        bool success = true;
+#pragma omp parallel reduction(&&: success)
+        {
+            unsigned threadIdx = threadId();
+            unsigned orderIdx = threadIdx % static_cast<unsigned>(cpuOrder.size());
+
+            cpu_set_t cpuSet;
+            CPU_ZERO(&cpuSet);
+            CPU_SET(cpuOrder[orderIdx], &cpuSet);
+            success = (sched_setaffinity(0, sizeof(cpuSet), &cpuSet) == 0);
+            threadNumaNode_[threadIdx] = cpuNode[orderIdx];
+        }
+
+        if (!success)
+            OPM_THROW(std::runtime_error, "Could not pin the threads to CPUs");
+
+        numNumaNodes_ = static_cast<unsigned>(nodeCpus.size());
+        pinned_ = true;
+#else
+        std::cerr << "Warning: Pinning threads to CPUs is only supported on Linux with "
+                  << "OpenMP. The threads are not pinned.\n";
+        (void) scatter;
+#endif
+    }
+
     static int numThreads_;
+    static bool pinned_;
+    static unsigned numNumaNodes_;
+    static std::vector<int> threadNumaNode_;
 };
 
 template <class TypeTag>
 int ThreadManager<TypeTag>::numThreads_ = 1;
+template <class TypeTag>
+bool ThreadManager<TypeTag>::pinned_ = false;
+template <class TypeTag>
+unsigned ThreadManager<TypeTag>::numNumaNodes_ = 1;
+template <class TypeTag>
+std::vector<int> ThreadManager<TypeTag>::threadNumaNode_;
 } // namespace Ewoms
 
 #endif
@@ -0,0 +1,350 @@
+// -*- mode: C++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*-
+// vi: set et ts=4 sw=4 sts=4:
+/*
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+
+  Consult the COPYING file in the top-level source directory of this
+  module for the precise wording of the license and the list of
+  copyright holders.
+*/
+/*!
+ * \file
+ *
+ * \brief Converts the snapshot files written by Ewoms::SnapshotWriter to a set of VTU
+ *        files and a PVD file which references them.
+ */
+#include "config.h"
+
+#include <ewoms/io/snapshotreader.hh>
+
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace Ewoms {
+/*!
+ * \brief Writes the time steps contained by a snapshot file as VTU files.
+ *
+ * All arrays are written as raw binary data to the appended section of the VTU files.
+ */
+class Snapshot2Vtu
+{
+    struct DataArray
+    {
+        std::string name;
+        std::string type;
+        unsigned numComponents;
+        const char *data;
+        uint64_t numBytes;
+
+        // two-dimensional vectors are padded with a zero third component
+        std::vector<double> padded;
+    };
+
+public:
+    Snapshot2Vtu(const SnapshotReader& reader, const std::string& baseName)
+        : reader_(reader)
+        , baseName_(baseName)
+    {}
+
+    /*!
+     * \brief Write a time step and return the name of the file which ought to be
+     *        referenced by the PVD file.
+     */
+    std::string convertStep(unsigned stepIdx)
+    {
+        unsigned numRanks = reader_.numRanks();
+        std::ostringstream oss;
+        oss << baseName_ << "-" << std::setw(5) << std::setfill('0') << stepIdx;
+        std::string stepName = oss.str();
+
+        if (numRanks == 1) {
+            writePiece_(stepIdx, /*rankIdx=*/0, stepName + ".vtu");
+            return stepName + ".vtu";
+        }
+
+        for (unsigned rankIdx = 0; rankIdx < numRanks; ++rankIdx)
+            writePiece_(stepIdx, rankIdx, pieceFileName_(stepName, rankIdx));
+        writeParallelHeader_(stepIdx, stepName);
+        return stepName + ".pvtu";
+    }
+
+    /*!
+     * \brief Convert all time steps and write the PVD file.
+     */
+    void convertAll()
+    {
+        std::ofstream pvd((baseName_ + ".pvd").c_str());
+        pvd << "<?xml version=\"1.0\"?>\n"
+            << "<VTKFile type=\"Collection\" version=\"0.1\" byte_order=\"LittleEndian\">\n"
+            << "<Collection>\n";
+
+        for (unsigned stepIdx = 0; stepIdx < reader_.numSteps(); ++stepIdx) {
+            std::string fileName = convertStep(stepIdx);
+            pvd << "   <DataSet timestep=\"" << std::setprecision(16) << reader_.time(stepIdx)
+                << "\" file=\"" << fileName << "\"/>\n";
+        }
+
+        pvd << "</Collection>\n"
+            << "</VTKFile>\n";
+    }
+
+private:
+    std::string pieceFileName_(const std::string& stepName, unsigned rankIdx) const
+    {
+        std::ostringstream oss;
+        oss << stepName << "-p" << std::setw(4) << std::setfill('0') << rankIdx << ".vtu";
+        return oss.str();
+    }
+
+    void collectFieldArrays_(unsigned stepIdx,
+                             unsigned rankIdx,
+                             bool cellData,
+                             std::vector<DataArray>& arrays) const
+    {
+        for (unsigned fieldIdx = 0; fieldIdx < reader_.numFields(stepIdx); ++fieldIdx) {
+            if (reader_.isCellField(stepIdx, fieldIdx) != cellData)
+                continue;
+
+            arrays.push_back(DataArray());
+            DataArray& array = arrays.back();
+            array.name = reader_.fieldName(stepIdx, fieldIdx);
+            array.type = "Float64";
+
+            unsigned n = reader_.numComponents(stepIdx, fieldIdx);
+            uint64_t numEntities = reader_.numEntities(stepIdx, fieldIdx, rankIdx);
+            const double *values = reader_.fieldData(stepIdx, fieldIdx, rankIdx);
+            if (n == 2) {
+                array.padded.resize(numEntities*3, 0.0);
+                for (uint64_t i = 0; i < numEntities; ++i) {
+                    array.padded[i*3 + 0] = values[i*2 + 0];
+                    array.padded[i*3 + 1] = values[i*2 + 1];
+                }
+                array.numComponents = 3;
+                array.data = reinterpret_cast<const char*>(array.padded.data());
+                array.numBytes = array.padded.size()*sizeof(double);
+            }
+            else {
+                array.numComponents = n;
+                array.data = reinterpret_cast<const char*>(values);
+                array.numBytes = numEntities*n*sizeof(double);
+            }
+        }
+    }
+
+    void writeDataArrayTag_(std::ostream& os, const DataArray& array, uint64_t& offset) const
+    {
+        os << "<DataArray type=\"" << array.type << "\" Name=\"" << array.name << "\""
+           << " NumberOfComponents=\"" << array.numComponents << "\""
+           << " format=\"appended\" offset=\"" << offset << "\"/>\n";
+        offset += sizeof(uint64_t) + array.numBytes;
+    }
+
+    void writePiece_(unsigned stepIdx, unsigned rankIdx, const std::string& fileName) const
+    {
+        unsigned gridIdx = reader_.gridIndex(stepIdx);
+        uint64_t numCells = reader_.numCells(gridIdx, rankIdx);
+        uint64_t numPoints = reader_.numPoints(gridIdx, rankIdx);
+
+        std::vector<DataArray> cellArrays;
+        std::vector<DataArray> pointArrays;
+        collectFieldArrays_(stepIdx, rankIdx, /*cellData=*/true, cellArrays);
+        collectFieldArrays_(stepIdx, rankIdx, /*cellData=*/false, pointArrays);
+
+        std::vector<DataArray> geomArrays(4);
+        geomArrays[0].name = "Coordinates";
+        geomArrays[0].type = "Float64";
+        geomArrays[0].numComponents = 3;
+        geomArrays[0].data = reinterpret_cast<const char*>(reader_.points(gridIdx, rankIdx));
+        geomArrays[0].numBytes = numPoints*3*sizeof(double);
+
+        geomArrays[1].name = "connectivity";
+        geomArrays[1].type = "Int64";
+        geomArrays[1].numComponents = 1;
+        geomArrays[1].data = reinterpret_cast<const char*>(reader_.connectivity(gridIdx, rankIdx));
+        geomArrays[1].numBytes = reader_.numCorners(gridIdx, rankIdx)*sizeof(int64_t);
+
+        geomArrays[2].name = "offsets";
+        geomArrays[2].type = "Int64";
+        geomArrays[2].numComponents = 1;
+        geomArrays[2].data = reinterpret_cast<const char*>(reader_.offsets(gridIdx, rankIdx));
+        geomArrays[2].numBytes = numCells*sizeof(int64_t);
+
+        geomArrays[3].name = "types";
+        geomArrays[3].type = "UInt8";
+        geomArrays[3].numComponents = 1;
+        geomArrays[3].data = reinterpret_cast<const char*>(reader_.types(gridIdx, rankIdx));
+        geomArrays[3].numBytes = numCells*sizeof(uint8_t);
+
+        std::ofstream os(fileName.c_str(), std::ios::binary);
+        if (!os)
+            OPM_THROW(std::runtime_error, "Could not open file '" << fileName << "'");
+
+        uint64_t offset = 0;
+        os << "<?xml version=\"1.0\"?>\n"
+           << "<VTKFile type=\"UnstructuredGrid\" version=\"1.0\" byte_order=\"LittleEndian\""
+           << " header_type=\"UInt64\">\n"
+           << "<UnstructuredGrid>\n"
+           << "<Piece NumberOfCells=\"" << numCells << "\" NumberOfPoints=\"" << numPoints << "\">\n";
+
+        os << "<PointData>\n";
+        for (const auto& array : pointArrays)
+            writeDataArrayTag_(os, array, offset);
+        os << "</PointData>\n";
+
+        os << "<CellData>\n";
+        for (const auto& array : cellArrays)
+            writeDataArrayTag_(os, array, offset);
+        os << "</CellData>\n";
+
+        os << "<Points>\n";
+        writeDataArrayTag_(os, geomArrays[0], offset);
+        os << "</Points>\n";
+
+        os << "<Cells>\n";
+        for (unsigned i = 1; i < geomArrays.size(); ++i)
+            writeDataArrayTag_(os, geomArrays[i], offset);
+        os << "</Cells>\n";
+
+        os << "</Piece>\n"
+           << "</UnstructuredGrid>\n"
+           << "<AppendedData encoding=\"raw\">\n_";
+
+        // the order of the blobs must match the order of the offsets above
+        for (const auto& array : pointArrays)
+            writeBlob_(os, array);
+        for (const auto& array : cellArrays)
+            writeBlob_(os, array);
+        for (const auto& array : geomArrays)
+            writeBlob_(os, array);
+
+        os << "\n</AppendedData>\n"
+           << "</VTKFile>\n";
+    }
+
+    void writeBlob_(std::ostream& os, const DataArray& array) const
+    {
+        uint64_t numBytes = array.numBytes;
+        os.write(reinterpret_cast<const char*>(&numBytes), sizeof(numBytes));
+        os.write(array.data, static_cast<std::streamsize>(numBytes));
+    }
+
+    void writeParallelHeader_(unsigned stepIdx, const std::string& stepName) const
+    {
+        std::string fileName = stepName + ".pvtu";
+        std::ofstream os(fileName.c_str());
+        if (!os)
+            OPM_THROW(std::runtime_error, "Could not open file '" << fileName << "'");
+
+        std::vector<DataArray> cellArrays;
+        std::vector<DataArray> pointArrays;
+        collectFieldArrays_(stepIdx, /*rankIdx=*/0, /*cellData=*/true, cellArrays);
+        collectFieldArrays_(stepIdx, /*rankIdx=*/0, /*cellData=*/false, pointArrays);
+
+        os << "<?xml version=\"1.0\"?>\n"
+           << "<VTKFile type=\"PUnstructuredGrid\" version=\"1.0\" byte_order=\"LittleEndian\""
+           << " header_type=\"UInt64\">\n"
+           << "<PUnstructuredGrid GhostLevel=\"0\">\n";
+
+        os << "<PPointData>\n";
+        for (const auto& array : pointArrays)
+            writePDataArrayTag_(os, array);
+        os << "</PPointData>\n";
+
+        os << "<PCellData>\n";
+        for (const auto& array : cellArrays)
+            writePDataArrayTag_(os, array);
+        os << "</PCellData>\n";
+
+        os << "<PPoints>\n"
+           << "<PDataArray type=\"Float64\" Name=\"Coordinates\" NumberOfComponents=\"3\"/>\n"
+           << "</PPoints>\n";
+
+        // the pieces are referenced relative to the location of the PVTU file
+        std::string pieceBaseName = stepName;
+        size_t slashPos = pieceBaseName.rfind('/');
+        if (slashPos != std::string::npos)
+            pieceBaseName = pieceBaseName.substr(slashPos + 1);
+        for (unsigned rankIdx = 0; rankIdx < reader_.numRanks(); ++rankIdx)
+            os << "<Piece Source=\"" << pieceFileName_(pieceBaseName, rankIdx) << "\"/>\n";
+
+        os << "</PUnstructuredGrid>\n"
+           << "</VTKFile>\n";
+    }
+
+    void writePDataArrayTag_(std::ostream& os, const DataArray& array) const
+    {
+        os << "<PDataArray type=\"" << array.type << "\" Name=\"" << array.name << "\""
+           << " NumberOfComponents=\"" << array.numComponents << "\"/>\n";
+    }
+
+    const SnapshotReader& reader_;
+    std::string baseName_;
+};
+} // namespace Ewoms
+
+int main(int argc, char** argv)
+{
+    if (argc < 2 || argc > 4) {
+        std::cout << "Converts a snapshot file to a VTK dataset\n\n"
+                  << "Usage: " << argv[0] << " SNAPSHOT_FILE [BASE_NAME [STEP_IDX]]\n\n"
+                  << "If STEP_IDX is not given, all time steps are converted and a PVD\n"
+                  << "file called BASE_NAME.pvd which references them is written.\n";
+        return 1;
+    }
+
+    std::string fileName = argv[1];
+    std::string baseName;
+    if (argc > 2)
+        baseName = argv[2];
+    else {
+        baseName = fileName;
+        size_t dotPos = baseName.rfind('.');
+        if (dotPos != std::string::npos)
+            baseName = baseName.substr(0, dotPos);
+    }
+
+    try {
+        Ewoms::SnapshotReader reader(fileName);
+        Ewoms::Snapshot2Vtu converter(reader, baseName);
+
+        if (argc > 3) {
+            unsigned stepIdx = static_cast<unsigned>(std::atoi(argv[3]));
+            if (stepIdx >= reader.numSteps()) {
+                std::cerr << "The snapshot file only contains " << reader.numSteps()
+                          << " time steps\n";
+                return 1;
+            }
+            std::cout << "Wrote " << converter.convertStep(stepIdx) << "\n";
+        }
+        else {
+            converter.convertAll();
+            std::cout << "Wrote " << reader.numSteps() << " time steps to "
+                      << baseName << ".pvd\n";
+        }
+    }
+    catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << "\n";
+        return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,127 @@
+// -*- mode: C++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*-
+// vi: set et ts=4 sw=4 sts=4:
+/*
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+
+  Consult the COPYING file in the top-level source directory of this
+  module for the precise wording of the license and the list of
+  copyright holders.
+*/
+/*!
+ * \file
+ *
+ * \brief Micro benchmark which compares the evaluation of the intensive quantities
+ *        while the elements are visited by the linearizer with the separate sweep of
+ *        FvBaseDiscretization::updateIntensiveQuantityCache().
+ *
+ * The benchmark uses the black-oil reservoir problem and accepts the same command
+ * line parameters as the reservoir_blackoil_ecfv simulator. The number of repetitions
+ * can be specified as the last command line argument if it is not a parameter.
+ */
+#include "config.h"
+
+#include <ewoms/common/start.hh>
+#include <ewoms/common/timer.hh>
+#include <ewoms/models/blackoil/blackoilmodel.hh>
+#include <ewoms/disc/ecfv/ecfvdiscretization.hh>
+#include "problems/reservoirproblem.hh"
+
+#include <iostream>
+#include <cstdlib>
+
+namespace Ewoms {
+namespace Properties {
+NEW_TYPE_TAG(IntensiveQuantitiesBenchmark, INHERITS_FROM(BlackOilModel, ReservoirBaseProblem));
+
+SET_TAG_PROP(IntensiveQuantitiesBenchmark, SpatialDiscretizationSplice, EcfvDiscretization);
+SET_TAG_PROP(IntensiveQuantitiesBenchmark, LocalLinearizerSplice, AutoDiffLocalLinearizer);
+
+// the separate sweep only makes sense if the intensive quantities are cached
+SET_BOOL_PROP(IntensiveQuantitiesBenchmark, EnableIntensiveQuantityCache, true);
+}}
+
+int main(int argc, char **argv)
+{
+    typedef TTAG(IntensiveQuantitiesBenchmark) TypeTag;
+    typedef GET_PROP_TYPE(TypeTag, Simulator) Simulator;
+    typedef GET_PROP_TYPE(TypeTag, ElementContext) ElementContext;
+    typedef GET_PROP_TYPE(TypeTag, GridView) GridView;
+    typedef GET_PROP_TYPE(TypeTag, ThreadManager) ThreadManager;
+    typedef GridView::Codim<0>::Iterator ElementIterator;
+
+    unsigned numRuns = 20;
+    if (argc > 1 && argv[argc - 1][0] != '-') {
+        numRuns = static_cast<unsigned>(std::atoi(argv[argc - 1]));
+        --argc;
+    }
+
+#if HAVE_DUNE_FEM
+    Dune::Fem::MPIManager::initialize(argc, argv);
+#else
+    Dune::MPIHelper::instance(argc, argv);
+#endif
+
+    int paramStatus = Ewoms::setupParameters_<TypeTag>(argc, argv);
+    if (paramStatus == 1)
+        return 1;
+    if (paramStatus == 2)
+        return 0;
+
+    ThreadManager::init();
+
+    Simulator simulator;
+    auto& model = simulator.model();
+    model.applyInitialSolution();
+
+    const GridView& gridView = simulator.gridView();
+    ElementContext elemCtx(simulator);
+
+    // evaluate the intensive quantities of the whole stencil of each element like the
+    // linearizer does it without the separate sweep
+    Ewoms::Timer elementTimer;
+    elementTimer.start();
+    for (unsigned runIdx = 0; runIdx < numRuns; ++runIdx) {
+        model.invalidateIntensiveQuantitiesCache(/*timeIdx=*/0);
+
+        ElementIterator elemIt = gridView.begin</*codim=*/0>();
+        const ElementIterator& elemEndIt = gridView.end</*codim=*/0>();
+        for (; elemIt != elemEndIt; ++elemIt) {
+            elemCtx.updateStencil(*elemIt);
+            elemCtx.updateIntensiveQuantities(/*timeIdx=*/0);
+        }
+    }
+    elementTimer.stop();
+
+    // evaluate them using the separate sweep
+    Ewoms::Timer sweepTimer;
+    sweepTimer.start();
+    for (unsigned runIdx = 0; runIdx < numRuns; ++runIdx) {
+        model.invalidateIntensiveQuantitiesCache(/*timeIdx=*/0);
+        model.updateIntensiveQuantityCache(/*timeIdx=*/0);
+    }
+    sweepTimer.stop();
+
+    double numDofEvals = static_cast<double>(numRuns)*model.numGridDof();
+    std::cout << "Evaluated the intensive quantities of " << model.numGridDof()
+              << " degrees of freedom " << numRuns << " times using "
+              << ThreadManager::maxThreads() << " thread(s)\n"
+              << "  per element: " << elementTimer.realTimeElapsed() << " s ("
+              << elementTimer.realTimeElapsed()/numDofEvals*1e9 << " ns per DOF)\n"
+              << "  separate sweep: " << sweepTimer.realTimeElapsed() << " s ("
+              << sweepTimer.realTimeElapsed()/numDofEvals*1e9 << " ns per DOF)\n";
+
+    return 0;
+}
@@ -0,0 +1,350 @@
+// -*- mode: C++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*-
+// vi: set et ts=4 sw=4 sts=4:
+/*
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+
+  Consult the COPYING file in the top-level source directory of this
+  module for the precise wording of the license and the list of
+  copyright holders.
+*/
+/*!
+ * \file
+ *
+ * \brief Micro benchmarks for the computational kernels of the simulator.
+ *
+ * For each of the immiscible, black-oil, PVS, NCP, flash and Richards models, the
+ * initial solution of one of the test problems is used to measure the following
+ * kernels in isolation:
+ *
+ * - The update of the intensive quantities of the stencil of a single element
+ * - The linearization of a single element using automatic differentiation
+ * - The addition of the result of this linearization to the global system
+ * - The synchronization of an overlapping block vector
+ * - The product of the overlapping Jacobian matrix with a vector
+ * - A single iteration of the BiCGStab solver
+ *
+ * The element-local kernels use an element from the middle of the grid. The models can
+ * be selected using "--model=NAME", all other command line arguments are passed to
+ * the simulators.
+ */
+#include "config.h"
+
+#include <ewoms/common/start.hh>
+#include <ewoms/common/kernelbenchmark.hh>
+#include <ewoms/models/immiscible/immisciblemodel.hh>
+#include <ewoms/models/blackoil/blackoilmodel.hh>
+#include <ewoms/models/pvs/pvsmodel.hh>
+#include <ewoms/models/ncp/ncpmodel.hh>
+#include <ewoms/models/flash/flashmodel.hh>
+#include <ewoms/disc/ecfv/ecfvdiscretization.hh>
+#include <ewoms/linear/bicgstabsolver.hh>
+#include <ewoms/linear/residreductioncriterion.hh>
+#include <ewoms/linear/overlappingpreconditioner.hh>
+#include <ewoms/linear/overlappingscalarproduct.hh>
+#include <ewoms/linear/overlappingoperator.hh>
+#include "problems/lensproblem.hh"
+#include "problems/reservoirproblem.hh"
+#include "problems/obstacleproblem.hh"
+#include "problems/co2injectionflash.hh"
+#include "problems/co2injectionproblem.hh"
+#include "problems/richardslensproblem.hh"
+
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <vector>
+
+namespace Ewoms {
+namespace Properties {
+NEW_TYPE_TAG(KernelBenchmark);
+
+//! The number of calls of each kernel before it is measured
+NEW_PROP_TAG(KernelBenchmarkWarmupCalls);
+
+//! The number of samples taken for each kernel
+NEW_PROP_TAG(KernelBenchmarkSamples);
+
+//! The number of BiCGStab iterations per call of the linear solver kernel
+NEW_PROP_TAG(KernelBenchmarkSolverIterations);
+
+SET_INT_PROP(KernelBenchmark, KernelBenchmarkWarmupCalls, 10);
+SET_INT_PROP(KernelBenchmark, KernelBenchmarkSamples, 20);
+SET_INT_PROP(KernelBenchmark, KernelBenchmarkSolverIterations, 10);
+
+// all kernels are measured for the element centered finite volume discretization
+// using automatic differentiation
+SET_TAG_PROP(KernelBenchmark, SpatialDiscretizationSplice, EcfvDiscretization);
+SET_TAG_PROP(KernelBenchmark, LocalLinearizerSplice, AutoDiffLocalLinearizer);
+
+NEW_TYPE_TAG(ImmiscibleKernelBenchmark, INHERITS_FROM(KernelBenchmark, ImmiscibleTwoPhaseModel, LensBaseProblem));
+NEW_TYPE_TAG(BlackOilKernelBenchmark, INHERITS_FROM(KernelBenchmark, BlackOilModel, ReservoirBaseProblem));
+NEW_TYPE_TAG(PvsKernelBenchmark, INHERITS_FROM(KernelBenchmark, PvsModel, ObstacleBaseProblem));
+NEW_TYPE_TAG(NcpKernelBenchmark, INHERITS_FROM(KernelBenchmark, NcpModel, ObstacleBaseProblem));
+NEW_TYPE_TAG(FlashKernelBenchmark, INHERITS_FROM(KernelBenchmark, FlashModel, Co2InjectionBaseProblem));
+NEW_TYPE_TAG(RichardsKernelBenchmark, INHERITS_FROM(KernelBenchmark, RichardsLensProblem));
+
+// use the flash solver adapted to the CO2 injection problem
+SET_TYPE_PROP(FlashKernelBenchmark, FlashSolver,
+              Ewoms::Co2InjectionFlash<typename GET_PROP_TYPE(TypeTag, Scalar),
+                                       typename GET_PROP_TYPE(TypeTag, FluidSystem)>);
+
+// the solver kernels need the preconditioner of the BiCGStab backend
+SET_TAG_PROP(FlashKernelBenchmark, LinearSolverSplice, ParallelBiCGStabLinearSolver);
+}}
+
+template <class TypeTag>
+static int benchmarkKernels_(const std::string& modelName, int argc, char **argv)
+{
+    typedef typename GET_PROP_TYPE(TypeTag, Scalar) Scalar;
+    typedef typename GET_PROP_TYPE(TypeTag, Simulator) Simulator;
+    typedef typename GET_PROP_TYPE(TypeTag, ElementContext) ElementContext;
+    typedef typename GET_PROP_TYPE(TypeTag, GridView) GridView;
+    typedef typename GET_PROP_TYPE(TypeTag, ThreadManager) ThreadManager;
+    typedef typename GET_PROP_TYPE(TypeTag, PrimaryVariables) PrimaryVariables;
+    typedef typename GET_PROP_TYPE(TypeTag, IntensiveQuantities) IntensiveQuantities;
+    typedef typename GET_PROP_TYPE(TypeTag, BorderListCreator) BorderListCreator;
+    typedef typename GET_PROP_TYPE(TypeTag, OverlappingMatrix) OverlappingMatrix;
+    typedef typename GET_PROP_TYPE(TypeTag, OverlappingVector) OverlappingVector;
+    typedef typename GET_PROP_TYPE(TypeTag, Overlap) Overlap;
+    typedef typename GET_PROP_TYPE(TypeTag, PreconditionerWrapper) PreconditionerWrapper;
+    typedef typename PreconditionerWrapper::SequentialPreconditioner SequentialPreconditioner;
+    typedef typename GridView::template Codim<0>::Iterator ElementIterator;
+
+    typedef Ewoms::Linear::OverlappingPreconditioner<SequentialPreconditioner, Overlap> ParallelPreconditioner;
+    typedef Ewoms::Linear::OverlappingScalarProduct<OverlappingVector, Overlap> ParallelScalarProduct;
+    typedef Ewoms::Linear::OverlappingOperator<OverlappingMatrix,
+                                               OverlappingVector,
+                                               OverlappingVector> ParallelOperator;
+    typedef Ewoms::Linear::BiCGStabSolver<ParallelOperator,
+                                          OverlappingVector,
+                                          ParallelPreconditioner> LinearSolver;
+
+    enum { numEq = GET_PROP_VALUE(TypeTag, NumEq) };
+    const double eqBlockBytes = numEq*sizeof(Scalar);
+    const double jacBlockBytes = numEq*numEq*sizeof(Scalar);
+
+    EWOMS_REGISTER_PARAM(TypeTag, unsigned, KernelBenchmarkWarmupCalls,
+                         "The number of calls of each kernel before it is measured");
+    EWOMS_REGISTER_PARAM(TypeTag, unsigned, KernelBenchmarkSamples,
+                         "The number of samples taken for each kernel");
+    EWOMS_REGISTER_PARAM(TypeTag, unsigned, KernelBenchmarkSolverIterations,
+                         "The number of BiCGStab iterations per call of the linear "
+                         "solver kernel");
+
+    int paramStatus = Ewoms::setupParameters_<TypeTag>(argc, argv);
+    if (paramStatus == 1)
+        return 1;
+    if (paramStatus == 2)
+        return 0;
+
+    ThreadManager::init();
+
+    Simulator simulator;
+    auto& model = simulator.model();
+    model.applyInitialSolution();
+    const GridView& gridView = simulator.gridView();
+
+    // linearize the whole system once. this allocates the Jacobian matrix and the
+    // residual which are required by the scatter and the solver kernels
+    auto& linearizer = model.linearizer();
+    linearizer.linearize();
+
+    // use an interior element from the middle of the grid as the representative one
+    ElementIterator elemIt = gridView.template begin</*codim=*/0>();
+    const ElementIterator& elemEndIt = gridView.template end</*codim=*/0>();
+    for (int n = gridView.size(/*codim=*/0)/2; n > 0; --n)
+        ++elemIt;
+    while (elemIt != elemEndIt && elemIt->partitionType() != Dune::InteriorEntity)
+        ++elemIt;
+    if (elemIt == elemEndIt)
+        elemIt = gridView.template begin</*codim=*/0>();
+
+    ElementContext elemCtx(simulator);
+    elemCtx.updateAll(*elemIt);
+    unsigned numDof = static_cast<unsigned>(elemCtx.numDof(/*timeIdx=*/0));
+    unsigned numPrimaryDof = static_cast<unsigned>(elemCtx.numPrimaryDof(/*timeIdx=*/0));
+
+    Ewoms::KernelBenchmark bench(EWOMS_GET_PARAM(TypeTag, unsigned, KernelBenchmarkWarmupCalls),
+                                 EWOMS_GET_PARAM(TypeTag, unsigned, KernelBenchmarkSamples));
+
+    std::cout << "\nModel '" << modelName << "': " << model.numGridDof()
+              << " degrees of freedom, " << numDof << " degrees of freedom per stencil, "
+              << numEq << " equations\n";
+    bench.printHeader(std::cout);
+
+    // the intensive quantities of all degrees of freedom of the stencil. the items are
+    // the degrees of freedom
+    std::vector<IntensiveQuantities> intQuants(numDof, elemCtx.intensiveQuantities(/*dofIdx=*/0,
+                                                                                   /*timeIdx=*/0));
+    bench.printResult(std::cout,
+                      bench.run("IntensiveQuantities::update",
+                                numDof,
+                                sizeof(PrimaryVariables) + sizeof(IntensiveQuantities),
+                                [&]() {
+                                    for (unsigned dofIdx = 0; dofIdx < numDof; ++dofIdx)
+                                        intQuants[dofIdx].update(elemCtx, dofIdx, /*timeIdx=*/0);
+                                }));
+
+    // the linearization of the element, i.e., the evaluation of the local residual
+    // including its derivatives. the items are the elements
+    auto& localLinearizer = model.localLinearizer(ThreadManager::threadId());
+    bench.printResult(std::cout,
+                      bench.run("LocalLinearizer::linearize",
+                                1,
+                                numDof*sizeof(IntensiveQuantities)
+                                + numDof*numPrimaryDof*jacBlockBytes
+                                + numPrimaryDof*eqBlockBytes,
+                                [&]() { localLinearizer.linearize(elemCtx); }));
+
+    // the addition of the local linearization to the global system of equations. each
+    // block of the Jacobian matrix and of the residual is read and written
+    bench.printResult(std::cout,
+                      bench.run("FvBaseLinearizer::addToGlobalSystem",
+                                1,
+                                2*numPrimaryDof*(numDof*jacBlockBytes + eqBlockBytes),
+                                [&]() { linearizer.addToGlobalSystem(elemCtx, localLinearizer); }));
+
+    // the benchmark above added the local system many times, so the global system must
+    // be linearized again before it is used by the solver kernels
+    linearizer.linearize();
+
+    // set up the overlapping linear system like the parallel linear solver backends
+    BorderListCreator borderListCreator(gridView, model.dofMapper());
+    unsigned overlapSize = EWOMS_GET_PARAM(TypeTag, unsigned, LinearSolverOverlapSize);
+    OverlappingMatrix overlappingMatrix(linearizer.matrix(),
+                                       borderListCreator.borderList(),
+                                       borderListCreator.blackList(),
+                                       overlapSize);
+    overlappingMatrix.assignFromNative(linearizer.matrix());
+    overlappingMatrix.syncAdd();
+    const Overlap& overlap = overlappingMatrix.overlap();
+
+    OverlappingVector x(overlap);
+    OverlappingVector b(overlap);
+    x = 1.0;
+    overlappingMatrix.mv(x, b);
+
+    typedef typename OverlappingMatrix::block_type MatrixBlock;
+    typedef typename OverlappingVector::block_type VectorBlock;
+    double numRows = static_cast<double>(overlappingMatrix.N());
+    double nnzPerRow = overlappingMatrix.nonzeroes()/numRows;
+    double spmvBytes = nnzPerRow*(sizeof(MatrixBlock) + sizeof(size_t)) + 2*sizeof(VectorBlock);
+
+    // the items of the solver kernels are the rows of the process-local matrix
+    bench.printResult(std::cout,
+                      bench.run("OverlappingBlockVector::sync",
+                                numRows,
+                                0.0,
+                                [&]() { x.sync(); }));
+
+    OverlappingVector y(x);
+    bench.printResult(std::cout,
+                      bench.run("BCRSMatrix::mv",
+                                numRows,
+                                spmvBytes,
+                                [&]() { overlappingMatrix.mv(x, y); }));
+
+    // BiCGStab with a criterion which is never met. each iteration applies the matrix
+    // and the preconditioner twice and streams about a dozen vectors
+    PreconditionerWrapper precWrapper;
+    precWrapper.prepare(overlappingMatrix);
+    ParallelPreconditioner parPreCond(precWrapper.get(), overlap);
+    ParallelScalarProduct parScalarProduct(overlap);
+    ParallelOperator parOperator(overlappingMatrix);
+    Ewoms::Linear::ResidReductionCriterion<OverlappingVector> convCrit(parScalarProduct,
+                                                                      /*tolerance=*/0.0);
+    LinearSolver solver(parPreCond, convCrit, parScalarProduct);
+    solver.setLinearOperator(&parOperator);
+    solver.setRhs(&b);
+    solver.setMaxIterations(EWOMS_GET_PARAM(TypeTag, unsigned, KernelBenchmarkSolverIterations));
+
+    // the solver may stop early because of a breakdown, so we need to determine the
+    // number of iterations which are actually done
+    x = 0.0;
+    solver.apply(x);
+    unsigned numIterations = solver.report().iterations();
+    if (numIterations > 0)
+        bench.printResult(std::cout,
+                          bench.run("BiCGStabSolver iteration",
+                                    numRows*numIterations,
+                                    2*spmvBytes + 2*nnzPerRow*sizeof(MatrixBlock)
+                                    + 12*sizeof(VectorBlock),
+                                    [&]() {
+                                        x = 0.0;
+                                        solver.apply(x);
+                                    }));
+    precWrapper.cleanup();
+
+    return 0;
+}
+
+int main(int argc, char **argv)
+{
+    // extract the name of the model from the command line. all remaining arguments are
+    // passed to the simulators.
+    const char *modelArg = "--model=";
+    std::string modelName;
+    int outArgIdx = 1;
+    for (int argIdx = 1; argIdx < argc; ++argIdx) {
+        if (std::strncmp(argv[argIdx], modelArg, std::strlen(modelArg)) == 0)
+            modelName = argv[argIdx] + std::strlen(modelArg);
+        else
+            argv[outArgIdx++] = argv[argIdx];
+    }
+    argc = outArgIdx;
+
+#if HAVE_DUNE_FEM
+    Dune::Fem::MPIManager::initialize(argc, argv);
+#else
+    Dune::MPIHelper::instance(argc, argv);
+#endif
+
+    bool all = modelName.empty();
+    bool found = false;
+    int result = 0;
+    if (all || modelName == "immiscible") {
+        found = true;
+        result = std::max(result, benchmarkKernels_<TTAG(ImmiscibleKernelBenchmark)>("immiscible", argc, argv));
+    }
+    if (all || modelName == "blackoil") {
+        found = true;
+        result = std::max(result, benchmarkKernels_<TTAG(BlackOilKernelBenchmark)>("blackoil", argc, argv));
+    }
+    if (all || modelName == "pvs") {
+        found = true;
+        result = std::max(result, benchmarkKernels_<TTAG(PvsKernelBenchmark)>("pvs", argc, argv));
+    }
+    if (all || modelName == "ncp") {
+        found = true;
+        result = std::max(result, benchmarkKernels_<TTAG(NcpKernelBenchmark)>("ncp", argc, argv));
+    }
+    if (all || modelName == "flash") {
+        found = true;
+        result = std::max(result, benchmarkKernels_<TTAG(FlashKernelBenchmark)>("flash", argc, argv));
+    }
+    if (all || modelName == "richards") {
+        found = true;
+        result = std::max(result, benchmarkKernels_<TTAG(RichardsKernelBenchmark)>("richards", argc, argv));
+    }
+
+    if (!found) {
+        std::cout << "Unknown model '" << modelName << "'. Valid models are: "
+                  << "immiscible, blackoil, pvs, ncp, flash and richards\n";
+        return 1;
+    }
+
+    return result;
+}
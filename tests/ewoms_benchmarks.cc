@@ -0,0 +1,168 @@
+// -*- mode: C++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*-
+// vi: set et ts=4 sw=4 sts=4:
+/*
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+
+  Consult the COPYING file in the top-level source directory of this
+  module for the precise wording of the license and the list of
+  copyright holders.
+*/
+/*!
+ * \file
+ *
+ * \brief Benchmark suite which is based on some of the test problems.
+ *
+ * The problem to be run is selected using the "--benchmark=NAME" command line argument,
+ * all other arguments are the parameters of the respective simulator. In contrast to
+ * the test simulators, all problems use structured grids, so that their size can be
+ * chosen via the --cells-x, --cells-y and --grid-global-refinements parameters. Each
+ * simulation stops after --benchmark-time-steps time steps. Its timings, iteration
+ * counts and size are then written as JSON to the terminal or to the file specified
+ * by --benchmark-output-file. If --benchmark-baseline-file is specified, the results
+ * are compared to the ones of a previous run and the program fails if a regression of
+ * more than --benchmark-tolerance is detected.
+ */
+#include "config.h"
+
+#include <ewoms/common/start.hh>
+#include <ewoms/common/benchmarkproblem.hh>
+#include <ewoms/io/cubegridmanager.hh>
+#include <ewoms/models/immiscible/immisciblemodel.hh>
+#include <ewoms/models/blackoil/blackoilmodel.hh>
+#include <ewoms/models/ncp/ncpmodel.hh>
+#include <ewoms/disc/ecfv/ecfvdiscretization.hh>
+#include "problems/lensproblem.hh"
+#include "problems/reservoirproblem.hh"
+#include "problems/co2injectionproblem.hh"
+#include "problems/obstacleproblem.hh"
+#if HAVE_DUNE_ALUGRID
+#include "problems/fingerproblem.hh"
+#endif
+
+#include <cstring>
+#include <iostream>
+#include <string>
+
+namespace Ewoms {
+namespace Properties {
+// the lens problem using the immiscible model
+NEW_TYPE_TAG(LensBenchmark, INHERITS_FROM(ImmiscibleTwoPhaseModel, LensBaseProblem, BenchmarkProblem));
+SET_TAG_PROP(LensBenchmark, SpatialDiscretizationSplice, EcfvDiscretization);
+SET_TAG_PROP(LensBenchmark, LocalLinearizerSplice, AutoDiffLocalLinearizer);
+SET_TYPE_PROP(LensBenchmark, Problem,
+              Ewoms::BenchmarkProblem<TypeTag, Ewoms::LensProblem<TypeTag> >);
+
+// the reservoir problem using the black-oil model. the grid corresponds to
+// data/reservoir.dgf
+NEW_TYPE_TAG(ReservoirBenchmark, INHERITS_FROM(BlackOilModel, ReservoirBaseProblem, BenchmarkProblem));
+SET_TAG_PROP(ReservoirBenchmark, SpatialDiscretizationSplice, EcfvDiscretization);
+SET_TAG_PROP(ReservoirBenchmark, LocalLinearizerSplice, AutoDiffLocalLinearizer);
+SET_TYPE_PROP(ReservoirBenchmark, Problem,
+              Ewoms::BenchmarkProblem<TypeTag, Ewoms::ReservoirProblem<TypeTag> >);
+SET_TYPE_PROP(ReservoirBenchmark, GridManager, Ewoms::CubeGridManager<TypeTag>);
+SET_SCALAR_PROP(ReservoirBenchmark, DomainSizeX, 6000.0);
+SET_SCALAR_PROP(ReservoirBenchmark, DomainSizeY, 20.0);
+SET_SCALAR_PROP(ReservoirBenchmark, DomainSizeZ, 1.0);
+SET_INT_PROP(ReservoirBenchmark, CellsX, 100);
+SET_INT_PROP(ReservoirBenchmark, CellsY, 10);
+SET_INT_PROP(ReservoirBenchmark, CellsZ, 1);
+
+// the CO2 injection problem using the NCP model. the grid corresponds to
+// data/co2injection.dgf
+NEW_TYPE_TAG(Co2InjectionBenchmark, INHERITS_FROM(NcpModel, Co2InjectionBaseProblem, BenchmarkProblem));
+SET_TAG_PROP(Co2InjectionBenchmark, SpatialDiscretizationSplice, EcfvDiscretization);
+SET_TYPE_PROP(Co2InjectionBenchmark, Problem,
+              Ewoms::BenchmarkProblem<TypeTag, Ewoms::Co2InjectionProblem<TypeTag> >);
+SET_TYPE_PROP(Co2InjectionBenchmark, GridManager, Ewoms::CubeGridManager<TypeTag>);
+SET_SCALAR_PROP(Co2InjectionBenchmark, DomainSizeX, 60.0);
+SET_SCALAR_PROP(Co2InjectionBenchmark, DomainSizeY, 40.0);
+SET_SCALAR_PROP(Co2InjectionBenchmark, DomainSizeZ, 1.0);
+SET_INT_PROP(Co2InjectionBenchmark, CellsX, 24);
+SET_INT_PROP(Co2InjectionBenchmark, CellsY, 16);
+SET_INT_PROP(Co2InjectionBenchmark, CellsZ, 1);
+
+// the obstacle problem using the immiscible model. the grid corresponds to
+// data/obstacle_24x16.dgf
+NEW_TYPE_TAG(ObstacleBenchmark, INHERITS_FROM(ImmiscibleModel, ObstacleBaseProblem, BenchmarkProblem));
+SET_TYPE_PROP(ObstacleBenchmark, Problem,
+              Ewoms::BenchmarkProblem<TypeTag, Ewoms::ObstacleProblem<TypeTag> >);
+SET_TYPE_PROP(ObstacleBenchmark, GridManager, Ewoms::CubeGridManager<TypeTag>);
+SET_SCALAR_PROP(ObstacleBenchmark, DomainSizeX, 60.0);
+SET_SCALAR_PROP(ObstacleBenchmark, DomainSizeY, 40.0);
+SET_SCALAR_PROP(ObstacleBenchmark, DomainSizeZ, 1.0);
+SET_INT_PROP(ObstacleBenchmark, CellsX, 24);
+SET_INT_PROP(ObstacleBenchmark, CellsY, 16);
+SET_INT_PROP(ObstacleBenchmark, CellsZ, 1);
+
+#if HAVE_DUNE_ALUGRID
+// the finger problem using the immiscible model
+NEW_TYPE_TAG(FingerBenchmark, INHERITS_FROM(ImmiscibleTwoPhaseModel, FingerBaseProblem, BenchmarkProblem));
+SET_TAG_PROP(FingerBenchmark, SpatialDiscretizationSplice, EcfvDiscretization);
+SET_TYPE_PROP(FingerBenchmark, Problem,
+              Ewoms::BenchmarkProblem<TypeTag, Ewoms::FingerProblem<TypeTag> >);
+#endif
+}}
+
+static void printBenchmarks_(const char *progName)
+{
+    std::cout << "Usage: " << progName << " --benchmark=NAME [SIMULATOR PARAMETERS]\n"
+              << "\n"
+              << "Available benchmarks:\n"
+              << "  lens          Lens problem, immiscible model, ECFV\n"
+              << "  reservoir     Reservoir problem, black-oil model, ECFV\n"
+              << "  co2injection  CO2 injection problem, NCP model, ECFV\n"
+              << "  obstacle      Obstacle problem, immiscible model, VCFV\n"
+#if HAVE_DUNE_ALUGRID
+              << "  finger        Finger problem, immiscible model, ECFV\n"
+#endif
+              << "\n"
+              << "Use '" << progName << " --benchmark=NAME --help' to list the parameters "
+              << "of a benchmark.\n";
+}
+
+int main(int argc, char **argv)
+{
+    // extract the name of the benchmark from the command line. all remaining arguments
+    // are passed to the simulator.
+    const char *benchmarkArg = "--benchmark=";
+    std::string benchmark;
+    int outArgIdx = 1;
+    for (int argIdx = 1; argIdx < argc; ++argIdx) {
+        if (std::strncmp(argv[argIdx], benchmarkArg, std::strlen(benchmarkArg)) == 0)
+            benchmark = argv[argIdx] + std::strlen(benchmarkArg);
+        else
+            argv[outArgIdx++] = argv[argIdx];
+    }
+    argc = outArgIdx;
+
+    if (benchmark == "lens")
+        return Ewoms::start<TTAG(LensBenchmark)>(argc, argv);
+    else if (benchmark == "reservoir")
+        return Ewoms::start<TTAG(ReservoirBenchmark)>(argc, argv);
+    else if (benchmark == "co2injection")
+        return Ewoms::start<TTAG(Co2InjectionBenchmark)>(argc, argv);
+    else if (benchmark == "obstacle")
+        return Ewoms::start<TTAG(ObstacleBenchmark)>(argc, argv);
+#if HAVE_DUNE_ALUGRID
+    else if (benchmark == "finger")
+        return Ewoms::start<TTAG(FingerBenchmark)>(argc, argv);
+#endif
+
+    if (!benchmark.empty())
+        std::cout << "Unknown benchmark '" << benchmark << "'\n\n";
+    printBenchmarks_(argv[0]);
+    return 1;
+}
@@ -0,0 +1,87 @@
+// -*- mode: C++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*-
+// vi: set et ts=4 sw=4 sts=4:
+/*
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+
+  Consult the COPYING file in the top-level source directory of this
+  module for the precise wording of the license and the list of
+  copyright holders.
+*/
+/*!
+ * \file
+ *
+ * \brief Test for the native VTK writer.
+ *
+ * This is the same simulation as lens_immiscible_ecfv, but the results are written as
+ * zlib compressed binary data in the appended section of the VTU files. The results
+ * are thus compared to the same reference solution.
+ */
+#include "config.h"
+
+#include <ewoms/common/start.hh>
+#include <ewoms/models/immiscible/immisciblemodel.hh>
+#include <ewoms/disc/ecfv/ecfvdiscretization.hh>
+#include <ewoms/io/vtknativewriter.hh>
+#include "problems/lensproblem.hh"
+
+namespace Ewoms {
+/*!
+ * \brief The lens problem which uses a different name for its output files.
+ *
+ * This avoids clashes with the files of lens_immiscible_ecfv if the tests are run
+ * concurrently.
+ */
+template <class TypeTag>
+class LensNativeVtkProblem : public LensProblem<TypeTag>
+{
+    typedef LensProblem<TypeTag> ParentType;
+    typedef typename GET_PROP_TYPE(TypeTag, Simulator) Simulator;
+
+public:
+    LensNativeVtkProblem(Simulator& simulator)
+        : ParentType(simulator)
+    { }
+
+    /*!
+     * \copydoc FvBaseProblem::name
+     */
+    std::string name() const
+    { return ParentType::name() + "_nativevtk"; }
+};
+
+namespace Properties {
+NEW_TYPE_TAG(LensProblemEcfvNativeVtk, INHERITS_FROM(ImmiscibleTwoPhaseModel, LensBaseProblem));
+
+SET_TYPE_PROP(LensProblemEcfvNativeVtk, Problem, Ewoms::LensNativeVtkProblem<TypeTag>);
+
+// use the element centered finite volume spatial discretization
+SET_TAG_PROP(LensProblemEcfvNativeVtk, SpatialDiscretizationSplice, EcfvDiscretization);
+
+// use automatic differentiation for this simulator
+SET_TAG_PROP(LensProblemEcfvNativeVtk, LocalLinearizerSplice, AutoDiffLocalLinearizer);
+
+// this problem works fine if the linear solver uses single precision scalars
+SET_TYPE_PROP(LensProblemEcfvNativeVtk, LinearSolverScalar, float);
+
+// write the VTK files using the native writer
+SET_INT_PROP(LensProblemEcfvNativeVtk, VtkOutputFormat, Ewoms::VtkNative::appendedZlib);
+}}
+
+int main(int argc, char **argv)
+{
+    typedef TTAG(LensProblemEcfvNativeVtk) ProblemTypeTag;
+    return Ewoms::start<ProblemTypeTag>(argc, argv);
+}
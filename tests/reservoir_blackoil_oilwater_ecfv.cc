@@ -0,0 +1,94 @@
+// -*- mode: C++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*-
+// vi: set et ts=4 sw=4 sts=4:
+/*
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+
+  Consult the COPYING file in the top-level source directory of this
+  module for the precise wording of the license and the list of
+  copyright holders.
+*/
+/*!
+ * \file
+ *
+ * \brief Test for the reservoir problem using the black-oil model instantiated for the
+ *        oil and water phases only, the ECFV discretization and automatic
+ *        differentiation.
+ *
+ * The reservoir problem does not contain any free gas, so the gas phase can be disabled
+ * at compile time. This reduces the number of equations to two, but the oil phase is then
+ * always saturated with gas. The purpose of this test is to make sure that the
+ * two-phase instantiation of the black-oil model compiles and runs.
+ */
+#include "config.h"
+
+#include <ewoms/common/start.hh>
+#include <ewoms/models/blackoil/blackoilmodel.hh>
+#include <ewoms/disc/ecfv/ecfvdiscretization.hh>
+#include "problems/reservoirproblem.hh"
+
+namespace Ewoms {
+/*!
+ * \brief The reservoir problem which uses a different name for its output files.
+ *
+ * The results of the two-phase instantiation differ from the ones of the three-phase
+ * model, so they must neither overwrite the files of reservoir_blackoil_ecfv nor be
+ * compared against its reference solution.
+ */
+template <class TypeTag>
+class ReservoirOilWaterProblem : public ReservoirProblem<TypeTag>
+{
+    typedef ReservoirProblem<TypeTag> ParentType;
+    typedef typename GET_PROP_TYPE(TypeTag, Simulator) Simulator;
+
+public:
+    ReservoirOilWaterProblem(Simulator& simulator)
+        : ParentType(simulator)
+    { }
+
+    /*!
+     * \copydoc FvBaseProblem::name
+     */
+    std::string name() const
+    { return "reservoir_blackoil_oilwater_ecfv"; }
+};
+
+namespace Properties {
+NEW_TYPE_TAG(ReservoirBlackOilOilWaterEcfvProblem, INHERITS_FROM(BlackOilModel, ReservoirBaseProblem));
+
+SET_TYPE_PROP(ReservoirBlackOilOilWaterEcfvProblem, Problem, Ewoms::ReservoirOilWaterProblem<TypeTag>);
+
+// Select the element centered finite volume method as spatial discretization
+SET_TAG_PROP(ReservoirBlackOilOilWaterEcfvProblem, SpatialDiscretizationSplice, EcfvDiscretization);
+
+// Use automatic differentiation to linearize the system of PDEs
+SET_TAG_PROP(ReservoirBlackOilOilWaterEcfvProblem, LocalLinearizerSplice, AutoDiffLocalLinearizer);
+
+// Only consider the oil and water phases
+SET_PROP(ReservoirBlackOilOilWaterEcfvProblem, Indices)
+{
+private:
+    typedef typename GET_PROP_TYPE(TypeTag, FluidSystem) FluidSystem;
+
+public:
+    typedef Ewoms::BlackOilTwoPhaseIndices<FluidSystem, FluidSystem::gasCompIdx> type;
+};
+}}
+
+int main(int argc, char **argv)
+{
+    typedef TTAG(ReservoirBlackOilOilWaterEcfvProblem) ProblemTypeTag;
+    return Ewoms::start<ProblemTypeTag>(argc, argv);
+}
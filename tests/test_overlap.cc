@@ -0,0 +1,260 @@
+// -*- mode: C++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*-
+// vi: set et ts=4 sw=4 sts=4:
+/*
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+
+  Consult the COPYING file in the top-level source directory of this
+  module for the precise wording of the license and the list of
+  copyright holders.
+*/
+/*!
+ * \file
+ *
+ * \brief This file tests the setup of the algebraic overlap of the parallel linear
+ *        solvers.
+ *
+ * The matrix is the one of a 1D chain of vertices which is distributed over all
+ * processes. Each process has five native vertices and its first vertex is the last one
+ * of the previous process, i.e., the native vertex i of process r corresponds to the
+ * global vertex 4r + i. This test is meant to be run in parallel.
+ */
+#include "config.h"
+
+#include <ewoms/linear/domesticoverlapfrombcrsmatrix.hh>
+#include <ewoms/linear/globalindices.hh>
+
+#include <opm/common/ErrorMacros.hpp>
+#include <opm/common/Exceptions.hpp>
+
+#include <dune/common/parallel/mpihelper.hh>
+
+#include <algorithm>
+#include <iostream>
+#include <stdexcept>
+#include <vector>
+
+using Ewoms::Linear::Index;
+using Ewoms::Linear::ProcessRank;
+
+static const int numNative = 5;
+
+// provides the sparsity pattern of a tridiagonal matrix. the overlap classes do not
+// access the matrix entries.
+class ChainMatrix
+{
+public:
+    class ConstColIterator
+    {
+    public:
+        explicit ConstColIterator(int colIdx)
+            : colIdx_(colIdx)
+        {}
+
+        bool operator!=(const ConstColIterator& other) const
+        { return colIdx_ != other.colIdx_; }
+
+        ConstColIterator& operator++()
+        { ++colIdx_; return *this; }
+
+        int index() const
+        { return colIdx_; }
+
+    private:
+        int colIdx_;
+    };
+
+    class Row
+    {
+    public:
+        Row(int rowIdx, int numRows)
+            : rowIdx_(rowIdx), numRows_(numRows)
+        {}
+
+        ConstColIterator begin() const
+        { return ConstColIterator(std::max(0, rowIdx_ - 1)); }
+
+        ConstColIterator end() const
+        { return ConstColIterator(std::min(numRows_, rowIdx_ + 2)); }
+
+    private:
+        int rowIdx_;
+        int numRows_;
+    };
+
+    size_t N() const
+    { return numNative; }
+
+    Row operator[](size_t rowIdx) const
+    { return Row(static_cast<int>(rowIdx), numNative); }
+};
+
+static Ewoms::Linear::BorderList chainBorderList(int rank, int size)
+{
+    Ewoms::Linear::BorderList borderList;
+    Ewoms::Linear::BorderIndex borderIdx;
+    borderIdx.borderDistance = 0;
+    if (rank > 0) {
+        borderIdx.localIdx = 0;
+        borderIdx.peerIdx = numNative - 1;
+        borderIdx.peerRank = static_cast<ProcessRank>(rank - 1);
+        borderList.push_back(borderIdx);
+    }
+    if (rank < size - 1) {
+        borderIdx.localIdx = numNative - 1;
+        borderIdx.peerIdx = 0;
+        borderIdx.peerRank = static_cast<ProcessRank>(rank + 1);
+        borderList.push_back(borderIdx);
+    }
+    return borderList;
+}
+
+// the process which is the master of a global vertex. shared vertices belong to the
+// process with the lower rank
+static ProcessRank chainMasterRank(Index globalIdx)
+{ return static_cast<ProcessRank>(std::max(0, (globalIdx - 1)/(numNative - 1))); }
+
+static void check(bool condition, int rank, const char *what)
+{
+    if (!condition)
+        OPM_THROW(std::logic_error, "Process " << rank << ": " << what);
+}
+
+// a minimal foreign overlap of the chain without any overlap beyond the border
+class ChainForeignOverlap
+{
+public:
+    ChainForeignOverlap(int rank, int size)
+        : rank_(rank)
+        , borderList_(chainBorderList(rank, size))
+    { peerSet_.update(borderList_); }
+
+    size_t numLocal() const
+    { return numNative; }
+
+    bool iAmMasterOf(Index localIdx) const
+    { return masterRank(localIdx) == static_cast<ProcessRank>(rank_); }
+
+    ProcessRank masterRank(Index localIdx) const
+    { return (localIdx == 0 && rank_ > 0) ? static_cast<ProcessRank>(rank_ - 1) : static_cast<ProcessRank>(rank_); }
+
+    Index nativeToLocal(Index nativeIdx) const
+    { return nativeIdx; }
+
+    const Ewoms::Linear::PeerSet& peerSet() const
+    { return peerSet_; }
+
+    const Ewoms::Linear::BorderList& borderList() const
+    { return borderList_; }
+
+private:
+    int rank_;
+    Ewoms::Linear::BorderList borderList_;
+    Ewoms::Linear::PeerSet peerSet_;
+};
+
+static void testGlobalIndices(int rank, int size)
+{
+    ChainForeignOverlap foreignOverlap(rank, size);
+    Ewoms::Linear::GlobalIndices<ChainForeignOverlap> globalIndices(foreignOverlap);
+
+    check(globalIndices.numDomestic() == numNative, rank, "wrong number of domestic indices");
+    for (Index localIdx = 0; localIdx < numNative; ++localIdx)
+        check(globalIndices.domesticToGlobal(localIdx) == (numNative - 1)*rank + localIdx,
+              rank, "wrong global index of a local index");
+
+    // duplicate and known indices are ignored, the new ones are numbered in the
+    // ascending order of their global indices
+    Index offset = 1000*(rank + 1);
+    std::vector<Index> newIndices = { offset + 2, (numNative - 1)*rank, offset + 1, offset + 2 };
+    globalIndices.addIndices(newIndices);
+    check(globalIndices.numDomestic() == numNative + 2, rank, "addIndices() added the wrong number of indices");
+    check(globalIndices.domesticToGlobal(numNative) == offset + 1
+          && globalIndices.domesticToGlobal(numNative + 1) == offset + 2,
+          rank, "addIndices() numbered the new indices in the wrong order");
+
+    globalIndices.addIndex(numNative + 2, offset);
+    for (Index domesticIdx = 0; domesticIdx < numNative + 3; ++domesticIdx)
+        check(globalIndices.globalToDomestic(globalIndices.domesticToGlobal(domesticIdx)) == domesticIdx,
+              rank, "the global and domestic indices are not inverse");
+    check(!globalIndices.hasGlobalIndex(offset + 3), rank, "unknown global index found");
+}
+
+static void testDomesticOverlap(int rank, int size)
+{
+    const unsigned overlapSize = 2;
+    ChainMatrix matrix;
+    Ewoms::Linear::BlackList blackList;
+    Ewoms::Linear::DomesticOverlapFromBCRSMatrix overlap(matrix,
+                                                          chainBorderList(rank, size),
+                                                          blackList,
+                                                          overlapSize);
+
+    // the process sees all global vertices which are at most 'overlapSize' vertices
+    // away from its native ones
+    Index firstGlobal = (numNative - 1)*rank;
+    Index beginGlobal = std::max(0, firstGlobal - static_cast<Index>(overlapSize));
+    Index endGlobal = std::min((numNative - 1)*size + 1,
+                               firstGlobal + numNative + static_cast<Index>(overlapSize));
+    check(overlap.numDomestic() == static_cast<size_t>(endGlobal - beginGlobal),
+          rank, "wrong number of domestic indices");
+
+    // the native indices come first, the remaining ones are numbered in the ascending
+    // order of their global indices
+    std::vector<Index> remoteGlobal;
+    for (Index domesticIdx = 0; domesticIdx < static_cast<Index>(overlap.numDomestic()); ++domesticIdx) {
+        Index globalIdx = overlap.domesticToGlobal(domesticIdx);
+        check(overlap.globalToDomestic(globalIdx) == domesticIdx,
+              rank, "the global and domestic indices are not inverse");
+        check(overlap.masterRank(domesticIdx) == chainMasterRank(globalIdx),
+              rank, "wrong master rank");
+
+        // the front consists of the outermost vertices of the overlap
+        bool isFront =
+            (globalIdx == beginGlobal && beginGlobal < firstGlobal)
+            || (globalIdx == endGlobal - 1 && endGlobal > firstGlobal + numNative);
+        check(overlap.isFront(domesticIdx) == isFront, rank, "wrong front flag");
+
+        if (domesticIdx < numNative)
+            check(globalIdx == firstGlobal + domesticIdx, rank, "wrong global index of a native index");
+        else
+            remoteGlobal.push_back(globalIdx);
+    }
+    check(std::is_sorted(remoteGlobal.begin(), remoteGlobal.end()),
+          rank, "the remote indices are not numbered in ascending order");
+}
+
+int main(int argc, char **argv)
+{
+    const auto& mpiHelper = Dune::MPIHelper::instance(argc, argv);
+    int rank = mpiHelper.rank();
+    int size = mpiHelper.size();
+
+    try {
+        testGlobalIndices(rank, size);
+        testDomesticOverlap(rank, size);
+    }
+    catch (const std::exception& e) {
+        std::cout << e.what() << "\n" << std::flush;
+#if HAVE_MPI
+        MPI_Abort(MPI_COMM_WORLD, 1);
+#endif
+        return 1;
+    }
+
+    if (rank == 0)
+        std::cout << "All tests passed\n";
+    return 0;
+}
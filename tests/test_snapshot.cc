@@ -0,0 +1,285 @@
+// -*- mode: C++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*-
+// vi: set et ts=4 sw=4 sts=4:
+/*
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+
+  Consult the COPYING file in the top-level source directory of this
+  module for the precise wording of the license and the list of
+  copyright holders.
+*/
+/*!
+ * \file
+ *
+ * \brief This file tests that the fields written by Ewoms::SnapshotWriter can be read
+ *        back using Ewoms::SnapshotReader.
+ *
+ * The values of the fields are functions of the time and of the position of the
+ * entities, so they can be checked using the geometry which is stored in the file. The
+ * test also makes sure that restarting the writer appends to the existing file.
+ */
+#include "config.h"
+
+#include <ewoms/io/snapshotwriter.hh>
+#include <ewoms/io/snapshotreader.hh>
+
+#include <opm/common/ErrorMacros.hpp>
+#include <opm/common/Exceptions.hpp>
+
+#include <dune/common/version.hh>
+#include <dune/common/parallel/mpihelper.hh>
+#include <dune/grid/yaspgrid.hh>
+#include <dune/grid/common/mcmgmapper.hh>
+
+#include <array>
+#include <bitset>
+#include <cmath>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+typedef Dune::YaspGrid<2> Grid;
+typedef Grid::LeafGridView GridView;
+typedef Ewoms::SnapshotWriter<GridView> Writer;
+
+static const char *fileName = "test_snapshot.ewsnap";
+
+// a minimal replacement for Ewoms::Restart which keeps the serialized data in memory
+class MemoryRestarter
+{
+public:
+    void serializeSectionBegin(const std::string& cookie)
+    { stream_ << cookie << "\n"; }
+
+    std::ostream& serializeStream()
+    { return stream_; }
+
+    void serializeSectionEnd()
+    { stream_ << "\n"; }
+
+    void deserializeSectionBegin(const std::string& cookie)
+    {
+        std::string buf;
+        std::getline(stream_, buf);
+        if (buf != cookie)
+            OPM_THROW(std::runtime_error, "Could not start section '" << cookie << "'");
+    }
+
+    std::istream& deserializeStream()
+    { return stream_; }
+
+    void deserializeSectionEnd()
+    {
+        std::string dummy;
+        std::getline(stream_, dummy);
+    }
+
+private:
+    std::stringstream stream_;
+};
+
+static void check(bool condition, const std::string& msg)
+{
+    if (!condition)
+        OPM_THROW(std::logic_error, msg);
+}
+
+static double pressure(double t, double x, double y)
+{ return 1e5 + t + 10.0*x + 100.0*y; }
+
+static double saturation(double t, double x, double y)
+{ return 0.01*t + x*y; }
+
+static double velocity(double t, double x, double y, unsigned compIdx)
+{ return (compIdx == 0) ? t*x : -t*y; }
+
+// attach the fields of the time step t to the writer and write them
+static void writeStep(Writer& writer, const GridView& gridView, double t)
+{
+    typedef Dune::MultipleCodimMultipleGeomTypeMapper<GridView, Dune::MCMGVertexLayout> VertexMapper;
+    typedef Dune::MultipleCodimMultipleGeomTypeMapper<GridView, Dune::MCMGElementLayout> ElementMapper;
+    VertexMapper vertexMapper(gridView);
+    ElementMapper elementMapper(gridView);
+
+    Writer::ScalarBuffer pressureBuf(static_cast<size_t>(vertexMapper.size()));
+    auto vIt = gridView.begin</*codim=*/2>();
+    const auto& vEndIt = gridView.end</*codim=*/2>();
+    for (; vIt != vEndIt; ++vIt) {
+#if DUNE_VERSION_NEWER(DUNE_COMMON, 2, 4)
+        size_t vIdx = static_cast<size_t>(vertexMapper.index(*vIt));
+#else
+        size_t vIdx = static_cast<size_t>(vertexMapper.map(*vIt));
+#endif
+        const auto& pos = vIt->geometry().corner(0);
+        pressureBuf[vIdx] = pressure(t, pos[0], pos[1]);
+    }
+
+    Writer::ScalarBuffer saturationBuf(static_cast<size_t>(elementMapper.size()));
+    Writer::VectorBuffer velocityBuf(static_cast<size_t>(elementMapper.size()),
+                                     Writer::Vector(2));
+    auto eIt = gridView.begin</*codim=*/0>();
+    const auto& eEndIt = gridView.end</*codim=*/0>();
+    for (; eIt != eEndIt; ++eIt) {
+#if DUNE_VERSION_NEWER(DUNE_COMMON, 2, 4)
+        size_t eIdx = static_cast<size_t>(elementMapper.index(*eIt));
+#else
+        size_t eIdx = static_cast<size_t>(elementMapper.map(*eIt));
+#endif
+        const auto& pos = eIt->geometry().center();
+        saturationBuf[eIdx] = saturation(t, pos[0], pos[1]);
+        for (unsigned compIdx = 0; compIdx < 2; ++compIdx)
+            velocityBuf[eIdx][compIdx] = velocity(t, pos[0], pos[1], compIdx);
+    }
+
+    writer.beginWrite(t);
+    writer.attachScalarVertexData(pressureBuf, "pressure");
+    writer.attachScalarElementData(saturationBuf, "saturation");
+    writer.attachVectorElementData(velocityBuf, "velocity");
+    writer.endWrite();
+}
+
+static bool isClose(double a, double b)
+{ return std::abs(a - b) <= 1e-10*std::max(1.0, std::abs(a) + std::abs(b)); }
+
+// check the fields of a time step of the file against the values which were written
+static void checkStep(const Ewoms::SnapshotReader& reader, unsigned stepIdx, double t)
+{
+    check(isClose(reader.time(stepIdx), t), "wrong time of a time step");
+    check(reader.numFields(stepIdx) == 3, "wrong number of fields");
+
+    int pressureIdx = reader.fieldIndex(stepIdx, "pressure");
+    int saturationIdx = reader.fieldIndex(stepIdx, "saturation");
+    int velocityIdx = reader.fieldIndex(stepIdx, "velocity");
+    check(pressureIdx >= 0 && saturationIdx >= 0 && velocityIdx >= 0, "field not found");
+    check(!reader.isCellField(stepIdx, static_cast<unsigned>(pressureIdx))
+          && reader.isCellField(stepIdx, static_cast<unsigned>(saturationIdx))
+          && reader.isCellField(stepIdx, static_cast<unsigned>(velocityIdx)),
+          "wrong entity type of a field");
+    check(reader.numComponents(stepIdx, static_cast<unsigned>(velocityIdx)) == 2,
+          "wrong number of components of a vector field");
+
+    unsigned gridIdx = reader.gridIndex(stepIdx);
+    for (unsigned rankIdx = 0; rankIdx < reader.numRanks(); ++rankIdx) {
+        const double *points = reader.points(gridIdx, rankIdx);
+        const int64_t *connectivity = reader.connectivity(gridIdx, rankIdx);
+        const int64_t *offsets = reader.offsets(gridIdx, rankIdx);
+
+        const double *p = reader.fieldData(stepIdx, static_cast<unsigned>(pressureIdx), rankIdx);
+        for (uint64_t pointIdx = 0; pointIdx < reader.numPoints(gridIdx, rankIdx); ++pointIdx)
+            check(isClose(p[pointIdx], pressure(t, points[3*pointIdx], points[3*pointIdx + 1])),
+                  "wrong value of a point field");
+
+        const double *s = reader.fieldData(stepIdx, static_cast<unsigned>(saturationIdx), rankIdx);
+        const double *v = reader.fieldData(stepIdx, static_cast<unsigned>(velocityIdx), rankIdx);
+        for (uint64_t cellIdx = 0; cellIdx < reader.numCells(gridIdx, rankIdx); ++cellIdx) {
+            // the center of the cell is the mean of its corners
+            int64_t cornerBegin = (cellIdx == 0) ? 0 : offsets[cellIdx - 1];
+            int64_t cornerEnd = offsets[cellIdx];
+            double x = 0.0, y = 0.0;
+            for (int64_t cornerIdx = cornerBegin; cornerIdx < cornerEnd; ++cornerIdx) {
+                int64_t pointIdx = connectivity[cornerIdx];
+                x += points[3*pointIdx];
+                y += points[3*pointIdx + 1];
+            }
+            x /= static_cast<double>(cornerEnd - cornerBegin);
+            y /= static_cast<double>(cornerEnd - cornerBegin);
+
+            check(isClose(s[cellIdx], saturation(t, x, y)), "wrong value of a cell field");
+            for (unsigned compIdx = 0; compIdx < 2; ++compIdx)
+                check(isClose(v[2*cellIdx + compIdx], velocity(t, x, y, compIdx)),
+                      "wrong value of a vector field");
+        }
+    }
+}
+
+static void testSnapshot(const GridView& gridView)
+{
+    MemoryRestarter restarter;
+
+    {
+        Writer writer(gridView, "test_snapshot");
+        writeStep(writer, gridView, 10.0);
+        writeStep(writer, gridView, 20.0);
+        writer.serialize(restarter);
+
+        // this step is written after the restart point, so it must be discarded by the
+        // restarted writer
+        writeStep(writer, gridView, 30.0);
+    }
+
+    gridView.comm().barrier();
+    if (gridView.comm().rank() == 0) {
+        Ewoms::SnapshotReader reader(fileName);
+        check(reader.numSteps() == 3, "wrong number of time steps");
+        check(reader.numRanks() == static_cast<unsigned>(gridView.comm().size()),
+              "wrong number of processes");
+        checkStep(reader, 0, 10.0);
+        checkStep(reader, 1, 20.0);
+        checkStep(reader, 2, 30.0);
+    }
+    gridView.comm().barrier();
+
+    {
+        Writer writer(gridView, "test_snapshot");
+        writer.deserialize(restarter);
+        writeStep(writer, gridView, 25.0);
+        writeStep(writer, gridView, 35.0);
+    }
+
+    gridView.comm().barrier();
+    if (gridView.comm().rank() == 0) {
+        Ewoms::SnapshotReader reader(fileName);
+        check(reader.numSteps() == 4, "the restarted writer did not append to the file");
+        checkStep(reader, 0, 10.0);
+        checkStep(reader, 1, 20.0);
+        checkStep(reader, 2, 25.0);
+        checkStep(reader, 3, 35.0);
+    }
+}
+
+int main(int argc, char **argv)
+{
+    Dune::MPIHelper::instance(argc, argv);
+
+    std::bitset<2> isPeriodic(false);
+    std::array<int, 2> cellRes = {{ 7, 5 }};
+    Dune::FieldVector<double, 2> upperRight(1.0);
+    upperRight[1] = 2.0;
+#if DUNE_VERSION_NEWER(DUNE_COMMON, 2, 4)
+    Grid grid(upperRight, cellRes, isPeriodic, /*overlap=*/0);
+#else
+    Grid grid(
+#ifdef HAVE_MPI
+        Dune::MPIHelper::getCommunicator(),
+#endif
+        upperRight,
+        cellRes,
+        isPeriodic,
+        /*overlap=*/0);
+#endif
+
+    try {
+        testSnapshot(grid.leafGridView());
+    }
+    catch (const std::exception& e) {
+        std::cout << e.what() << "\n" << std::flush;
+        return 1;
+    }
+
+    std::cout << "All tests passed\n";
+    return 0;
+}
@@ -0,0 +1,220 @@
+// -*- mode: C++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*-
+// vi: set et ts=4 sw=4 sts=4:
+/*
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+
+  Consult the COPYING file in the top-level source directory of this
+  module for the precise wording of the license and the list of
+  copyright holders.
+*/
+/*!
+ * \file
+ *
+ * \brief This file tests the step-size response of the PID time-step controller.
+ *
+ * The simulator and the model are replaced by minimal mock objects which only provide
+ * the solutions of the old and the new time level.
+ */
+#include "config.h"
+
+#include <ewoms/common/basicproperties.hh>
+#include <ewoms/disc/common/fvbasetimestepcontroller.hh>
+
+#include <opm/common/ErrorMacros.hpp>
+#include <opm/common/Exceptions.hpp>
+
+#include <array>
+#include <cmath>
+#include <iostream>
+#include <stdexcept>
+#include <vector>
+
+class MockCommunication
+{
+public:
+    template <class T>
+    int sum(T* inout OPM_UNUSED, int len OPM_UNUSED) const
+    { return 0; }
+};
+
+class MockGridView
+{
+public:
+    const MockCommunication& comm() const
+    { return comm_; }
+
+private:
+    MockCommunication comm_;
+};
+
+class MockModel
+{
+public:
+    typedef std::array<double, 2> PrimaryVariables;
+    typedef std::vector<PrimaryVariables> SolutionVector;
+
+    MockModel()
+        : controlsTimeStep_{{true, true}}
+    { solution_[0].resize(10); solution_[1].resize(10); }
+
+    unsigned numGridDof() const
+    { return static_cast<unsigned>(solution_[0].size()); }
+
+    bool isLocalDof(unsigned dofIdx OPM_UNUSED) const
+    { return true; }
+
+    const SolutionVector& solution(unsigned timeIdx) const
+    { return solution_[timeIdx]; }
+
+    bool primaryVarControlsTimeStep(unsigned dofIdx OPM_UNUSED, unsigned pvIdx) const
+    { return controlsTimeStep_[pvIdx]; }
+
+    // set the solutions of both time levels such that the relative change of the given
+    // primary variable is 'change'
+    void setRelativeChange(unsigned pvIdx, double change)
+    {
+        for (unsigned dofIdx = 0; dofIdx < numGridDof(); ++dofIdx) {
+            solution_[0][dofIdx][pvIdx] = 1.0;
+            solution_[1][dofIdx][pvIdx] = 1.0 - change;
+        }
+    }
+
+    void setControlsTimeStep(unsigned pvIdx, bool yesno)
+    { controlsTimeStep_[pvIdx] = yesno; }
+
+private:
+    SolutionVector solution_[2];
+    std::array<bool, 2> controlsTimeStep_;
+};
+
+class MockSimulator
+{
+public:
+    MockModel& model()
+    { return model_; }
+
+    const MockModel& model() const
+    { return model_; }
+
+    const MockGridView& gridView() const
+    { return gridView_; }
+
+private:
+    MockModel model_;
+    MockGridView gridView_;
+};
+
+namespace Ewoms {
+namespace Properties {
+NEW_TYPE_TAG(TimeStepControllerTest, INHERITS_FROM(NumericModel));
+
+SET_TYPE_PROP(TimeStepControllerTest, Simulator, MockSimulator);
+SET_INT_PROP(TimeStepControllerTest, NumEq, 2);
+SET_INT_PROP(TimeStepControllerTest, TimeStepGrowthDelay, 2);
+SET_SCALAR_PROP(TimeStepControllerTest, TimeStepMaxGrowthFactor, 2.0);
+SET_SCALAR_PROP(TimeStepControllerTest, PidTimeStepTolerance, 0.1);
+}}
+
+typedef TTAG(TimeStepControllerTest) TypeTag;
+typedef Ewoms::PidTimeStepController<TypeTag> Controller;
+
+static const double tol = 0.1;
+static const double dt = 100.0;
+
+static void checkClose(double value, double expected, const char *what)
+{
+    if (std::abs(value - expected) > 1e-10*expected)
+        OPM_THROW(std::logic_error,
+                  what << ": expected a time step size of " << expected
+                  << ", got " << value);
+}
+
+// computes the size of the next time step after a single successful time step which
+// changed the first primary variable by 'change'
+static double nextStepSize(MockSimulator& simulator, double change)
+{
+    Controller controller(simulator);
+    simulator.model().setRelativeChange(/*pvIdx=*/0, change);
+    controller.timeStepSucceeded(dt);
+    return controller.suggestTimeStepSize(dt);
+}
+
+static void testStepSizeResponse()
+{
+    MockSimulator simulator;
+    simulator.model().setRelativeChange(/*pvIdx=*/1, 0.0);
+
+    // hitting the tolerance exactly keeps the step size
+    checkClose(nextStepSize(simulator, tol), dt, "change at the tolerance");
+
+    // too large changes reduce the step size proportionally
+    checkClose(nextStepSize(simulator, 2*tol), dt/2, "change above the tolerance");
+
+    // smaller changes increase the step size according to the PID formula. since the
+    // history is initialized to the tolerance, all three terms contribute the same
+    // ratio
+    checkClose(nextStepSize(simulator, tol/4), dt*std::pow(4.0, 0.075 + 0.175 + 0.01),
+               "change below the tolerance");
+
+    // the growth is bounded by TimeStepMaxGrowthFactor
+    checkClose(nextStepSize(simulator, 1e-10), 2*dt, "tiny change");
+}
+
+static void testExcludedPrimaryVariables()
+{
+    MockSimulator simulator;
+
+    // a jump of the second primary variable dominates the relative change...
+    simulator.model().setRelativeChange(/*pvIdx=*/1, 0.5);
+    checkClose(nextStepSize(simulator, tol), dt*tol/0.5, "all variables considered");
+
+    // ... unless the model excludes it from the time step control
+    simulator.model().setControlsTimeStep(/*pvIdx=*/1, false);
+    checkClose(nextStepSize(simulator, tol), dt, "second variable excluded");
+}
+
+static void testGrowthDelay()
+{
+    MockSimulator simulator;
+    simulator.model().setRelativeChange(/*pvIdx=*/0, tol/4);
+    simulator.model().setRelativeChange(/*pvIdx=*/1, 0.0);
+
+    Controller controller(simulator);
+    controller.timeStepFailed(2*dt);
+    controller.timeStepSucceeded(dt);
+
+    // the step size must not grow during the TimeStepGrowthDelay steps after a cut
+    checkClose(controller.suggestTimeStepSize(dt), dt, "first step after the cut");
+    controller.timeStepSucceeded(dt);
+    checkClose(controller.suggestTimeStepSize(dt), dt, "second step after the cut");
+    controller.timeStepSucceeded(dt);
+    if (!(controller.suggestTimeStepSize(dt) > dt))
+        OPM_THROW(std::logic_error,
+                  "The time step size did not grow after the growth delay");
+}
+
+int main()
+{
+    Controller::registerParameters();
+    EWOMS_END_PARAM_REGISTRATION(TypeTag);
+
+    testStepSizeResponse();
+    testExcludedPrimaryVariables();
+    testGrowthDelay();
+
+    std::cout << "All tests passed\n";
+    return 0;
+}